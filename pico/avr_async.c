@@ -0,0 +1,149 @@
+/**
+ * @file avr_async.c
+ * @brief Non-blocking ISP Batch Engine
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "avr_async.h"
+#include "avrprog.h"
+#include "metrics.h"
+#include "trace.h"
+#include <pico/stdlib.h>
+
+/*******************************************************************************
+ * Engine State
+ ******************************************************************************/
+
+typedef enum {
+    ASYNC_IDLE,
+    ASYNC_RUN,          /* Next segment ready to transfer */
+    ASYNC_WAIT_DELAY,   /* Fixed delay until deadline */
+    ASYNC_WAIT_POLL,    /* RDY/BSY polling until ready or deadline */
+} async_state_t;
+
+static async_state_t state = ASYNC_IDLE;
+static avr_batch_t *job;
+static size_t next;                 /* First instruction of the next segment */
+static bool job_ok;
+static absolute_time_t deadline;
+static uint64_t wait_start;         /* Start of the current wait */
+static avr_async_done_t done_cb;
+static void *done_ctx;
+
+/**
+ * @brief Finish the job and report it
+ *
+ * The engine is idle before the callback runs so it can submit again.
+ */
+static void complete(void) {
+    avr_async_done_t cb = done_cb;
+    void *ctx = done_ctx;
+    bool ok = job_ok;
+
+    job->count = 0;
+    job = NULL;
+    state = ASYNC_IDLE;
+    if (cb) {
+        cb(ok, ctx);
+    }
+}
+
+/** Continue after a segment's wait has ended */
+static void wait_done(void) {
+    metrics_add(METRIC_BUSY_US, (uint32_t)(time_us_64() - wait_start));
+    trace(TRACE_WAIT_END, job_ok, 0);
+    if (next < job->count) {
+        state = ASYNC_RUN;
+    } else {
+        complete();
+    }
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/**
+ * @brief Start executing a batch
+ */
+bool avr_async_submit(avr_batch_t *b, avr_async_done_t done, void *ctx) {
+    if (state != ASYNC_IDLE) {
+        return false;
+    }
+    job = b;
+    next = 0;
+    job_ok = true;
+    done_cb = done;
+    done_ctx = ctx;
+    state = ASYNC_RUN;
+    if (b->count == 0) {
+        complete();
+    }
+    return true;
+}
+
+/**
+ * @brief Advance the running batch
+ *
+ * At most one segment transfer or one RDY/BSY query per call.
+ */
+bool avr_async_poll(void) {
+    switch (state) {
+        case ASYNC_RUN: {
+            next = avr_batch_run_segment(job, next);
+            const avr_batch_instr_t *last = &job->instr[next - 1];
+            wait_start = time_us_64();
+            if (last->wait != AVR_BATCH_NONE) {
+                trace(TRACE_WAIT_BEGIN, 0, 0);
+            }
+            if (last->wait == AVR_BATCH_POLL) {
+                deadline = make_timeout_time_us(last->wait_us);
+                state = ASYNC_WAIT_POLL;
+            } else if (last->wait == AVR_BATCH_DELAY) {
+                deadline = make_timeout_time_us(last->wait_us);
+                state = ASYNC_WAIT_DELAY;
+            } else if (next >= job->count) {
+                complete();
+            }
+        } break;
+
+        case ASYNC_WAIT_DELAY:
+            if (time_reached(deadline)) {
+                wait_done();
+            }
+            break;
+
+        case ASYNC_WAIT_POLL:
+            /* A zero timeout makes avr_poll_ready() a single query */
+            if (avr_poll_ready(0)) {
+                wait_done();
+            } else if (time_reached(deadline)) {
+                job_ok = false;
+                wait_done();
+            }
+            break;
+
+        case ASYNC_IDLE:
+        default:
+            break;
+    }
+    return state != ASYNC_IDLE;
+}
+
+/**
+ * @brief Check whether a batch is running
+ */
+bool avr_async_busy(void) {
+    return state != ASYNC_IDLE;
+}
+
+/**
+ * @brief Poll until the running batch (if any) has completed
+ */
+void avr_async_finish(void) {
+    while (avr_async_poll()) {
+        tight_loop_contents();
+    }
+}
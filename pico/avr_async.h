@@ -0,0 +1,70 @@
+/**
+ * @file avr_async.h
+ * @brief Non-blocking ISP Batch Engine
+ *
+ * Runs an instruction batch (avr_batch.h) as a state machine instead of
+ * blocking in sleep_us()/poll loops, so the main loop keeps calling
+ * tud_task() while the target erases or writes a page.
+ *
+ * Semantics:
+ *   - submit: hand over a batch and a completion callback; the batch must
+ *     stay untouched until the callback runs
+ *   - poll:   transfer the next segment or check the current wait; never
+ *     blocks longer than one segment transfer
+ *   - complete: the callback runs from poll() with the result, after the
+ *     engine is idle again so it may submit the next batch
+ *
+ * Waits:
+ *   AVR_BATCH_DELAY becomes a deadline, AVR_BATCH_POLL one RDY/BSY query
+ *   per poll() until the target is ready or the timeout passes.
+ *
+ * Usage:
+ *   avr_async_submit(&b, done, NULL);
+ *   while (true) { tud_task(); avr_async_poll(); }
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "avr_batch.h"
+
+/**
+ * @brief Completion callback
+ *
+ * @param ok  false if a poll ran into its timeout
+ * @param ctx Context pointer given to avr_async_submit()
+ */
+typedef void (*avr_async_done_t)(bool ok, void *ctx);
+
+/**
+ * @brief Start executing a batch
+ *
+ * @param b    Batch to run; cleared on completion
+ * @param done Completion callback (may be NULL)
+ * @param ctx  Passed to done
+ * @return false if another batch is still running
+ */
+bool avr_async_submit(avr_batch_t *b, avr_async_done_t done, void *ctx);
+
+/**
+ * @brief Advance the running batch
+ *
+ * @return true while a batch is still running
+ */
+bool avr_async_poll(void);
+
+/**
+ * @brief Check whether a batch is running
+ */
+bool avr_async_busy(void);
+
+/**
+ * @brief Poll until the running batch (if any) has completed
+ *
+ * For the rare caller that must order a blocking operation after a
+ * submitted one.
+ */
+void avr_async_finish(void);
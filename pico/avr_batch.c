@@ -0,0 +1,178 @@
+/**
+ * @file avr_batch.c
+ * @brief ISP Instruction Batch Encoders and Runner
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "avr_batch.h"
+#include "avrprog.h"
+#include "metrics.h"
+#include <string.h>
+#include <pico/stdlib.h>
+
+/** Bytes handed to the transport per transfer */
+#define AVR_BATCH_STREAM_BYTES   256
+
+/*******************************************************************************
+ * Building
+ ******************************************************************************/
+
+/**
+ * @brief Empty the batch
+ */
+void avr_batch_clear(avr_batch_t *b) {
+    b->count = 0;
+}
+
+/**
+ * @brief Append one instruction
+ */
+bool avr_batch_add(avr_batch_t *b, uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3, uint8_t *result) {
+    if (b->count >= b->capacity) {
+        return false;
+    }
+    avr_batch_instr_t *in = &b->instr[b->count++];
+    in->op[0] = b0;
+    in->op[1] = b1;
+    in->op[2] = b2;
+    in->op[3] = b3;
+    in->wait = AVR_BATCH_NONE;
+    in->wait_us = 0;
+    in->result = result;
+    return true;
+}
+
+/**
+ * @brief Attach a wait to the last instruction
+ */
+void avr_batch_wait(avr_batch_t *b, uint8_t kind, uint32_t us) {
+    if (b->count) {
+        b->instr[b->count - 1].wait = kind;
+        b->instr[b->count - 1].wait_us = us;
+    }
+}
+
+/*******************************************************************************
+ * Encoders
+ ******************************************************************************/
+
+/**
+ * @brief Load len bytes (whole words) into the page buffer from word 0
+ *
+ * 0x40 (low byte) and 0x48 (high byte) per word.
+ */
+bool avr_batch_load_page(avr_batch_t *b, const uint8_t *data, size_t len) {
+    bool ok = true;
+    for (size_t j = 0; j < len / 2 && ok; j++) {
+        uint8_t hi = (uint8_t)(j >> 8);
+        uint8_t lo = (uint8_t)j;
+        ok = avr_batch_add(b, 0x40, hi, lo, data[j * 2], NULL) &&
+             avr_batch_add(b, 0x48, hi, lo, data[j * 2 + 1], NULL);
+    }
+    return ok;
+}
+
+/**
+ * @brief Write Program Memory Page (0x4C) for the page holding word_addr
+ */
+bool avr_batch_write_page(avr_batch_t *b, uint16_t word_addr) {
+    return avr_batch_add(b, 0x4C, (uint8_t)(word_addr >> 8), (uint8_t)word_addr, 0x00, NULL);
+}
+
+/**
+ * @brief Read len bytes of flash starting at byte address byte_addr
+ *
+ * 0x20 reads the low byte of a word, 0x28 the high byte.
+ */
+bool avr_batch_read_flash(avr_batch_t *b, uint32_t byte_addr, uint8_t *out, size_t len) {
+    bool ok = true;
+    for (size_t i = 0; i < len && ok; i++) {
+        uint32_t a = byte_addr + i;
+        uint16_t w = (uint16_t)(a / 2);
+        ok = avr_batch_add(b, (a & 1) ? 0x28 : 0x20, (uint8_t)(w >> 8), (uint8_t)w, 0x00, &out[i]);
+    }
+    return ok;
+}
+
+/**
+ * @brief Read the signature bytes into sig[0..2]
+ */
+bool avr_batch_read_signature(avr_batch_t *b, uint8_t sig[3]) {
+    return avr_batch_add(b, 0x30, 0x00, 0x00, 0x00, &sig[0]) &&
+           avr_batch_add(b, 0x30, 0x00, 0x01, 0x00, &sig[1]) &&
+           avr_batch_add(b, 0x30, 0x00, 0x02, 0x00, &sig[2]);
+}
+
+/**
+ * @brief Read low, high, extended fuse and lock bits into out[0..3]
+ */
+bool avr_batch_read_fuses(avr_batch_t *b, uint8_t out[4]) {
+    return avr_batch_add(b, 0x50, 0x00, 0x00, 0x00, &out[0]) &&
+           avr_batch_add(b, 0x58, 0x08, 0x00, 0x00, &out[1]) &&
+           avr_batch_add(b, 0x50, 0x08, 0x00, 0x00, &out[2]) &&
+           avr_batch_add(b, 0x58, 0x00, 0x00, 0x00, &out[3]);
+}
+
+/**
+ * @brief Chip erase (0xAC 0x80)
+ */
+bool avr_batch_chip_erase(avr_batch_t *b) {
+    return avr_batch_add(b, 0xAC, 0x80, 0x00, 0x00, NULL);
+}
+
+/*******************************************************************************
+ * Execution
+ ******************************************************************************/
+
+/**
+ * @brief Transfer one segment of the batch starting at instruction start
+ *
+ * Consecutive instructions are packed into one transfer until a wait
+ * marker or the stream buffer size ends the run. The wait of the last
+ * instruction is left to the caller.
+ */
+size_t avr_batch_run_segment(avr_batch_t *b, size_t start) {
+    static uint8_t tx[AVR_BATCH_STREAM_BYTES];
+    static uint8_t rx[AVR_BATCH_STREAM_BYTES];
+    size_t i = start;
+    size_t n = 0;
+
+    do {
+        memcpy(&tx[n * 4], b->instr[i].op, 4);
+        n++;
+    } while (b->instr[i++].wait == AVR_BATCH_NONE && i < b->count &&
+             n < AVR_BATCH_STREAM_BYTES / 4);
+
+    avr_spi_transfer(tx, rx, n * 4);
+    for (size_t k = 0; k < n; k++) {
+        if (b->instr[start + k].result) {
+            *b->instr[start + k].result = rx[k * 4 + 3];
+        }
+    }
+    return i;
+}
+
+/**
+ * @brief Execute the batch on the selected ISP transport and clear it
+ */
+bool avr_batch_run(avr_batch_t *b) {
+    bool ok = true;
+    size_t i = 0;
+
+    while (i < b->count) {
+        i = avr_batch_run_segment(b, i);
+
+        const avr_batch_instr_t *last = &b->instr[i - 1];
+        if (last->wait == AVR_BATCH_POLL) {
+            ok = avr_poll_ready(last->wait_us) && ok;
+        } else if (last->wait == AVR_BATCH_DELAY) {
+            sleep_us(last->wait_us);
+            metrics_add(METRIC_BUSY_US, last->wait_us);
+        }
+    }
+
+    b->count = 0;
+    return ok;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file avr_batch.h
+ * @brief ISP Instruction Batches
+ *
+ * A batch is a list of 4-byte ISP instructions, each with an optional
+ * result slot (the 4th response byte) and an optional wait after it:
+ *
+ *   - AVR_BATCH_POLL:  poll RDY/BSY, the time is the timeout
+ *   - AVR_BATCH_DELAY: fixed delay (parts without RDY/BSY polling)
+ *
+ * Runs of instructions without a wait go to the transport as one
+ * transfer, so hardware SPI keeps its FIFO busy and bit-bang streams
+ * without per-instruction call overhead. All ISP operations in avrprog.c
+ * are built from the encoders below.
+ *
+ * Usage:
+ *   AVR_BATCH_DEFINE(b, 8);
+ *   avr_batch_add(&b, 0xAC, 0x80, 0x00, 0x00, NULL);
+ *   avr_batch_wait(&b, AVR_BATCH_DELAY, 9000);
+ *   avr_batch_read_fuses(&b, fuses);
+ *   avr_batch_run(&b);
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+
+/** Wait kinds after an instruction */
+#define AVR_BATCH_NONE    0
+#define AVR_BATCH_POLL    1
+#define AVR_BATCH_DELAY   2
+
+/** Largest classic ISP page (256 bytes) as loads, plus write and RDY/BSY query */
+#define AVR_BATCH_PAGE_INSTR   (2 * 128 + 2)
+
+typedef struct {
+    uint8_t op[4];
+    uint8_t wait;         /**< AVR_BATCH_NONE / POLL / DELAY */
+    uint32_t wait_us;     /**< Poll timeout or delay */
+    uint8_t *result;      /**< Receives response byte 4, or NULL */
+} avr_batch_instr_t;
+
+typedef struct {
+    avr_batch_instr_t *instr;
+    size_t count;
+    size_t capacity;
+} avr_batch_t;
+
+/** Define a static batch with storage for cap instructions */
+#define AVR_BATCH_DEFINE(name, cap) \
+    static avr_batch_instr_t name##_instr[cap]; \
+    static avr_batch_t name = {name##_instr, 0, cap}
+
+/*******************************************************************************
+ * Building
+ ******************************************************************************/
+
+/**
+ * @brief Empty the batch
+ */
+void avr_batch_clear(avr_batch_t *b);
+
+/**
+ * @brief Append one instruction
+ *
+ * @param result Receives the 4th response byte (may be NULL)
+ * @return false if the batch is full
+ */
+bool avr_batch_add(avr_batch_t *b, uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3, uint8_t *result);
+
+/**
+ * @brief Attach a wait to the last instruction
+ */
+void avr_batch_wait(avr_batch_t *b, uint8_t kind, uint32_t us);
+
+/*******************************************************************************
+ * Encoders
+ ******************************************************************************/
+
+/**
+ * @brief Load len bytes (whole words) into the page buffer from word 0
+ */
+bool avr_batch_load_page(avr_batch_t *b, const uint8_t *data, size_t len);
+
+/**
+ * @brief Write Program Memory Page for the page holding word_addr
+ */
+bool avr_batch_write_page(avr_batch_t *b, uint16_t word_addr);
+
+/**
+ * @brief Read len bytes of flash starting at byte address byte_addr
+ */
+bool avr_batch_read_flash(avr_batch_t *b, uint32_t byte_addr, uint8_t *out, size_t len);
+
+/**
+ * @brief Read the signature bytes into sig[0..2]
+ */
+bool avr_batch_read_signature(avr_batch_t *b, uint8_t sig[3]);
+
+/**
+ * @brief Read low, high, extended fuse and lock bits into out[0..3]
+ */
+bool avr_batch_read_fuses(avr_batch_t *b, uint8_t out[4]);
+
+/**
+ * @brief Chip erase
+ */
+bool avr_batch_chip_erase(avr_batch_t *b);
+
+/*******************************************************************************
+ * Execution
+ ******************************************************************************/
+
+/**
+ * @brief Transfer the instructions from start up to the next wait
+ *
+ * Building block for avr_batch_run() and the non-blocking engine
+ * (avr_async.h); the wait itself is not performed.
+ *
+ * @param start Index of the first instruction (must be < count)
+ * @return Index after the last instruction transferred
+ */
+size_t avr_batch_run_segment(avr_batch_t *b, size_t start);
+
+/**
+ * @brief Execute the batch on the selected ISP transport and clear it
+ *
+ * Blocks for every wait; use avr_async_submit() to keep servicing USB.
+ *
+ * @return false if a poll ran into its timeout
+ */
+bool avr_batch_run(avr_batch_t *b);
@@ -19,24 +19,49 @@
 
 #include <stdint.h>
 
+/*******************************************************************************
+ * Device Capability Flags (avr_device_t.flags)
+ ******************************************************************************/
+#define AVR_DEV_ISP           0x0001  /**< Programmable over SPI (ISP) */
+#define AVR_DEV_TPI           0x0002  /**< Reduced-core tiny, Tiny Programming Interface */
+#define AVR_DEV_PDI           0x0004  /**< XMEGA Program and Debug Interface */
+#define AVR_DEV_UPDI          0x0008  /**< Unified Program and Debug Interface */
+#define AVR_DEV_DEBUGWIRE     0x0010  /**< debugWIRE on the RESET pin */
+#define AVR_DEV_HAS_EFUSE     0x0020  /**< Has an extended fuse byte */
+#define AVR_DEV_PAGED_EEPROM  0x0040  /**< EEPROM supports page writes over ISP */
+#define AVR_DEV_EXT_ADDR      0x0080  /**< Flash > 128 KB, needs Load Extended Address */
+
 /**
  * @brief AVR device information structure
  * 
  * Contains all device-specific parameters needed for programming.
  * The signature uniquely identifies each AVR chip model.
+ * 
+ * Entries are generated from avrdude.conf / ATDF data by
+ * gen_avr_devices.py; fields are ordered to avoid padding.
+ * Delays are the minimum write/erase times in microseconds
+ * (0 = unknown, poll RDY/BSY instead).
  */
 typedef struct {
     uint8_t signature[3];       /**< 3-byte device signature (from ISP cmd 0x30) */
+    uint8_t eeprom_page_bytes;  /**< EEPROM page size in bytes (0 = no EEPROM) */
+    uint8_t flash_poll;         /**< Value read back while a flash write is pending */
+    uint8_t eeprom_poll;        /**< Value read back while an EEPROM write is pending */
+    uint16_t page_size_bytes;   /**< Flash page size in bytes (for paged programming) */
+    uint16_t eeprom_size_bytes; /**< Total EEPROM size in bytes */
+    uint16_t flash_write_us;    /**< Flash page write time */
+    uint16_t eeprom_write_us;   /**< EEPROM byte/page write time */
+    uint16_t erase_us;          /**< Chip erase time */
+    uint16_t flags;             /**< AVR_DEV_* capability flags */
     const char *name;           /**< Human-readable device name (e.g., "ATmega328P") */
     uint32_t flash_size_bytes;  /**< Total flash memory size in bytes */
-    uint16_t page_size_bytes;   /**< Flash page size in bytes (for paged programming) */
 } avr_device_t;
 
 /**
  * @brief Look up device parameters by signature
  * 
- * Searches the internal device database for a matching signature
- * and returns the device profile if found.
+ * Constant-time lookup through the generated perfect hash; the full
+ * signature is compared before a profile is returned.
  * 
  * @param sig 3-byte device signature to look up
  * @return Pointer to device info structure, or NULL if not found
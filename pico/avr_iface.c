@@ -0,0 +1,151 @@
+/**
+ * @file avr_iface.c
+ * @brief Programming Interface Table and ISP Adapter
+ *
+ * Holds the table of available interfaces and adapts the classic ISP
+ * functions from avrprog.h to the avr_iface_t operations; page writes and
+ * reads go out as instruction batches (avr_batch.h).
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "avr_iface.h"
+#include "avrprog.h"
+#include "avr_batch.h"
+#include "avr_profile.h"
+#include "tpi.h"
+#include "updi.h"
+#include "pdi.h"
+#include "debugwire.h"
+
+/*******************************************************************************
+ * ISP Adapter
+ ******************************************************************************/
+
+AVR_BATCH_DEFINE(isp_ops, AVR_BATCH_PAGE_INSTR);
+AVR_BATCH_DEFINE(isp_async_ops, AVR_BATCH_PAGE_INSTR);
+
+/** RDY/BSY response read right after each page write */
+static uint8_t isp_busy_probe;
+
+/** Caller's completion for the queued page write */
+static avr_async_done_t isp_page_done;
+static void* isp_page_ctx;
+
+/**
+ * @brief Encode a page load and write, followed by one RDY/BSY query
+ *
+ * The query tells avr_profile.h whether polling works on this part; once
+ * it has, the wait polls instead of sleeping the full 5 ms.
+ */
+static void isp_encode_page(avr_batch_t* b, uint32_t byte_addr, const uint8_t* data, size_t len) {
+    avr_batch_load_page(b, data, len);
+    avr_batch_write_page(b, (uint16_t)(byte_addr / 2));
+    avr_batch_add(b, 0xF0, 0x00, 0x00, 0x00, &isp_busy_probe);
+    if (avr_profile_polling()) {
+        avr_batch_wait(b, AVR_BATCH_POLL, 5000);
+    } else {
+        avr_batch_wait(b, AVR_BATCH_DELAY, 5000);  /* Page write, 4.5ms minimum */
+    }
+}
+
+static void isp_note_probe(void) {
+    if (isp_busy_probe & 0x01) {
+        avr_profile_note_busy();
+    }
+}
+
+/**
+ * @brief Load the page buffer and write the page as one batch
+ */
+static void isp_write_flash_page(uint32_t byte_addr, const uint8_t* data, size_t len) {
+    isp_encode_page(&isp_ops, byte_addr, data, len);
+    avr_batch_run(&isp_ops);
+    isp_note_probe();
+}
+
+static void isp_page_complete(bool ok, void* ctx) {
+    (void)ctx;
+    isp_note_probe();
+    if (isp_page_done) {
+        isp_page_done(ok, isp_page_ctx);
+    }
+}
+
+/**
+ * @brief Queue the same page write on the non-blocking engine
+ *
+ * The data bytes are encoded into the batch, so the caller's buffer may
+ * be reused as soon as this returns.
+ */
+static bool isp_submit_flash_page(uint32_t byte_addr, const uint8_t* data, size_t len,
+                                  avr_async_done_t done, void* ctx) {
+    if (avr_async_busy()) {
+        return false;
+    }
+    isp_page_done = done;
+    isp_page_ctx = ctx;
+    isp_encode_page(&isp_async_ops, byte_addr, data, len);
+    return avr_async_submit(&isp_async_ops, isp_page_complete, NULL);
+}
+
+static void isp_read_flash(uint32_t byte_addr, uint8_t* out, size_t len) {
+    for (size_t off = 0; off < len; off += isp_ops.capacity) {
+        size_t n = len - off < isp_ops.capacity ? len - off : isp_ops.capacity;
+        avr_batch_read_flash(&isp_ops, byte_addr + off, out + off, n);
+        avr_batch_run(&isp_ops);
+    }
+}
+
+static const avr_iface_t avr_iface_isp = {
+    .name = "ISP",
+    .enter = avr_enter_programming_mode,
+    .leave = avr_leave_programming_mode,
+    .universal = avr_universal,
+    .poll_ready = avr_poll_ready,
+    .chip_erase = avr_erase_memory,
+    .write_flash_page = isp_write_flash_page,
+    .read_flash = isp_read_flash,
+    .submit_chip_erase = avr_erase_memory_submit,
+    .submit_flash_page = isp_submit_flash_page,
+};
+
+/*******************************************************************************
+ * Interface Table
+ ******************************************************************************/
+
+static const avr_iface_t* const ifaces[] = {
+    [AVR_IFACE_ISP] = &avr_iface_isp,
+    [AVR_IFACE_TPI] = &avr_iface_tpi,
+    [AVR_IFACE_UPDI] = &avr_iface_updi,
+    [AVR_IFACE_PDI] = &avr_iface_pdi,
+    [AVR_IFACE_DW] = &avr_iface_dw,
+};
+
+static uint8_t selected = AVR_IFACE_ISP;
+
+/**
+ * @brief Select the interface used by subsequent operations
+ */
+bool avr_iface_select(uint8_t id) {
+    if (id >= sizeof(ifaces) / sizeof(ifaces[0]) || !ifaces[id]) {
+        return false;
+    }
+    selected = id;
+    return true;
+}
+
+/**
+ * @brief Get the identifier of the selected interface
+ */
+uint8_t avr_iface_selected(void) {
+    return selected;
+}
+
+/**
+ * @brief Get the operations of the selected interface
+ */
+const avr_iface_t* avr_iface(void) {
+    return ifaces[selected];
+}
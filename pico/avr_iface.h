@@ -0,0 +1,107 @@
+/**
+ * @file avr_iface.h
+ * @brief Programming Interface Selection (ISP, TPI, ...)
+ *
+ * The STK500v1 front end talks to the target through one of several
+ * programming interfaces. Each interface provides the same small set of
+ * operations; the protocol handler calls them through the currently
+ * selected entry and never touches interface-specific code.
+ *
+ * Interfaces:
+ *   - AVR_IFACE_ISP: Classic 4-byte SPI serial programming (avrprog.h)
+ *   - AVR_IFACE_TPI: Tiny Programming Interface for ATtiny4/5/9/10 (tpi.h)
+ *   - AVR_IFACE_UPDI: tinyAVR 0/1/2 and megaAVR 0 over UART1 (updi.h)
+ *   - AVR_IFACE_PDI: ATxmega parts, PIO-clocked (pdi.h)
+ *   - AVR_IFACE_DW: debugWIRE on RESET for DWEN-fused parts (debugwire.h)
+ *
+ * Selection:
+ *   The host selects an interface with SET_PARAMETER Parm_VND_INTERFACE
+ *   before ENTER_PROGMODE. ISP is the default, so plain avrdude sessions
+ *   are unaffected.
+ *
+ * Raw Instructions:
+ *   universal() takes classic ISP instructions. Non-ISP interfaces
+ *   translate the ones with an equivalent (signature, fuse, lock and
+ *   calibration reads, fuse/lock writes, chip erase) and return 0 for the
+ *   rest, so the target cache and avrdude's fuse handling keep working.
+ *
+ * Non-blocking Operations:
+ *   An interface may also provide submit_* variants of chip erase and
+ *   page write that return once the work is queued on the engine in
+ *   avr_async.h. Entries left NULL fall back to the blocking operation.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "avr_async.h"
+
+/*******************************************************************************
+ * Interface Identifiers (values of Parm_VND_INTERFACE)
+ ******************************************************************************/
+#define AVR_IFACE_ISP   0x00
+#define AVR_IFACE_TPI   0x01
+#define AVR_IFACE_UPDI  0x02
+#define AVR_IFACE_PDI   0x03
+#define AVR_IFACE_DW    0x04
+
+/**
+ * @brief Operations implemented by every programming interface
+ *
+ * Flash addresses are byte offsets from the start of program memory;
+ * each interface maps them onto its own address space.
+ */
+typedef struct {
+    const char *name;
+
+    /** Connect to the target and enable NVM programming */
+    bool (*enter)(void);
+
+    /** Disable programming and release the target */
+    void (*leave)(void);
+
+    /** Execute (or emulate) one 4-byte ISP instruction */
+    void (*universal)(const uint8_t cmd[4], uint8_t rx[4]);
+
+    /** Wait until a pending NVM write has finished */
+    bool (*poll_ready)(uint32_t timeout_us);
+
+    /** Erase flash (and lock bits) */
+    void (*chip_erase)(void);
+
+    /** Program one flash page; len is a whole number of words */
+    void (*write_flash_page)(uint32_t byte_addr, const uint8_t* data, size_t len);
+
+    /** Read len bytes of flash */
+    void (*read_flash)(uint32_t byte_addr, uint8_t* out, size_t len);
+
+    /** Optional: queue a chip erase, false if the engine is busy */
+    bool (*submit_chip_erase)(avr_async_done_t done, void* ctx);
+
+    /** Optional: queue a page write (data is copied), false if busy */
+    bool (*submit_flash_page)(uint32_t byte_addr, const uint8_t* data, size_t len,
+                              avr_async_done_t done, void* ctx);
+} avr_iface_t;
+
+/**
+ * @brief Select the interface used by subsequent operations
+ *
+ * @param id AVR_IFACE_* identifier
+ * @return false if the identifier is unknown (selection unchanged)
+ */
+bool avr_iface_select(uint8_t id);
+
+/**
+ * @brief Get the identifier of the selected interface
+ */
+uint8_t avr_iface_selected(void);
+
+/**
+ * @brief Get the operations of the selected interface
+ */
+const avr_iface_t* avr_iface(void);
@@ -0,0 +1,197 @@
+/**
+ * @file avr_profile.c
+ * @brief Per-signature ISP Speed Profiles Learned Across Sessions
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "avr_profile.h"
+#include "avrprog.h"
+#include "flash_store.h"
+#include "target_clock.h"
+#include <string.h>
+
+/*******************************************************************************
+ * Rates
+ ******************************************************************************/
+
+/** SCK rates tried when probing, slowest first */
+static const uint32_t ladder[] = {
+    50000, 125000, 250000, 500000, 1000000, 2000000, 4000000,
+};
+
+#define LADDER_STEPS (sizeof(ladder) / sizeof(ladder[0]))
+
+/** Next ladder rate below hz (the slowest rate if none) */
+static uint32_t step_below(uint32_t hz) {
+    uint32_t below = ladder[0];
+    for (size_t i = 0; i < LADDER_STEPS && ladder[i] < hz; i++) {
+        below = ladder[i];
+    }
+    return below;
+}
+
+/*******************************************************************************
+ * Session State
+ ******************************************************************************/
+
+static uint32_t clock_hz;   /* Slowest target clock the host states, 0 = off */
+static bool active;         /* A profile session is open */
+static uint32_t key;        /* Store key: 0x00 sig0 sig1 sig2 */
+static uint32_t rate_hz;    /* Rate in use */
+static uint8_t flags;       /* Learned flags (AVR_PROFILE_*) */
+static bool busy_seen;      /* RDY/BSY reported busy this session */
+
+static void store(uint32_t hz, uint8_t f) {
+    uint8_t data[FLASH_STORE_DATA_BYTES];
+    memset(data, 0xFF, sizeof(data));
+    data[0] = (uint8_t)hz;
+    data[1] = (uint8_t)(hz >> 8);
+    data[2] = (uint8_t)(hz >> 16);
+    data[3] = (uint8_t)(hz >> 24);
+    data[4] = f;
+    flash_store_put(key, data);
+}
+
+/** Switch to hz and check that the signature still reads correctly */
+static bool signature_stable(uint32_t hz, const uint8_t sig[3]) {
+    uint8_t check[3];
+    avr_set_sck_frequency(hz);
+    avr_read_signature(check);
+    return memcmp(check, sig, 3) == 0;
+}
+
+/**
+ * @brief Find the fastest rate that reads the signature, with one step margin
+ *
+ * A misread can shift the target's bit alignment, so programming mode is
+ * entered again at the chosen rate afterwards.
+ */
+static uint32_t probe(uint32_t base_hz, uint32_t limit_hz, const uint8_t sig[3]) {
+    uint32_t best = base_hz;
+    bool misread = false;
+
+    for (size_t i = 0; i < LADDER_STEPS && ladder[i] <= limit_hz; i++) {
+        if (ladder[i] <= base_hz) {
+            continue;
+        }
+        if (!signature_stable(ladder[i], sig)) {
+            misread = true;
+            break;
+        }
+        best = ladder[i];
+    }
+
+    if (misread) {
+        if (best > base_hz && step_below(best) > base_hz) {
+            best = step_below(best);
+        } else {
+            best = base_hz;
+        }
+        avr_set_sck_frequency(best);
+        if (!avr_enter_programming_mode() || !signature_stable(best, sig)) {
+            best = base_hz;
+            avr_set_sck_frequency(best);
+            avr_enter_programming_mode();
+        }
+    }
+    return best;
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/**
+ * @brief Open the record store
+ */
+void avr_profile_init(void) {
+    flash_store_init();
+}
+
+/**
+ * @brief Set the slowest target clock rates may be learned for
+ */
+void avr_profile_set_clock_hz(uint32_t hz) {
+    clock_hz = hz;
+}
+
+/**
+ * @brief Get the clock set by avr_profile_set_clock_hz() (0 = off)
+ */
+uint32_t avr_profile_clock_hz(void) {
+    return clock_hz;
+}
+
+/**
+ * @brief Apply the learned (or probed) SCK rate for a target
+ */
+uint32_t avr_profile_begin(const uint8_t sig[3]) {
+    uint32_t base_hz = avr_get_sck_frequency();
+    uint32_t limit_hz = clock_hz ? target_clock_isp_rate(clock_hz, 0) : base_hz;
+    uint8_t data[FLASH_STORE_DATA_BYTES];
+
+    active = false;
+    busy_seen = false;
+    flags = 0;
+
+    /* No target answering (all 0x00 or 0xFF): nothing to learn */
+    if ((sig[0] == 0x00 && sig[1] == 0x00 && sig[2] == 0x00) ||
+        (sig[0] == 0xFF && sig[1] == 0xFF && sig[2] == 0xFF)) {
+        return base_hz;
+    }
+
+    active = true;
+    key = (uint32_t)sig[0] << 16 | (uint32_t)sig[1] << 8 | sig[2];
+
+    if (flash_store_get(key, data)) {
+        uint32_t learned = (uint32_t)data[0] | (uint32_t)data[1] << 8 |
+                           (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+        if (learned > limit_hz) {
+            learned = limit_hz;
+        }
+        if (learned <= base_hz || signature_stable(learned, sig)) {
+            rate_hz = learned > base_hz ? learned : base_hz;
+            flags = data[4];
+        } else {
+            /* Learned rate no longer works (different board or clock) */
+            rate_hz = base_hz;
+            store(step_below(learned), 0);
+            avr_set_sck_frequency(base_hz);
+            avr_enter_programming_mode();
+        }
+    } else {
+        rate_hz = probe(base_hz, limit_hz, sig);
+    }
+    return rate_hz;
+}
+
+/**
+ * @brief Check whether page writes may poll RDY/BSY this session
+ */
+bool avr_profile_polling(void) {
+    return active && (flags & AVR_PROFILE_POLL);
+}
+
+/**
+ * @brief Report a RDY/BSY query that returned busy after a page write
+ */
+void avr_profile_note_busy(void) {
+    busy_seen = true;
+}
+
+/**
+ * @brief Close the session and persist what was learned
+ */
+void avr_profile_end(bool ok) {
+    if (!active) {
+        return;
+    }
+    active = false;
+    if (ok) {
+        store(rate_hz, (uint8_t)(flags | (busy_seen ? AVR_PROFILE_POLL : 0)));
+    } else {
+        store(step_below(rate_hz), 0);
+    }
+}
@@ -0,0 +1,92 @@
+/**
+ * @file avr_profile.h
+ * @brief Per-signature ISP Speed Profiles Learned Across Sessions
+ *
+ * Every ISP session used to start at 50 kHz, even for a board that has
+ * been programmed at MHz rates many times. A profile remembers, per
+ * device signature, the last SCK rate a session completed at without a
+ * failed write, and whether RDY/BSY polling was seen to work. Profiles
+ * live in the flash record store (flash_store.h).
+ *
+ * Session Flow (ISP only, when the host set neither SCK_DURATION nor a
+ * target clock):
+ *   1. After ENTER_PROGMODE the signature is read at the base rate
+ *   2. Known signature: switch to the learned rate and re-read the
+ *      signature; on mismatch fall back to the base rate and store the
+ *      next slower step
+ *   3. Unknown signature: probe up a ladder of rates, one signature read
+ *      per step, and keep one step below the first rate that misreads
+ *   4. LEAVE_PROGMODE: a clean session stores the rate (and the polling
+ *      flag), a failed one stores the next slower step
+ *
+ * Rate Limit:
+ *   A signature read can succeed at a rate the datasheet does not allow
+ *   for the target's clock, and writes then fail. Rates above the base
+ *   rate are therefore only probed and used once the host states the
+ *   slowest clock its targets run at (avr_profile_set_clock_hz()), and
+ *   never above the SCK limit for that clock (target_clock_isp_rate()).
+ *   Off by default: sessions stay at the base rate and only the polling
+ *   flag is learned.
+ *
+ * Polling:
+ *   Page writes are followed by one RDY/BSY query. If it ever reports
+ *   busy, polling works on this part and later sessions poll instead of
+ *   waiting the fixed 5 ms.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Profile flag: RDY/BSY polling reported busy after a page write */
+#define AVR_PROFILE_POLL   0x01
+
+/**
+ * @brief Open the record store
+ *
+ * Call once at startup.
+ */
+void avr_profile_init(void);
+
+/**
+ * @brief Set the slowest target clock rates may be learned for
+ *
+ * @param hz Target clock in Hz, 0 to stay at the base rate (default)
+ */
+void avr_profile_set_clock_hz(uint32_t hz);
+
+/**
+ * @brief Get the clock set by avr_profile_set_clock_hz() (0 = off)
+ */
+uint32_t avr_profile_clock_hz(void);
+
+/**
+ * @brief Apply the learned (or probed) SCK rate for a target
+ *
+ * Call in programming mode, with the signature read at the current rate.
+ *
+ * @param sig Signature bytes of the target
+ * @return SCK rate in use for the rest of the session
+ */
+uint32_t avr_profile_begin(const uint8_t sig[3]);
+
+/**
+ * @brief Check whether page writes may poll RDY/BSY this session
+ */
+bool avr_profile_polling(void);
+
+/**
+ * @brief Report a RDY/BSY query that returned busy after a page write
+ */
+void avr_profile_note_busy(void);
+
+/**
+ * @brief Close the session and persist what was learned
+ *
+ * @param ok false if a write failed during the session
+ */
+void avr_profile_end(bool ok);
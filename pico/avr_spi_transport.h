@@ -0,0 +1,78 @@
+/**
+ * @file avr_spi_transport.h
+ * @brief ISP Transport Selection (Hardware SPI, Bit-bang)
+ *
+ * The ISP command layer (avrprog.c) sends 4-byte instructions through a
+ * transport. All transports are linked in and the host picks one per
+ * session, so trying bit-bang on an awkward target needs no reflash.
+ *
+ * Transports:
+ *   - AVR_SPI_HW: RP2040 SPI0 peripheral (avrprog_hwspi.h)
+ *   - AVR_SPI_BITBANG: SIO bit-bang on any pins (avrprog_bitbang.h)
+ *
+ * Selection:
+ *   SET_PARAMETER Parm_VND_SPI_BACKEND outside programming mode. The
+ *   power-up default is hardware SPI, or bit-bang when built with
+ *   -DUSE_BITBANG_SPI=ON.
+ *
+ * Dispatch Cost:
+ *   Operations take whole buffers, so the indirect call happens once per
+ *   instruction or batch; the per-byte loops stay inside each transport.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*******************************************************************************
+ * Transport Identifiers (values of Parm_VND_SPI_BACKEND)
+ ******************************************************************************/
+#define AVR_SPI_HW        0x00
+#define AVR_SPI_BITBANG   0x01
+
+#ifdef USE_BITBANG_SPI
+#define AVR_SPI_DEFAULT   AVR_SPI_BITBANG
+#else
+#define AVR_SPI_DEFAULT   AVR_SPI_HW
+#endif
+
+/**
+ * @brief Operations implemented by every ISP transport
+ */
+typedef struct {
+    const char *name;
+
+    /** Claim the pins: SCK/MOSI low, MISO input, RESET high, default rate */
+    void (*init)(void);
+
+    /** Full-duplex transfer of len bytes (rx may equal tx) */
+    void (*transfer)(const uint8_t *tx, uint8_t *rx, size_t len);
+
+    /** Drive RESET (false = target held in reset) */
+    void (*set_reset)(bool level);
+
+    /** Set SCK to the nearest rate not above hz */
+    void (*set_sck_hz)(uint32_t hz);
+
+    /** Drive one positive SCK pulse of high_us outside a transfer
+     *  (Programming Enable resync: shifts the target's bit alignment) */
+    void (*pulse_sck)(uint32_t high_us);
+} avr_spi_transport_t;
+
+/**
+ * @brief Select and initialize the transport used by avrprog.c
+ *
+ * @param id AVR_SPI_* identifier
+ * @return false if the identifier is unknown (selection unchanged)
+ */
+bool avr_spi_select(uint8_t id);
+
+/**
+ * @brief Get the identifier of the selected transport
+ */
+uint8_t avr_spi_selected(void);
@@ -15,6 +15,9 @@
  * 4-byte SPI transactions for all commands. The protocol runs over SPI Mode 0
  * (CPOL=0, CPHA=0) with the target held in reset during programming.
  * 
+ * The bytes go out through the selected transport (avr_spi_transport.h):
+ * hardware SPI0 or bit-bang, switchable at runtime.
+ * 
  * Reference: Atmel AVR ISP Programming Specification
  * 
  * @author MUdroThe1
@@ -22,25 +25,52 @@
  */
 
 #include "avrprog.h"
+#include "avr_batch.h"
+#include "avrprog_hwspi.h"
+#include "avrprog_bitbang.h"
+#include "debugwire.h"
+#include "metrics.h"
+#include "trace.h"
 #include <stdint.h>
+#include <string.h>
 #include <pico/stdlib.h>
-#include <hardware/spi.h>
 #include <stdio.h>
 
 /*******************************************************************************
- * GPIO Pin Definitions for AVR ISP Interface
- * 
- * These pins connect the Pico to the AVR target's ISP header.
- * Standard 6-pin ISP header pinout:
- *   Pin 1: MISO    Pin 2: VCC
- *   Pin 3: SCK     Pin 4: MOSI
- *   Pin 5: RESET   Pin 6: GND
+ * Transport Selection
  ******************************************************************************/
-#define mosi_pin 19     /* Master Out Slave In - data from Pico to AVR */
-#define sck_pin 18      /* Serial Clock - generated by Pico (master) */
-#define miso_pin 16     /* Master In Slave Out - data from AVR to Pico */
-#define reset_pin 17    /* Active-low reset line to hold AVR in programming mode */
-#define power_pin 0     /* Optional power control for target (not currently used) */
+
+static const avr_spi_transport_t* const transports[] = {
+    [AVR_SPI_HW] = &avr_spi_transport_hw,
+    [AVR_SPI_BITBANG] = &avr_spi_transport_bitbang,
+};
+
+static uint8_t transport_id = AVR_SPI_DEFAULT;
+static const avr_spi_transport_t* transport = transports[AVR_SPI_DEFAULT];
+
+/** Current SCK request; every transport's init() starts at 50kHz */
+static uint32_t sck_hz = 50000;
+
+/**
+ * @brief Select and initialize the transport used for ISP
+ */
+bool avr_spi_select(uint8_t id) {
+    if (id >= sizeof(transports) / sizeof(transports[0]) || !transports[id]) {
+        return false;
+    }
+    transport_id = id;
+    transport = transports[id];
+    transport->init();
+    sck_hz = 50000;
+    return true;
+}
+
+/**
+ * @brief Get the identifier of the selected transport
+ */
+uint8_t avr_spi_selected(void) {
+    return transport_id;
+}
 
 /**
  * @brief SPI transaction output buffer
@@ -50,6 +80,23 @@
  */
 uint8_t output_buffer[4] = {0,0,0,0};
 
+/**
+ * @brief Instruction batch shared by the operations below
+ * 
+ * Sized for a full 256-byte page load plus the page write.
+ */
+AVR_BATCH_DEFINE(ops, AVR_BATCH_PAGE_INSTR);
+
+/**
+ * @brief Full-duplex transfer on the selected transport
+ */
+void avr_spi_transfer(const uint8_t *tx, uint8_t *rx, size_t len) {
+    trace(TRACE_ISP_BEGIN, 0, (uint16_t)(len / 4));
+    transport->transfer(tx, rx, len);
+    trace(TRACE_ISP_END, 0, (uint16_t)(len / 4));
+    metrics_add(METRIC_ISP_INSTR, (uint32_t)(len / 4));
+}
+
 
 /**
  * @brief Read the 3-byte device signature from the AVR
@@ -73,45 +120,105 @@ uint8_t output_buffer[4] = {0,0,0,0};
  * @param signature Pointer to a 3-byte buffer to store the signature
  */
 void avr_read_signature(uint8_t *signature) {
-    for (int i = 0; i < 3; i++) {
-        uint8_t cmd[4] = {0x30, 0x00, (uint8_t)i, 0x00};
-        spi_write_read_blocking(spi0, cmd, output_buffer, 4);
-        signature[i] = output_buffer[3];
+    avr_batch_read_signature(&ops, signature);
+    avr_batch_run(&ops);
+}
+
+/**
+ * @brief Execute one raw 4-byte ISP instruction
+ * 
+ * @param cmd 4 instruction bytes to send
+ * @param rx  Buffer receiving the 4 bytes clocked back from the target
+ */
+void avr_universal(const uint8_t cmd[4], uint8_t rx[4]) {
+    avr_spi_transfer(cmd, rx, 4);
+}
+
+/**
+ * @brief Poll RDY/BSY until the target finishes an internal write
+ * 
+ * Poll RDY/BSY Command: 0xF0 0x00 0x00 0x00
+ *   - Bit 0 of response byte 3 is 1 while a write is in progress
+ * 
+ * @param timeout_us Maximum time to wait in microseconds
+ * @return true if the target reported ready before the timeout
+ */
+bool avr_poll_ready(uint32_t timeout_us) {
+    uint8_t cmd[4] = {0xF0, 0x00, 0x00, 0x00};
+    absolute_time_t deadline = make_timeout_time_us(timeout_us);
+    uint64_t start = time_us_64();
+    bool ready = false;
+    do {
+        avr_spi_transfer(cmd, output_buffer, 4);
+        trace(TRACE_POLL, output_buffer[3] & 0x01, 0);
+        if ((output_buffer[3] & 0x01) == 0) {
+            ready = true;
+            break;
+        }
+    } while (!time_reached(deadline));
+    if (timeout_us) {
+        /* Single queries are timed by the async engine instead */
+        metrics_add(METRIC_BUSY_US, (uint32_t)(time_us_64() - start));
     }
+    return ready;
 }
 
 /**
  * @brief Initialize the SPI interface for AVR ISP communication
  * 
- * This function configures the RP2040's SPI0 peripheral and associated GPIO
- * pins for communication with an AVR target in ISP mode.
+ * Hands the ISP pins to the selected transport, which starts at a
+ * conservative 50kHz SCK. That rate supports AVR targets running with
+ * the CKDIV8 fuse set (1MHz internal clock / 8 = 125kHz); ISP clock should
+ * be less than 1/4 of the target's system clock.
+ */
+void avr_spi_init() {
+    transport->init();
+    sck_hz = 50000;
+}
+
+/**
+ * @brief Set the ISP clock (SCK) frequency
  * 
- * SPI Configuration:
- *   - Frequency: 50kHz (conservative to support slow-clocked AVRs)
- *   - Mode 0: CPOL=0 (clock idle low), CPHA=0 (sample on rising edge)
- *   - Data order: MSB first (standard for AVR ISP)
- *   - Data bits: 8
+ * The transport picks the nearest rate not above the request.
+ */
+void avr_set_sck_frequency(uint32_t hz) {
+    transport->set_sck_hz(hz);
+    sck_hz = hz;
+}
+
+/**
+ * @brief Get the SCK frequency last requested
+ */
+uint32_t avr_get_sck_frequency(void) {
+    return sck_hz;
+}
+
+/**
+ * @brief Measure ISP instruction throughput at one SCK rate
  * 
- * Note: The SPI frequency is intentionally kept low (50kHz) to support AVR
- * targets running with the CKDIV8 fuse set (1MHz internal clock / 8 = 125kHz).
- * ISP clock should be less than 1/4 of the target's system clock.
+ * Streams AVR_SPI_BENCH_INSTR all-zero instructions in 256-byte
+ * transfers, the way a page load goes out. MOSI stays low the whole
+ * time, so a target that misreads the clock still sees no valid
+ * instruction; RESET is held low for the run and released afterwards.
+ * The previous SCK rate is restored.
  */
-void avr_spi_init() {
-    /* Configure RESET pin as output, initially high (target not in reset) */
-    gpio_init(reset_pin);
-    gpio_set_dir(reset_pin, GPIO_OUT);
-    gpio_put(reset_pin, 1);  /* High = target running normally */
+uint32_t avr_spi_benchmark(uint32_t hz) {
+    static uint8_t buf[256];
+    uint32_t saved_hz = sck_hz;
 
-    /* Configure SPI pins for hardware SPI0 peripheral */
-    gpio_set_function(mosi_pin, GPIO_FUNC_SPI);  /* SPI0 TX */
-    gpio_set_function(sck_pin, GPIO_FUNC_SPI);   /* SPI0 SCK */
-    gpio_set_function(miso_pin, GPIO_FUNC_SPI);  /* SPI0 RX */
+    transport->set_reset(false);
+    transport->set_sck_hz(hz);
 
-    /* Initialize SPI0 at 50kHz - slow enough for AVRs with CKDIV8 fuse */
-    spi_init(spi0, 50000);
+    uint64_t start = time_us_64();
+    for (size_t n = 0; n < AVR_SPI_BENCH_INSTR * 4; n += sizeof(buf)) {
+        memset(buf, 0, sizeof(buf));
+        transport->transfer(buf, buf, sizeof(buf));
+    }
+    uint64_t elapsed = time_us_64() - start;
 
-    /* Configure SPI Mode 0 as required by AVR ISP protocol */
-    spi_set_format(spi0, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    transport->set_sck_hz(saved_hz);
+    transport->set_reset(true);
+    return elapsed ? (uint32_t)((uint64_t)AVR_SPI_BENCH_INSTR * 1000000u / elapsed) : 0;
 }
 
 /**
@@ -126,12 +233,36 @@ void avr_spi_init() {
  *   - RESET released high for 20ms before returning
  */
 void avr_reset() {
-    gpio_put(reset_pin, 0);   /* Assert reset (active low) */
+    transport->set_reset(false);   /* Assert reset (active low) */
     sleep_ms(20);             /* Hold reset for 20ms */
-    gpio_put(reset_pin, 1);   /* Release reset */
+    transport->set_reset(true);   /* Release reset */
     sleep_ms(20);             /* Wait for target to stabilize */
 }
 
+/**
+ * @brief Settle time before Programming Enable, per attempt
+ * 
+ * The first attempt waits the datasheet's 20ms after RESET goes low: the
+ * target was running (or only just powered) and ignores the instruction
+ * any earlier. Resyncs keep RESET pulses short, so the target stays
+ * settled and the first retries only wait AVR_ENTRY_SETTLE_SCK clock
+ * periods; later ones back off again for a target that is still
+ * powering up.
+ */
+static const uint32_t entry_settle_us[AVR_ENTRY_MAX_ATTEMPTS] = {
+    20000, 0, 0, 1000, 2000, 5000, 10000, 20000,
+};
+
+/** Timing of the last Programming Enable sequence */
+static avr_entry_log_t entry_log;
+
+/** RESET positive pulse, then back into reset */
+static void reset_pulse(uint32_t high_us) {
+    transport->set_reset(true);
+    busy_wait_us_32(high_us);
+    transport->set_reset(false);
+}
+
 /**
  * @brief Enter AVR Serial Programming mode
  * 
@@ -148,38 +279,107 @@ void avr_reset() {
  * Expected Response:
  *   - Byte 2 should echo 0x53 if successful
  * 
- * The function retries up to 8 times before giving up, as per datasheet
- * recommendation: "If the 0x53 did not echo back, give RESET a positive
- * pulse and issue a new Programming Enable command."
+ * Timing is derived from the current SCK rate. SCK may be at most 1/4 of
+ * the target clock, so one SCK period covers the datasheet's minimum
+ * RESET pulse of 2 target clocks with margin. Between attempts the
+ * datasheet resyncs are alternated: a positive SCK pulse (older parts,
+ * shifts the bit alignment by one) and a positive RESET pulse. Each
+ * attempt is recorded in the entry log (avr_entry_log()).
  * 
  * @return true if programming mode was entered successfully, false otherwise
  */
-bool avr_enter_programming_mode() {
-    /* Ensure RESET starts high, then pull low to enter programming mode */
-    gpio_put(reset_pin, 1);
-    sleep_ms(2);
-    gpio_put(reset_pin, 0);  /* Hold target in reset for programming */
-
-    /* Programming Enable command with signature 0x53 */
+static bool programming_enable() {
+    uint32_t period_us = (1000000u + sck_hz - 1u) / sck_hz;
+    uint32_t min_settle_us = AVR_ENTRY_SETTLE_SCK * period_us;
     uint8_t cmd[4] = {0xAC, 0x53, 0x00, 0x00};
-    
-    /* Retry up to 8 times - target may need time to synchronize */
-    for (int attempt = 0; attempt < 8; attempt++) {
-        spi_write_read_blocking(spi0, cmd, output_buffer, 4);
-        
+    uint64_t start = time_us_64();
+
+    /* SCK is low: a RESET pulse puts the target into a known state */
+    entry_log.attempts = 0;
+    reset_pulse(period_us);
+
+    for (uint8_t i = 0; i < AVR_ENTRY_MAX_ATTEMPTS; i++) {
+        avr_entry_attempt_t *a = &entry_log.attempt[i];
+        uint64_t t0 = time_us_64();
+
+        if (i == 0) {
+            a->resync = AVR_ENTRY_RESYNC_NONE;
+        } else if (i & 1) {
+            transport->pulse_sck(period_us);
+            a->resync = AVR_ENTRY_RESYNC_SCK;
+        } else {
+            reset_pulse(period_us);
+            a->resync = AVR_ENTRY_RESYNC_RESET;
+        }
+
+        a->settle_us = entry_settle_us[i] > min_settle_us ? entry_settle_us[i] : min_settle_us;
+        sleep_us(a->settle_us);
+        avr_spi_transfer(cmd, output_buffer, 4);
+
+        a->echo = output_buffer[2];
+        a->elapsed_us = (uint32_t)(time_us_64() - t0);
+        entry_log.attempts = i + 1;
+
         /* Success: target echoes 0x53 in third response byte */
         if (output_buffer[2] == 0x53) {
+            entry_log.total_us = (uint32_t)(time_us_64() - start);
+            entry_log.ok = true;
+            metrics_add(METRIC_RETRIES, i);
             return true;
         }
-        sleep_ms(10);  /* Wait before retry */
     }
 
     /* Failed to enter programming mode - release reset and return failure */
-    gpio_put(reset_pin, 1);
-    sleep_ms(2);
+    transport->set_reset(true);
+    entry_log.total_us = (uint32_t)(time_us_64() - start);
+    entry_log.ok = false;
+    metrics_add(METRIC_RETRIES, AVR_ENTRY_MAX_ATTEMPTS - 1);
     return false;
 }
 
+/**
+ * @brief Get the timing of the last Programming Enable sequence
+ */
+const avr_entry_log_t* avr_entry_log(void) {
+    return &entry_log;
+}
+
+/** Off by default: a break on RESET is wrong for parts that are not dW */
+static bool dw_fallback = false;
+
+/**
+ * @brief Enable or disable the debugWIRE fallback of ISP entry
+ */
+void avr_dw_fallback_enable(bool enable) {
+    dw_fallback = enable;
+}
+
+/**
+ * @brief Check whether failed ISP entries fall back to debugWIRE
+ */
+bool avr_dw_fallback_enabled(void) {
+    return dw_fallback;
+}
+
+/**
+ * @brief Enter AVR Serial Programming mode
+ * 
+ * With the debugWIRE fallback enabled, a target that does not answer may
+ * have debugWIRE enabled; it is then told to disable dW for this power
+ * cycle and Programming Enable is retried.
+ * 
+ * @return true if programming mode was entered successfully, false otherwise
+ */
+bool avr_enter_programming_mode() {
+    if (programming_enable()) {
+        return true;
+    }
+
+    /* With DWEN programmed RESET is the debugWIRE line and ignores ISP:
+       switch dW off until the next power cycle and try once more */
+    return dw_fallback && dw_disable() && programming_enable();
+}
+
 /**
  * @brief Exit AVR Serial Programming mode
  * 
@@ -188,7 +388,7 @@ bool avr_enter_programming_mode() {
  * start running its programmed firmware after RESET is released.
  */
 void avr_leave_programming_mode() {
-    gpio_put(reset_pin, 1);  /* Release reset - target starts running */
+    transport->set_reset(true);  /* Release reset - target starts running */
     sleep_ms(2);             /* Brief delay for target stabilization */
 }
 
@@ -221,22 +421,41 @@ int erase_c = 0;
  * 
  * Post-erase delay: 9ms minimum (as specified in AVR datasheets)
  */
-void avr_erase_memory() {
+static void erase_guard(void) {
     /* Safety check: prevent infinite erase loops from wearing out flash */
     if (erase_c > 200) {
         printf("the erase operation has been performed more than 200 times in this session!\n"
                "to protect the flash from a potential infinite erase loop the program has been halted\n");
         while (true) sleep_ms(100);  /* Halt execution */
     }
+    erase_c++;  /* Track erase count for safety */
+}
 
-    /* Send Chip Erase command */
-    uint8_t cmd[4] = {0xAC, 0x80, 0x00, 0x00};
-    spi_write_read_blocking(spi0, cmd, output_buffer, 4);
-    
-    /* Wait for erase to complete - minimum 9ms per datasheet */
-    sleep_ms(9);
+void avr_erase_memory() {
+    erase_guard();
 
-    erase_c++;  /* Track erase count for safety */
+    /* Chip Erase, then wait for it to complete - minimum 9ms per datasheet */
+    avr_batch_chip_erase(&ops);
+    avr_batch_wait(&ops, AVR_BATCH_DELAY, 9000);
+    avr_batch_run(&ops);
+}
+
+/**
+ * @brief Queue a Chip Erase on the non-blocking engine
+ *
+ * Same instruction, delay and erase limit as avr_erase_memory(); done
+ * runs once the 9ms have passed.
+ */
+bool avr_erase_memory_submit(avr_async_done_t done, void *ctx) {
+    AVR_BATCH_DEFINE(erase_ops, 1);
+
+    if (avr_async_busy()) {
+        return false;
+    }
+    erase_guard();
+    avr_batch_chip_erase(&erase_ops);
+    avr_batch_wait(&erase_ops, AVR_BATCH_DELAY, 9000);
+    return avr_async_submit(&erase_ops, done, ctx);
 }
 
 /**
@@ -261,13 +480,10 @@ void avr_write_temporary_buffer(uint16_t word_address, uint8_t low_byte, uint8_t
     uint8_t addr_msb = word_address >> 8;        /* High byte of word address */
     uint8_t addr_lsb = word_address & 0xFF;      /* Low byte of word address */
 
-    /* Load Program Memory Page (Low Byte): 0x40 */
-    uint8_t cmd[4] = {0x40, addr_msb, addr_lsb, low_byte};
-    spi_write_read_blocking(spi0, cmd, output_buffer, 4);
-
-    /* Load Program Memory Page (High Byte): 0x48 */
-    uint8_t cmd2[4] = {0x48, addr_msb, addr_lsb, high_byte};
-    spi_write_read_blocking(spi0, cmd2, output_buffer, 4);
+    /* Load Program Memory Page: 0x40 (low byte), 0x48 (high byte) */
+    avr_batch_add(&ops, 0x40, addr_msb, addr_lsb, low_byte, NULL);
+    avr_batch_add(&ops, 0x48, addr_msb, addr_lsb, high_byte, NULL);
+    avr_batch_run(&ops);
 }
 
 /**
@@ -303,15 +519,11 @@ void avr_write_temporary_buffer_16(uint16_t word_address, uint16_t word) {
  * @param word_address Word address that falls within the target page
  */
 void avr_flash_program_memory(uint16_t word_address) {
-    uint8_t addr_msb = word_address >> 8;    /* High byte of word address */
-    uint8_t addr_lsb = word_address & 0xFF;  /* Low byte of word address */
-
-    /* Write Program Memory Page: 0x4C */
-    uint8_t cmd[4] = {0x4C, addr_msb, addr_lsb, 0x0};
-    spi_write_read_blocking(spi0, cmd, output_buffer, 4);
-
-    /* Wait for page write to complete - minimum 4.5ms per datasheet */
-    sleep_ms(5);
+    /* Write Program Memory Page (0x4C), then wait for the page write to
+       complete - minimum 4.5ms per datasheet */
+    avr_batch_write_page(&ops, word_address);
+    avr_batch_wait(&ops, AVR_BATCH_DELAY, 5000);
+    avr_batch_run(&ops);
 }
 
 /**
@@ -326,14 +538,13 @@ void avr_flash_program_memory(uint16_t word_address) {
  * @return Lower 8 bits of the program word at the specified address
  */
 uint8_t avr_read_program_memory_low_byte(uint16_t word_address) {
-    uint8_t addr_msb = word_address >> 8;    /* High byte of word address */
-    uint8_t addr_lsb = word_address & 0xFF;  /* Low byte of word address */
+    uint8_t data = 0;
 
     /* Read Program Memory (Low Byte): 0x20 */
-    uint8_t cmd[4] = {0x20, addr_msb, addr_lsb, 0x0};
-    spi_write_read_blocking(spi0, cmd, output_buffer, 4);
+    avr_batch_read_flash(&ops, (uint32_t)word_address * 2, &data, 1);
+    avr_batch_run(&ops);
 
-    return output_buffer[3];  /* Data returned in 4th byte */
+    return data;
 }
 
 /**
@@ -348,14 +559,13 @@ uint8_t avr_read_program_memory_low_byte(uint16_t word_address) {
  * @return Upper 8 bits of the program word at the specified address
  */
 uint8_t avr_read_program_memory_high_byte(uint16_t word_address) {
-    uint8_t addr_msb = word_address >> 8;    /* High byte of word address */
-    uint8_t addr_lsb = word_address & 0xFF;  /* Low byte of word address */
+    uint8_t data = 0;
 
     /* Read Program Memory (High Byte): 0x28 */
-    uint8_t cmd[4] = {0x28, addr_msb, addr_lsb, 0x0};
-    spi_write_read_blocking(spi0, cmd, output_buffer, 4);
+    avr_batch_read_flash(&ops, (uint32_t)word_address * 2 + 1, &data, 1);
+    avr_batch_run(&ops);
 
-    return output_buffer[3];  /* Data returned in 4th byte */
+    return data;
 }
 
 /**
@@ -368,14 +578,13 @@ uint8_t avr_read_program_memory_high_byte(uint16_t word_address) {
  * @return 16-bit program word (high byte << 8 | low byte)
  */
 uint16_t avr_read_program_memory(uint16_t word_address) {
-    uint16_t data;
+    uint8_t bytes[2] = {0, 0};
 
-    /* Read high byte first, then low byte */
-    data = avr_read_program_memory_high_byte(word_address);
-    data <<= 8;  /* Shift high byte to upper position */
-    data |= avr_read_program_memory_low_byte(word_address);
+    /* Low and high byte in one batch */
+    avr_batch_read_flash(&ops, (uint32_t)word_address * 2, bytes, 2);
+    avr_batch_run(&ops);
 
-    return data;
+    return (uint16_t)((bytes[1] << 8) | bytes[0]);
 }
 
 /**
@@ -396,10 +605,17 @@ uint16_t avr_read_program_memory(uint16_t word_address) {
 void avr_write_temporary_buffer_page(uint16_t* data, size_t data_len) {
     if (data_len == 0) return;
 
-    /* Write each word to sequential addresses in the page buffer */
+    /* Queue every word and stream the loads in as few transfers as possible */
     for (size_t i = 0; i < data_len; i++) {
-        avr_write_temporary_buffer_16((uint16_t)i, data[i]);
+        uint8_t hi = (uint8_t)(i >> 8);
+        uint8_t lo = (uint8_t)i;
+        if (ops.capacity - ops.count < 2) {
+            avr_batch_run(&ops);
+        }
+        avr_batch_add(&ops, 0x40, hi, lo, (uint8_t)(data[i] & 0xFF), NULL);
+        avr_batch_add(&ops, 0x48, hi, lo, (uint8_t)(data[i] >> 8), NULL);
     }
+    avr_batch_run(&ops);
 }
 
 /**
@@ -418,11 +634,24 @@ void avr_write_temporary_buffer_page(uint16_t* data, size_t data_len) {
  * @return true if all words match expected data, false if any mismatch
  */
 bool avr_verify_program_memory_page(uint16_t page_address_start, uint16_t* expected_data, size_t data_len) {
-    for (size_t i = 0; i < data_len; i++) {
-        uint16_t word = avr_read_program_memory(page_address_start + i);
-        if (word != expected_data[i]) {
-            return false;  /* Verification failed - mismatch detected */
+    uint8_t bytes[AVR_BATCH_PAGE_INSTR];
+
+    /* Read back in batch-sized chunks, then compare */
+    for (size_t done = 0; done < data_len; ) {
+        size_t n = data_len - done;
+        if (n > sizeof(bytes) / 2) {
+            n = sizeof(bytes) / 2;
+        }
+        avr_batch_read_flash(&ops, (uint32_t)(page_address_start + done) * 2, bytes, n * 2);
+        avr_batch_run(&ops);
+
+        for (size_t i = 0; i < n; i++) {
+            uint16_t word = (uint16_t)((bytes[i * 2 + 1] << 8) | bytes[i * 2]);
+            if (word != expected_data[done + i]) {
+                return false;  /* Verification failed - mismatch detected */
+            }
         }
+        done += n;
     }
 
     return true;  /* All words verified successfully */
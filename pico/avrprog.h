@@ -5,11 +5,12 @@
  * This header defines the public interface for AVR In-System Programming (ISP)
  * functions. These functions implement the low-level AVR ISP protocol over SPI.
  * 
- * SPI Implementation Options:
+ * SPI Implementation Options (both linked in, see avr_spi_transport.h):
  *   - Hardware SPI (default): Uses RP2040's SPI0 peripheral for fast transfers
  *   - Bit-bang SPI: Software implementation using GPIO, allows any pins
  * 
- * To use bit-bang mode, build with: cmake -DUSE_BITBANG_SPI=ON ..
+ * The host switches with SET_PARAMETER Parm_VND_SPI_BACKEND; to make
+ * bit-bang the power-up default, build with: cmake -DUSE_BITBANG_SPI=ON ..
  * 
  * AVR ISP Protocol Overview:
  *   - All commands are 4-byte SPI transactions
@@ -34,10 +35,37 @@
 
 #include <pico/stdlib.h>
 
-/* Include bit-bang header for access to speed control functions */
-#ifdef USE_BITBANG_SPI
-#include "avrprog_bitbang.h"
-#endif
+#include "avr_spi_transport.h"
+#include "avr_async.h"
+
+/*******************************************************************************
+ * Programming Enable Timing
+ ******************************************************************************/
+
+/** Programming Enable attempts before giving up */
+#define AVR_ENTRY_MAX_ATTEMPTS   8
+
+/** Minimum settle time after RESET goes low, in SCK periods */
+#define AVR_ENTRY_SETTLE_SCK     16
+
+/** Resync applied before an attempt */
+#define AVR_ENTRY_RESYNC_NONE    0
+#define AVR_ENTRY_RESYNC_SCK     1   /* Positive SCK pulse */
+#define AVR_ENTRY_RESYNC_RESET   2   /* Positive RESET pulse */
+
+typedef struct {
+    uint8_t resync;         /**< AVR_ENTRY_RESYNC_* */
+    uint8_t echo;           /**< Third response byte (0x53 on success) */
+    uint32_t settle_us;     /**< Wait before the instruction */
+    uint32_t elapsed_us;    /**< Whole attempt, resync included */
+} avr_entry_attempt_t;
+
+typedef struct {
+    uint8_t attempts;
+    bool ok;
+    uint32_t total_us;      /**< Initial RESET pulse to result */
+    avr_entry_attempt_t attempt[AVR_ENTRY_MAX_ATTEMPTS];
+} avr_entry_log_t;
 
 /*******************************************************************************
  * Initialization and Mode Control Functions
@@ -51,6 +79,36 @@
  */
 void avr_spi_init();
 
+/**
+ * @brief Set the ISP clock (SCK) frequency
+ * 
+ * Must stay below 1/4 of the target's system clock.
+ * 
+ * @param hz Requested SCK frequency; the nearest lower achievable rate is used
+ */
+void avr_set_sck_frequency(uint32_t hz);
+
+/**
+ * @brief Get the SCK frequency last requested
+ * 
+ * @return Requested rate in Hz (50kHz after init or transport selection)
+ */
+uint32_t avr_get_sck_frequency(void);
+
+/** Instructions streamed per avr_spi_benchmark() run */
+#define AVR_SPI_BENCH_INSTR 512
+
+/**
+ * @brief Measure ISP instruction throughput at one SCK rate
+ * 
+ * Uses the selected transport with MOSI held low and RESET asserted;
+ * call only outside programming mode. RESET is released afterwards.
+ * 
+ * @param hz SCK frequency to measure
+ * @return 4-byte instructions per second
+ */
+uint32_t avr_spi_benchmark(uint32_t hz);
+
 /**
  * @brief Pulse RESET line to restart target
  * 
@@ -63,12 +121,39 @@ void avr_reset();
  * @brief Enter Serial Programming mode
  * 
  * Holds RESET low and sends Programming Enable command to put the
- * target into ISP mode. Retries automatically if synchronization fails.
+ * target into ISP mode, with waits derived from the current SCK rate.
+ * Failed attempts are retried after an SCK or RESET pulse resync.
+ * If the target still does not answer and the debugWIRE fallback is
+ * enabled, a debugWIRE disable is attempted on RESET (see debugwire.h)
+ * before one more try.
  * 
  * @return true if programming mode entered successfully, false if failed
  */
 bool avr_enter_programming_mode();
 
+/**
+ * @brief Enable or disable the debugWIRE fallback of ISP entry
+ * 
+ * Off by default: the fallback breaks RESET low for 20 ms and waits up
+ * to 50 ms for a dW answer after every failed entry, which only helps
+ * parts with DWEN programmed.
+ * 
+ * @param enable true to try dw_disable() when Programming Enable fails
+ */
+void avr_dw_fallback_enable(bool enable);
+
+/**
+ * @brief Check whether failed ISP entries fall back to debugWIRE
+ */
+bool avr_dw_fallback_enabled(void);
+
+/**
+ * @brief Get the timing of the last Programming Enable sequence
+ * 
+ * @return Per-attempt resync, settle time and duration
+ */
+const avr_entry_log_t* avr_entry_log(void);
+
 /**
  * @brief Exit Serial Programming mode
  * 
@@ -76,6 +161,44 @@ bool avr_enter_programming_mode();
  */
 void avr_leave_programming_mode();
 
+/*******************************************************************************
+ * Raw Instruction Access
+ ******************************************************************************/
+
+/**
+ * @brief Execute one raw 4-byte ISP instruction
+ * 
+ * Used for STK500 UNIVERSAL commands (fuses, lock bits, calibration).
+ * 
+ * @param cmd 4 instruction bytes to send
+ * @param rx  Buffer receiving the 4 bytes clocked back from the target
+ */
+void avr_universal(const uint8_t cmd[4], uint8_t rx[4]);
+
+/**
+ * @brief Full-duplex transfer on the selected transport
+ * 
+ * Used by the batch runner (avr_batch.h) to stream several instructions
+ * in one call.
+ * 
+ * @param tx  Bytes to send
+ * @param rx  Buffer receiving the bytes clocked back (may equal tx)
+ * @param len Number of bytes
+ */
+void avr_spi_transfer(const uint8_t *tx, uint8_t *rx, size_t len);
+
+/**
+ * @brief Poll the target's RDY/BSY flag until a write completes
+ * 
+ * Issues Poll RDY/BSY (0xF0 0x00 0x00 0x00) until bit 0 of the reply
+ * reads 0. Parts without polling support simply run into the timeout,
+ * which then acts as the fixed datasheet delay.
+ * 
+ * @param timeout_us Maximum time to wait in microseconds
+ * @return true if the target reported ready before the timeout
+ */
+bool avr_poll_ready(uint32_t timeout_us);
+
 /*******************************************************************************
  * Memory Operations
  ******************************************************************************/
@@ -90,6 +213,15 @@ void avr_leave_programming_mode();
  */
 void avr_erase_memory();
 
+/**
+ * @brief Queue a Chip Erase without blocking
+ *
+ * @param done Completion callback, run from avr_async_poll()
+ * @param ctx  Passed to done
+ * @return false if the engine is busy with another batch
+ */
+bool avr_erase_memory_submit(avr_async_done_t done, void *ctx);
+
 /**
  * @brief Read 3-byte device signature
  * 
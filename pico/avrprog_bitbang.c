@@ -13,17 +13,26 @@
  *   - MSB first data order
  *   - 4-byte transaction format
  * 
+ * The ISP command layer (avrprog.c) reaches this code through the
+ * avr_spi_transport_bitbang operations table.
+ * 
  * Performance Notes:
  *   - Default speed is ~50kHz (10us half-period delay)
- *   - Speed can be adjusted at runtime via avr_bitbang_set_speed()
- *   - Bit-banging is CPU-intensive but sufficient for ISP operations
+ *   - Speed can be adjusted at runtime via avr_bitbang_set_speed() or
+ *     avr_set_sck_frequency() (sub-microsecond half-periods)
+ *   - MOSI/SCK are driven with single SIO set/clear writes and MISO is
+ *     read from SIO GPIO_IN; half-periods are busy-wait cycle counts
+ *     with the per-edge instruction overhead subtracted
+ *   - The transfer kernel runs from SRAM so XIP cache misses cannot
+ *     stretch a clock edge
  * 
  * @author MUdroThe1
  * @date 2026
  */
 
 #include "avrprog_bitbang.h"
-#include <stdio.h>
+#include "hardware/clocks.h"
+#include "hardware/structs/sio.h"
 
 /*******************************************************************************
  * Private Variables
@@ -33,20 +42,27 @@
  * @brief Current SPI clock half-period delay in microseconds
  * 
  * This can be modified at runtime using avr_bitbang_set_speed().
+ * Sub-microsecond rates report 0.
  */
 static uint32_t bb_delay_us = BB_DELAY_US;
 
+/**
+ * @brief Busy-wait cycles per clock half-period (overhead already removed)
+ */
+static uint32_t bb_half_cycles = 0;
+
 /*******************************************************************************
  * Private Helper Functions
  ******************************************************************************/
 
+#define BB_MOSI_MASK   (1u << BB_MOSI_PIN)
+#define BB_SCK_MASK    (1u << BB_SCK_PIN)
+
 /**
- * @brief Inline delay for SPI timing
- * 
- * Uses the configured delay value for clock half-period timing.
+ * @brief Convert a half-period in nanoseconds to busy-wait cycles
  */
-static inline void bb_delay(void) {
-    sleep_us(bb_delay_us);
+static void bb_set_half_period_ns(uint32_t half_ns) {
+    bb_half_cycles = avr_bitbang_half_period_cycles(clock_get_hz(clk_sys), half_ns);
 }
 
 /*******************************************************************************
@@ -84,7 +100,7 @@ void avr_bitbang_init(void) {
     gpio_put(BB_RESET_PIN, 1);
     
     /* Reset delay value to default */
-    bb_delay_us = BB_DELAY_US;
+    avr_bitbang_set_speed(BB_DELAY_US);
 }
 
 /*******************************************************************************
@@ -113,32 +129,33 @@ void avr_bitbang_init(void) {
  * @param tx_byte Byte to transmit to target
  * @return Byte received from target
  */
-uint8_t avr_bitbang_transfer_byte(uint8_t tx_byte) {
-    uint8_t rx_byte = 0;
+uint8_t __not_in_flash_func(avr_bitbang_transfer_byte)(uint8_t tx_byte) {
+    const uint32_t half = bb_half_cycles;
+    uint32_t rx_byte = 0;
     
     for (int bit = 7; bit >= 0; bit--) {
         /* Set MOSI to current transmit bit (MSB first) */
-        gpio_put(BB_MOSI_PIN, (tx_byte >> bit) & 0x01);
+        if ((tx_byte >> bit) & 0x01) {
+            sio_hw->gpio_set = BB_MOSI_MASK;
+        } else {
+            sio_hw->gpio_clr = BB_MOSI_MASK;
+        }
         
         /* Setup time before rising edge */
-        bb_delay();
-        
-        /* Rising edge of SCK - target will sample MOSI, we sample MISO */
-        gpio_put(BB_SCK_PIN, 1);
+        busy_wait_at_least_cycles(half);
         
-        /* Sample MISO and store in receive byte */
-        if (gpio_get(BB_MISO_PIN)) {
-            rx_byte |= (1 << bit);
-        }
+        /* Rising edge of SCK - target samples MOSI, we sample MISO */
+        sio_hw->gpio_set = BB_SCK_MASK;
+        rx_byte = (rx_byte << 1) | ((sio_hw->gpio_in >> BB_MISO_PIN) & 0x01);
         
         /* Hold time after rising edge */
-        bb_delay();
+        busy_wait_at_least_cycles(half);
         
         /* Falling edge of SCK */
-        gpio_put(BB_SCK_PIN, 0);
+        sio_hw->gpio_clr = BB_SCK_MASK;
     }
     
-    return rx_byte;
+    return (uint8_t)rx_byte;
 }
 
 /**
@@ -154,7 +171,7 @@ uint8_t avr_bitbang_transfer_byte(uint8_t tx_byte) {
  * @param rx_buf Pointer to receive data buffer (can equal tx_buf)
  * @param len Number of bytes to transfer
  */
-void avr_bitbang_transfer(const uint8_t *tx_buf, uint8_t *rx_buf, size_t len) {
+void __not_in_flash_func(avr_bitbang_transfer)(const uint8_t *tx_buf, uint8_t *rx_buf, size_t len) {
     for (size_t i = 0; i < len; i++) {
         rx_buf[i] = avr_bitbang_transfer_byte(tx_buf[i]);
     }
@@ -221,202 +238,70 @@ void avr_bitbang_set_speed(uint32_t delay_us) {
         delay_us = 1;  /* Enforce minimum delay */
     }
     bb_delay_us = delay_us;
+    bb_set_half_period_ns(delay_us * 1000u);
 }
 
 /**
- * @brief Get the current bit-bang SPI clock delay
+ * @brief Busy-wait cycles for one clock half-period
  * 
- * @return Current half-period delay in microseconds
- */
-uint32_t avr_bitbang_get_speed(void) {
-    return bb_delay_us;
-}
-
-/*******************************************************************************
- * AVR ISP Compatible Wrapper Functions
+ * Each half-period already costs BB_EDGE_OVERHEAD_CYCLES for the SIO
+ * writes, MISO sample and loop, so only the remainder is waited.
  * 
- * These functions provide the same interface as the hardware SPI version
- * in avrprog.c, allowing easy switching between implementations.
- ******************************************************************************/
-
-#ifdef USE_BITBANG_SPI
-
-#include "avrprog.h"
-
-/**
- * @brief SPI transaction output buffer (same as hardware version)
- */
-static uint8_t bb_output_buffer[4] = {0, 0, 0, 0};
-
-/**
- * @brief Erase counter for flash protection
- */
-static int bb_erase_count = 0;
-
-/**
- * @brief Initialize SPI interface (bit-bang version)
+ * @param sys_hz  System clock in Hz
+ * @param half_ns Half-period in nanoseconds
+ * @return Cycles to pass to busy_wait_at_least_cycles()
  */
-void avr_spi_init(void) {
-    avr_bitbang_init();
+uint32_t avr_bitbang_half_period_cycles(uint32_t sys_hz, uint32_t half_ns) {
+    uint64_t cycles = ((uint64_t)sys_hz * half_ns + 999999999u) / 1000000000u;
+    return cycles > BB_EDGE_OVERHEAD_CYCLES ? (uint32_t)(cycles - BB_EDGE_OVERHEAD_CYCLES) : 0;
 }
 
 /**
- * @brief Read the 3-byte device signature from the AVR
+ * @brief Get the current bit-bang SPI clock delay
  * 
- * @param signature Pointer to a 3-byte buffer to store the signature
+ * @return Current half-period delay in microseconds
  */
-void avr_read_signature(uint8_t *signature) {
-    for (int i = 0; i < 3; i++) {
-        uint8_t cmd[4] = {0x30, 0x00, (uint8_t)i, 0x00};
-        avr_bitbang_transfer(cmd, bb_output_buffer, 4);
-        signature[i] = bb_output_buffer[3];
-    }
+uint32_t avr_bitbang_get_speed(void) {
+    return bb_delay_us;
 }
 
-/**
- * @brief Perform a hardware reset pulse on the AVR target
- */
-void avr_reset(void) {
-    avr_bitbang_reset_pulse();
-}
+/*******************************************************************************
+ * Transport Operations
+ ******************************************************************************/
 
 /**
- * @brief Enter AVR Serial Programming mode
+ * @brief Set the SCK frequency
  * 
- * @return true if programming mode entered successfully
- */
-bool avr_enter_programming_mode(void) {
-    avr_bitbang_reset_release();
-    sleep_ms(2);
-    avr_bitbang_reset_assert();
-
-    uint8_t cmd[4] = {0xAC, 0x53, 0x00, 0x00};
-    
-    for (int attempt = 0; attempt < 8; attempt++) {
-        avr_bitbang_transfer(cmd, bb_output_buffer, 4);
-        
-        if (bb_output_buffer[2] == 0x53) {
-            return true;
-        }
-        sleep_ms(10);
-    }
-
-    avr_bitbang_reset_release();
-    sleep_ms(2);
-    return false;
-}
-
-/**
- * @brief Exit AVR Serial Programming mode
- */
-void avr_leave_programming_mode(void) {
-    avr_bitbang_reset_release();
-    sleep_ms(2);
-}
-
-/**
- * @brief Perform a Chip Erase operation
+ * Converted to a half-period in nanoseconds, rounded up so the rate
+ * never exceeds the request.
  */
-void avr_erase_memory(void) {
-    if (bb_erase_count > 200) {
-        printf("Erase limit exceeded - halting to protect flash\n");
-        while (true) sleep_ms(100);
+static void bb_set_sck_hz(uint32_t hz) {
+    if (hz == 0) {
+        hz = 1;
     }
-
-    uint8_t cmd[4] = {0xAC, 0x80, 0x00, 0x00};
-    avr_bitbang_transfer(cmd, bb_output_buffer, 4);
-    sleep_ms(9);
-    bb_erase_count++;
-}
-
-/**
- * @brief Write a word to the temporary page buffer
- */
-void avr_write_temporary_buffer(uint16_t word_address, uint8_t low_byte, uint8_t high_byte) {
-    uint8_t addr_msb = word_address >> 8;
-    uint8_t addr_lsb = word_address & 0xFF;
-
-    uint8_t cmd[4] = {0x40, addr_msb, addr_lsb, low_byte};
-    avr_bitbang_transfer(cmd, bb_output_buffer, 4);
-
-    uint8_t cmd2[4] = {0x48, addr_msb, addr_lsb, high_byte};
-    avr_bitbang_transfer(cmd2, bb_output_buffer, 4);
-}
-
-/**
- * @brief Write a 16-bit word to the temporary page buffer
- */
-void avr_write_temporary_buffer_16(uint16_t word_address, uint16_t word) {
-    avr_write_temporary_buffer(word_address, word & 0xFF, word >> 8);
-}
-
-/**
- * @brief Flash the temporary page buffer to program memory
- */
-void avr_flash_program_memory(uint16_t word_address) {
-    uint8_t addr_msb = word_address >> 8;
-    uint8_t addr_lsb = word_address & 0xFF;
-
-    uint8_t cmd[4] = {0x4C, addr_msb, addr_lsb, 0x00};
-    avr_bitbang_transfer(cmd, bb_output_buffer, 4);
-    sleep_ms(5);
-}
-
-/**
- * @brief Read the low byte of a program memory word
- */
-uint8_t avr_read_program_memory_low_byte(uint16_t word_address) {
-    uint8_t addr_msb = word_address >> 8;
-    uint8_t addr_lsb = word_address & 0xFF;
-
-    uint8_t cmd[4] = {0x20, addr_msb, addr_lsb, 0x00};
-    avr_bitbang_transfer(cmd, bb_output_buffer, 4);
-    return bb_output_buffer[3];
+    uint32_t half_ns = (500000000u + hz - 1u) / hz;
+    bb_delay_us = half_ns / 1000u;
+    bb_set_half_period_ns(half_ns);
 }
 
-/**
- * @brief Read the high byte of a program memory word
- */
-uint8_t avr_read_program_memory_high_byte(uint16_t word_address) {
-    uint8_t addr_msb = word_address >> 8;
-    uint8_t addr_lsb = word_address & 0xFF;
-
-    uint8_t cmd[4] = {0x28, addr_msb, addr_lsb, 0x00};
-    avr_bitbang_transfer(cmd, bb_output_buffer, 4);
-    return bb_output_buffer[3];
+static void bb_set_reset(bool level) {
+    gpio_put(BB_RESET_PIN, level);
 }
 
-/**
- * @brief Read a complete 16-bit program word
- */
-uint16_t avr_read_program_memory(uint16_t word_address) {
-    uint16_t data = avr_read_program_memory_high_byte(word_address);
-    data <<= 8;
-    data |= avr_read_program_memory_low_byte(word_address);
-    return data;
-}
-
-/**
- * @brief Fill page buffer from array
- */
-void avr_write_temporary_buffer_page(uint16_t* data, size_t data_len) {
-    if (data_len == 0) return;
-    for (size_t i = 0; i < data_len; i++) {
-        avr_write_temporary_buffer_16((uint16_t)i, data[i]);
-    }
+static void bb_pulse_sck(uint32_t high_us) {
+    gpio_put(BB_SCK_PIN, 1);
+    busy_wait_us_32(high_us);
+    gpio_put(BB_SCK_PIN, 0);
 }
 
 /**
- * @brief Verify programmed page against expected data
+ * @brief Bit-bang implementation of the ISP transport
  */
-bool avr_verify_program_memory_page(uint16_t page_address_start, uint16_t* expected_data, size_t data_len) {
-    for (size_t i = 0; i < data_len; i++) {
-        uint16_t word = avr_read_program_memory(page_address_start + i);
-        if (word != expected_data[i]) {
-            return false;
-        }
-    }
-    return true;
-}
-
-#endif /* USE_BITBANG_SPI */
+const avr_spi_transport_t avr_spi_transport_bitbang = {
+    .name = "bit-bang",
+    .init = avr_bitbang_init,
+    .transfer = avr_bitbang_transfer,
+    .set_reset = bb_set_reset,
+    .set_sck_hz = bb_set_sck_hz,
+    .pulse_sck = bb_pulse_sck,
+};
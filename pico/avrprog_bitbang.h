@@ -25,6 +25,7 @@
 #include <pico/stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include "avr_spi_transport.h"
 
 /*******************************************************************************
  * Configuration - Bit-bang Pin Definitions
@@ -67,6 +68,17 @@
 #define BB_DELAY_US   10
 #endif
 
+/**
+ * @brief CPU cycles spent per clock half-period outside the busy-wait
+ * 
+ * SIO write, MISO sample/shift and loop bookkeeping of the SRAM kernel
+ * (Cortex-M0+, -O2). Subtracted from every half-period so the SCK rate
+ * matches the request; the fastest clock is clk_sys / (2 * this).
+ */
+#ifndef BB_EDGE_OVERHEAD_CYCLES
+#define BB_EDGE_OVERHEAD_CYCLES   6
+#endif
+
 /*******************************************************************************
  * Initialization Functions
  ******************************************************************************/
@@ -151,5 +163,14 @@ void avr_bitbang_set_speed(uint32_t delay_us);
  */
 uint32_t avr_bitbang_get_speed(void);
 
-//#endif /* AVRPROG_BITBANG_H */
+/**
+ * @brief Busy-wait cycles for one SCK half-period (timing model)
+ * 
+ * @param sys_hz  System clock in Hz
+ * @param half_ns Half-period in nanoseconds
+ * @return Cycles left to wait after the per-edge overhead
+ */
+uint32_t avr_bitbang_half_period_cycles(uint32_t sys_hz, uint32_t half_ns);
 
+/** Bit-bang implementation of the ISP transport */
+extern const avr_spi_transport_t avr_spi_transport_bitbang;
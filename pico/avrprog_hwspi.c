@@ -0,0 +1,141 @@
+/**
+ * @file avrprog_hwspi.c
+ * @brief Hardware SPI (SPI0) Transport for AVR ISP Programming
+ *
+ * Drives the ISP header from the RP2040's SPI0 peripheral in Mode 0
+ * (CPOL=0, CPHA=0, MSB first). RESET is a plain GPIO.
+ *
+ * Frame Packing:
+ *   ISP instructions are 4 bytes, so transfers are clocked as 16-bit
+ *   frames: two FIFO entries per instruction instead of four. The TX FIFO
+ *   is kept full across instruction boundaries and RX is drained whenever
+ *   it holds data, so a page load streams at the SCK rate. The PL022 may
+ *   idle SCK briefly between frames, which the AVR ignores.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "avrprog_hwspi.h"
+#include <pico/stdlib.h>
+#include <hardware/spi.h>
+
+/*******************************************************************************
+ * GPIO Pin Definitions for AVR ISP Interface
+ *
+ * These pins connect the Pico to the AVR target's ISP header.
+ * Standard 6-pin ISP header pinout:
+ *   Pin 1: MISO    Pin 2: VCC
+ *   Pin 3: SCK     Pin 4: MOSI
+ *   Pin 5: RESET   Pin 6: GND
+ ******************************************************************************/
+#define mosi_pin 19     /* Master Out Slave In - data from Pico to AVR */
+#define sck_pin 18      /* Serial Clock - generated by Pico (master) */
+#define miso_pin 16     /* Master In Slave Out - data from AVR to Pico */
+#define reset_pin 17    /* Active-low reset line to hold AVR in programming mode */
+
+/** PL022 FIFO depth; frames in flight never exceed it so RX cannot overflow */
+#define SPI_FIFO_DEPTH 8
+
+/**
+ * @brief Initialize SPI0 and the ISP pins
+ *
+ * SPI Configuration:
+ *   - Frequency: 50kHz (conservative to support slow-clocked AVRs)
+ *   - Mode 0: CPOL=0 (clock idle low), CPHA=0 (sample on rising edge)
+ *   - Data order: MSB first (standard for AVR ISP)
+ *   - Data bits: 16 (two bytes per FIFO entry, MSB first)
+ *
+ * Note: The SPI frequency is intentionally kept low (50kHz) to support AVR
+ * targets running with the CKDIV8 fuse set (1MHz internal clock / 8 = 125kHz).
+ * ISP clock should be less than 1/4 of the target's system clock.
+ */
+static void hw_init(void) {
+    /* Configure RESET pin as output, initially high (target not in reset) */
+    gpio_init(reset_pin);
+    gpio_set_dir(reset_pin, GPIO_OUT);
+    gpio_put(reset_pin, 1);  /* High = target running normally */
+
+    /* Configure SPI pins for hardware SPI0 peripheral */
+    gpio_set_function(mosi_pin, GPIO_FUNC_SPI);  /* SPI0 TX */
+    gpio_set_function(sck_pin, GPIO_FUNC_SPI);   /* SPI0 SCK */
+    gpio_set_function(miso_pin, GPIO_FUNC_SPI);  /* SPI0 RX */
+
+    /* Initialize SPI0 at 50kHz - slow enough for AVRs with CKDIV8 fuse */
+    spi_init(spi0, 50000);
+
+    /* Configure SPI Mode 0 as required by AVR ISP protocol */
+    spi_set_format(spi0, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+}
+
+/**
+ * @brief Full-duplex transfer in 16-bit frames
+ *
+ * Runs from RAM so flash wait states don't open gaps in the stream.
+ * An odd length (never produced by the ISP layer) is sent in 8-bit mode.
+ */
+static void __not_in_flash_func(hw_transfer)(const uint8_t *tx, uint8_t *rx, size_t len) {
+    if (len & 1) {
+        spi_set_format(spi0, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+        spi_write_read_blocking(spi0, tx, rx, len);
+        spi_set_format(spi0, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+        return;
+    }
+
+    size_t frames = len / 2;
+    size_t sent = 0;
+    size_t received = 0;
+
+    /* rx may equal tx: frame k is always read from tx before rx[k] is written.
+       The SDK accessors inline to the same SSPSR/SSPDR accesses. */
+    while (received < frames) {
+        while (sent < frames && sent - received < SPI_FIFO_DEPTH && spi_is_writable(spi0)) {
+            spi_get_hw(spi0)->dr = (uint32_t)tx[sent * 2] << 8 | tx[sent * 2 + 1];
+            sent++;
+        }
+        while (received < sent && spi_is_readable(spi0)) {
+            uint16_t v = (uint16_t)spi_get_hw(spi0)->dr;
+            rx[received * 2] = (uint8_t)(v >> 8);
+            rx[received * 2 + 1] = (uint8_t)v;
+            received++;
+        }
+    }
+}
+
+static void hw_set_reset(bool level) {
+    gpio_put(reset_pin, level);
+}
+
+/**
+ * @brief Set the SCK frequency
+ *
+ * The SPI peripheral picks the nearest rate not above the request.
+ */
+static void hw_set_sck_hz(uint32_t hz) {
+    spi_set_baudrate(spi0, hz);
+}
+
+/**
+ * @brief One positive SCK pulse with the pin briefly taken from SPI0
+ */
+static void hw_pulse_sck(uint32_t high_us) {
+    gpio_put(sck_pin, 0);
+    gpio_set_dir(sck_pin, GPIO_OUT);
+    gpio_set_function(sck_pin, GPIO_FUNC_SIO);
+    gpio_put(sck_pin, 1);
+    busy_wait_us_32(high_us);
+    gpio_put(sck_pin, 0);
+    gpio_set_function(sck_pin, GPIO_FUNC_SPI);
+}
+
+/**
+ * @brief Hardware SPI implementation of the ISP transport
+ */
+const avr_spi_transport_t avr_spi_transport_hw = {
+    .name = "hardware SPI",
+    .init = hw_init,
+    .transfer = hw_transfer,
+    .set_reset = hw_set_reset,
+    .set_sck_hz = hw_set_sck_hz,
+    .pulse_sck = hw_pulse_sck,
+};
@@ -0,0 +1,18 @@
+/**
+ * @file avrprog_hwspi.h
+ * @brief Hardware SPI (SPI0) Transport for AVR ISP Programming
+ *
+ * Pins are fixed by the SPI0 function mapping:
+ *   - MOSI -> GPIO 19, SCK -> GPIO 18, MISO -> GPIO 16
+ *   - RESET -> GPIO 17 (plain GPIO)
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include "avr_spi_transport.h"
+
+/** Hardware SPI implementation of the ISP transport */
+extern const avr_spi_transport_t avr_spi_transport_hw;
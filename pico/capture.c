@@ -0,0 +1,162 @@
+/**
+ * @file capture.c
+ * @brief Timestamped Capture of the STK500v1 Byte Stream
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "capture.h"
+#include <string.h>
+#include <pico/stdlib.h>
+
+/*******************************************************************************
+ * Buffer State
+ ******************************************************************************/
+
+static uint8_t buf[CAPTURE_BYTES];
+static size_t used;
+static uint32_t lost;
+
+static bool enabled;        /* Requested by the host */
+static bool started;        /* First host bytes seen since enabling */
+static bool paused;
+static bool full;           /* Out of space: stopped for good */
+
+static bool rec_open;       /* Programmer record still growing */
+static size_t rec_at;       /* Offset of its header */
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static size_t record_len(size_t at) {
+    return (size_t)buf[at + 5] | (size_t)buf[at + 6] << 8;
+}
+
+/** Append a record header; false if out of space */
+static bool begin_record(uint8_t dir, size_t len) {
+    if (used + CAPTURE_HEADER_BYTES + len > sizeof(buf)) {
+        return false;
+    }
+    put_u32(buf + used, time_us_32());
+    buf[used + 4] = dir;
+    buf[used + 5] = 0;
+    buf[used + 6] = 0;
+    used += CAPTURE_HEADER_BYTES;
+    return true;
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/**
+ * @brief Enable recording (from the next host bytes, empty buffer) or stop it
+ */
+void capture_enable(bool on) {
+    capture_flush();
+    if (on && !enabled) {
+        capture_clear();
+        started = false;
+    }
+    enabled = on;
+}
+
+/**
+ * @brief Check whether recording is enabled
+ */
+bool capture_enabled(void) {
+    return enabled;
+}
+
+/**
+ * @brief Record stream bytes
+ */
+void capture_bytes(uint8_t dir, const uint8_t* data, size_t len) {
+    if (!enabled || paused || len == 0) {
+        return;
+    }
+    if (!started) {
+        if (dir != CAPTURE_HOST) {
+            return;     /* Reply to the frame that enabled capture */
+        }
+        started = true;
+    }
+    if (full) {
+        lost += (uint32_t)len;
+        return;
+    }
+
+    bool extend = dir == CAPTURE_PROGRAMMER && rec_open && record_len(rec_at) + len <= 0xFFFF;
+    if (!extend) {
+        capture_flush();
+        if (!begin_record(dir, len)) {
+            full = true;
+            lost += (uint32_t)len;
+            return;
+        }
+        if (dir == CAPTURE_PROGRAMMER) {
+            rec_open = true;
+            rec_at = used - CAPTURE_HEADER_BYTES;
+        }
+    } else if (used + len > sizeof(buf)) {
+        capture_flush();
+        full = true;
+        lost += (uint32_t)len;
+        return;
+    }
+
+    size_t at = extend ? rec_at : used - CAPTURE_HEADER_BYTES;
+    size_t n = record_len(at) + len;
+    memcpy(buf + used, data, len);
+    used += len;
+    buf[at + 5] = (uint8_t)n;
+    buf[at + 6] = (uint8_t)(n >> 8);
+}
+
+/**
+ * @brief Close the open programmer record, stamping it with the current time
+ */
+void capture_flush(void) {
+    if (rec_open) {
+        put_u32(buf + rec_at, time_us_32());
+        rec_open = false;
+    }
+}
+
+/**
+ * @brief Pause or resume recording without touching the buffer
+ */
+void capture_pause(bool pause) {
+    capture_flush();
+    paused = pause;
+}
+
+/**
+ * @brief Get the recorded bytes
+ */
+const uint8_t* capture_data(size_t* len) {
+    *len = used;
+    return buf;
+}
+
+/**
+ * @brief Get the number of stream bytes not recorded for lack of space
+ */
+uint32_t capture_lost(void) {
+    return lost;
+}
+
+/**
+ * @brief Drop the recorded bytes (recording state unchanged)
+ */
+void capture_clear(void) {
+    rec_open = false;
+    used = 0;
+    lost = 0;
+    full = false;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file capture.h
+ * @brief Timestamped Capture of the STK500v1 Byte Stream
+ *
+ * test.py used to work from in.txt/out.txt captured by hand with a USB
+ * sniffer, which loses the timing and needs the two directions lined up
+ * manually. While enabled (Parm_VND_CAPTURE), the protocol handler copies
+ * both directions into a RAM buffer that the host reads back with
+ * Cmnd_STK_CAPTURE_DUMP and test.py pairs and times.
+ *
+ * Record Format (little-endian, as dumped):
+ *   [0..3] time_us_32() timestamp
+ *   [4]    Direction (CAPTURE_HOST or CAPTURE_PROGRAMMER)
+ *   [5..6] Data length
+ *   [7..]  Data
+ *
+ *   Host records are stamped when the bytes reach the parser, programmer
+ *   records when they are flushed to USB.
+ *
+ * Start and Overflow:
+ *   Recording starts with the first host bytes after it is enabled, so
+ *   the stream begins on a command. Once the buffer is full recording
+ *   stops (a gap would desynchronise the pairing) and further bytes are
+ *   only counted.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Capture buffer size in bytes (records and data) */
+#define CAPTURE_BYTES           16384
+
+/** Record header size in bytes */
+#define CAPTURE_HEADER_BYTES    7
+
+/** Directions */
+#define CAPTURE_HOST            0x00    /* Host to programmer */
+#define CAPTURE_PROGRAMMER      0x01    /* Programmer to host */
+
+/**
+ * @brief Enable recording (from the next host bytes, empty buffer) or stop it
+ */
+void capture_enable(bool on);
+
+/**
+ * @brief Check whether recording is enabled
+ */
+bool capture_enabled(void);
+
+/**
+ * @brief Record stream bytes
+ *
+ * Consecutive programmer bytes are merged into one record until
+ * capture_flush().
+ *
+ * @param dir  CAPTURE_HOST or CAPTURE_PROGRAMMER
+ * @param data Bytes
+ * @param len  Number of bytes
+ */
+void capture_bytes(uint8_t dir, const uint8_t* data, size_t len);
+
+/**
+ * @brief Close the open programmer record, stamping it with the current time
+ */
+void capture_flush(void);
+
+/**
+ * @brief Pause or resume recording without touching the buffer
+ *
+ * Used while the buffer itself is being sent.
+ */
+void capture_pause(bool paused);
+
+/**
+ * @brief Get the recorded bytes
+ *
+ * @param len Receives the number of bytes
+ * @return Buffer holding whole records
+ */
+const uint8_t* capture_data(size_t* len);
+
+/**
+ * @brief Get the number of stream bytes not recorded for lack of space
+ */
+uint32_t capture_lost(void);
+
+/**
+ * @brief Drop the recorded bytes (recording state unchanged)
+ */
+void capture_clear(void);
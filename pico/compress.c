@@ -0,0 +1,220 @@
+/**
+ * @file compress.c
+ * @brief Streaming LZSS Decoder and Run-Length Encoder
+ *
+ * Decodes the LZSS format described in compress.h. The decoder keeps only
+ * the 256-byte history window plus a few bytes of parser state, so RAM use
+ * is fixed regardless of image size.
+ *
+ * The run-length encoder used for flash readback is at the end of the
+ * file. It emits output through a callback as soon as a block is final.
+ *
+ * Parser States:
+ *   - ST_FLAGS:  waiting for the next group flag byte
+ *   - ST_ITEM:   waiting for the first byte of an item
+ *   - ST_LENGTH: got match offset, waiting for match length
+ *
+ * A match is expanded lazily: match_left counts the bytes still to copy
+ * so the output side can stop at a page boundary and resume later.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "compress.h"
+#include <string.h>
+
+/*******************************************************************************
+ * Parser States
+ ******************************************************************************/
+#define ST_FLAGS    0   /* Expecting group flag byte */
+#define ST_ITEM     1   /* Expecting literal byte or match offset */
+#define ST_LENGTH   2   /* Expecting match length byte */
+
+/**
+ * @brief Reset decoder state and pre-fill the window with erased flash
+ *
+ * @param d Decoder state to initialize
+ */
+void lzss_init(lzss_decoder_t *d) {
+    memset(d->window, 0xFF, sizeof(d->window));
+    d->pos = 0;
+    d->flags = 0;
+    d->flag_bits = 0;
+    d->state = ST_FLAGS;
+    d->offset = 0;
+    d->match_left = 0;
+}
+
+/**
+ * @brief Append one byte to output and history window
+ */
+static inline void emit(lzss_decoder_t *d, uint8_t b, uint8_t *out, size_t *produced) {
+    d->window[d->pos++] = b;   /* uint8_t position wraps at 256 */
+    out[(*produced)++] = b;
+}
+
+/**
+ * @brief Decode compressed input into the output buffer
+ *
+ * @param d       Decoder state
+ * @param in      Compressed input bytes
+ * @param in_len  Number of input bytes available
+ * @param in_used Set to the number of input bytes consumed
+ * @param out     Output buffer
+ * @param out_cap Output buffer capacity in bytes
+ * @return Number of decoded bytes written to out
+ */
+size_t lzss_decode(lzss_decoder_t *d, const uint8_t *in, size_t in_len,
+                   size_t *in_used, uint8_t *out, size_t out_cap) {
+    size_t produced = 0;
+    size_t used = 0;
+
+    while (produced < out_cap) {
+        /* Finish any match in progress before parsing more input */
+        if (d->match_left) {
+            uint8_t b = d->window[(uint8_t)(d->pos - d->offset)];
+            emit(d, b, out, &produced);
+            d->match_left--;
+            continue;
+        }
+
+        if (used >= in_len) {
+            break;  /* Need more input */
+        }
+        uint8_t b = in[used++];
+
+        switch (d->state) {
+            case ST_FLAGS:
+                d->flags = b;
+                d->flag_bits = 8;
+                d->state = ST_ITEM;
+                break;
+
+            case ST_ITEM:
+                if (d->flags & 0x01) {
+                    /* Literal byte */
+                    emit(d, b, out, &produced);
+                    d->flags >>= 1;
+                    d->state = (--d->flag_bits) ? ST_ITEM : ST_FLAGS;
+                } else {
+                    /* Match: offset stored as offset-1 (1..256 -> 0..255).
+                     * An offset of 256 wraps to 0 in uint8_t arithmetic,
+                     * which indexes the same slot as pos - 256. */
+                    d->offset = (uint8_t)(b + 1);
+                    d->state = ST_LENGTH;
+                }
+                break;
+
+            case ST_LENGTH:
+                d->match_left = (uint16_t)b + LZSS_MIN_MATCH;
+                d->flags >>= 1;
+                d->state = (--d->flag_bits) ? ST_ITEM : ST_FLAGS;
+                break;
+
+            default:
+                /* Unreachable; resynchronize on a fresh group */
+                d->state = ST_FLAGS;
+                break;
+        }
+    }
+
+    if (in_used) *in_used = used;
+    return produced;
+}
+
+/**
+ * @brief Check whether a match is still being expanded
+ *
+ * @param d Decoder state
+ * @return true if output is pending without further input
+ */
+bool lzss_pending(const lzss_decoder_t *d) {
+    return d->match_left != 0;
+}
+
+/**
+ * @brief Check whether the decoder sits on an item boundary
+ *
+ * @param d Decoder state
+ * @return true if the stream could legally end here
+ */
+bool lzss_at_boundary(const lzss_decoder_t *d) {
+    return d->match_left == 0 && d->state != ST_LENGTH;
+}
+
+/*******************************************************************************
+ * Run-Length Encoder
+ ******************************************************************************/
+
+/**
+ * @brief Initialize the run-length encoder
+ *
+ * @param e    Encoder state
+ * @param sink Callback receiving encoded bytes
+ * @param ctx  Opaque pointer passed to sink
+ */
+void rle_init(rle_encoder_t *e, rle_sink_t sink, void *ctx) {
+    e->lit_len = 0;
+    e->run_val = 0;
+    e->run_len = 0;
+    e->sink = sink;
+    e->ctx = ctx;
+    e->out_bytes = 0;
+}
+
+/** Emit pending literal block, if any */
+static void rle_flush_literals(rle_encoder_t *e) {
+    if (e->lit_len == 0) return;
+    uint8_t ctrl = (uint8_t)(e->lit_len - 1);
+    e->sink(&ctrl, 1, e->ctx);
+    e->sink(e->lit, e->lit_len, e->ctx);
+    e->out_bytes += 1u + e->lit_len;
+    e->lit_len = 0;
+}
+
+/** Emit the pending run, either as a repeat token or as literals */
+static void rle_flush_run(rle_encoder_t *e) {
+    if (e->run_len >= RLE_MIN_RUN) {
+        rle_flush_literals(e);
+        uint16_t n = (uint16_t)(e->run_len - RLE_MIN_RUN);
+        uint8_t tok[3] = { (uint8_t)(0x80 | (n >> 8)), (uint8_t)(n & 0xFF), e->run_val };
+        e->sink(tok, sizeof(tok), e->ctx);
+        e->out_bytes += sizeof(tok);
+    } else {
+        /* Too short to pay for a repeat token - append as literals */
+        for (uint16_t i = 0; i < e->run_len; i++) {
+            if (e->lit_len == RLE_MAX_LITERAL) {
+                rle_flush_literals(e);
+            }
+            e->lit[e->lit_len++] = e->run_val;
+        }
+    }
+    e->run_len = 0;
+}
+
+/**
+ * @brief Add one byte to the encoder
+ *
+ * @param e Encoder state
+ * @param b Raw byte
+ */
+void rle_put(rle_encoder_t *e, uint8_t b) {
+    if (e->run_len && b == e->run_val && e->run_len < RLE_MAX_RUN) {
+        e->run_len++;
+        return;
+    }
+    rle_flush_run(e);
+    e->run_val = b;
+    e->run_len = 1;
+}
+
+/**
+ * @brief Flush pending run and literals at end of stream
+ *
+ * @param e Encoder state
+ */
+void rle_finish(rle_encoder_t *e) {
+    rle_flush_run(e);
+    rle_flush_literals(e);
+}
@@ -0,0 +1,174 @@
+/**
+ * @file compress.h
+ * @brief Streaming Codecs for Compressed Flash Upload and Readback
+ *
+ * AVR firmware images compress very well: unused flash is long runs of 0xFF
+ * and interrupt vector tables repeat the same jump instruction many times.
+ * This module implements a small LZSS decoder that runs with a fixed,
+ * bounded amount of RAM so the programmer can accept compressed page data
+ * and expand it directly into the flash page buffer.
+ *
+ * Stream Format:
+ *   - The stream is a sequence of groups: one flag byte followed by up to
+ *     8 items. Flag bits are consumed LSB first.
+ *   - Flag bit 1: literal item, 1 byte copied to the output as-is
+ *   - Flag bit 0: match item, 2 bytes <offset-1> <length-3>
+ *       offset: 1..256 bytes back into the history window
+ *       length: 3..258 bytes (may exceed offset, e.g. runs of 0xFF)
+ *   - The 256-byte history window starts out filled with 0xFF, so an
+ *     erased-flash run can be encoded as a match right from the start.
+ *
+ * The decoder is a byte-wise state machine: input may be split at any
+ * byte boundary (e.g. across USB packets or STK500 frames) and output may
+ * be drained in arbitrarily small pieces. The host-side encoder lives in
+ * pico/compress.py.
+ *
+ * The reverse direction (flash readback) uses a simpler run-length code
+ * that the device can produce while streaming, with no history window:
+ *   - Control byte 0x00..0x7F: literal run, (c + 1) bytes follow
+ *   - Control byte 0x80..0xFF: repeat run, one more length byte follows,
+ *     length = ((c & 0x7F) << 8 | next) + 3, then the repeated value
+ * A fully erased 32 KB part collapses to 3 bytes.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/** History window size in bytes (offsets are encoded in one byte) */
+#define LZSS_WINDOW_SIZE    256
+
+/** Shortest back-reference worth encoding (stored as length - 3) */
+#define LZSS_MIN_MATCH      3
+
+/** Longest back-reference (255 + LZSS_MIN_MATCH) */
+#define LZSS_MAX_MATCH      258
+
+/**
+ * @brief LZSS decoder state
+ *
+ * Roughly 262 bytes of RAM. Treat as opaque; initialize with lzss_init().
+ */
+typedef struct {
+    uint8_t window[LZSS_WINDOW_SIZE]; /**< History ring buffer (pre-filled with 0xFF) */
+    uint8_t pos;                      /**< Next write position in window (wraps at 256) */
+    uint8_t flags;                    /**< Current group flag byte */
+    uint8_t flag_bits;                /**< Items remaining in current group */
+    uint8_t state;                    /**< Parser state (see compress.c) */
+    uint8_t offset;                   /**< Offset of the match being decoded */
+    uint16_t match_left;              /**< Output bytes still owed by current match */
+} lzss_decoder_t;
+
+/**
+ * @brief Reset decoder to the start of a new stream
+ *
+ * @param d Decoder state to initialize
+ */
+void lzss_init(lzss_decoder_t *d);
+
+/**
+ * @brief Decode as much input as fits in the output buffer
+ *
+ * Consumes bytes from in[] and produces at most out_cap bytes. Decoding
+ * stops when either the input is exhausted or the output is full; call
+ * again with the remaining input (and/or fresh output space) to continue.
+ *
+ * @param d       Decoder state
+ * @param in      Compressed input bytes
+ * @param in_len  Number of input bytes available
+ * @param in_used Set to the number of input bytes consumed
+ * @param out     Output buffer
+ * @param out_cap Output buffer capacity in bytes
+ * @return Number of decoded bytes written to out
+ */
+size_t lzss_decode(lzss_decoder_t *d, const uint8_t *in, size_t in_len,
+                   size_t *in_used, uint8_t *out, size_t out_cap);
+
+/**
+ * @brief Check whether the decoder still owes output without more input
+ *
+ * True while a match is partially copied. Callers draining into fixed
+ * size page buffers must keep calling lzss_decode() until this is false.
+ *
+ * @param d Decoder state
+ * @return true if lzss_decode() can produce output from zero input
+ */
+bool lzss_pending(const lzss_decoder_t *d);
+
+/**
+ * @brief Check whether the decoder is between items
+ *
+ * A well-formed stream always ends on an item boundary. Ending a stream
+ * while this returns false means the upload was truncated.
+ *
+ * @param d Decoder state
+ * @return true if no item is partially parsed
+ */
+bool lzss_at_boundary(const lzss_decoder_t *d);
+
+/*******************************************************************************
+ * Run-Length Encoder (flash readback)
+ ******************************************************************************/
+
+/** Longest literal run (control byte 0x7F) */
+#define RLE_MAX_LITERAL     128
+
+/** Shortest repeat run worth encoding */
+#define RLE_MIN_RUN         3
+
+/** Longest repeat run (15-bit length field + RLE_MIN_RUN) */
+#define RLE_MAX_RUN         (0x7FFF + RLE_MIN_RUN)
+
+/**
+ * @brief Output callback for encoded bytes
+ *
+ * @param data Encoded bytes
+ * @param len  Number of bytes
+ * @param ctx  Caller context passed to rle_init()
+ */
+typedef void (*rle_sink_t)(const uint8_t *data, size_t len, void *ctx);
+
+/**
+ * @brief Run-length encoder state
+ *
+ * Holds at most one pending literal block and one pending run, so the
+ * encoder needs about 136 bytes of RAM.
+ */
+typedef struct {
+    uint8_t lit[RLE_MAX_LITERAL];     /**< Pending literal bytes */
+    uint8_t lit_len;                  /**< Number of pending literal bytes */
+    uint8_t run_val;                  /**< Value of the pending run */
+    uint16_t run_len;                 /**< Length of the pending run (0 = none) */
+    rle_sink_t sink;                  /**< Output callback */
+    void *ctx;                        /**< Output callback context */
+    uint32_t out_bytes;               /**< Total encoded bytes emitted */
+} rle_encoder_t;
+
+/**
+ * @brief Reset encoder and attach an output callback
+ *
+ * @param e    Encoder state
+ * @param sink Callback receiving encoded bytes
+ * @param ctx  Opaque pointer passed to sink
+ */
+void rle_init(rle_encoder_t *e, rle_sink_t sink, void *ctx);
+
+/**
+ * @brief Encode one input byte
+ *
+ * @param e Encoder state
+ * @param b Raw byte
+ */
+void rle_put(rle_encoder_t *e, uint8_t b);
+
+/**
+ * @brief Flush all pending output at the end of the stream
+ *
+ * @param e Encoder state
+ */
+void rle_finish(rle_encoder_t *e);
@@ -0,0 +1,472 @@
+#!/usr/bin/env python3
+"""
+compress.py - Host Tools for Compressed Upload (PROG_PAGE_LZ) and Readback
+
+Host-side companion to pico/compress.c. Encodes AVR firmware images into
+the LZSS stream format expected by the Cmnd_STK_PROG_PAGE_LZ (0x66) vendor
+command, decodes the run-length stream returned by Cmnd_STK_READ_FLASH_RLE
+(0x79), and models transfers so compressed and plain STK500v1 sessions can
+be compared without hardware. Vendor parameters, metrics and the event
+trace are handled by progctl.py.
+
+Usage:
+    python3 compress.py encode fw.hex fw.lz
+    python3 compress.py bench ../fw.hex other.hex [--page 128] [--sck 50000]
+    python3 compress.py roundtrip ../fw.hex --flash 32768
+    python3 compress.py upload fw.hex --port /dev/ttyACM0   (needs pyserial)
+    python3 compress.py upload fw.hex --port /dev/ttyACM0 --verify
+    python3 compress.py upload boot.hex --port /dev/ttyACM0 --no-erase   (append)
+    python3 compress.py dump out.bin --size 32768 --port /dev/ttyACM0
+    python3 compress.py upload t10.hex --port /dev/ttyACM0 --iface tpi
+
+LZSS Upload Format (see compress.h):
+    - Flag byte, then up to 8 items, flag bits consumed LSB first
+    - Bit 1: literal byte
+    - Bit 0: match <offset-1> <length-3>, offset 1..256, length 3..258
+    - History window is 256 bytes, pre-filled with 0xFF
+
+RLE Readback Format:
+    - 0x00..0x7F: literal run of (c + 1) bytes
+    - 0x80..0xFF <lo> <value>: ((c & 0x7F) << 8 | lo) + 3 copies of value
+
+Author: MUdroThe1
+Date: 2026
+"""
+
+import argparse
+import sys
+from pathlib import Path
+
+WINDOW = 256
+MIN_MATCH = 3
+MAX_MATCH = 258
+
+# STK500v1 framing
+INSYNC = 0x14
+OK = 0x10
+EOP = 0x20
+CMD_SET_PARAMETER = 0x40
+CMD_GET_PARAMETER = 0x41
+CMD_ENTER_PROGMODE = 0x50
+CMD_LEAVE_PROGMODE = 0x51
+CMD_CHIP_ERASE = 0x52
+CMD_LOAD_ADDRESS = 0x55
+CMD_VERIFY_MAP = 0x5A
+CMD_PROG_PAGE = 0x64
+CMD_PROG_PAGE_LZ = 0x66
+CMD_READ_FLASH_RLE = 0x79
+
+PARM_VND_INTERFACE = 0xC2
+PARM_VND_TARGET_CLOCK = 0xC3
+PARM_VND_SPI_BACKEND = 0xC4
+PARM_VND_VERIFY = 0xCC
+PARM_VND_VERIFY_RETRIED = 0xCD
+IFACES = {"isp": 0x00, "tpi": 0x01, "updi": 0x02, "pdi": 0x03, "dw": 0x04}
+SPI_BACKENDS = {"hw": 0x00, "bitbang": 0x01}
+
+RLE_MAX_LITERAL = 128
+RLE_MIN_RUN = 3
+RLE_MAX_RUN = 0x7FFF + RLE_MIN_RUN
+
+FRAME_MAX = 256  # Compressed bytes per PROG_PAGE_LZ frame
+# One frame can expand to about 230 pages; at 50 kHz SCK that takes ~20 s
+LZ_FRAME_TIMEOUT_S = 30
+
+
+# =============================================================================
+# Image loading
+# =============================================================================
+
+def load_image(path: str) -> bytes:
+    """Load an Intel HEX or raw binary image as a contiguous byte string."""
+    p = Path(path)
+    if p.suffix.lower() not in (".hex", ".ihx"):
+        return p.read_bytes()
+    mem = {}
+    base = 0
+    for line in p.read_text().splitlines():
+        line = line.strip()
+        if not line.startswith(":"):
+            continue
+        rec = bytes.fromhex(line[1:])
+        n, addr, rtype = rec[0], (rec[1] << 8) | rec[2], rec[3]
+        data = rec[4:4 + n]
+        if rtype == 0x00:
+            for i, b in enumerate(data):
+                mem[base + addr + i] = b
+        elif rtype == 0x02:
+            base = ((data[0] << 8) | data[1]) << 4
+        elif rtype == 0x04:
+            base = ((data[0] << 8) | data[1]) << 16
+        elif rtype == 0x01:
+            break
+    if not mem:
+        return b""
+    out = bytearray(b"\xff" * (max(mem) + 1))
+    for a, b in mem.items():
+        out[a] = b
+    return bytes(out)
+
+
+# =============================================================================
+# LZSS codec
+# =============================================================================
+
+def lzss_encode(data: bytes) -> bytes:
+    """Greedy LZSS encoder matching the device decoder's window rules."""
+    buf = b"\xff" * WINDOW + data     # Pre-filled history, like lzss_init()
+    out = bytearray()
+    flags_at = -1
+    nbits = 8
+    pos = WINDOW
+    end = len(buf)
+    while pos < end:
+        if nbits == 8:
+            flags_at = len(out)
+            out.append(0)
+            nbits = 0
+        best_len, best_off = 0, 0
+        limit = min(MAX_MATCH, end - pos)
+        for off in range(1, WINDOW + 1):
+            src = pos - off
+            n = 0
+            while n < limit and buf[src + n] == buf[pos + n]:
+                n += 1
+            if n > best_len:
+                best_len, best_off = n, off
+                if n == limit:
+                    break
+        if best_len >= MIN_MATCH:
+            out += bytes((best_off - 1, best_len - MIN_MATCH))
+            pos += best_len
+        else:
+            out[flags_at] |= 1 << nbits
+            out.append(buf[pos])
+            pos += 1
+        nbits += 1
+    return bytes(out)
+
+
+def lzss_decode(stream: bytes) -> bytes:
+    """Reference decoder, mirrors lzss_decode() in compress.c."""
+    window = bytearray(b"\xff" * WINDOW)
+    wpos = 0
+    out = bytearray()
+    i = 0
+    while i < len(stream):
+        flags = stream[i]
+        i += 1
+        for _ in range(8):
+            if i >= len(stream):
+                break
+            if flags & 1:
+                b = stream[i]
+                i += 1
+                window[wpos] = b
+                wpos = (wpos + 1) & 0xFF
+                out.append(b)
+            else:
+                off = stream[i] + 1
+                length = stream[i + 1] + MIN_MATCH
+                i += 2
+                for _ in range(length):
+                    b = window[(wpos - off) & 0xFF]
+                    window[wpos] = b
+                    wpos = (wpos + 1) & 0xFF
+                    out.append(b)
+            flags >>= 1
+    return bytes(out)
+
+
+def rle_encode(data: bytes) -> bytes:
+    """Mirror of the device encoder (rle_put/rle_finish in compress.c)."""
+    out = bytearray()
+    lit = bytearray()
+
+    def flush_lit():
+        if lit:
+            out.append(len(lit) - 1)
+            out.extend(lit)
+            lit.clear()
+
+    i = 0
+    while i < len(data):
+        j = i
+        while j < len(data) and data[j] == data[i] and j - i < RLE_MAX_RUN:
+            j += 1
+        run = j - i
+        if run >= RLE_MIN_RUN:
+            flush_lit()
+            n = run - RLE_MIN_RUN
+            out += bytes((0x80 | (n >> 8), n & 0xFF, data[i]))
+        else:
+            for _ in range(run):
+                if len(lit) == RLE_MAX_LITERAL:
+                    flush_lit()
+                lit.append(data[i])
+        i = j
+    flush_lit()
+    return bytes(out)
+
+
+def rle_decode(read, size: int) -> bytes:
+    """
+    Decode exactly size bytes of RLE readback.
+
+    read(n) must return the next n stream bytes; this lets the same decoder
+    run on a bytes object or directly on a serial port.
+    """
+    out = bytearray()
+    while len(out) < size:
+        c = read(1)[0]
+        if c < 0x80:
+            out += read(c + 1)
+        else:
+            lo, val = read(2)
+            out += bytes((val,)) * ((((c & 0x7F) << 8) | lo) + RLE_MIN_RUN)
+    if len(out) != size:
+        raise ValueError(f"stream overran requested size ({len(out)} > {size})")
+    return bytes(out)
+
+
+def _reader(buf: bytes):
+    pos = 0
+
+    def read(n):
+        nonlocal pos
+        chunk = buf[pos:pos + n]
+        if len(chunk) != n:
+            raise ValueError("truncated RLE stream")
+        pos += n
+        return chunk
+    return read
+
+
+# =============================================================================
+# Transfer model
+# =============================================================================
+
+def model_upload(image: bytes, page: int, sck_hz: float, rtt_s: float,
+                 usb_bps: float, page_write_s: float, compressed: bytes = None) -> float:
+    """
+    Estimate seconds to program an image.
+
+    Every frame costs one request/response round trip plus its bytes on the
+    USB link. Every page costs its ISP load instructions (two 4-byte SPI
+    transfers per word) plus the commit and the fixed page write delay.
+    """
+    pages = (len(image) + page - 1) // page
+    isp_s = pages * ((page // 2) * 2 * 32 / sck_hz + 32 / sck_hz + page_write_s)
+    if compressed is None:
+        # avrdude: LOAD_ADDRESS + PROG_PAGE per page
+        frames = 2 * pages
+        wire = pages * (4 + 2) + pages * (5 + page + 2)
+    else:
+        chunks = (len(compressed) + FRAME_MAX - 1) // FRAME_MAX + 1  # + terminator
+        frames = 1 + chunks
+        wire = (4 + 2) + len(compressed) + chunks * (5 + 2)
+    return frames * rtt_s + wire / usb_bps + isp_s
+
+
+def cmd_bench(args) -> int:
+    print(f"{'image':32s} {'bytes':>8s} {'lz':>8s} {'ratio':>6s} "
+          f"{'raw B/s':>9s} {'lz B/s':>9s} {'speedup':>7s}")
+    for path in args.images:
+        img = load_image(path)
+        if args.pad and len(img) < args.pad:
+            img = img + b"\xff" * (args.pad - len(img))
+        lz = lzss_encode(img)
+        if lzss_decode(lz)[:len(img)] != img:
+            print(f"{path}: round-trip mismatch", file=sys.stderr)
+            return 1
+        kw = dict(page=args.page, sck_hz=args.sck, rtt_s=args.rtt_ms / 1e3,
+                  usb_bps=args.usb_kbps * 1e3, page_write_s=args.write_ms / 1e3)
+        t_raw = model_upload(img, **kw)
+        t_lz = model_upload(img, compressed=lz, **kw)
+        print(f"{Path(path).name:32s} {len(img):8d} {len(lz):8d} "
+              f"{len(img) / max(len(lz), 1):6.2f} {len(img) / t_raw:9.0f} "
+              f"{len(img) / t_lz:9.0f} {t_raw / t_lz:7.2f}")
+    return 0
+
+
+def model_readback(size: int, sck_hz: float, rtt_s: float, usb_bps: float,
+                   encoded: int = None, chunk: int = 256) -> float:
+    """Estimate seconds to read size bytes: READ_PAGE loop or one RLE dump."""
+    isp_s = size * 32 / sck_hz          # one 4-byte read instruction per byte
+    if encoded is None:
+        pages = (size + chunk - 1) // chunk
+        return pages * 2 * rtt_s + pages * (6 + 5 + chunk + 2) / usb_bps + isp_s
+    return rtt_s + (6 + encoded + 2) / usb_bps + isp_s
+
+
+def cmd_roundtrip(args) -> int:
+    """Model an RLE dump of each image on an erased part; check the host codec round trip."""
+    print(f"{'image':32s} {'flash':>8s} {'rle':>8s} {'ratio':>7s} "
+          f"{'pages s':>8s} {'rle s':>8s} {'speedup':>7s}")
+    for path in args.images:
+        img = load_image(path)
+        target = bytearray(b"\xff" * max(args.flash, len(img)))   # erased part
+        target[:len(img)] = img
+        stream = rle_encode(bytes(target))
+        if rle_decode(_reader(stream), len(target)) != target:
+            print(f"{path}: round-trip mismatch", file=sys.stderr)
+            return 1
+        kw = dict(sck_hz=args.sck, rtt_s=args.rtt_ms / 1e3, usb_bps=args.usb_kbps * 1e3)
+        t_pages = model_readback(len(target), **kw)
+        t_rle = model_readback(len(target), encoded=len(stream), **kw)
+        print(f"{Path(path).name:32s} {len(target):8d} {len(stream):8d} "
+              f"{len(target) / max(len(stream), 1):7.1f} {t_pages:8.2f} "
+              f"{t_rle:8.2f} {t_pages / t_rle:7.2f}")
+    return 0
+
+
+def cmd_encode(args) -> int:
+    img = load_image(args.input)
+    lz = lzss_encode(img)
+    Path(args.output).write_bytes(lz)
+    print(f"{len(img)} -> {len(lz)} bytes ({len(img) / max(len(lz), 1):.2f}x)")
+    return 0
+
+
+# =============================================================================
+# Upload over USB CDC
+# =============================================================================
+
+def _xfer(port, frame: bytes, reply_len: int = 2) -> bytes:
+    port.write(frame)
+    rsp = port.read(reply_len)
+    if len(rsp) != reply_len or rsp[0] != INSYNC or rsp[-1] != OK:
+        raise IOError(f"bad reply to {frame[:1].hex()}: {rsp.hex()}")
+    return rsp
+
+
+def _enter(port, iface: str, clock_mhz: int = 0, spi: str = None):
+    _xfer(port, bytes((CMD_SET_PARAMETER, PARM_VND_INTERFACE, IFACES[iface], EOP)))
+    if spi:
+        _xfer(port, bytes((CMD_SET_PARAMETER, PARM_VND_SPI_BACKEND, SPI_BACKENDS[spi], EOP)))
+    _xfer(port, bytes((CMD_SET_PARAMETER, PARM_VND_TARGET_CLOCK, clock_mhz, EOP)))
+    _xfer(port, bytes((CMD_ENTER_PROGMODE, EOP)))
+
+
+def _verify_map(port) -> list:
+    """Page indices that failed inline verify this session."""
+    port.write(bytes((CMD_VERIFY_MAP, EOP)))
+    hdr = port.read(3)
+    if len(hdr) != 3 or hdr[0] != INSYNC:
+        raise IOError(f"bad reply to VERIFY_MAP: {hdr.hex()}")
+    n = hdr[1] << 8 | hdr[2]
+    body = port.read(n + 1)
+    if len(body) != n + 1 or body[-1] != OK:
+        raise IOError("truncated VERIFY_MAP reply")
+    return [i * 8 + b for i in range(n) for b in range(8) if body[i] >> b & 1]
+
+
+def cmd_upload(args) -> int:
+    import serial  # pyserial, only needed for real uploads
+
+    img = load_image(args.input)
+    lz = lzss_encode(img)
+    with serial.Serial(args.port, 115200, timeout=2) as port:
+        _xfer(port, bytes((CMD_SET_PARAMETER, PARM_VND_VERIFY, int(args.verify), EOP)))
+        _enter(port, args.iface, args.clock, args.spi)
+        try:
+            if not args.no_erase:
+                # Page writes only clear bits: programmed pages must be erased first
+                _xfer(port, bytes((CMD_CHIP_ERASE, EOP)))
+            _xfer(port, bytes((CMD_LOAD_ADDRESS, 0, 0, EOP)))
+            port.timeout = LZ_FRAME_TIMEOUT_S
+            for i in range(0, len(lz), FRAME_MAX):
+                chunk = lz[i:i + FRAME_MAX]
+                hdr = bytes((CMD_PROG_PAGE_LZ, len(chunk) >> 8, len(chunk) & 0xFF, ord("F")))
+                _xfer(port, hdr + chunk + bytes((EOP,)))
+            _xfer(port, bytes((CMD_PROG_PAGE_LZ, 0, 0, ord("F"), EOP)))
+            retried = _xfer(port, bytes((CMD_GET_PARAMETER, PARM_VND_VERIFY_RETRIED, EOP)), 3)[1]
+            _xfer(port, bytes((CMD_LEAVE_PROGMODE, EOP)))
+        except IOError:
+            if not args.verify:
+                raise
+            bad = _verify_map(port)
+            port.write(bytes((CMD_LEAVE_PROGMODE, EOP)))
+            port.read(2)
+            print(f"verify failed for page(s) {bad}; chip erase and upload again", file=sys.stderr)
+            return 1
+    print(f"uploaded {len(img)} bytes as {len(lz)} compressed bytes")
+    if args.verify:
+        print(f"verified on the programmer, {retried} page(s) rewritten")
+    return 0
+
+
+def cmd_dump(args) -> int:
+    import serial  # pyserial, only needed for real dumps
+
+    size = args.size
+    with serial.Serial(args.port, 115200, timeout=5) as port:
+        _enter(port, args.iface, args.clock, args.spi)
+        _xfer(port, bytes((CMD_LOAD_ADDRESS, 0, 0, EOP)))
+        port.write(bytes((CMD_READ_FLASH_RLE, (size >> 16) & 0xFF, (size >> 8) & 0xFF,
+                          size & 0xFF, ord("F"), EOP)))
+        if port.read(1) != bytes((INSYNC,)):
+            raise IOError("no INSYNC for READ_FLASH_RLE")
+        data = rle_decode(port.read, size)
+        if port.read(1) != bytes((OK,)):
+            raise IOError("missing OK after RLE stream")
+        _xfer(port, bytes((CMD_LEAVE_PROGMODE, EOP)))
+    Path(args.output).write_bytes(data)
+    print(f"read {size} bytes")
+    return 0
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("encode", help="compress an image to an LZSS stream")
+    p.add_argument("input")
+    p.add_argument("output")
+    p.set_defaults(fn=cmd_encode)
+
+    p = sub.add_parser("bench", help="model raw vs compressed upload throughput")
+    p.add_argument("images", nargs="+")
+    p.add_argument("--page", type=int, default=128, help="flash page size in bytes")
+    p.add_argument("--pad", type=int, default=0, help="pad images with 0xFF to this size")
+    p.add_argument("--sck", type=float, default=50000, help="ISP clock in Hz")
+    p.add_argument("--rtt-ms", type=float, default=2.0, help="USB round trip per frame")
+    p.add_argument("--usb-kbps", type=float, default=800, help="CDC payload throughput (kB/s)")
+    p.add_argument("--write-ms", type=float, default=5.0, help="page write delay")
+    p.set_defaults(fn=cmd_bench)
+
+    p = sub.add_parser("upload", help="program an image via PROG_PAGE_LZ")
+    p.add_argument("input")
+    p.add_argument("--port", required=True)
+    p.add_argument("--iface", choices=IFACES, default="isp", help="programming interface")
+    p.add_argument("--clock", type=int, default=0, choices=range(0, 256), metavar="MHZ",
+                   help="drive the target clock output during programming (0 = off)")
+    p.add_argument("--spi", choices=SPI_BACKENDS, help="ISP transport (default: firmware's power-up choice)")
+    p.add_argument("--verify", action="store_true", help="verify each page on the programmer, retrying failures")
+    p.add_argument("--no-erase", action="store_true", help="skip the chip erase (only for appending to erased flash)")
+    p.set_defaults(fn=cmd_upload)
+
+    p = sub.add_parser("roundtrip", help="model RLE readback time (host codec round trip)")
+    p.add_argument("images", nargs="+")
+    p.add_argument("--flash", type=int, default=32768, help="simulated flash size in bytes")
+    p.add_argument("--sck", type=float, default=50000, help="ISP clock in Hz")
+    p.add_argument("--rtt-ms", type=float, default=2.0, help="USB round trip per frame")
+    p.add_argument("--usb-kbps", type=float, default=800, help="CDC payload throughput (kB/s)")
+    p.set_defaults(fn=cmd_roundtrip)
+
+    p = sub.add_parser("dump", help="read flash via READ_FLASH_RLE")
+    p.add_argument("output")
+    p.add_argument("--size", type=int, required=True, help="bytes to read")
+    p.add_argument("--port", required=True)
+    p.add_argument("--iface", choices=IFACES, default="isp", help="programming interface")
+    p.add_argument("--clock", type=int, default=0, choices=range(0, 256), metavar="MHZ",
+                   help="drive the target clock output during programming (0 = off)")
+    p.add_argument("--spi", choices=SPI_BACKENDS, help="ISP transport (default: firmware's power-up choice)")
+    p.set_defaults(fn=cmd_dump)
+
+    args = ap.parse_args()
+    return args.fn(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,499 @@
+/**
+ * @file debugwire.c
+ * @brief debugWIRE Link, Memory Access and Flash Programming
+ *
+ * Layers:
+ *   - Link: break + 0x55 autobaud, PIO UART (debugwire.pio) with echo
+ *     removal and per-byte timeouts
+ *   - Access: register, SRAM and flash reads through the dW memory
+ *     commands; register writes
+ *   - Flash: SPM executed from the instruction register, with the PC
+ *     parked in the boot section so RWW parts accept it
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "debugwire.h"
+#include "avr_devices.h"
+#include <pico/stdlib.h>
+#include "hardware/clocks.h"
+#include "hardware/pio.h"
+#include "hardware/structs/systick.h"
+#include "debugwire.pio.h"
+
+#define DW_PIO           pio0
+
+/*******************************************************************************
+ * debugWIRE Commands
+ ******************************************************************************/
+#define DW_SYNC              0x55
+
+#define DW_CMD_DISABLE       0x06    /* dW off until power cycle */
+#define DW_CMD_RESET         0x07    /* Target answers break + 0x55 */
+#define DW_CMD_MEM_GO        0x20    /* Start the memory access set up by C2 */
+#define DW_CMD_EXEC          0x23    /* Execute the instruction in IR */
+#define DW_CMD_GO            0x30    /* Run from PC */
+#define DW_CMD_EXEC_SPM      0x33    /* Execute IR (SPM) */
+#define DW_CMD_MODE          0xC2
+#define DW_CMD_SET_PC        0xD0
+#define DW_CMD_SET_BP        0xD1
+#define DW_CMD_SET_IR        0xD2
+#define DW_CMD_DEVICE_ID     0xF3
+
+#define DW_CTX_RUN           0x60
+#define DW_CTX_EXEC          0x64
+#define DW_CTX_MEMORY        0x66
+
+#define DW_MODE_READ_SRAM    0x00
+#define DW_MODE_READ_REGS    0x01
+#define DW_MODE_READ_FLASH   0x02
+#define DW_MODE_WRITE_REGS   0x05
+
+/* Instructions executed through IR (SPMCSR is I/O 0x37 on all dW parts) */
+#define AVR_OUT_SPMCSR_R29   0xBFD7
+#define AVR_SPM              0x95E8
+#define AVR_ADIW_Z_2         0x9632
+
+#define SPM_SPMEN            0x01
+#define SPM_PGERS            0x03
+#define SPM_PGWRT            0x05
+#define SPM_RWWSRE           0x11
+
+#define DW_BREAK_MS          20      /* Longer than a frame at 1000 baud */
+#define DW_SYNC_TIMEOUT_MS   50
+#define DW_MAX_CHUNK         128     /* Bytes per memory read command */
+#define DW_TX_DEPTH          4
+
+/*******************************************************************************
+ * Private Variables
+ ******************************************************************************/
+static int sm_tx = -1;
+static int sm_rx = -1;
+static uint offset_tx;
+static uint offset_rx;
+static bool loaded = false;
+static uint32_t baud = 0;
+static uint32_t byte_timeout_us = 1000;
+static bool link_error = false;
+static const avr_device_t* device = NULL;
+
+/*******************************************************************************
+ * Link Layer
+ ******************************************************************************/
+
+/**
+ * @brief Time the target's 0x55 answer in system clock cycles
+ *
+ * 0x55 on the wire is start(0) 1 0 1 0 1 0 1 0 stop(1): from the first
+ * falling edge to the fifth rising edge is exactly nine bits. SysTick runs
+ * at the core clock, so the measurement resolution is a few cycles.
+ *
+ * @return Cycles for nine bits, 0 if the target did not answer
+ */
+static uint32_t __not_in_flash_func(measure_sync)(void) {
+    absolute_time_t deadline = make_timeout_time_ms(DW_SYNC_TIMEOUT_MS);
+
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;  /* Enable, processor clock */
+
+    while (gpio_get(DW_PIN)) {
+        if (time_reached(deadline)) {
+            return 0;
+        }
+    }
+    uint32_t start = systick_hw->cvr;
+    for (int rising = 0; rising < 5; rising++) {
+        while (!gpio_get(DW_PIN)) {
+            if (time_reached(deadline)) {
+                return 0;
+            }
+        }
+        if (rising == 4) {
+            break;
+        }
+        while (gpio_get(DW_PIN)) {
+            if (time_reached(deadline)) {
+                return 0;
+            }
+        }
+    }
+    /* SysTick counts down */
+    return (start - systick_hw->cvr) & 0x00FFFFFF;
+}
+
+static void link_start(void) {
+    float clkdiv = (float)clock_get_hz(clk_sys) / (8.0f * (float)baud);
+    dw_tx_program_init(DW_PIO, (uint)sm_tx, offset_tx, DW_PIN, clkdiv);
+    dw_rx_program_init(DW_PIO, (uint)sm_rx, offset_rx, DW_PIN, clkdiv);
+    pio_sm_set_enabled(DW_PIO, (uint)sm_rx, true);
+    pio_sm_set_enabled(DW_PIO, (uint)sm_tx, true);
+}
+
+static void link_stop(void) {
+    pio_sm_set_enabled(DW_PIO, (uint)sm_tx, false);
+    pio_sm_set_enabled(DW_PIO, (uint)sm_rx, false);
+    pio_sm_clear_fifos(DW_PIO, (uint)sm_tx);
+    pio_sm_clear_fifos(DW_PIO, (uint)sm_rx);
+}
+
+static bool read_byte(uint8_t* out) {
+    absolute_time_t deadline = make_timeout_time_us(byte_timeout_us);
+    while (pio_sm_is_rx_fifo_empty(DW_PIO, (uint)sm_rx)) {
+        if (time_reached(deadline)) {
+            link_error = true;
+            return false;
+        }
+    }
+    *out = (uint8_t)(pio_sm_get(DW_PIO, (uint)sm_rx) >> 24);
+    return true;
+}
+
+/**
+ * @brief Send bytes and consume their echo, keeping the TX FIFO primed
+ */
+static void dw_send(const uint8_t* data, size_t len) {
+    size_t sent = 0;
+    size_t echoed = 0;
+    uint8_t echo;
+
+    while (echoed < len && !link_error) {
+        while (sent < len && sent - echoed < DW_TX_DEPTH) {
+            pio_sm_put(DW_PIO, (uint)sm_tx, (uint8_t)~data[sent]);
+            sent++;
+        }
+        if (!read_byte(&echo)) {
+            return;
+        }
+        echoed++;
+    }
+}
+
+static void dw_recv(uint8_t* out, size_t len) {
+    for (size_t i = 0; i < len && !link_error; i++) {
+        read_byte(&out[i]);
+    }
+}
+
+/**
+ * @brief Break on the running link and wait for the target's 0x55
+ *
+ * Needed after SPM, which leaves the target busy and out of step.
+ */
+static bool dw_sync(void) {
+    uint8_t b = 0;
+    uint32_t break_us = 20u * 1000000u / baud + 100u;
+
+    pio_sm_exec(DW_PIO, (uint)sm_tx, pio_encode_set(pio_pindirs, 1));
+    sleep_us(break_us);
+    pio_sm_exec(DW_PIO, (uint)sm_tx, pio_encode_set(pio_pindirs, 0));
+
+    link_error = false;
+    absolute_time_t deadline = make_timeout_time_ms(DW_SYNC_TIMEOUT_MS);
+    while (!time_reached(deadline)) {
+        if (!pio_sm_is_rx_fifo_empty(DW_PIO, (uint)sm_rx)) {
+            b = (uint8_t)(pio_sm_get(DW_PIO, (uint)sm_rx) >> 24);
+            if (b == DW_SYNC) {
+                return true;
+            }
+        }
+    }
+    link_error = true;
+    return false;
+}
+
+/*******************************************************************************
+ * Access Layer
+ ******************************************************************************/
+
+static void set_pc(uint16_t word_addr) {
+    uint8_t frame[3] = {DW_CMD_SET_PC, (uint8_t)(word_addr >> 8), (uint8_t)word_addr};
+    dw_send(frame, sizeof(frame));
+}
+
+/** Set up a memory command: PC = start, BP = end, mode, go */
+static void mem_command(uint16_t start, uint16_t end, uint8_t mode) {
+    uint8_t frame[10] = {
+        DW_CTX_MEMORY,
+        DW_CMD_SET_PC, (uint8_t)(start >> 8), (uint8_t)start,
+        DW_CMD_SET_BP, (uint8_t)(end >> 8), (uint8_t)end,
+        DW_CMD_MODE, mode, DW_CMD_MEM_GO,
+    };
+    dw_send(frame, sizeof(frame));
+}
+
+static void exec_insn(uint16_t insn, uint8_t how) {
+    uint8_t frame[4] = {DW_CMD_SET_IR, (uint8_t)(insn >> 8), (uint8_t)insn, how};
+    dw_send(frame, sizeof(frame));
+}
+
+static void set_z(uint16_t addr) {
+    uint8_t z[2] = {(uint8_t)addr, (uint8_t)(addr >> 8)};
+    dw_write_registers(30, z, 2);
+}
+
+/**
+ * @brief Read general purpose registers first..first+len-1
+ */
+void dw_read_registers(uint8_t first, uint8_t* out, size_t len) {
+    mem_command(first, (uint16_t)(first + len), DW_MODE_READ_REGS);
+    dw_recv(out, len);
+}
+
+/**
+ * @brief Write general purpose registers first..first+len-1
+ */
+void dw_write_registers(uint8_t first, const uint8_t* data, size_t len) {
+    mem_command(first, (uint16_t)(first + len), DW_MODE_WRITE_REGS);
+    dw_send(data, len);
+}
+
+/**
+ * @brief Read len bytes of data space starting at addr (Z is clobbered)
+ */
+void dw_read_sram(uint16_t addr, uint8_t* out, size_t len) {
+    for (size_t off = 0; off < len && !link_error; off += DW_MAX_CHUNK) {
+        size_t n = len - off < DW_MAX_CHUNK ? len - off : DW_MAX_CHUNK;
+        set_z((uint16_t)(addr + off));
+        mem_command(0, (uint16_t)(n * 2), DW_MODE_READ_SRAM);
+        dw_recv(out + off, n);
+    }
+}
+
+/**
+ * @brief Read the 16-bit device ID (signature bytes 1 and 2)
+ */
+uint16_t dw_read_device_id(void) {
+    uint8_t cmd = DW_CMD_DEVICE_ID;
+    uint8_t id[2] = {0, 0};
+    dw_send(&cmd, 1);
+    dw_recv(id, 2);
+    return (uint16_t)((id[0] << 8) | id[1]);
+}
+
+/*******************************************************************************
+ * Flash (SPM through the instruction register)
+ ******************************************************************************/
+
+/** Any word in the smallest boot section: SPM is only allowed from there */
+static uint16_t boot_pc(void) {
+    return (uint16_t)(device->flash_size_bytes / 2 - 64);
+}
+
+/**
+ * @brief Run one SPM operation on the page containing byte_addr
+ */
+static void spm_page(uint8_t spmcsr, uint32_t byte_addr) {
+    uint8_t regs[3] = {spmcsr, (uint8_t)byte_addr, (uint8_t)(byte_addr >> 8)};
+    uint8_t ctx = DW_CTX_EXEC;
+
+    dw_write_registers(29, regs, sizeof(regs));  /* r29 = SPMCSR value, Z */
+    set_pc(boot_pc());
+    dw_send(&ctx, 1);
+    exec_insn(AVR_OUT_SPMCSR_R29, DW_CMD_EXEC);
+    exec_insn(AVR_SPM, DW_CMD_EXEC_SPM);
+    sleep_us(device->flash_write_us);
+    dw_sync();
+}
+
+/*******************************************************************************
+ * Connection
+ ******************************************************************************/
+
+/**
+ * @brief Break, measure the target's rate and start the UART
+ */
+bool dw_connect(void) {
+    if (!loaded) {
+        if (!pio_can_add_program(DW_PIO, &dw_tx_program)) {
+            return false;
+        }
+        offset_tx = pio_add_program(DW_PIO, &dw_tx_program);
+        if (!pio_can_add_program(DW_PIO, &dw_rx_program)) {
+            pio_remove_program(DW_PIO, &dw_tx_program, offset_tx);
+            return false;
+        }
+        offset_rx = pio_add_program(DW_PIO, &dw_rx_program);
+        loaded = true;
+        sm_tx = pio_claim_unused_sm(DW_PIO, false);
+        sm_rx = pio_claim_unused_sm(DW_PIO, false);
+        if (sm_tx < 0 || sm_rx < 0) {
+            dw_release();
+            return false;
+        }
+    } else {
+        link_stop();
+    }
+
+    /* Break: hold RESET low, then let the pull-ups take it */
+    gpio_init(DW_PIN);
+    gpio_pull_up(DW_PIN);
+    gpio_set_dir(DW_PIN, GPIO_OUT);
+    gpio_put(DW_PIN, 0);
+    sleep_ms(DW_BREAK_MS);
+    gpio_set_dir(DW_PIN, GPIO_IN);
+
+    uint32_t cycles = measure_sync();
+    if (cycles == 0) {
+        dw_release();
+        return false;
+    }
+    baud = (uint32_t)((uint64_t)clock_get_hz(clk_sys) * 9 / cycles);
+    byte_timeout_us = 40u * 1000000u / baud + 1000u;
+    link_error = false;
+    link_start();
+    return true;
+}
+
+/**
+ * @brief Stop the UART and hand RESET back to the ISP driver
+ */
+void dw_release(void) {
+    if (sm_tx >= 0) {
+        pio_sm_set_enabled(DW_PIO, (uint)sm_tx, false);
+        pio_sm_unclaim(DW_PIO, (uint)sm_tx);
+    }
+    if (sm_rx >= 0) {
+        pio_sm_set_enabled(DW_PIO, (uint)sm_rx, false);
+        pio_sm_unclaim(DW_PIO, (uint)sm_rx);
+    }
+    if (loaded) {
+        pio_remove_program(DW_PIO, &dw_tx_program, offset_tx);
+        pio_remove_program(DW_PIO, &dw_rx_program, offset_rx);
+        loaded = false;
+    }
+    sm_tx = sm_rx = -1;
+    baud = 0;
+
+    /* Same state avr_spi_init() leaves RESET in */
+    gpio_init(DW_PIN);
+    gpio_set_dir(DW_PIN, GPIO_OUT);
+    gpio_put(DW_PIN, 1);
+}
+
+/**
+ * @brief Get the measured debugWIRE baud rate (0 if not connected)
+ */
+uint32_t dw_baud(void) {
+    return baud;
+}
+
+/**
+ * @brief Turn debugWIRE off until the next power cycle
+ */
+bool dw_disable(void) {
+    if (!dw_connect()) {
+        return false;
+    }
+    uint8_t cmd = DW_CMD_DISABLE;
+    dw_send(&cmd, 1);
+    bool ok = !link_error;
+    dw_release();
+    return ok;
+}
+
+/*******************************************************************************
+ * Interface Operations
+ ******************************************************************************/
+
+static bool dw_enter(void) {
+    if (!dw_connect()) {
+        return false;
+    }
+    uint16_t id = dw_read_device_id();
+    uint8_t sig[3] = {0x1E, (uint8_t)(id >> 8), (uint8_t)id};
+    device = avr_lookup_device_by_signature(sig);
+    if (link_error || !device || !(device->flags & AVR_DEV_DEBUGWIRE)) {
+        dw_release();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reset the target, let it run and release RESET
+ */
+static void dw_leave(void) {
+    if (sm_tx < 0) {
+        return;
+    }
+    uint8_t reset = DW_CMD_RESET;
+    uint8_t go[5] = {DW_CTX_RUN, DW_CMD_SET_PC, 0x00, 0x00, DW_CMD_GO};
+    dw_send(&reset, 1);
+    sleep_ms(DW_SYNC_TIMEOUT_MS);
+    link_stop();
+    link_start();
+    link_error = false;
+    dw_send(go, sizeof(go));
+    dw_release();
+}
+
+/**
+ * @brief Emulate signature reads; dW has no fuse or lock access
+ */
+static void dw_universal(const uint8_t cmd[4], uint8_t rx[4]) {
+    rx[0] = rx[1] = rx[2] = rx[3] = 0;
+    if (cmd[0] == 0x30) {
+        uint8_t idx = cmd[2] & 0x03;
+        rx[3] = idx == 0 ? 0x1E : device->signature[idx];
+    }
+}
+
+static bool dw_poll_ready(uint32_t timeout_us) {
+    /* SPM operations already waited and resynchronised */
+    (void)timeout_us;
+    return !link_error;
+}
+
+/**
+ * @brief Erase every page (dW has no chip erase; lock bits stay)
+ */
+static void dw_chip_erase(void) {
+    for (uint32_t a = 0; a < device->flash_size_bytes && !link_error; a += device->page_size_bytes) {
+        spm_page(SPM_PGERS, a);
+    }
+}
+
+/**
+ * @brief Erase the page, fill the page buffer word by word and write it
+ */
+static void dw_write_flash_page(uint32_t byte_addr, const uint8_t* data, size_t len) {
+    uint8_t ctx = DW_CTX_EXEC;
+    uint8_t regs[3] = {SPM_SPMEN, (uint8_t)byte_addr, (uint8_t)(byte_addr >> 8)};
+
+    spm_page(SPM_PGERS, byte_addr);
+
+    dw_write_registers(29, regs, sizeof(regs));
+    for (size_t off = 0; off + 1 < len && !link_error; off += 2) {
+        dw_write_registers(0, data + off, 2);
+        set_pc(boot_pc());
+        dw_send(&ctx, 1);
+        exec_insn(AVR_OUT_SPMCSR_R29, DW_CMD_EXEC);
+        exec_insn(AVR_SPM, DW_CMD_EXEC_SPM);
+        exec_insn(AVR_ADIW_Z_2, DW_CMD_EXEC);
+    }
+
+    spm_page(SPM_PGWRT, byte_addr);
+    spm_page(SPM_RWWSRE, byte_addr);
+}
+
+static void dw_read_flash(uint32_t byte_addr, uint8_t* out, size_t len) {
+    for (size_t off = 0; off < len && !link_error; off += DW_MAX_CHUNK) {
+        size_t n = len - off < DW_MAX_CHUNK ? len - off : DW_MAX_CHUNK;
+        set_z((uint16_t)(byte_addr + off));
+        mem_command(0, (uint16_t)(n * 2), DW_MODE_READ_FLASH);
+        dw_recv(out + off, n);
+    }
+}
+
+const avr_iface_t avr_iface_dw = {
+    .name = "debugWIRE",
+    .enter = dw_enter,
+    .leave = dw_leave,
+    .universal = dw_universal,
+    .poll_ready = dw_poll_ready,
+    .chip_erase = dw_chip_erase,
+    .write_flash_page = dw_write_flash_page,
+    .read_flash = dw_read_flash,
+};
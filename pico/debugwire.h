@@ -0,0 +1,96 @@
+/**
+ * @file debugwire.h
+ * @brief debugWIRE Access for Parts with the DWEN Fuse Programmed
+ *
+ * With DWEN programmed the RESET pin becomes a single-wire, open-drain
+ * UART running at f_cpu/128 and ISP no longer works. This module talks
+ * that protocol on the ISP RESET pin so such parts can be read, written
+ * and switched back to ISP without another tool.
+ *
+ * Connection:
+ *   A long break (RESET held low) makes the target answer 0x55 at its own
+ *   rate. The 0x55 edges are timed with SysTick and the PIO UART
+ *   (debugwire.pio) is clocked to match, so no baud rate is configured.
+ *
+ * Uses:
+ *   - AVR_IFACE_DW: flash read/write and signature through dW itself
+ *   - dw_disable(): opt-in fallback in avr_enter_programming_mode()
+ *     (avr_dw_fallback_enable()); turns dW off until the next power
+ *     cycle so ISP can connect. Program DWEN (usually the high fuse)
+ *     unprogrammed in that session to make it permanent.
+ *
+ * The command set follows the publicly documented reverse-engineered
+ * protocol. Register and memory access clobber r28..r31 and the PC; the
+ * target is reset on leave.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "avr_iface.h"
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+#ifndef DW_PIN
+#define DW_PIN   17    /* Target RESET (ISP RESET pin) */
+#endif
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/**
+ * @brief Break, measure the target's rate and start the UART
+ *
+ * @return true if the target answered the break with 0x55
+ */
+bool dw_connect(void);
+
+/**
+ * @brief Stop the UART and hand RESET back to the ISP driver
+ */
+void dw_release(void);
+
+/**
+ * @brief Get the measured debugWIRE baud rate (0 if not connected)
+ */
+uint32_t dw_baud(void);
+
+/**
+ * @brief Read the 16-bit device ID (signature bytes 1 and 2)
+ */
+uint16_t dw_read_device_id(void);
+
+/**
+ * @brief Read general purpose registers first..first+len-1
+ */
+void dw_read_registers(uint8_t first, uint8_t* out, size_t len);
+
+/**
+ * @brief Write general purpose registers first..first+len-1
+ */
+void dw_write_registers(uint8_t first, const uint8_t* data, size_t len);
+
+/**
+ * @brief Read len bytes of data space (I/O and SRAM) starting at addr
+ */
+void dw_read_sram(uint16_t addr, uint8_t* out, size_t len);
+
+/**
+ * @brief Turn debugWIRE off until the next power cycle
+ *
+ * Connects, sends the disable command and releases RESET, so the part
+ * accepts ISP programming enable right after.
+ *
+ * @return true if a debugWIRE target answered
+ */
+bool dw_disable(void);
+
+/** debugWIRE implementation of the programming interface operations */
+extern const avr_iface_t avr_iface_dw;
@@ -0,0 +1,236 @@
+/**
+ * @file flash_store.c
+ * @brief Wear-levelled Record Store in the Last Sectors of QSPI Flash
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "flash_store.h"
+#include <string.h>
+#include <pico/stdlib.h>
+#include <hardware/flash.h>
+#include <hardware/sync.h>
+
+/*******************************************************************************
+ * Layout
+ ******************************************************************************/
+
+#define STORE_SECTORS       2
+#define STORE_OFFSET        (PICO_FLASH_SIZE_BYTES - STORE_SECTORS * FLASH_SECTOR_SIZE)
+#define SLOT_BYTES          16
+#define SLOTS               (FLASH_SECTOR_SIZE / SLOT_BYTES)
+#define SLOTS_PER_PAGE      (FLASH_PAGE_SIZE / SLOT_BYTES)
+
+#define MAGIC_HEADER        0xA55A
+#define MAGIC_RECORD        0x5AA5
+
+typedef struct {
+    uint16_t magic;     /* MAGIC_HEADER or MAGIC_RECORD */
+    uint16_t check;     /* Fletcher-16 over key and data */
+    uint32_t key;       /* Header: generation */
+    uint8_t data[FLASH_STORE_DATA_BYTES];
+} store_slot_t;
+
+_Static_assert(sizeof(store_slot_t) == SLOT_BYTES, "slot layout");
+
+static uint8_t active;          /* Active sector index */
+static uint32_t generation;     /* Generation of the active sector */
+static size_t next_slot;        /* First blank slot in the active sector */
+
+/*******************************************************************************
+ * Flash Access
+ ******************************************************************************/
+
+static uint32_t sector_offset(uint8_t sector) {
+    return STORE_OFFSET + (uint32_t)sector * FLASH_SECTOR_SIZE;
+}
+
+static const store_slot_t* slot_at(uint8_t sector, size_t slot) {
+    return (const store_slot_t*)(uintptr_t)(XIP_BASE + sector_offset(sector)) + slot;
+}
+
+static void erase_sector(uint8_t sector) {
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(sector_offset(sector), FLASH_SECTOR_SIZE);
+    restore_interrupts(irq);
+}
+
+/**
+ * @brief Program slots [first, first + count) of one flash page
+ *
+ * The rest of the page is programmed as 0xFF, which leaves it unchanged.
+ */
+static void program_slots(uint8_t sector, size_t first, const store_slot_t* slots, size_t count) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    size_t page_first = first - first % SLOTS_PER_PAGE;
+
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page + (first - page_first) * SLOT_BYTES, slots, count * SLOT_BYTES);
+
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_program(sector_offset(sector) + (uint32_t)page_first * SLOT_BYTES, page, FLASH_PAGE_SIZE);
+    restore_interrupts(irq);
+}
+
+/*******************************************************************************
+ * Slots
+ ******************************************************************************/
+
+static uint16_t slot_check(const store_slot_t* s) {
+    uint8_t bytes[4 + FLASH_STORE_DATA_BYTES];
+    uint16_t a = 0, b = 0;
+
+    memcpy(bytes, &s->key, 4);
+    memcpy(bytes + 4, s->data, FLASH_STORE_DATA_BYTES);
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        a = (uint16_t)((a + bytes[i]) % 255);
+        b = (uint16_t)((b + a) % 255);
+    }
+    return (uint16_t)(b << 8 | a);
+}
+
+static void slot_fill(store_slot_t* s, uint16_t magic, uint32_t key, const uint8_t* data) {
+    s->magic = magic;
+    s->key = key;
+    memcpy(s->data, data, FLASH_STORE_DATA_BYTES);
+    s->check = slot_check(s);
+}
+
+static bool slot_valid(const store_slot_t* s, uint16_t magic) {
+    return s->magic == magic && s->check == slot_check(s);
+}
+
+static bool slot_blank(const store_slot_t* s) {
+    const uint8_t* p = (const uint8_t*)s;
+    for (size_t i = 0; i < SLOT_BYTES; i++) {
+        if (p[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Newest valid record for key in the active sector, or NULL */
+static const store_slot_t* find(uint32_t key) {
+    for (size_t i = next_slot; i-- > 1;) {
+        const store_slot_t* s = slot_at(active, i);
+        if (slot_valid(s, MAGIC_RECORD) && s->key == key) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Copy the newest record of every key into the other sector
+ *
+ * The header goes in last, so the copy only becomes active once complete.
+ */
+static void compact(void) {
+    uint8_t target = active ^ 1;
+    store_slot_t page[SLOTS_PER_PAGE];
+    size_t out = 1;
+    size_t batch_first = 1;
+    size_t batch = 0;
+
+    erase_sector(target);
+    for (size_t i = 1; i < next_slot; i++) {
+        const store_slot_t* s = slot_at(active, i);
+        if (!slot_valid(s, MAGIC_RECORD) || find(s->key) != s) {
+            continue;   /* Torn or superseded */
+        }
+        page[batch++] = *s;
+        out++;
+        if (out % SLOTS_PER_PAGE == 0) {
+            program_slots(target, batch_first, page, batch);
+            batch_first = out;
+            batch = 0;
+        }
+    }
+    if (batch) {
+        program_slots(target, batch_first, page, batch);
+    }
+
+    store_slot_t header;
+    uint8_t none[FLASH_STORE_DATA_BYTES];
+    memset(none, 0xFF, sizeof(none));
+    slot_fill(&header, MAGIC_HEADER, generation + 1, none);
+    program_slots(target, 0, &header, 1);
+
+    active = target;
+    generation++;
+    next_slot = out;
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/**
+ * @brief Locate the active sector, formatting the store if neither is valid
+ */
+void flash_store_init(void) {
+    bool found = false;
+
+    for (uint8_t sector = 0; sector < STORE_SECTORS; sector++) {
+        const store_slot_t* h = slot_at(sector, 0);
+        if (slot_valid(h, MAGIC_HEADER) && (!found || h->key > generation)) {
+            active = sector;
+            generation = h->key;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        store_slot_t header;
+        uint8_t none[FLASH_STORE_DATA_BYTES];
+        memset(none, 0xFF, sizeof(none));
+        erase_sector(0);
+        slot_fill(&header, MAGIC_HEADER, 1, none);
+        program_slots(0, 0, &header, 1);
+        active = 0;
+        generation = 1;
+    }
+
+    /* Records are appended in order: the first blank slot ends the log */
+    next_slot = 1;
+    while (next_slot < SLOTS && !slot_blank(slot_at(active, next_slot))) {
+        next_slot++;
+    }
+}
+
+/**
+ * @brief Read the newest record for a key
+ */
+bool flash_store_get(uint32_t key, uint8_t data[FLASH_STORE_DATA_BYTES]) {
+    const store_slot_t* s = find(key);
+    if (!s) {
+        return false;
+    }
+    memcpy(data, s->data, FLASH_STORE_DATA_BYTES);
+    return true;
+}
+
+/**
+ * @brief Store a record for a key
+ */
+bool flash_store_put(uint32_t key, const uint8_t data[FLASH_STORE_DATA_BYTES]) {
+    const store_slot_t* old = find(key);
+    if (old && memcmp(old->data, data, FLASH_STORE_DATA_BYTES) == 0) {
+        return true;
+    }
+
+    if (next_slot >= SLOTS) {
+        compact();
+        if (next_slot >= SLOTS) {
+            return false;
+        }
+    }
+
+    store_slot_t s;
+    slot_fill(&s, MAGIC_RECORD, key, data);
+    program_slots(active, next_slot, &s, 1);
+    next_slot++;
+    return true;
+}
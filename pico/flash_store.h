@@ -0,0 +1,64 @@
+/**
+ * @file flash_store.h
+ * @brief Wear-levelled Record Store in the Last Sectors of QSPI Flash
+ *
+ * Small key/value records that survive power cycles, used for settings
+ * learned per target (see avr_profile.h).
+ *
+ * Layout:
+ *   Two 4 KB sectors at the end of flash, well past the firmware image.
+ *   Each holds 16-byte slots: slot 0 is a header carrying a generation
+ *   count, the rest are records appended in order. The sector with the
+ *   valid header of the highest generation is active.
+ *
+ * Wear Levelling:
+ *   Updates are appended, never rewritten in place; the newest record of
+ *   a key wins. When the active sector is full, the newest record of each
+ *   key is copied into the other sector and its header is programmed last,
+ *   so a power loss mid-compaction leaves the old sector active. Erases
+ *   alternate between the two sectors, one per 255 updates.
+ *
+ * Integrity:
+ *   Every slot carries a checksum; a torn write is skipped as used.
+ *
+ * Flash programming stalls XIP with interrupts disabled (a page program
+ * takes under 1 ms, a sector erase tens of ms during compaction), so
+ * records are only written at session boundaries.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Payload bytes per record */
+#define FLASH_STORE_DATA_BYTES  8
+
+/**
+ * @brief Locate the active sector, formatting the store if neither is valid
+ *
+ * Call once at startup before the other functions.
+ */
+void flash_store_init(void);
+
+/**
+ * @brief Read the newest record for a key
+ *
+ * @param key  Record key (0xFFFFFFFF is reserved)
+ * @param data Receives FLASH_STORE_DATA_BYTES bytes
+ * @return false if the key has no record
+ */
+bool flash_store_get(uint32_t key, uint8_t data[FLASH_STORE_DATA_BYTES]);
+
+/**
+ * @brief Store a record for a key
+ *
+ * Nothing is written if the newest record already holds the same data.
+ *
+ * @return false if the store is full of distinct keys
+ */
+bool flash_store_put(uint32_t key, const uint8_t data[FLASH_STORE_DATA_BYTES]);
@@ -0,0 +1,545 @@
+#!/usr/bin/env python3
+"""
+gen_avr_devices.py - Generate the Firmware Device Table from avrdude.conf / ATDF
+
+Reads part descriptions from avrdude.conf-style files and/or Microchip ATDF
+files and writes avr_devices_table.h, which avr_devices.c compiles into a
+constant table plus a perfect hash over the signature. Run by CMake at build
+time; can be run by hand to inspect the result.
+
+Usage:
+    python3 gen_avr_devices.py -o avr_devices_table.h devices/avrdude-parts.conf
+    python3 gen_avr_devices.py -o table.h /usr/share/avrdude/avrdude.conf
+    python3 gen_avr_devices.py -o table.h ATmega328P.atdf ATtiny85.atdf
+    python3 gen_avr_devices.py --list devices/avrdude-parts.conf
+
+Sources:
+    - avrdude.conf syntax (6.x and 7.x), including "part parent" inheritance.
+      Template parts (id starting with '.') and parts without a signature
+      are skipped.
+    - ATDF (*.atdf): signature, memory segments, interfaces and the ISP
+      timing/poll properties.
+    - When two parts share a signature, the first one read wins.
+
+Perfect Hash (must match avr_devices.c):
+    key    = sig[1] << 8 | sig[2]
+    x      = (uint32)((k | s << 16) * 0x9E3779B1)
+    h(k,s) = (uint32)((x ^ x >> 15) * 0x85EBCA6B)
+    bucket = h(key, 0) >> (32 - BUCKET_BITS)
+    slot   = h(key, disp[bucket] + 1) >> (32 - SLOT_BITS)
+    index  = slot_table[slot]        (EMPTY if no device)
+    The full signature is compared afterwards, so unknown parts miss.
+
+The generator checks every entry against this lookup before writing.
+
+Author: MUdroThe1
+Date: 2026
+"""
+
+import argparse
+import re
+import sys
+import xml.etree.ElementTree as ET
+from pathlib import Path
+
+HASH_MUL = 0x9E3779B1
+HASH_MUL2 = 0x85EBCA6B
+MAX_DISP = 256
+
+# Flags (must match avr_devices.h)
+FLAGS = {
+    "ISP":          0x0001,
+    "TPI":          0x0002,
+    "PDI":          0x0004,
+    "UPDI":         0x0008,
+    "DEBUGWIRE":    0x0010,
+    "HAS_EFUSE":    0x0020,
+    "PAGED_EEPROM": 0x0040,
+    "EXT_ADDR":     0x0080,
+}
+
+PROG_MODE_FLAGS = {
+    "PM_ISP": "ISP",
+    "PM_TPI": "TPI",
+    "PM_PDI": "PDI",
+    "PM_UPDI": "UPDI",
+    "PM_debugWIRE": "DEBUGWIRE",
+}
+
+
+# =============================================================================
+# Device record
+# =============================================================================
+
+class Device:
+    def __init__(self, name, sig):
+        self.name = name
+        self.sig = sig
+        self.flash_size = 0
+        self.page_size = 0
+        self.eeprom_size = 0
+        self.eeprom_page = 0
+        self.flash_poll = 0xFF
+        self.eeprom_poll = 0xFF
+        self.flash_write_us = 0
+        self.eeprom_write_us = 0
+        self.erase_us = 0
+        self.flags = set()
+
+    def check(self):
+        if self.page_size > 0xFFFF or self.eeprom_size > 0xFFFF:
+            raise ValueError(f"{self.name}: memory geometry out of range")
+        if self.eeprom_page > 0xFF:
+            raise ValueError(f"{self.name}: EEPROM page > 255 bytes")
+
+
+def clamp_u16(v: int) -> int:
+    return max(0, min(int(v), 0xFFFF))
+
+
+# =============================================================================
+# avrdude.conf
+# =============================================================================
+
+TOKEN_RE = re.compile(r'''
+    (?P<comment>\#[^\n]*)
+  | (?P<string>"(?:[^"\\]|\\.)*")
+  | (?P<number>0[xX][0-9a-fA-F]+|-?\d+)
+  | (?P<ident>[A-Za-z_.][A-Za-z0-9_.\-]*)
+  | (?P<punct>[=;,|])
+  | (?P<space>\s+)
+''', re.VERBOSE)
+
+
+def tokenize(text: str, path: str):
+    pos = 0
+    line = 1
+    while pos < len(text):
+        m = TOKEN_RE.match(text, pos)
+        if not m:
+            raise SyntaxError(f"{path}:{line}: unexpected {text[pos]!r}")
+        kind = m.lastgroup
+        value = m.group()
+        if kind == "string":
+            yield ("string", value[1:-1], line)
+        elif kind == "number":
+            yield ("number", int(value, 0), line)
+        elif kind in ("ident", "punct"):
+            yield (kind, value, line)
+        line += value.count("\n")
+        pos = m.end()
+
+
+class ConfParser:
+    def __init__(self, text: str, path: str):
+        self.tokens = list(tokenize(text, path))
+        self.pos = 0
+        self.path = path
+
+    def peek(self):
+        return self.tokens[self.pos] if self.pos < len(self.tokens) else (None, None, 0)
+
+    def next(self):
+        tok = self.peek()
+        self.pos += 1
+        return tok
+
+    def expect(self, value):
+        kind, v, line = self.next()
+        if v != value:
+            raise SyntaxError(f"{self.path}:{line}: expected {value!r}, got {v!r}")
+
+    def values(self):
+        """Read values up to and including ';'"""
+        out = []
+        while True:
+            kind, v, line = self.next()
+            if kind is None:
+                raise SyntaxError(f"{self.path}: unexpected end of file")
+            if v == ";" and kind == "punct":
+                return out
+            if kind != "punct" or v == "|":
+                out.append(v)
+
+    def block(self):
+        """Read 'key = values;' pairs until a lone ';'"""
+        fields = {}
+        memories = {}
+        while True:
+            kind, v, line = self.next()
+            if kind is None:
+                raise SyntaxError(f"{self.path}: unterminated block")
+            if v == ";":
+                return fields, memories
+            if v == "memory":
+                _, name, _ = self.next()
+                nk, nv, _ = self.peek()
+                if nv == "alias":
+                    self.next()
+                    self.next()
+                    self.expect(";")
+                    continue
+                if nv == "=":
+                    self.next()
+                    self.values()
+                    memories[name] = None       # memory deleted from parent
+                    continue
+                mem_fields, _ = self.block()
+                memories[name] = mem_fields
+                continue
+            self.expect("=")
+            fields[v] = self.values()
+
+    def parse(self):
+        """Return list of (parent_id, fields, memories) for every part"""
+        parts = []
+        while self.peek()[0] is not None:
+            kind, v, line = self.next()
+            if v in ("part", "programmer", "serialadapter"):
+                parent = None
+                if self.peek()[1] == "parent":
+                    self.next()
+                    parent = self.next()[1]
+                fields, memories = self.block()
+                if v == "part":
+                    parts.append((parent, fields, memories))
+            else:
+                self.expect("=")
+                self.values()
+        return parts
+
+
+def resolve_parts(raw_parts):
+    """Apply 'part parent' inheritance; return {id: (fields, memories)}"""
+    by_id = {}
+    ordered = []
+    for parent, fields, memories in raw_parts:
+        if parent is not None:
+            if parent not in by_id:
+                raise ValueError(f"part {fields.get('id')}: unknown parent {parent!r}")
+            base_fields, base_mems = by_id[parent]
+            merged_fields = dict(base_fields)
+            merged_fields.update(fields)
+            merged_mems = {k: dict(v) for k, v in base_mems.items()}
+            for name, mem in memories.items():
+                if mem is None:
+                    merged_mems.pop(name, None)
+                else:
+                    merged_mems.setdefault(name, {}).update(mem)
+            fields, memories = merged_fields, merged_mems
+        else:
+            memories = {k: v for k, v in memories.items() if v is not None}
+        part_id = fields.get("id", [""])[0]
+        by_id[part_id] = (fields, memories)
+        ordered.append(part_id)
+    return [(pid, *by_id[pid]) for pid in ordered]
+
+
+def first(fields, key, default=None):
+    v = fields.get(key)
+    return v[0] if v else default
+
+
+def yes(fields, key) -> bool:
+    return first(fields, key) == "yes"
+
+
+def device_from_conf(part_id, fields, memories):
+    if part_id.startswith("."):
+        return None
+    sig = fields.get("signature")
+    if not sig or len(sig) != 3 or not all(isinstance(b, int) for b in sig):
+        return None
+    if sig == [0, 0, 0] or sig == [0xFF, 0xFF, 0xFF]:
+        return None
+
+    dev = Device(first(fields, "desc", part_id), tuple(sig))
+    dev.erase_us = clamp_u16(first(fields, "chip_erase_delay", 0))
+
+    if "prog_modes" in fields:
+        for mode in fields["prog_modes"]:
+            if mode in PROG_MODE_FLAGS:
+                dev.flags.add(PROG_MODE_FLAGS[mode])
+    else:
+        # avrdude 6.x: has_* booleans, ISP unless another interface is set
+        for key, flag in (("has_tpi", "TPI"), ("has_pdi", "PDI"),
+                          ("has_updi", "UPDI"), ("has_debugwire", "DEBUGWIRE")):
+            if yes(fields, key):
+                dev.flags.add(flag)
+        if not dev.flags & {"TPI", "PDI", "UPDI"}:
+            dev.flags.add("ISP")
+
+    flash = memories.get("flash")
+    if flash:
+        dev.flash_size = first(flash, "size", 0)
+        dev.page_size = first(flash, "page_size", 0) if yes(flash, "paged") else 0
+        dev.flash_write_us = clamp_u16(first(flash, "min_write_delay", 0))
+        rb = flash.get("readback") or flash.get("readback_p1")
+        if rb:
+            dev.flash_poll = rb[0]
+        if "load_ext_addr" in flash or dev.flash_size > 128 * 1024:
+            dev.flags.add("EXT_ADDR")
+
+    eeprom = memories.get("eeprom")
+    if eeprom:
+        dev.eeprom_size = first(eeprom, "size", 0)
+        dev.eeprom_page = first(eeprom, "page_size", 0)
+        dev.eeprom_write_us = clamp_u16(first(eeprom, "min_write_delay", 0))
+        rb = eeprom.get("readback") or eeprom.get("readback_p1")
+        if rb:
+            dev.eeprom_poll = rb[0]
+        if yes(eeprom, "paged"):
+            dev.flags.add("PAGED_EEPROM")
+
+    if "efuse" in memories:
+        dev.flags.add("HAS_EFUSE")
+    return dev
+
+
+def load_conf(path: Path):
+    parser = ConfParser(path.read_text(errors="replace"), str(path))
+    devices = []
+    for part_id, fields, memories in resolve_parts(parser.parse()):
+        dev = device_from_conf(part_id, fields, memories)
+        if dev:
+            devices.append(dev)
+    return devices
+
+
+# =============================================================================
+# ATDF
+# =============================================================================
+
+ATDF_INTERFACES = {
+    "isp": "ISP",
+    "tpi": "TPI",
+    "pdi": "PDI",
+    "updi": "UPDI",
+    "dw": "DEBUGWIRE",
+}
+
+
+def _num(s, default=0):
+    try:
+        return int(s, 0)
+    except (TypeError, ValueError):
+        return default
+
+
+def load_atdf(path: Path):
+    root = ET.parse(path).getroot()
+    devices = []
+    for node in root.iter("device"):
+        props = {}
+        for group in node.iter("property-group"):
+            for p in group.iter("property"):
+                props[(group.get("name"), p.get("name"))] = p.get("value")
+
+        sig = tuple(_num(props.get(("SIGNATURES", f"SIGNATURE{i}"))) for i in range(3))
+        if sig == (0, 0, 0):
+            continue
+        dev = Device(node.get("name"), sig)
+
+        for space in node.iter("address-space"):
+            for seg in space.iter("memory-segment"):
+                kind = (seg.get("type") or "").lower()
+                name = (seg.get("name") or "").upper()
+                if kind == "flash" and name in ("FLASH", "PROGMEM", "APP_SECTION", "BOOT_SECTION"):
+                    dev.flash_size += _num(seg.get("size"))
+                    dev.page_size = max(dev.page_size, _num(seg.get("pagesize")))
+                elif kind == "eeprom":
+                    dev.eeprom_size = _num(seg.get("size"))
+                    dev.eeprom_page = _num(seg.get("pagesize"))
+
+        for iface in node.iter("interface"):
+            flag = ATDF_INTERFACES.get((iface.get("type") or "").lower())
+            if flag:
+                dev.flags.add(flag)
+
+        for reg in node.iter("register"):
+            if reg.get("name") == "EXTENDED" and reg.get("offset") is not None:
+                dev.flags.add("HAS_EFUSE")
+                break
+
+        isp = lambda key, default=0: _num(props.get(("ISP_INTERFACE", key)), default)
+        dev.erase_us = clamp_u16(isp("IspChipErase_eraseDelay") * 1000)
+        dev.flash_write_us = clamp_u16(isp("IspProgramFlash_delay") * 1000)
+        dev.eeprom_write_us = clamp_u16(isp("IspProgramEeprom_delay") * 1000)
+        dev.flash_poll = isp("IspProgramFlash_pollVal1", 0xFF)
+        dev.eeprom_poll = isp("IspProgramEeprom_pollVal1", 0xFF)
+        if dev.flash_size > 128 * 1024:
+            dev.flags.add("EXT_ADDR")
+        if dev.eeprom_page > 1 and "ISP" in dev.flags:
+            dev.flags.add("PAGED_EEPROM")
+        devices.append(dev)
+    return devices
+
+
+# =============================================================================
+# Perfect hash
+# =============================================================================
+
+def sig_key(sig) -> int:
+    return (sig[1] << 8) | sig[2]
+
+
+def sig_hash(key: int, seed: int) -> int:
+    x = ((key | (seed << 16)) * HASH_MUL) & 0xFFFFFFFF
+    x ^= x >> 15
+    return (x * HASH_MUL2) & 0xFFFFFFFF
+
+
+def bits_for(n: int) -> int:
+    return max(1, (n - 1).bit_length())
+
+
+def build_hash(keys):
+    """Hash-and-displace: return (bucket_bits, slot_bits, disp, slots)"""
+    n = len(keys)
+    bucket_bits = bits_for(max(1, n // 2))
+    for slot_bits in range(bits_for(n), bits_for(n) + 6):
+        buckets = [[] for _ in range(1 << bucket_bits)]
+        for i, k in enumerate(keys):
+            buckets[sig_hash(k, 0) >> (32 - bucket_bits)].append(i)
+        disp = [0] * (1 << bucket_bits)
+        slots = [None] * (1 << slot_bits)
+        ok = True
+        for b in sorted(range(len(buckets)), key=lambda b: -len(buckets[b])):
+            if not buckets[b]:
+                break
+            for d in range(MAX_DISP):
+                pos = [sig_hash(keys[i], d + 1) >> (32 - slot_bits) for i in buckets[b]]
+                if len(set(pos)) == len(pos) and all(slots[p] is None for p in pos):
+                    for i, p in zip(buckets[b], pos):
+                        slots[p] = i
+                    disp[b] = d
+                    break
+            else:
+                ok = False
+                break
+        if ok:
+            return bucket_bits, slot_bits, disp, slots
+    raise RuntimeError("no perfect hash found")
+
+
+def lookup(sig, devices, bucket_bits, slot_bits, disp, slots):
+    """Python model of avr_lookup_device_by_signature()"""
+    key = sig_key(sig)
+    d = disp[sig_hash(key, 0) >> (32 - bucket_bits)]
+    idx = slots[sig_hash(key, d + 1) >> (32 - slot_bits)]
+    if idx is None or devices[idx].sig != tuple(sig):
+        return None
+    return devices[idx]
+
+
+# =============================================================================
+# Output
+# =============================================================================
+
+def c_flags(dev) -> str:
+    names = [f"AVR_DEV_{f}" for f in FLAGS if f in dev.flags]
+    return " | ".join(names) if names else "0"
+
+
+def render(devices, sources, bucket_bits, slot_bits, disp, slots) -> str:
+    empty = 0xFF if len(devices) < 0xFF else 0xFFFF
+    index_t = "uint8_t" if empty == 0xFF else "uint16_t"
+    out = []
+    out.append("/* Generated by gen_avr_devices.py - do not edit.")
+    for s in sources:
+        out.append(f" * Source: {Path(s).name}")
+    out.append(" */")
+    out.append("")
+    out.append("#pragma once")
+    out.append("")
+    out.append(f"#define AVR_DEVICE_COUNT        {len(devices)}u")
+    out.append(f"#define AVR_DEVICE_BUCKET_BITS  {bucket_bits}u")
+    out.append(f"#define AVR_DEVICE_SLOT_BITS    {slot_bits}u")
+    out.append(f"#define AVR_DEVICE_HASH_MUL     0x{HASH_MUL:08X}u")
+    out.append(f"#define AVR_DEVICE_HASH_MUL2    0x{HASH_MUL2:08X}u")
+    out.append(f"#define AVR_DEVICE_SLOT_EMPTY   0x{empty:X}u")
+    out.append("")
+    out.append(f"typedef {index_t} avr_device_index_t;")
+    out.append("")
+    out.append("static const avr_device_t avr_device_table[AVR_DEVICE_COUNT] = {")
+    for d in devices:
+        sig = ", ".join(f"0x{b:02X}" for b in d.sig)
+        out.append(f'    {{ {{{sig}}}, {d.eeprom_page}, 0x{d.flash_poll:02X}, 0x{d.eeprom_poll:02X}, '
+                   f'{d.page_size}, {d.eeprom_size}, {d.flash_write_us}, {d.eeprom_write_us}, '
+                   f'{d.erase_us}, {c_flags(d)}, "{d.name}", {d.flash_size} }},')
+    out.append("};")
+    out.append("")
+    out.append("static const uint8_t avr_device_disp[1u << AVR_DEVICE_BUCKET_BITS] = {")
+    for i in range(0, len(disp), 16):
+        out.append("    " + ", ".join(f"{v:3d}" for v in disp[i:i + 16]) + ",")
+    out.append("};")
+    out.append("")
+    out.append("static const avr_device_index_t avr_device_slot[1u << AVR_DEVICE_SLOT_BITS] = {")
+    cells = [f"{empty:#x}" if s is None else f"{s:d}" for s in slots]
+    for i in range(0, len(cells), 16):
+        out.append("    " + ", ".join(f"{c:>6}" if empty > 0xFF else f"{c:>4}"
+                                      for c in cells[i:i + 16]) + ",")
+    out.append("};")
+    out.append("")
+    return "\n".join(out)
+
+
+def load_sources(paths):
+    devices = []
+    seen = {}
+    for p in map(Path, paths):
+        loaded = load_atdf(p) if p.suffix.lower() == ".atdf" else load_conf(p)
+        for dev in loaded:
+            if dev.sig in seen:
+                if seen[dev.sig] != dev.name:
+                    print(f"note: {dev.name} shares signature with {seen[dev.sig]}, skipped",
+                          file=sys.stderr)
+                continue
+            dev.check()
+            seen[dev.sig] = dev.name
+            devices.append(dev)
+    devices.sort(key=lambda d: d.sig)
+    return devices
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("sources", nargs="+", help="avrdude.conf or .atdf files")
+    ap.add_argument("-o", "--output", help="Header to write")
+    ap.add_argument("--list", action="store_true", help="Print the parsed table")
+    args = ap.parse_args()
+
+    devices = load_sources(args.sources)
+    if not devices:
+        print("error: no devices found", file=sys.stderr)
+        return 1
+
+    keys = [sig_key(d.sig) for d in devices]
+    if len(set(keys)) != len(keys):
+        print("error: signatures collide on bytes 1-2", file=sys.stderr)
+        return 1
+    bucket_bits, slot_bits, disp, slots = build_hash(keys)
+
+    # Verify every entry resolves to itself through the C lookup model
+    for d in devices:
+        if lookup(d.sig, devices, bucket_bits, slot_bits, disp, slots) is not d:
+            print(f"error: hash lookup failed for {d.name}", file=sys.stderr)
+            return 1
+
+    if args.list:
+        for d in devices:
+            sig = " ".join(f"{b:02X}" for b in d.sig)
+            print(f"{sig}  {d.name:<16} flash {d.flash_size:>6}/{d.page_size:<3} "
+                  f"eeprom {d.eeprom_size:>4}/{d.eeprom_page:<2} [{', '.join(sorted(d.flags))}]")
+        print(f"{len(devices)} devices, {1 << bucket_bits} buckets, {1 << slot_bits} slots")
+
+    if args.output:
+        text = render(devices, args.sources, bucket_bits, slot_bits, disp, slots)
+        out = Path(args.output)
+        if not out.exists() or out.read_text() != text:
+            out.write_text(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -12,6 +12,7 @@
  *      - Process USB tasks (TinyUSB device task)
  *      - When CDC data is available, feed it to STK500v1 protocol handler
  *      - STK500v1 handler parses commands and invokes AVR programming functions
+ *      - Queued erases and page writes advance without blocking USB
  * 
  * The USB CDC interface appears as a virtual serial port (e.g., /dev/ttyACM0)
  * which avrdude can use with the "-c arduino" programmer type.
@@ -25,6 +26,8 @@
 #include "tusb.h"
 #include "avrprog.h"
 #include "stk500v1.h"
+#include "avr_async.h"
+#include "avr_profile.h"
 
 /**
  * @brief Main application entry point
@@ -34,6 +37,7 @@
  *   1. Runs TinyUSB device tasks to handle USB events
  *   2. Checks for incoming CDC data when connected
  *   3. Passes received data to STK500v1 protocol handler
+ *   4. Advances queued target operations
  * 
  * @return Never returns (infinite loop)
  */
@@ -46,6 +50,9 @@ int main() {
     
     /* Initialize SPI interface for AVR ISP communication */
     avr_spi_init();
+
+    /* Open the learned ISP speed profiles in flash */
+    avr_profile_init();
     
     /* Initialize STK500v1 protocol state machine */
     stk500v1_init();
@@ -65,8 +72,10 @@ int main() {
             /* Feed received bytes to STK500v1 protocol handler */
             if (n) stk500v1_feed(rx, (int)n);
         }
-        
-        /* Small delay to prevent busy-looping */
-        sleep_ms(1);
+
+        /* Advance a queued erase/page write, then any frames held back,
+         * then read-ahead. Small delay to prevent busy-looping, skipped
+         * while any of them has work left */
+        if (!stk500v1_task()) sleep_ms(1);
     }
 }
@@ -0,0 +1,77 @@
+/**
+ * @file metrics.c
+ * @brief Programming Session Counters
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "metrics.h"
+#include <string.h>
+#include <pico/stdlib.h>
+
+/*******************************************************************************
+ * Counters
+ ******************************************************************************/
+
+static uint32_t counter[METRIC_COUNT];
+static metrics_cmd_t commands[256];
+static uint64_t reset_at;
+
+static uint32_t add_sat(uint32_t a, uint32_t b) {
+    return a > UINT32_MAX - b ? UINT32_MAX : a + b;
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/**
+ * @brief Clear all counters and restart the session clock
+ */
+void metrics_reset(void) {
+    memset(counter, 0, sizeof(counter));
+    memset(commands, 0, sizeof(commands));
+    reset_at = time_us_64();
+}
+
+/**
+ * @brief Add to a counter (saturating)
+ */
+void metrics_add(metric_t m, uint32_t n) {
+    counter[m] = add_sat(counter[m], n);
+}
+
+/**
+ * @brief Get a counter
+ */
+uint32_t metrics_get(metric_t m) {
+    return counter[m];
+}
+
+/**
+ * @brief Record one handled command
+ */
+void metrics_command(uint8_t cmd, uint32_t us) {
+    metrics_cmd_t *c = &commands[cmd];
+    c->count = add_sat(c->count, 1);
+    c->total_us = add_sat(c->total_us, us);
+    if (us > c->max_us) {
+        c->max_us = us;
+    }
+}
+
+/**
+ * @brief Get the statistics of a command
+ */
+const metrics_cmd_t* metrics_command_stats(uint8_t cmd) {
+    return &commands[cmd];
+}
+
+/**
+ * @brief Get the time since the last reset
+ */
+uint32_t metrics_elapsed_us(void) {
+    uint64_t us = time_us_64() - reset_at;
+    return us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file metrics.h
+ * @brief Programming Session Counters
+ *
+ * Where a session spends its time is not visible from the host: a slow
+ * upload can be USB round trips, ISP clock, page write waits or resyncs.
+ * This module keeps cheap counters that the protocol handler and the ISP
+ * layer bump as they go, read by the host with Cmnd_STK_METRICS.
+ *
+ * Counted:
+ *   - Per STK500 command: frames handled, total and maximum handling time
+ *     (for queued writes this is the time to queue, not to complete)
+ *   - Bytes received and sent over CDC
+ *   - ISP instructions clocked out (4-byte transfers, any transport)
+ *   - Time spent waiting for the target (RDY/BSY polling and fixed write
+ *     delays, blocking or queued)
+ *   - Retries (Programming Enable resyncs, inline verify rewrites)
+ *   - Sync failures (frames answered with NOSYNC)
+ *
+ * Counters start from zero at boot and on a reset request, so the host
+ * can scope them to one session. Time totals saturate.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*******************************************************************************
+ * Counter Identifiers (order of the METRICS reply)
+ ******************************************************************************/
+typedef enum {
+    METRIC_BYTES_IN,        /* CDC bytes received */
+    METRIC_BYTES_OUT,       /* CDC bytes sent */
+    METRIC_ISP_INSTR,       /* 4-byte ISP instructions */
+    METRIC_BUSY_US,         /* Time waiting for the target */
+    METRIC_RETRIES,         /* Entry resyncs and page rewrites */
+    METRIC_SYNC_FAILS,      /* NOSYNC replies */
+    METRIC_COUNT
+} metric_t;
+
+/** Per-command statistics */
+typedef struct {
+    uint32_t count;
+    uint32_t total_us;
+    uint32_t max_us;
+} metrics_cmd_t;
+
+/**
+ * @brief Clear all counters and restart the session clock
+ */
+void metrics_reset(void);
+
+/**
+ * @brief Add to a counter (saturating)
+ */
+void metrics_add(metric_t m, uint32_t n);
+
+/**
+ * @brief Get a counter
+ */
+uint32_t metrics_get(metric_t m);
+
+/**
+ * @brief Record one handled command
+ *
+ * @param cmd STK500 command byte
+ * @param us  Handling time in microseconds
+ */
+void metrics_command(uint8_t cmd, uint32_t us);
+
+/**
+ * @brief Get the statistics of a command
+ *
+ * @param cmd STK500 command byte
+ * @return Statistics (count 0 if never seen)
+ */
+const metrics_cmd_t* metrics_command_stats(uint8_t cmd);
+
+/**
+ * @brief Get the time since the last reset
+ */
+uint32_t metrics_elapsed_us(void);
@@ -0,0 +1,390 @@
+/**
+ * @file pdi.c
+ * @brief PDI Access Layer and XMEGA NVM Controller Implementation
+ *
+ * The PIO state machine (pdi.pio) turns TX FIFO words into frames and
+ * keeps clocking idle bits in between. This file builds frames, decodes
+ * responses and implements the PDI instruction set and NVM sequences.
+ *
+ * Speed Notes:
+ *   - Page buffer loads use REPEAT + ST *(ptr++), so a 256-byte page
+ *     costs 256 data frames plus a handful of instruction frames.
+ *   - Reads keep up to four response requests queued in the state machine
+ *     so the link never idles between bytes of a burst.
+ *   - The guard time is cut from 128 to 2 bits after connecting.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "pdi.h"
+#include "avrprog.h"
+#include <pico/stdlib.h>
+#include "hardware/clocks.h"
+#include "hardware/pio.h"
+#include "pdi.pio.h"
+
+/*******************************************************************************
+ * PDI Instruction Set
+ ******************************************************************************/
+#define PDI_LDS          0x00
+#define PDI_STS          0x40
+#define PDI_LD           0x20
+#define PDI_ST           0x60
+#define PDI_LDCS         0x80
+#define PDI_STCS         0xC0
+#define PDI_KEY          0xE0
+#define PDI_REPEAT       0xA0
+
+#define PDI_ADDR_32      0x0C   /* LDS/STS address size: 4 bytes */
+#define PDI_DATA_8       0x00
+#define PDI_PTR_INC      0x04   /* LD/ST *(ptr++) */
+#define PDI_PTR_ADDR     0x08   /* LD/ST ptr (pointer register itself) */
+#define PDI_PTR_32       0x03   /* Pointer write: 4-byte address */
+
+/* Control/status registers */
+#define PDI_CS_STATUS    0x00
+#define PDI_CS_RESET     0x01
+#define PDI_CS_CTRL      0x02
+#define PDI_STATUS_NVMEN 0x02
+#define PDI_RESET_KEY    0x59
+#define PDI_GT_2         0x06
+
+/** NVM key, sent least significant byte first */
+static const uint8_t nvm_key[8] = {0xFF, 0x88, 0xD8, 0xCD, 0x45, 0xAB, 0x89, 0x12};
+
+/* NVM controller (data space 0x01C0) */
+#define NVM_BASE         0x010001C0u
+#define NVM_CMD          (NVM_BASE + 0x0A)
+#define NVM_CTRLA        (NVM_BASE + 0x0B)
+#define NVM_STATUS       (NVM_BASE + 0x0F)
+#define NVM_CTRLA_CMDEX  0x01
+#define NVM_STATUS_BUSY  0x80
+
+#define NVM_CMD_NOP                 0x00
+#define NVM_CMD_WRITE_LOCK_BITS     0x08
+#define NVM_CMD_LOAD_FLASH_BUFFER   0x23
+#define NVM_CMD_ERASE_FLASH_BUFFER  0x26
+#define NVM_CMD_ERASE_WRITE_PAGE    0x2F
+#define NVM_CMD_CHIP_ERASE          0x40
+#define NVM_CMD_READ_NVM            0x43
+
+/* Address space */
+#define PDI_ADDR_FLASH   0x00800000u
+#define PDI_ADDR_LOCK    0x008F0027u
+#define PDI_ADDR_SIG     0x01000090u
+
+#define PDI_MAX_BURST        256     /* REPEAT count is one byte (n - 1) */
+#define PDI_RX_DEPTH         4       /* Outstanding receive requests */
+#define PDI_NVM_TIMEOUT_US   100000  /* Chip erase on 256 KB parts */
+
+/*******************************************************************************
+ * Private Variables
+ ******************************************************************************/
+#define PDI_PIO pio0
+static int sm = -1;
+static uint offset;
+static uint32_t rx_timeout_us;
+static bool link_error = false;
+
+/*******************************************************************************
+ * Physical Layer (PIO)
+ ******************************************************************************/
+
+/** TX FIFO word: mode bit 1, then ST, data LSB first, even parity, 2 stop */
+static uint32_t tx_word(uint8_t b) {
+    uint32_t frame = ((uint32_t)b << 1)
+                   | ((uint32_t)__builtin_parity(b) << 9)
+                   | (3u << 10);
+    return (frame << 1) | 1u;
+}
+
+#define PDI_IDLE_WORD  ((0xFFFu << 1) | 1u)
+#define PDI_RX_WORD    0u
+
+/** Load the idle word into X so the SM clocks idle bits when starved */
+static void load_idle_word(void) {
+    uint side_high = pio_encode_sideset(1, 1);
+    pio_sm_put(PDI_PIO, (uint)sm, PDI_IDLE_WORD);
+    pio_sm_exec(PDI_PIO, (uint)sm, pio_encode_pull(false, true) | side_high);
+    pio_sm_exec(PDI_PIO, (uint)sm, pio_encode_mov(pio_x, pio_osr) | side_high);
+}
+
+/** Recover from a missing response: restart the SM at its idle loop */
+static void link_recover(void) {
+    link_error = true;
+    pio_sm_set_enabled(PDI_PIO, (uint)sm, false);
+    pio_sm_clear_fifos(PDI_PIO, (uint)sm);
+    pio_sm_restart(PDI_PIO, (uint)sm);
+    load_idle_word();
+    pio_sm_exec(PDI_PIO, (uint)sm, pio_encode_jmp(offset + pdi_offset_top));
+    pio_sm_set_enabled(PDI_PIO, (uint)sm, true);
+}
+
+static void pdi_send(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        pio_sm_put_blocking(PDI_PIO, (uint)sm, tx_word(data[i]));
+    }
+}
+
+static void pdi_send_byte(uint8_t b) {
+    pdi_send(&b, 1);
+}
+
+/**
+ * @brief Receive len response frames, keeping the SM request queue full
+ */
+static void pdi_recv(uint8_t* out, size_t len) {
+    size_t queued = 0;
+    size_t got = 0;
+    absolute_time_t deadline = make_timeout_time_us(rx_timeout_us);
+
+    while (got < len && !link_error) {
+        while (queued < len && queued - got < PDI_RX_DEPTH &&
+               !pio_sm_is_tx_fifo_full(PDI_PIO, (uint)sm)) {
+            pio_sm_put(PDI_PIO, (uint)sm, PDI_RX_WORD);
+            queued++;
+        }
+        if (!pio_sm_is_rx_fifo_empty(PDI_PIO, (uint)sm)) {
+            uint32_t v = pio_sm_get(PDI_PIO, (uint)sm) >> 21;
+            uint8_t b = (uint8_t)(v & 0xFF);
+            if (((v >> 8) & 1u) != (uint32_t)__builtin_parity(b) || ((v >> 9) & 3u) != 3u) {
+                link_error = true;
+            }
+            out[got++] = b;
+            deadline = make_timeout_time_us(rx_timeout_us);
+        } else if (time_reached(deadline)) {
+            link_recover();
+        }
+    }
+}
+
+/*******************************************************************************
+ * Access Layer
+ ******************************************************************************/
+
+static void put_addr32(uint8_t* p, uint32_t addr) {
+    p[0] = (uint8_t)addr;
+    p[1] = (uint8_t)(addr >> 8);
+    p[2] = (uint8_t)(addr >> 16);
+    p[3] = (uint8_t)(addr >> 24);
+}
+
+static uint8_t ldcs(uint8_t reg) {
+    uint8_t v = 0;
+    pdi_send_byte((uint8_t)(PDI_LDCS | reg));
+    pdi_recv(&v, 1);
+    return v;
+}
+
+static void stcs(uint8_t reg, uint8_t value) {
+    uint8_t frame[2] = {(uint8_t)(PDI_STCS | reg), value};
+    pdi_send(frame, sizeof(frame));
+}
+
+static uint8_t lds8(uint32_t addr) {
+    uint8_t frame[5] = {PDI_LDS | PDI_ADDR_32 | PDI_DATA_8};
+    uint8_t v = 0;
+    put_addr32(frame + 1, addr);
+    pdi_send(frame, sizeof(frame));
+    pdi_recv(&v, 1);
+    return v;
+}
+
+static void sts8(uint32_t addr, uint8_t value) {
+    uint8_t frame[6] = {PDI_STS | PDI_ADDR_32 | PDI_DATA_8};
+    put_addr32(frame + 1, addr);
+    frame[5] = value;
+    pdi_send(frame, sizeof(frame));
+}
+
+static void set_pointer(uint32_t addr) {
+    uint8_t frame[5] = {PDI_ST | PDI_PTR_ADDR | PDI_PTR_32};
+    put_addr32(frame + 1, addr);
+    pdi_send(frame, sizeof(frame));
+}
+
+static void repeat(size_t count) {
+    uint8_t frame[2] = {PDI_REPEAT, (uint8_t)(count - 1)};
+    pdi_send(frame, sizeof(frame));
+}
+
+/*******************************************************************************
+ * NVM Controller
+ ******************************************************************************/
+
+static bool nvm_wait(uint32_t timeout_us) {
+    absolute_time_t deadline = make_timeout_time_us(timeout_us);
+    /* NVM access is suspended while the controller is busy (e.g. erase) */
+    while (!(ldcs(PDI_CS_STATUS) & PDI_STATUS_NVMEN) ||
+           (lds8(NVM_STATUS) & NVM_STATUS_BUSY)) {
+        if (link_error || time_reached(deadline)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void nvm_command(uint8_t cmd) {
+    sts8(NVM_CMD, cmd);
+}
+
+/** Commands triggered through CTRLA.CMDEX */
+static void nvm_execute(uint8_t cmd) {
+    nvm_command(cmd);
+    sts8(NVM_CTRLA, NVM_CTRLA_CMDEX);
+    nvm_wait(PDI_NVM_TIMEOUT_US);
+}
+
+static uint8_t nvm_read_byte(uint32_t addr) {
+    nvm_command(NVM_CMD_READ_NVM);
+    return lds8(addr);
+}
+
+/*******************************************************************************
+ * Interface Operations
+ ******************************************************************************/
+
+/**
+ * @brief Start PDI_CLK, reset the target and enable NVM programming
+ *
+ * Sequence: PDI_DATA high while the clock starts (at least 16 idle bits),
+ * guard time 2 bits, hold the core in reset, NVM key, poll STATUS.NVMEN.
+ */
+static bool pdi_enter(void) {
+    if (sm < 0) {
+        if (!pio_can_add_program(PDI_PIO, &pdi_program)) {
+            return false;
+        }
+        offset = pio_add_program(PDI_PIO, &pdi_program);
+        sm = pio_claim_unused_sm(PDI_PIO, false);
+        if (sm < 0) {
+            pio_remove_program(PDI_PIO, &pdi_program, offset);
+            return false;
+        }
+    }
+
+    float clkdiv = (float)clock_get_hz(clk_sys) / (4.0f * PDI_CLOCK_HZ);
+    pdi_program_init(PDI_PIO, (uint)sm, offset, PDI_DATA_PIN, PDI_CLK_PIN, clkdiv);
+    load_idle_word();
+    pio_sm_set_enabled(PDI_PIO, (uint)sm, true);
+
+    /* ~200 bits of 128-bit guard time worst case, plus enable idle bits */
+    rx_timeout_us = 200u * 1000000u / PDI_CLOCK_HZ + 100u;
+    link_error = false;
+    sleep_us(32u * 1000000u / PDI_CLOCK_HZ + 10u);
+
+    stcs(PDI_CS_CTRL, PDI_GT_2);
+    stcs(PDI_CS_RESET, PDI_RESET_KEY);
+    pdi_send_byte(PDI_KEY);
+    pdi_send(nvm_key, sizeof(nvm_key));
+
+    for (int attempt = 0; attempt < 32 && !link_error; attempt++) {
+        if (ldcs(PDI_CS_STATUS) & PDI_STATUS_NVMEN) {
+            return true;
+        }
+    }
+    avr_iface_pdi.leave();
+    return false;
+}
+
+/**
+ * @brief Release reset, stop PDI_CLK and hand the pins back to ISP
+ *
+ * Stopping the clock makes the target leave PDI mode on its own.
+ */
+static void pdi_leave(void) {
+    if (sm < 0) {
+        return;
+    }
+    link_error = false;
+    stcs(PDI_CS_RESET, 0x00);
+    while (!pio_sm_is_tx_fifo_empty(PDI_PIO, (uint)sm)) {
+        tight_loop_contents();
+    }
+    sleep_us(100);
+    pio_sm_set_enabled(PDI_PIO, (uint)sm, false);
+    pio_sm_unclaim(PDI_PIO, (uint)sm);
+    pio_remove_program(PDI_PIO, &pdi_program, offset);
+    sm = -1;
+    avr_spi_init();
+}
+
+/**
+ * @brief Emulate the ISP instructions that have a PDI equivalent
+ *
+ * Signature and lock bit reads, lock bit write and chip erase.
+ */
+static void pdi_universal(const uint8_t cmd[4], uint8_t rx[4]) {
+    rx[0] = rx[1] = rx[2] = rx[3] = 0;
+    switch (cmd[0]) {
+        case 0x30: rx[3] = lds8(PDI_ADDR_SIG + (cmd[2] & 0x03)); break;
+        case 0x58: rx[3] = cmd[1] == 0x00 ? nvm_read_byte(PDI_ADDR_LOCK) : 0; break;
+        case 0xAC:
+            if (cmd[1] == 0x80) {
+                avr_iface_pdi.chip_erase();
+            } else if (cmd[1] == 0xE0) {
+                nvm_command(NVM_CMD_WRITE_LOCK_BITS);
+                sts8(PDI_ADDR_LOCK, cmd[3]);
+                nvm_wait(PDI_NVM_TIMEOUT_US);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static bool pdi_poll_ready(uint32_t timeout_us) {
+    return nvm_wait(timeout_us);
+}
+
+static void pdi_chip_erase(void) {
+    nvm_execute(NVM_CMD_CHIP_ERASE);
+}
+
+/**
+ * @brief Erase the page buffer, burst-load it and erase+write the page
+ */
+static void pdi_write_flash_page(uint32_t byte_addr, const uint8_t* data, size_t len) {
+    static const uint8_t st_inc = PDI_ST | PDI_PTR_INC | PDI_DATA_8;
+    uint32_t addr = PDI_ADDR_FLASH + byte_addr;
+
+    nvm_execute(NVM_CMD_ERASE_FLASH_BUFFER);
+    nvm_command(NVM_CMD_LOAD_FLASH_BUFFER);
+    set_pointer(addr);
+    for (size_t off = 0; off < len; off += PDI_MAX_BURST) {
+        size_t n = len - off < PDI_MAX_BURST ? len - off : PDI_MAX_BURST;
+        repeat(n);
+        pdi_send_byte(st_inc);
+        pdi_send(data + off, n);
+    }
+
+    /* Any write inside the page starts the erase + write */
+    nvm_command(NVM_CMD_ERASE_WRITE_PAGE);
+    sts8(addr, 0x00);
+    nvm_wait(PDI_NVM_TIMEOUT_US);
+}
+
+static void pdi_read_flash(uint32_t byte_addr, uint8_t* out, size_t len) {
+    static const uint8_t ld_inc = PDI_LD | PDI_PTR_INC | PDI_DATA_8;
+
+    nvm_command(NVM_CMD_READ_NVM);
+    set_pointer(PDI_ADDR_FLASH + byte_addr);
+    for (size_t off = 0; off < len; off += PDI_MAX_BURST) {
+        size_t n = len - off < PDI_MAX_BURST ? len - off : PDI_MAX_BURST;
+        repeat(n);
+        pdi_send_byte(ld_inc);
+        pdi_recv(out + off, n);
+    }
+}
+
+const avr_iface_t avr_iface_pdi = {
+    .name = "PDI",
+    .enter = pdi_enter,
+    .leave = pdi_leave,
+    .universal = pdi_universal,
+    .poll_ready = pdi_poll_ready,
+    .chip_erase = pdi_chip_erase,
+    .write_flash_page = pdi_write_flash_page,
+    .read_flash = pdi_read_flash,
+};
@@ -0,0 +1,51 @@
+/**
+ * @file pdi.h
+ * @brief Program and Debug Interface (PDI) for ATxmega Parts
+ *
+ * XMEGA devices are programmed over PDI: a synchronous half-duplex link
+ * clocked on the RESET pin (PDI_CLK) with one bidirectional data line.
+ * The physical layer runs on a PIO state machine (pdi.pio) because the
+ * clock has to keep running between frames - the target drops out of
+ * PDI mode if PDI_CLK stays idle for more than ~100 us.
+ *
+ * Wiring (standard 6-pin PDI header):
+ *   - 1 PDI_DATA -> GPIO 16 (the ISP MISO pin)
+ *   - 5 PDI_CLK  -> GPIO 17 (the ISP RESET pin)
+ *
+ * Address Space (32-bit PDI addresses):
+ *   - 0x00800000 Flash (application + boot section)
+ *   - 0x008F0020 Fuse bytes, 0x008F0027 lock bits
+ *   - 0x01000000 + data address: I/O and SRAM (signature at 0x0090,
+ *     NVM controller at 0x01C0)
+ *
+ * Reference: XMEGA AU manual, "Program and Debug Interface" and
+ *            "Memory Programming"
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "avr_iface.h"
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+#ifndef PDI_DATA_PIN
+#define PDI_DATA_PIN   16
+#endif
+
+#ifndef PDI_CLK_PIN
+#define PDI_CLK_PIN    17
+#endif
+
+/** PDI_CLK frequency in Hz (XMEGA accepts up to 10 MHz) */
+#ifndef PDI_CLOCK_HZ
+#define PDI_CLOCK_HZ   1000000
+#endif
+
+/** PDI implementation of the programming interface operations */
+extern const avr_iface_t avr_iface_pdi;
@@ -0,0 +1,327 @@
+#!/usr/bin/env python3
+"""
+progctl.py - Programmer Control and Diagnostics over USB CDC
+
+Sets the firmware's vendor parameters and reads its diagnostics outside
+an avrdude session: SPI benchmark, warm sessions, debugWIRE fallback,
+learned ISP rates, session metrics and the event trace. Also models a
+verify pass with and without the read-ahead window (no hardware needed).
+Uploads and dumps live in compress.py.
+
+Usage:
+    python3 progctl.py spibench --port /dev/ttyACM0 [--spi bitbang]
+    python3 progctl.py warm --port /dev/ttyACM0 --timeout 5   (0 = off)
+    python3 progctl.py dwfallback --port /dev/ttyACM0 [--off]
+    python3 progctl.py profileclock --port /dev/ttyACM0 --mhz 8   (0 = off)
+    python3 progctl.py metrics --port /dev/ttyACM0 [--reset]
+    python3 progctl.py trace --port /dev/ttyACM0 --enable        (then run avrdude)
+    python3 progctl.py trace --port /dev/ttyACM0 out.json [--raw trace.bin]
+    python3 progctl.py trace --input trace.bin out.json           (open in ui.perfetto.dev)
+    python3 progctl.py verify ../fw.hex [--page 128] [--sck 1000000]
+
+The port commands need pyserial.
+
+Author: MUdroThe1
+Date: 2026
+"""
+
+import argparse
+import sys
+from pathlib import Path
+
+from compress import load_image
+from trace_decode import COMMAND_NAMES, TRACE_RECORD, trace_decode, trace_to_chrome
+
+# STK500v1 framing
+INSYNC = 0x14
+OK = 0x10
+EOP = 0x20
+CMD_SET_PARAMETER = 0x40
+CMD_GET_PARAMETER = 0x41
+CMD_SPI_BENCH = 0x59
+CMD_METRICS = 0x5B
+CMD_TRACE_DUMP = 0x5C
+
+PARM_VND_SPI_BACKEND = 0xC4
+PARM_VND_WARM_TIMEOUT = 0xC7
+PARM_VND_WARM_HITS = 0xC8
+PARM_VND_ENTER_TIME = 0xC9
+PARM_VND_TRACE = 0xCF
+PARM_VND_DW_FALLBACK = 0xD1
+PARM_VND_PROFILE_CLOCK = 0xD2
+SPI_BACKENDS = {"hw": 0x00, "bitbang": 0x01}
+
+METRICS = ("bytes in", "bytes out", "ISP instructions", "target busy us", "retries", "sync failures")
+
+
+def _xfer(port, frame: bytes, reply_len: int = 2) -> bytes:
+    port.write(frame)
+    rsp = port.read(reply_len)
+    if len(rsp) != reply_len or rsp[0] != INSYNC or rsp[-1] != OK:
+        raise IOError(f"bad reply to {frame[:1].hex()}: {rsp.hex()}")
+    return rsp
+
+
+# =============================================================================
+# Vendor parameters and diagnostics
+# =============================================================================
+
+def cmd_spibench(args) -> int:
+    import serial  # pyserial, only needed for real benchmarks
+
+    with serial.Serial(args.port, 115200, timeout=10) as port:
+        if args.spi:
+            _xfer(port, bytes((CMD_SET_PARAMETER, PARM_VND_SPI_BACKEND, SPI_BACKENDS[args.spi], EOP)))
+        port.write(bytes((CMD_SPI_BENCH, EOP)))
+        hdr = port.read(2)
+        if len(hdr) != 2 or hdr[0] != INSYNC:
+            raise IOError(f"bad reply to SPI_BENCH: {hdr.hex()}")
+        body = port.read(hdr[1] * 8 + 1)
+        if len(body) != hdr[1] * 8 + 1 or body[-1] != OK:
+            raise IOError("truncated SPI_BENCH reply")
+    print(f"{'SCK':>10} {'instr/s':>10} {'kB/s':>8} {'bus eff':>8}")
+    for i in range(hdr[1]):
+        hz = int.from_bytes(body[i * 8:i * 8 + 4], "big")
+        ips = int.from_bytes(body[i * 8 + 4:i * 8 + 8], "big")
+        eff = ips * 32 / hz if hz else 0.0
+        print(f"{hz:>10} {ips:>10} {ips * 4 / 1e3:>8.1f} {eff:>8.0%}")
+    return 0
+
+
+def cmd_warm(args) -> int:
+    import serial  # pyserial, only needed for real sessions
+
+    units = min(255, max(0, round(args.timeout * 10)))
+    with serial.Serial(args.port, 115200, timeout=2) as port:
+        _xfer(port, bytes((CMD_SET_PARAMETER, PARM_VND_WARM_TIMEOUT, units, EOP)))
+        hits = _xfer(port, bytes((CMD_GET_PARAMETER, PARM_VND_WARM_HITS, EOP)), 3)[1]
+        enter = _xfer(port, bytes((CMD_GET_PARAMETER, PARM_VND_ENTER_TIME, EOP)), 3)[1]
+    state = f"{units / 10:.1f} s idle timeout" if units else "off"
+    print(f"warm sessions {state}; {hits} warm entries so far, last entry {enter / 10:.1f} ms")
+    return 0
+
+
+def cmd_dwfallback(args) -> int:
+    import serial  # pyserial, only needed for real sessions
+
+    with serial.Serial(args.port, 115200, timeout=2) as port:
+        _xfer(port, bytes((CMD_SET_PARAMETER, PARM_VND_DW_FALLBACK, int(not args.off), EOP)))
+    print(f"debugWIRE fallback {'off' if args.off else 'on'}")
+    return 0
+
+
+def cmd_profileclock(args) -> int:
+    import serial  # pyserial, only needed for real sessions
+
+    with serial.Serial(args.port, 115200, timeout=2) as port:
+        _xfer(port, bytes((CMD_SET_PARAMETER, PARM_VND_PROFILE_CLOCK, args.mhz, EOP)))
+    print(f"learned ISP rates {'off' if not args.mhz else f'up to the SCK limit for {args.mhz} MHz'}")
+    return 0
+
+
+def cmd_metrics(args) -> int:
+    import serial  # pyserial, only needed for real sessions
+
+    def be32(b, i):
+        return int.from_bytes(b[i:i + 4], "big")
+
+    with serial.Serial(args.port, 115200, timeout=2) as port:
+        port.write(bytes((CMD_METRICS, int(args.reset), EOP)))
+        hdr = port.read(6)
+        if len(hdr) != 6 or hdr[0] != INSYNC:
+            raise IOError(f"bad reply to METRICS: {hdr.hex()}")
+        counters = port.read(hdr[5] * 4 + 1)
+        if len(counters) != hdr[5] * 4 + 1:
+            raise IOError("truncated METRICS reply")
+        n_cmds = counters[-1]
+        body = port.read(n_cmds * 13 + 1)
+        if len(body) != n_cmds * 13 + 1 or body[-1] != OK:
+            raise IOError("truncated METRICS reply")
+
+    elapsed = max(be32(hdr, 1), 1) / 1e6
+    values = {name: be32(counters, i * 4) for i, name in enumerate(METRICS[:hdr[5]])}
+    print(f"session {elapsed:.3f} s")
+    for name, v in values.items():
+        print(f"  {name:18s} {v:>12}")
+    print(f"  {'USB in':18s} {values.get('bytes in', 0) / elapsed / 1e3:>10.1f} kB/s")
+    print(f"  {'USB out':18s} {values.get('bytes out', 0) / elapsed / 1e3:>10.1f} kB/s")
+    print(f"  {'ISP':18s} {values.get('ISP instructions', 0) / elapsed:>10.0f} instr/s")
+    print(f"  {'target busy':18s} {values.get('target busy us', 0) / 1e6 / elapsed:>10.0%}")
+
+    print(f"\n{'command':16s} {'count':>7s} {'total ms':>9s} {'avg us':>8s} {'max us':>8s} {'share':>6s}")
+    rows = []
+    for i in range(n_cmds):
+        e = body[i * 13:i * 13 + 13]
+        rows.append((e[0], be32(e, 1), be32(e, 5), be32(e, 9)))
+    for cmd, count, total, peak in sorted(rows, key=lambda r: -r[2]):
+        name = COMMAND_NAMES.get(cmd, f"0x{cmd:02X}")
+        print(f"{name:16s} {count:7d} {total / 1e3:9.1f} {total / count:8.0f} {peak:8d} "
+              f"{total / 1e6 / elapsed:6.1%}")
+    return 0
+
+
+# =============================================================================
+# Event trace
+# =============================================================================
+
+def cmd_trace(args) -> int:
+    import json
+
+    if args.input:
+        raw, dropped = Path(args.input).read_bytes(), 0
+    else:
+        import serial  # pyserial, only needed for real sessions
+
+        with serial.Serial(args.port, 115200, timeout=5) as port:
+            if args.enable or args.disable:
+                _xfer(port, bytes((CMD_SET_PARAMETER, PARM_VND_TRACE, int(args.enable), EOP)))
+                print(f"tracing {'on' if args.enable else 'off'}")
+                if not args.output:
+                    return 0
+            port.write(bytes((CMD_TRACE_DUMP, int(args.clear), EOP)))
+            hdr = port.read(7)
+            if len(hdr) != 7 or hdr[0] != INSYNC:
+                raise IOError(f"bad reply to TRACE_DUMP: {hdr.hex()}")
+            count = hdr[1] << 8 | hdr[2]
+            dropped = int.from_bytes(hdr[3:7], "big")
+            raw = port.read(count * TRACE_RECORD + 1)
+            if len(raw) != count * TRACE_RECORD + 1 or raw[-1] != OK:
+                raise IOError("truncated TRACE_DUMP reply")
+            raw = raw[:-1]
+        if args.raw:
+            Path(args.raw).write_bytes(raw)
+
+    if not args.output:
+        print("no output file given", file=sys.stderr)
+        return 1
+    events = trace_decode(raw)
+    Path(args.output).write_text(json.dumps(trace_to_chrome(events)))
+    span = (events[-1][0] - events[0][0]) / 1e3 if events else 0.0
+    print(f"{len(events)} events over {span:.1f} ms ({dropped} overwritten) -> {args.output}")
+    return 0
+
+
+# =============================================================================
+# Verify model
+# =============================================================================
+
+def model_verify(size: int, page: int, sck_hz: float, rtt_s: float, usb_bps: float,
+                 readahead: bool = True, window: int = 1024, chunk: int = 16):
+    """
+    Simulate an avrdude verify pass (LOAD_ADDRESS + READ_PAGE per page).
+
+    Mirrors pico/readahead.c: two contiguous requests arm the window, the
+    main loop prefetches one chunk at a time between a reply and the next
+    request, and a request arriving mid-chunk waits for that chunk.
+    Returns (seconds, full hits, misses, bytes served from the window).
+    """
+    byte_s = 32 / sck_hz                # one 4-byte read instruction per byte
+    gap = 2 * rtt_s                     # reply out, LOAD_ADDRESS, next READ_PAGE in
+    t = 0.0
+    hits = misses = served = 0
+    armed, base, filled, next_addr = False, 0, 0, None
+
+    for addr in range(0, size, page):
+        n = min(page, size - addr)
+        sequential = next_addr == addr
+        next_addr = addr + n
+        got = 0
+        if readahead and armed and base <= addr < base + filled:
+            off = addr - base
+            got = min(filled - off, n)
+            base, filled = addr + got, filled - off - got
+        else:
+            armed = sequential
+        if got < n:
+            misses += 1
+            base, filled = next_addr, 0
+        else:
+            hits += 1
+        served += got
+        t += (n - got) * byte_s + (6 + 5 + n + 2) / usb_bps + gap
+
+        if readahead and armed:
+            room = min(window - filled, size - (base + filled))
+            fit = gap / (chunk * byte_s)
+            if room > int(fit) * chunk:
+                t += (int(fit) + 1 - fit) * chunk * byte_s    # request waits for the chunk
+                filled += min(room, (int(fit) + 1) * chunk)
+            else:
+                filled += room
+    return t, hits, misses, served
+
+
+def cmd_verify(args) -> int:
+    """Model a verify pass with and without the firmware read-ahead window."""
+    print(f"{'image':32s} {'bytes':>8s} {'hits':>6s} {'served':>7s} "
+          f"{'plain s':>8s} {'ahead s':>8s} {'speedup':>7s}")
+    for path in args.images:
+        img = load_image(path)
+        size = (len(img) + args.page - 1) // args.page * args.page
+        kw = dict(page=args.page, sck_hz=args.sck, rtt_s=args.rtt_ms / 1e3,
+                  usb_bps=args.usb_kbps * 1e3, window=args.window, chunk=args.chunk)
+        t_plain, _, _, _ = model_verify(size, readahead=False, **kw)
+        t_ahead, hits, misses, served = model_verify(size, **kw)
+        print(f"{Path(path).name:32s} {size:8d} {100 * hits / max(hits + misses, 1):5.1f}% "
+              f"{100 * served / max(size, 1):6.1f}% {t_plain:8.2f} {t_ahead:8.2f} "
+              f"{t_plain / t_ahead:7.2f}")
+    return 0
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("spibench", help="measure ISP instruction throughput at each SCK rate")
+    p.add_argument("--port", required=True)
+    p.add_argument("--spi", choices=SPI_BACKENDS, help="ISP transport (default: firmware's power-up choice)")
+    p.set_defaults(fn=cmd_spibench)
+
+    p = sub.add_parser("warm", help="hold the target between avrdude runs")
+    p.add_argument("--port", required=True)
+    p.add_argument("--timeout", type=float, default=5.0, help="idle seconds before release (0 = off, max 25.5)")
+    p.set_defaults(fn=cmd_warm)
+
+    p = sub.add_parser("dwfallback", help="let failed ISP entries disable debugWIRE and retry")
+    p.add_argument("--port", required=True)
+    p.add_argument("--off", action="store_true", help="turn the fallback off again")
+    p.set_defaults(fn=cmd_dwfallback)
+
+    p = sub.add_parser("profileclock", help="let ISP sessions learn rates above the base rate")
+    p.add_argument("--port", required=True)
+    p.add_argument("--mhz", type=int, choices=range(0, 256), metavar="MHZ", required=True,
+                   help="slowest target clock of the boards (0 = off)")
+    p.set_defaults(fn=cmd_profileclock)
+
+    p = sub.add_parser("metrics", help="print the programmer's session counters")
+    p.add_argument("--port", required=True)
+    p.add_argument("--reset", action="store_true", help="clear the counters after reading")
+    p.set_defaults(fn=cmd_metrics)
+
+    p = sub.add_parser("trace", help="dump the event trace as Chrome/Perfetto JSON")
+    p.add_argument("output", nargs="?", help="JSON file to write")
+    src = p.add_mutually_exclusive_group(required=True)
+    src.add_argument("--port")
+    src.add_argument("--input", help="decode a raw dump saved with --raw")
+    p.add_argument("--raw", help="also save the raw records")
+    p.add_argument("--clear", action="store_true", help="drop the events on the device after dumping")
+    p.add_argument("--enable", action="store_true", help="start recording (clears the ring)")
+    p.add_argument("--disable", action="store_true", help="stop recording")
+    p.set_defaults(fn=cmd_trace)
+
+    p = sub.add_parser("verify", help="model READ_PAGE verify with and without read-ahead")
+    p.add_argument("images", nargs="+")
+    p.add_argument("--page", type=int, default=128, help="READ_PAGE size in bytes")
+    p.add_argument("--sck", type=float, default=1000000, help="ISP clock in Hz")
+    p.add_argument("--rtt-ms", type=float, default=2.0, help="USB round trip per frame")
+    p.add_argument("--usb-kbps", type=float, default=800, help="CDC payload throughput (kB/s)")
+    p.add_argument("--window", type=int, default=1024, help="read-ahead window in bytes")
+    p.add_argument("--chunk", type=int, default=16, help="bytes prefetched per main loop pass")
+    p.set_defaults(fn=cmd_verify)
+
+    args = ap.parse_args()
+    return args.fn(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
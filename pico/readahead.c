@@ -0,0 +1,117 @@
+/**
+ * @file readahead.c
+ * @brief Sequential Flash Read-ahead for READ_PAGE Verify Passes
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "readahead.h"
+#include "avr_iface.h"
+#include <string.h>
+
+/*******************************************************************************
+ * Window State
+ ******************************************************************************/
+
+static uint8_t window[READAHEAD_WINDOW];
+static uint32_t base;           /* Address of window[0] */
+static size_t filled;           /* Valid bytes from base */
+static bool armed;              /* Sequential pattern detected */
+static uint32_t next_addr;      /* Start of the request that would be sequential */
+static bool have_next;
+static uint32_t limit;          /* Flash end, 0 = unknown (no read-ahead) */
+
+static uint32_t hit_count;
+static uint32_t miss_count;
+
+/** Drop served bytes from the front of the window */
+static void consume(size_t n) {
+    memmove(window, window + n, filled - n);
+    base += (uint32_t)n;
+    filled -= n;
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/**
+ * @brief Drop the window and restart pattern detection
+ */
+void readahead_invalidate(void) {
+    filled = 0;
+    armed = false;
+    have_next = false;
+}
+
+/**
+ * @brief Bound prefetching to the flash of the current target
+ */
+void readahead_set_limit(uint32_t flash_bytes) {
+    limit = flash_bytes;
+    readahead_invalidate();
+}
+
+/**
+ * @brief Serve a flash read, from the window where possible
+ */
+void readahead_read(uint32_t byte_addr, uint8_t* out, size_t len) {
+    bool sequential = have_next && byte_addr == next_addr;
+    next_addr = byte_addr + (uint32_t)len;
+    have_next = true;
+
+    if (armed && byte_addr >= base && byte_addr < base + filled) {
+        size_t off = byte_addr - base;
+        size_t n = filled - off < len ? filled - off : len;
+        memcpy(out, window + off, n);
+        consume(off + n);
+        if (n == len) {
+            hit_count++;
+            return;
+        }
+        /* Prefetch had not caught up: read the rest, continue behind it */
+        avr_iface()->read_flash(byte_addr + (uint32_t)n, out + n, len - n);
+        miss_count++;
+        base = next_addr;
+        filled = 0;
+        return;
+    }
+
+    avr_iface()->read_flash(byte_addr, out, len);
+    miss_count++;
+    armed = sequential && limit != 0;   /* Not on an unknown part: no flash end to stop at */
+    base = next_addr;
+    filled = 0;
+}
+
+/**
+ * @brief Prefetch one chunk if a sequential pattern is active
+ */
+bool readahead_step(void) {
+    if (!armed || filled >= READAHEAD_WINDOW) {
+        return false;
+    }
+    uint32_t addr = base + (uint32_t)filled;
+    size_t n = READAHEAD_WINDOW - filled;
+    if (n > READAHEAD_CHUNK) {
+        n = READAHEAD_CHUNK;
+    }
+    if (addr >= limit) {
+        return false;
+    }
+    if (n > limit - addr) {
+        n = limit - addr;
+    }
+    avr_iface()->read_flash(addr, window + filled, n);
+    filled += n;
+    return filled < READAHEAD_WINDOW && base + filled < limit;
+}
+
+/**
+ * @brief Get request statistics since startup
+ */
+void readahead_stats(uint32_t *hits, uint32_t *misses) {
+    *hits = hit_count;
+    *misses = miss_count;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file readahead.h
+ * @brief Sequential Flash Read-ahead for READ_PAGE Verify Passes
+ *
+ * avrdude verifies with LOAD_ADDRESS + READ_PAGE pairs walking up through
+ * flash, and each page used to be read from the target only once its
+ * request had arrived. Once two requests in a row are contiguous, the
+ * bytes following the second are prefetched into a RAM window in small
+ * chunks from the main loop, i.e. while the previous reply is on USB and
+ * the next request is on its way.
+ *
+ * Window:
+ *   READAHEAD_WINDOW bytes starting at the next expected address. Served
+ *   bytes are dropped from the front and prefetching tops the window up.
+ *   A request outside the window is read directly and restarts detection.
+ *
+ * Invalidation:
+ *   Everything that can change flash or the target (page writes, erase,
+ *   raw instructions, entering/leaving programming mode) drops the window.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Bytes held ahead of the host */
+#define READAHEAD_WINDOW   1024
+
+/** Bytes read from the target per readahead_step() */
+#define READAHEAD_CHUNK    16
+
+/**
+ * @brief Drop the window and restart pattern detection
+ */
+void readahead_invalidate(void);
+
+/**
+ * @brief Bound prefetching to the flash of the current target
+ *
+ * Prefetching never reads past the end of flash. With the part unknown
+ * the end is too, so read-ahead stays off and every request reads the
+ * target.
+ *
+ * @param flash_bytes Flash size in bytes (0 = unknown)
+ */
+void readahead_set_limit(uint32_t flash_bytes);
+
+/**
+ * @brief Serve a flash read, from the window where possible
+ *
+ * @param byte_addr Start address in bytes
+ * @param out       Receives len bytes
+ * @param len       Number of bytes
+ */
+void readahead_read(uint32_t byte_addr, uint8_t* out, size_t len);
+
+/**
+ * @brief Prefetch one chunk if a sequential pattern is active
+ *
+ * @return true if more prefetching remains
+ */
+bool readahead_step(void);
+
+/**
+ * @brief Get request statistics since startup
+ *
+ * @param hits   Requests served entirely from the window
+ * @param misses Requests that read the target
+ */
+void readahead_stats(uint32_t *hits, uint32_t *misses);
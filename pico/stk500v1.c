@@ -15,15 +15,43 @@
  * Supported Commands:
  *   - GET_SYNC: Synchronization/ping
  *   - GET_SIGN_ON: Returns programmer identification
- *   - GET/SET_PARAMETER: Read/write programmer parameters
+ *   - GET/SET_PARAMETER: Read/write programmer parameters (incl. interface)
  *   - SET_DEVICE: Configure target device parameters
- *   - ENTER/LEAVE_PROGMODE: Enter/exit programming mode
+ *   - ENTER/LEAVE_PROGMODE: Enter/exit programming mode (ISP sessions
+ *     start at the SCK rate learned for the signature, see avr_profile.h)
  *   - CHIP_ERASE: Erase target flash memory
  *   - LOAD_ADDRESS: Set current address for read/write
  *   - PROG_PAGE: Write a page of flash memory
- *   - READ_PAGE: Read a page of flash memory
+ *   - PROG_PAGE_LZ: Vendor extension, LZSS-compressed flash upload
+ *   - READ_PAGE: Read a page of flash memory (prefetched during sequential
+ *     verify passes, see readahead.h)
+ *   - READ_FLASH_RLE: Vendor extension, run-length encoded bulk readback
  *   - READ_SIGN: Read target device signature
  *   - UNIVERSAL: Raw 4-byte SPI transaction
+ *   - UNIVERSAL_MULTI: Several raw ISP instructions in one frame
+ *   - UNIVERSAL_BATCH: Vendor extension, batched instructions with results
+ *   - SPI_BENCH: Vendor extension, ISP throughput at each SCK rate
+ *   - VERIFY_MAP: Vendor extension, pages that failed inline verify
+ *   - METRICS: Vendor extension, session counters (see metrics.h)
+ *   - TRACE_DUMP: Vendor extension, timestamped event trace (see trace.h)
+ *   - CAPTURE_DUMP: Vendor extension, timestamped stream capture (see capture.h)
+ * 
+ * Non-blocking Writes:
+ *   When the interface supports it, CHIP_ERASE and page writes are queued
+ *   on the async engine (avr_async.h) and acknowledged right away. The
+ *   next frame is parsed once the engine is idle, so commands still run
+ *   in order while USB keeps being serviced; stk500v1_task() drives the
+ *   engine. A write that fails fails the next PROG_PAGE or LEAVE_PROGMODE.
+ *   A PROG_PAGE_LZ frame is expanded one page per stk500v1_task() call
+ *   and answered once done, with later frames held back the same way.
+ *   With inline verify on, each page is read back (and rewritten if
+ *   needed) once its write completes, before the next frame runs.
+ * 
+ * Warm Sessions:
+ *   With Parm_VND_WARM_TIMEOUT set, LEAVE_PROGMODE keeps the target in
+ *   programming mode until the host has been idle for the timeout. An
+ *   ENTER_PROGMODE in the meantime only re-reads the signature, so
+ *   back-to-back avrdude runs skip reset, sync and cache population.
  * 
  * Reference: Atmel AVR061 - STK500 Communication Protocol
  * 
@@ -35,12 +63,20 @@
 #include "pico/stdlib.h"
 #include "tusb.h"
 #include "stk500v1.h"
-#include "avrprog.h"
-#ifdef USE_BITBANG_SPI
-#include "avrprog_bitbang.h"
-#endif
 #include "avr_devices.h"
-#include <hardware/spi.h>
+#include "avr_iface.h"
+#include "avr_async.h"
+#include "avr_profile.h"
+#include "avrprog.h"
+#include "avr_spi_transport.h"
+#include "capture.h"
+#include "compress.h"
+#include "metrics.h"
+#include "readahead.h"
+#include "target_cache.h"
+#include "target_clock.h"
+#include "trace.h"
+#include "write_verify.h"
 
 /*******************************************************************************
  * Protocol State Variables
@@ -58,6 +94,34 @@ static uint16_t page_size_bytes = 128;
 /** Number of 16-bit words per flash page */
 static uint16_t words_per_page = 64;
 
+/** SCK rates measured by SPI_BENCH, slowest first */
+static const uint32_t bench_sck_hz[] = {
+    50000, 125000, 250000, 500000, 1000000, 2000000, 4000000, 8000000,
+};
+
+/** Set when a queued erase or page write did not complete */
+static bool async_failed = false;
+
+/*******************************************************************************
+ * Warm Session State
+ ******************************************************************************/
+
+/** Idle time before a held target is released, 100ms units (0 = off) */
+static uint8_t warm_timeout = 0;
+
+/** Target still in programming mode after LEAVE_PROGMODE */
+static bool warm = false;
+static absolute_time_t warm_deadline;
+
+/** A queued write failed since the last cold ENTER_PROGMODE */
+static bool session_failed = false;
+
+/** ENTER_PROGMODE requests served from a held target */
+static uint32_t warm_hits = 0;
+
+/** Duration of the last ENTER_PROGMODE */
+static uint32_t enter_us = 0;
+
 /*******************************************************************************
  * Stream Buffer for STK500v1 Frame Parsing
  * 
@@ -68,17 +132,108 @@ static uint16_t words_per_page = 64;
 static uint8_t rx_buf[STK_RX_BUF_SIZE];
 static size_t rx_len = 0;
 
+/*******************************************************************************
+ * Compressed Upload State (Cmnd_STK_PROG_PAGE_LZ)
+ *
+ * The LZSS stream may span many frames. Decoded bytes collect in lz_page
+ * and are programmed one full device page at a time. One frame can expand
+ * to hundreds of pages, so its input is held in lz_in and expanded one
+ * page per stk500v1_task() call; the reply and later frames wait for it.
+ ******************************************************************************/
+#define STK_MAX_PAGE_BYTES 256
+#define STK_MAX_LZ_FRAME   256
+static lzss_decoder_t lz_decoder;
+static uint8_t lz_page[STK_MAX_PAGE_BYTES];
+static size_t lz_page_len = 0;
+static uint8_t lz_in[STK_MAX_LZ_FRAME];
+static size_t lz_in_len = 0;
+static size_t lz_in_pos = 0;
+
+/** A PROG_PAGE_LZ frame is still being expanded (reply not sent yet) */
+static bool lz_active = false;
+
 /*******************************************************************************
  * Helper Functions for USB CDC Response Transmission
  ******************************************************************************/
 
-static inline void put(uint8_t b) { tud_cdc_write_char(b); }
-static inline void flush(void) { tud_cdc_write_flush(); }
+static inline void put(uint8_t b) {
+    tud_cdc_write_char(b);
+    metrics_add(METRIC_BYTES_OUT, 1);
+    capture_bytes(CAPTURE_PROGRAMMER, &b, 1);
+}
+
+/** Push queued bytes to USB without ending the reply */
+static inline void usb_flush(void) {
+    tud_cdc_write_flush();
+    trace(TRACE_FLUSH, 0, 0);
+}
+
+/** End of a reply: push it out and close its capture record */
+static inline void flush(void) {
+    usb_flush();
+    capture_flush();
+}
 
 static inline void resp_ok_insync(void) { put(Resp_STK_INSYNC); put(Resp_STK_OK); flush(); }
 static inline void resp_failed(void) { put(Resp_STK_INSYNC); put(Resp_STK_FAILED); flush(); }
 
-static inline void resp_nosync(void) { put(Resp_STK_NOSYNC); flush(); }
+static inline void resp_nosync(void) {
+    put(Resp_STK_NOSYNC);
+    flush();
+    metrics_add(METRIC_SYNC_FAILS, 1);
+    trace(TRACE_NOSYNC, 0, 0);
+}
+
+/** Time a reply may wait for TX space before the rest of it is dropped */
+#define STK_TX_STALL_MS 500
+
+/** The host stopped draining during this frame's reply; drop the rest */
+static bool tx_abandoned = false;
+
+/**
+ * @brief Queue a block of reply bytes, waiting for TX space as needed
+ *
+ * The CDC TX FIFO is small, so long replies keep the USB stack running
+ * while the host drains it. If the port closes, or no space frees up for
+ * STK_TX_STALL_MS, the remainder of the reply is dropped so the main
+ * loop keeps running; the host resyncs with GET_SYNC.
+ */
+static void put_all(const uint8_t* data, size_t len) {
+    absolute_time_t deadline = make_timeout_time_ms(STK_TX_STALL_MS);
+    while (len > 0 && !tx_abandoned) {
+        uint32_t n = tud_cdc_write(data, (uint32_t)len);
+        metrics_add(METRIC_BYTES_OUT, n);
+        capture_bytes(CAPTURE_PROGRAMMER, data, n);
+        data += n;
+        len -= n;
+        if (n > 0) {
+            deadline = make_timeout_time_ms(STK_TX_STALL_MS);
+        }
+        if (len > 0) {
+            if (!tud_cdc_connected() || time_reached(deadline)) {
+                tx_abandoned = true;
+                break;
+            }
+            usb_flush();
+            tud_task();
+        }
+    }
+}
+
+/** Store a big-endian 32-bit value, returning the bytes written */
+static size_t pack_be32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+    return 4;
+}
+
+/** rle_sink_t adapter that streams encoded readback straight to CDC */
+static void rle_cdc_sink(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    put_all(data, len);
+}
 
 static void drop_rx(size_t n) {
     if (n >= rx_len) {
@@ -89,24 +244,331 @@ static void drop_rx(size_t n) {
     rx_len -= n;
 }
 
+static uint8_t saturate_u8(uint32_t v) { return v > 0xFF ? 0xFF : (uint8_t)v; }
+
+/** Last STK500 clock parameters, reported back by GET_PARAMETER */
+static uint8_t osc_pscale = 0;
+static uint8_t osc_cmatch = 0;
+static uint8_t sck_duration = 0;
+
 static uint8_t get_parameter_value(uint8_t param) {
+    uint32_t hits, misses;
     // Values are mostly informational for avrdude; keep stable.
     switch (param) {
         case 0x80: return 0x02; // HWVER
         case 0x81: return 0x01; // SW_MAJOR
         case 0x82: return 0x12; // SW_MINOR (18)
+        case Parm_VND_CACHE_HITS:
+            target_cache_stats(&hits, &misses);
+            return saturate_u8(hits);
+        case Parm_VND_CACHE_MISSES:
+            target_cache_stats(&hits, &misses);
+            return saturate_u8(misses);
+        case Parm_VND_INTERFACE:
+            return avr_iface_selected();
+        case Parm_STK_OSC_PSCALE:
+            return osc_pscale;
+        case Parm_STK_OSC_CMATCH:
+            return osc_cmatch;
+        case Parm_STK_SCK_DURATION:
+            return sck_duration;
+        case Parm_VND_TARGET_CLOCK:
+            return saturate_u8(target_clock_hz() / 1000000u);
+        case Parm_VND_SPI_BACKEND:
+            return avr_spi_selected();
+        case Parm_VND_ENTRY_ATTEMPTS:
+            return avr_entry_log()->attempts;
+        case Parm_VND_ENTRY_TIME:
+            return saturate_u8(avr_entry_log()->total_us / 100u);
+        case Parm_VND_WARM_TIMEOUT:
+            return warm_timeout;
+        case Parm_VND_WARM_HITS:
+            return saturate_u8(warm_hits);
+        case Parm_VND_ENTER_TIME:
+            return saturate_u8(enter_us / 100u);
+        case Parm_VND_READAHEAD_HITS:
+            readahead_stats(&hits, &misses);
+            return saturate_u8(hits);
+        case Parm_VND_READAHEAD_MISSES:
+            readahead_stats(&hits, &misses);
+            return saturate_u8(misses);
+        case Parm_VND_VERIFY:
+            return write_verify_enabled() ? 1 : 0;
+        case Parm_VND_VERIFY_RETRIED:
+            write_verify_stats(&hits, &misses);
+            return saturate_u8(hits);
+        case Parm_VND_VERIFY_FAILED:
+            write_verify_stats(&hits, &misses);
+            return saturate_u8(misses);
+        case Parm_VND_TRACE:
+            return trace_enabled() ? 1 : 0;
+        case Parm_VND_CAPTURE:
+            return capture_enabled() ? 1 : 0;
+        case Parm_VND_DW_FALLBACK:
+            return avr_dw_fallback_enabled() ? 1 : 0;
+        case Parm_VND_PROFILE_CLOCK:
+            return saturate_u8(avr_profile_clock_hz() / 1000000u);
         default: return 0x00;
     }
 }
 
 static void cache_device_params(void) {
-    uint8_t sig[3] = {0};
-    avr_read_signature(sig);
-    const avr_device_t* dev = avr_lookup_device_by_signature(sig);
+    target_cache_populate();  /* Signature, fuses, lock, calibration - once per session */
+    const avr_device_t* dev = target_cache_device();
     if (dev && dev->page_size_bytes) {
         page_size_bytes = dev->page_size_bytes;
         words_per_page = page_size_bytes / 2;
     }
+    readahead_set_limit(dev ? dev->flash_size_bytes : 0);
+}
+
+/**
+ * @brief Check whether a command leaves target flash and mode untouched
+ *
+ * Any other command drops the read-ahead window before it runs.
+ */
+static bool keeps_readahead(uint8_t cmd) {
+    switch (cmd) {
+        case Cmnd_STK_GET_SYNC:
+        case Cmnd_STK_GET_SIGN_ON:
+        case Cmnd_STK_GET_PARAMETER:
+        case Cmnd_STK_SET_DEVICE:
+        case Cmnd_STK_SET_DEVICE_EXT:
+        case Cmnd_STK_CHECK_AUTOINC:
+        case Cmnd_STK_LOAD_ADDRESS:
+        case Cmnd_STK_READ_SIGN:
+        case Cmnd_STK_READ_PAGE:
+        case Cmnd_STK_READ_FLASH_RLE:
+        case Cmnd_STK_VERIFY_MAP:
+        case Cmnd_STK_METRICS:
+        case Cmnd_STK_TRACE_DUMP:
+        case Cmnd_STK_CAPTURE_DUMP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** Completion callback for queued erases and page writes */
+static void async_done(bool ok, void* ctx) {
+    (void)ctx;
+    if (!ok) {
+        async_failed = true;
+    }
+}
+
+/** Completion callback for queued page writes */
+static void page_done(bool ok, void* ctx) {
+    (void)ctx;
+    write_verify_complete(ok);  /* With inline verify, a failed write is retried */
+    if (!ok && !write_verify_enabled()) {
+        async_failed = true;
+    }
+}
+
+/**
+ * @brief Verify the last queued page once its write has completed
+ *
+ * Runs before the next frame is handled, so results are in order.
+ */
+static void check_written_page(void) {
+    if (!write_verify_run_deferred()) {
+        async_failed = true;
+    }
+}
+
+/**
+ * @brief Report and clear a failure of an earlier queued write
+ */
+static bool take_async_failure(void) {
+    bool failed = async_failed;
+    async_failed = false;
+    return failed;
+}
+
+/**
+ * @brief Load bytes into the target page buffer and commit at current address
+ *
+ * Shared by PROG_PAGE and the compressed upload path. Advances
+ * current_address by the number of words written.
+ *
+ * @param data Little-endian program bytes (low byte first)
+ * @param len  Number of bytes (rounded down to whole words)
+ */
+static void program_flash_page(const uint8_t* data, size_t len) {
+    const avr_iface_t* iface = avr_iface();
+    size_t words = len / 2;
+    if (iface->submit_flash_page) {
+        avr_async_finish();  /* Normally idle: frames and LZ pages wait for it */
+        check_written_page();
+        if (write_verify_enabled()) {
+            write_verify_defer(current_address * 2, data, words * 2);
+        }
+        iface->submit_flash_page(current_address * 2, data, words * 2, page_done, NULL);
+    } else {
+        iface->write_flash_page(current_address * 2, data, words * 2);
+        if (write_verify_enabled() &&
+            !write_verify_page(current_address * 2, data, words * 2, true)) {
+            async_failed = true;
+        }
+    }
+    current_address += (uint32_t)words;
+}
+
+/** Start a fresh compressed upload stream */
+static void lz_reset(void) {
+    lzss_init(&lz_decoder);
+    lz_page_len = 0;
+    lz_in_len = 0;
+    lz_in_pos = 0;
+    lz_active = false;
+}
+
+/**
+ * @brief Program a decoded page, skipping it when it is all 0xFF
+ *
+ * Uploads start with a chip erase, so an erased page needs no write.
+ */
+static void lz_program_page(void) {
+    for (size_t i = 0; i < lz_page_len; i++) {
+        if (lz_page[i] != 0xFF) {
+            program_flash_page(lz_page, lz_page_len);
+            return;
+        }
+    }
+    current_address += (uint32_t)(lz_page_len / 2);
+}
+
+/**
+ * @brief Expand the held frame until its input runs out or a page fills
+ *
+ * @return true once the frame is fully expanded
+ */
+static bool lz_step(void) {
+    size_t page_bytes = page_size_bytes < STK_MAX_PAGE_BYTES ? page_size_bytes : STK_MAX_PAGE_BYTES;
+    while (lz_in_pos < lz_in_len || lzss_pending(&lz_decoder)) {
+        size_t used = 0;
+        lz_page_len += lzss_decode(&lz_decoder, lz_in + lz_in_pos, lz_in_len - lz_in_pos, &used,
+                                   lz_page + lz_page_len, page_bytes - lz_page_len);
+        lz_in_pos += used;
+        if (lz_page_len == page_bytes) {
+            lz_program_page();
+            lz_page_len = 0;
+            return lz_in_pos == lz_in_len && !lzss_pending(&lz_decoder);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Expand one more page of the held frame, replying once it is done
+ */
+static void lz_continue(void) {
+    if (!lz_step()) {
+        return;
+    }
+    lz_active = false;
+    if (take_async_failure()) {
+        resp_failed();
+    } else {
+        resp_ok_insync();
+    }
+}
+
+/**
+ * @brief End the compressed stream and program the partial last page
+ *
+ * @return false if the stream ended in the middle of an item
+ */
+static bool lz_finish(void) {
+    bool ok = lzss_at_boundary(&lz_decoder);
+    if (ok && lz_page_len > 0) {
+        if (lz_page_len & 1) {
+            lz_page[lz_page_len++] = 0xFF;  /* Complete the last word */
+        }
+        lz_program_page();
+    }
+    lz_reset();
+    return ok;
+}
+
+/**
+ * @brief Worst-case completion time of a self-timed ISP write instruction
+ * 
+ * Classifies a raw instruction so batched execution can poll RDY/BSY
+ * after writes before issuing the next instruction.
+ * 
+ * @param instr 4-byte ISP instruction
+ * @return Poll timeout in microseconds, 0 if the instruction is not a write
+ */
+static uint32_t isp_write_timeout_us(const uint8_t* instr) {
+    switch (instr[0]) {
+        case 0xAC:
+            switch (instr[1]) {
+                case 0x80: return 9000;  /* Chip erase */
+                case 0xA0:               /* Write low fuse */
+                case 0xA8:               /* Write high fuse */
+                case 0xA4:               /* Write extended fuse */
+                case 0xE0: return 4500;  /* Write lock bits */
+                default:   return 0;     /* Programming enable */
+            }
+        case 0xC0:                       /* Write EEPROM byte */
+        case 0xC2: return 3600;          /* Write EEPROM page */
+        case 0x4C: return 4500;          /* Write program memory page */
+        default:   return 0;
+    }
+}
+
+/**
+ * @brief Execute a list of 4-byte ISP instructions back to back
+ * 
+ * Writes are followed by RDY/BSY polling so the next instruction (e.g. the
+ * next fuse write) is only issued once the target has finished.
+ * 
+ * @param instr   count x 4 instruction bytes
+ * @param count   Number of instructions
+ * @param results Receives the 4th response byte of each instruction (may be NULL)
+ */
+static void run_isp_instructions(const uint8_t* instr, size_t count, uint8_t* results) {
+    for (size_t i = 0; i < count; i++) {
+        uint8_t result = target_cache_instruction(instr + i * 4);
+        if (results) {
+            results[i] = result;
+        }
+        uint32_t timeout_us = isp_write_timeout_us(instr + i * 4);
+        if (timeout_us) {
+            avr_iface()->poll_ready(timeout_us);
+        }
+    }
+}
+
+/**
+ * @brief End the session: release the target and persist what was learned
+ */
+static void session_release(void) {
+    warm = false;
+    target_cache_invalidate();  /* Target may be swapped once released */
+    avr_iface()->leave();
+    target_clock_stop();
+    avr_profile_end(!session_failed);
+    session_failed = false;
+}
+
+/**
+ * @brief Check that the held target is still the one in the target cache
+ */
+static bool warm_target_matches(void) {
+    uint8_t held[3];
+    target_cache_signature(held);
+    for (uint8_t i = 0; i < 3; i++) {
+        uint8_t cmd[4] = {0x30, 0x00, i, 0x00};
+        uint8_t rx[4];
+        avr_iface()->universal(cmd, rx);
+        if (rx[3] != held[i]) {
+            return false;
+        }
+    }
+    return true;
 }
 
 /**
@@ -120,6 +582,10 @@ static void cache_device_params(void) {
  * @param payload_len Number of payload bytes
  */
 static void handle_frame(uint8_t cmd, const uint8_t* payload, size_t payload_len) {
+    if (!keeps_readahead(cmd)) {
+        readahead_invalidate();
+    }
+
     switch (cmd) {
         
         /*------------------------------------------------------------------
@@ -137,7 +603,7 @@ static void handle_frame(uint8_t cmd, const uint8_t* payload, size_t payload_len
         case Cmnd_STK_GET_SIGN_ON: {
             static const uint8_t sign_on[] = {'A','V','R',' ','I','S','P'};
             put(Resp_STK_INSYNC);
-            tud_cdc_write(sign_on, sizeof(sign_on));
+            put_all(sign_on, sizeof(sign_on));
             put(Resp_STK_OK);
             flush();
         } break;
@@ -159,13 +625,86 @@ static void handle_frame(uint8_t cmd, const uint8_t* payload, size_t payload_len
 
         /*------------------------------------------------------------------
          * SET_PARAMETER (0x40): Write programmer parameter
-         * Accepts but ignores - no configurable parameters
+         * Interface and transport selection, target clock and ISP rate are
+         * acted upon; other standard STK500 parameters are accepted and
+         * ignored
          *------------------------------------------------------------------*/
         case Cmnd_STK_SET_PARAMETER: {
             if (payload_len != 2) {
                 resp_failed();
                 break;
             }
+            switch (payload[0]) {
+                case Parm_VND_INTERFACE:
+                case Parm_VND_SPI_BACKEND:
+                case Parm_VND_TARGET_CLOCK:
+                case Parm_STK_OSC_PSCALE:
+                case Parm_STK_OSC_CMATCH:
+                case Parm_STK_SCK_DURATION:
+                    /* A held target belongs to the old settings */
+                    if (warm && payload[1] != get_parameter_value(payload[0])) {
+                        session_release();
+                    }
+                    break;
+                default:
+                    break;
+            }
+            switch (payload[0]) {
+                case Parm_VND_INTERFACE:
+                    if (programming || !avr_iface_select(payload[1])) {
+                        resp_failed();
+                        return;
+                    }
+                    target_cache_invalidate();
+                    break;
+                case Parm_STK_OSC_PSCALE:
+                    osc_pscale = payload[1];
+                    target_clock_set_stk(osc_pscale, osc_cmatch);
+                    break;
+                case Parm_STK_OSC_CMATCH:
+                    osc_cmatch = payload[1];
+                    target_clock_set_stk(osc_pscale, osc_cmatch);
+                    break;
+                case Parm_STK_SCK_DURATION:
+                    sck_duration = payload[1];
+                    target_clock_set_sck_duration(sck_duration);
+                    break;
+                case Parm_VND_TARGET_CLOCK:
+                    target_clock_set_hz((uint32_t)payload[1] * 1000000u);
+                    break;
+                case Parm_VND_SPI_BACKEND:
+                    if (programming || !avr_spi_select(payload[1])) {
+                        resp_failed();
+                        return;
+                    }
+                    break;
+                case Parm_VND_WARM_TIMEOUT:
+                    warm_timeout = payload[1];
+                    if (warm && !warm_timeout) {
+                        session_release();
+                    }
+                    break;
+                case Parm_VND_VERIFY:
+                    write_verify_enable(payload[1] != 0);
+                    break;
+                case Parm_VND_TRACE:
+                    if (payload[1] && !trace_enabled()) {
+                        trace_clear();
+                    }
+                    trace_enable(payload[1] != 0);
+                    break;
+                case Parm_VND_CAPTURE:
+                    capture_enable(payload[1] != 0);
+                    break;
+                case Parm_VND_DW_FALLBACK:
+                    avr_dw_fallback_enable(payload[1] != 0);
+                    break;
+                case Parm_VND_PROFILE_CLOCK:
+                    avr_profile_set_clock_hz((uint32_t)payload[1] * 1000000u);
+                    break;
+                default:
+                    break;
+            }
             resp_ok_insync();
         } break;
 
@@ -188,26 +727,67 @@ static void handle_frame(uint8_t cmd, const uint8_t* payload, size_t payload_len
 
         /*------------------------------------------------------------------
          * ENTER_PROGMODE (0x50): Enter target programming mode
-         * Puts AVR target into ISP mode for programming
+         * Connects over the selected interface (ISP by default), with the
+         * target clock output running if one is configured
          *------------------------------------------------------------------*/
         case Cmnd_STK_ENTER_PROGMODE: {
-            if (avr_enter_programming_mode()) {
+            uint64_t start = time_us_64();
+            lz_reset();
+            if (warm) {
+                warm = false;
+                if (warm_target_matches()) {
+                    programming = true;
+                    write_verify_reset(page_size_bytes);
+                    warm_hits++;
+                    enter_us = (uint32_t)(time_us_64() - start);
+                    resp_ok_insync();
+                    break;
+                }
+                session_release();  /* Different target: start over */
+            }
+            uint32_t clock_hz = target_clock_start();
+            if (avr_iface()->enter()) {
                 programming = true;
                 cache_device_params();  /* Auto-detect target page size */
+                write_verify_reset(page_size_bytes);
+                if (avr_iface_selected() == AVR_IFACE_ISP && !clock_hz && !sck_duration) {
+                    uint8_t sig[3];
+                    target_cache_signature(sig);
+                    avr_profile_begin(sig);  /* Learned SCK rate for this part */
+                }
                 resp_ok_insync();
             } else {
+                target_cache_invalidate();
+                target_clock_stop();
                 resp_failed();
             }
+            enter_us = (uint32_t)(time_us_64() - start);
         } break;
 
         /*------------------------------------------------------------------
          * LEAVE_PROGMODE (0x51): Exit target programming mode
-         * Releases AVR reset so target can run
+         * Releases AVR reset so target can run, or holds it for the warm
+         * timeout when one is set
          *------------------------------------------------------------------*/
         case Cmnd_STK_LEAVE_PROGMODE: {
+            bool failed = take_async_failure();
+            uint32_t retried, lost;
+            write_verify_stats(&retried, &lost);
+            /* Pages that needed a slower rewrite count against the learned rate */
+            session_failed = session_failed || failed || retried;
             programming = false;
-            avr_leave_programming_mode();
-            resp_ok_insync();
+            lz_reset();
+            if (warm_timeout) {
+                warm = true;
+                warm_deadline = make_timeout_time_ms((uint32_t)warm_timeout * 100u);
+            } else {
+                session_release();
+            }
+            if (failed) {
+                resp_failed();
+            } else {
+                resp_ok_insync();
+            }
         } break;
 
         /*------------------------------------------------------------------
@@ -215,7 +795,13 @@ static void handle_frame(uint8_t cmd, const uint8_t* payload, size_t payload_len
          * Must be done before programming new data
          *------------------------------------------------------------------*/
         case Cmnd_STK_CHIP_ERASE: {
-            avr_erase_memory();
+            const avr_iface_t* iface = avr_iface();
+            if (iface->submit_chip_erase) {
+                iface->submit_chip_erase(async_done, NULL);
+            } else {
+                iface->chip_erase();
+            }
+            target_cache_note_erase();
             resp_ok_insync();
         } break;
 
@@ -249,7 +835,7 @@ static void handle_frame(uint8_t cmd, const uint8_t* payload, size_t payload_len
          *------------------------------------------------------------------*/
         case Cmnd_STK_READ_SIGN: {
             uint8_t sig[3] = {0};
-            avr_read_signature(sig);
+            target_cache_signature(sig);
             put(Resp_STK_INSYNC);
             put(sig[0]); put(sig[1]); put(sig[2]);
             put(Resp_STK_OK);
@@ -266,16 +852,190 @@ static void handle_frame(uint8_t cmd, const uint8_t* payload, size_t payload_len
                 resp_failed();
                 break;
             }
-            uint8_t rx[4] = {0};
-#ifdef USE_BITBANG_SPI
-            avr_bitbang_transfer(payload, rx, 4);
-#else
-            spi_write_read_blocking(spi0, payload, rx, 4);
-#endif
+            uint8_t result = target_cache_instruction(payload);
+            put(Resp_STK_INSYNC);
+            put(result);  /* 4th byte of SPI response (or its cached value) */
+            put(Resp_STK_OK);
+            flush();
+        } break;
+
+        /*------------------------------------------------------------------
+         * UNIVERSAL_MULTI (0x57): Raw n-byte SPI transaction
+         * Payload: [n-1, data...]
+         * Data must be whole 4-byte ISP instructions; they are executed
+         * back to back with write-completion polling in between
+         *------------------------------------------------------------------*/
+        case Cmnd_STK_UNIVERSAL_MULTI: {
+            size_t n = payload_len ? payload_len - 1 : 0;
+            if (n == 0 || (size_t)payload[0] + 1 != n || (n % 4) != 0) {
+                resp_failed();
+                break;
+            }
+            run_isp_instructions(payload + 1, n / 4, NULL);
+            resp_ok_insync();
+        } break;
+
+        /*------------------------------------------------------------------
+         * UNIVERSAL_BATCH (0x58): Vendor extension - batched instructions
+         * Payload: [count, count x 4 bytes]
+         * Reply: INSYNC, count result bytes, OK
+         *------------------------------------------------------------------*/
+        case Cmnd_STK_UNIVERSAL_BATCH: {
+            size_t count = payload_len ? payload[0] : 0;
+            if (count == 0 || count > STK_BATCH_MAX_INSTR || payload_len != 1 + count * 4) {
+                resp_failed();
+                break;
+            }
+            uint8_t results[STK_BATCH_MAX_INSTR];
+            run_isp_instructions(payload + 1, count, results);
+            put(Resp_STK_INSYNC);
+            put_all(results, count);
+            put(Resp_STK_OK);
+            flush();
+        } break;
+
+        /*------------------------------------------------------------------
+         * SPI_BENCH (0x59): Vendor extension - ISP transport throughput
+         * Only outside programming mode; RESET is pulsed low meanwhile
+         *------------------------------------------------------------------*/
+        case Cmnd_STK_SPI_BENCH: {
+            if (programming) {
+                resp_failed();
+                break;
+            }
+            if (warm) {
+                session_release();  /* The benchmark drives RESET itself */
+            }
+            size_t n = sizeof(bench_sck_hz) / sizeof(bench_sck_hz[0]);
+            put(Resp_STK_INSYNC);
+            put((uint8_t)n);
+            for (size_t i = 0; i < n; i++) {
+                uint32_t hz = bench_sck_hz[i];
+                uint32_t ips = avr_spi_benchmark(hz);
+                uint8_t entry[8] = {
+                    (uint8_t)(hz >> 24), (uint8_t)(hz >> 16), (uint8_t)(hz >> 8), (uint8_t)hz,
+                    (uint8_t)(ips >> 24), (uint8_t)(ips >> 16), (uint8_t)(ips >> 8), (uint8_t)ips,
+                };
+                put_all(entry, sizeof(entry));
+            }
+            put(Resp_STK_OK);
+            flush();
+        } break;
+
+        /*------------------------------------------------------------------
+         * VERIFY_MAP (0x5A): Vendor extension - inline verify failures
+         * Bitmap of pages still wrong after their retries, this session
+         *------------------------------------------------------------------*/
+        case Cmnd_STK_VERIFY_MAP: {
+            size_t n;
+            const uint8_t* map = write_verify_map(&n);
             put(Resp_STK_INSYNC);
-            put(rx[3]);  /* Return 4th byte of SPI response */
+            put((uint8_t)(n >> 8));
+            put((uint8_t)n);
+            put_all(map, n);
+            put(Resp_STK_OK);
+            flush();
+        } break;
+
+        /*------------------------------------------------------------------
+         * METRICS (0x5B): Vendor extension - session counters
+         * Payload: [flags]; STK_METRICS_RESET clears them after the reply
+         *------------------------------------------------------------------*/
+        case Cmnd_STK_METRICS: {
+            if (payload_len != 1) {
+                resp_failed();
+                break;
+            }
+            /* Replies can exceed the TX FIFO, so everything goes via put_all() */
+            uint8_t head[1 + 4 + 1 + METRIC_COUNT * 4 + 1];
+            size_t n = 0;
+            head[n++] = Resp_STK_INSYNC;
+            n += pack_be32(head + n, metrics_elapsed_us());
+            head[n++] = METRIC_COUNT;
+            for (int m = 0; m < METRIC_COUNT; m++) {
+                n += pack_be32(head + n, metrics_get((metric_t)m));
+            }
+            head[n] = 0;
+            for (int c = 0; c < 256; c++) {
+                head[n] += metrics_command_stats((uint8_t)c)->count ? 1 : 0;
+            }
+            put_all(head, n + 1);
+            for (int c = 0; c < 256; c++) {
+                const metrics_cmd_t* st = metrics_command_stats((uint8_t)c);
+                if (st->count) {
+                    uint8_t entry[13];
+                    entry[0] = (uint8_t)c;
+                    pack_be32(entry + 1, st->count);
+                    pack_be32(entry + 5, st->total_us);
+                    pack_be32(entry + 9, st->max_us);
+                    put_all(entry, sizeof(entry));
+                }
+            }
+            put(Resp_STK_OK);
+            flush();
+            if (payload[0] & STK_METRICS_RESET) {
+                metrics_reset();
+            }
+        } break;
+
+        /*------------------------------------------------------------------
+         * TRACE_DUMP (0x5C): Vendor extension - event trace
+         * Payload: [flags]; STK_TRACE_CLEAR drops the events once sent
+         *------------------------------------------------------------------*/
+        case Cmnd_STK_TRACE_DUMP: {
+            if (payload_len != 1) {
+                resp_failed();
+                break;
+            }
+            bool was_on = trace_enabled();
+            trace_enable(false);  /* Keep the dump's own flushes out */
+            size_t count = trace_count();
+            uint8_t head[1 + 2 + 4];
+            head[0] = Resp_STK_INSYNC;
+            head[1] = (uint8_t)(count >> 8);
+            head[2] = (uint8_t)count;
+            pack_be32(head + 3, trace_dropped());
+            put_all(head, sizeof(head));
+            for (size_t i = 0; i < count; i += 8) {
+                uint8_t block[8 * TRACE_RECORD_BYTES];
+                size_t n = count - i < 8 ? count - i : 8;
+                for (size_t k = 0; k < n; k++) {
+                    trace_record(i + k, block + k * TRACE_RECORD_BYTES);
+                }
+                put_all(block, n * TRACE_RECORD_BYTES);
+            }
+            put(Resp_STK_OK);
+            flush();
+            if (payload[0] & STK_TRACE_CLEAR) {
+                trace_clear();
+            }
+            trace_enable(was_on);
+        } break;
+
+        /*------------------------------------------------------------------
+         * CAPTURE_DUMP (0x5D): Vendor extension - stream capture
+         * Payload: [flags]; STK_CAPTURE_CLEAR drops the records once sent
+         *------------------------------------------------------------------*/
+        case Cmnd_STK_CAPTURE_DUMP: {
+            if (payload_len != 1) {
+                resp_failed();
+                break;
+            }
+            size_t len;
+            const uint8_t* data = capture_data(&len);
+            uint8_t head[1 + 4 + 4];
+            capture_pause(true);  /* Keep the dump out of the capture */
+            head[0] = Resp_STK_INSYNC;
+            pack_be32(head + 1, (uint32_t)len);
+            pack_be32(head + 5, capture_lost());
+            put_all(head, sizeof(head));
+            put_all(data, len);
             put(Resp_STK_OK);
             flush();
+            if (payload[0] & STK_CAPTURE_CLEAR) {
+                capture_clear();
+            }
+            capture_pause(false);
         } break;
 
         /*------------------------------------------------------------------
@@ -303,19 +1063,52 @@ static void handle_frame(uint8_t cmd, const uint8_t* payload, size_t payload_len
                 break;
             }
             
-            /* Load data into page buffer (as words, even byte count) */
-            int words = size / 2;
-            for (int j = 0; j < words; j++) {
-                uint16_t low = data[j * 2 + 0];
-                uint16_t high = data[j * 2 + 1];
-                uint16_t word = (high << 8) | low;
-                avr_write_temporary_buffer_16((uint16_t)j, word);
+            /* Load page buffer, commit at current address, auto-increment */
+            program_flash_page(data, (size_t)size);
+            if (take_async_failure()) {
+                resp_failed();
+            } else {
+                resp_ok_insync();
             }
-            
-            /* Commit page buffer to flash at current address */
-            avr_flash_program_memory((uint16_t)current_address);
-            current_address += (uint32_t)words;  /* Auto-increment address */
-            resp_ok_insync();
+        } break;
+
+        /*------------------------------------------------------------------
+         * PROG_PAGE_LZ (0x66): Vendor extension - compressed flash upload
+         * Payload: [len_hi, len_lo, memtype, lzss_data...]
+         * len == 0 terminates the stream and flushes the last page
+         * Replies once the frame is expanded, see lz_continue()
+         *------------------------------------------------------------------*/
+        case Cmnd_STK_PROG_PAGE_LZ: {
+            if (payload_len < 3) {
+                resp_failed();
+                break;
+            }
+
+            int size = ((int)payload[0] << 8) | payload[1];  /* Compressed byte count */
+            uint8_t memtype = payload[2];
+            if (!(memtype == 'F' || memtype == 'f') || (size_t)size != payload_len - 3) {
+                lz_reset();
+                resp_failed();
+                break;
+            }
+
+            if (size == 0) {
+                bool complete = lz_finish();  /* false: stream truncated mid-item */
+                /* Last reply of the stream: wait for its final page too */
+                avr_async_finish();
+                check_written_page();
+                if (take_async_failure() || !complete) {
+                    resp_failed();
+                } else {
+                    resp_ok_insync();
+                }
+                break;
+            }
+            memcpy(lz_in, payload + 3, (size_t)size);
+            lz_in_len = (size_t)size;
+            lz_in_pos = 0;
+            lz_active = true;
+            lz_continue();  /* Replies now, or from stk500v1_task() */
         } break;
 
         /*------------------------------------------------------------------
@@ -336,19 +1129,59 @@ static void handle_frame(uint8_t cmd, const uint8_t* payload, size_t payload_len
                 break;
             }
 
-            /* Read bytes from flash and send via CDC */
+            /* Read bytes from flash (or the read-ahead window) and send via CDC */
+            uint8_t page[256];
+            readahead_read(current_address * 2, page, (size_t)size);
             put(Resp_STK_INSYNC);
-            for (int off = 0; off < size; off++) {
-                /* Read word, extract appropriate byte (low or high) */
-                uint16_t w = avr_read_program_memory((uint16_t)(current_address + (uint32_t)(off / 2)));
-                uint8_t b = (off & 1) ? (uint8_t)(w >> 8) : (uint8_t)(w & 0xFF);
-                tud_cdc_write_char(b);
-            }
+            put_all(page, (size_t)size);
             put(Resp_STK_OK);
             flush();
             current_address += (uint32_t)((size + 1) / 2);  /* Auto-increment */
         } break;
 
+        /*------------------------------------------------------------------
+         * READ_FLASH_RLE (0x79): Vendor extension - compressed bulk read
+         * Payload: [size_hi, size_mid, size_lo, memtype]
+         * Reply: INSYNC, RLE stream decoding to exactly size bytes, OK
+         * FAILED if the range runs past the end of a known part's flash
+         *------------------------------------------------------------------*/
+        case Cmnd_STK_READ_FLASH_RLE: {
+            if (payload_len != 4) {
+                resp_failed();
+                break;
+            }
+            uint32_t size = ((uint32_t)payload[0] << 16) | ((uint32_t)payload[1] << 8) | payload[2];
+            uint8_t memtype = payload[3];
+            if (!(memtype == 'F' || memtype == 'f') || size == 0) {
+                resp_failed();
+                break;
+            }
+            /* Past the end of flash, word addresses would wrap */
+            const avr_device_t* dev = target_cache_device();
+            if (dev && dev->flash_size_bytes &&
+                (uint64_t)current_address * 2 + size > dev->flash_size_bytes) {
+                resp_failed();
+                break;
+            }
+
+            rle_encoder_t enc;
+            uint8_t chunk[64];
+            rle_init(&enc, rle_cdc_sink, NULL);
+            put(Resp_STK_INSYNC);
+            /* A host that stopped reading gets no more target reads */
+            for (uint32_t off = 0; off < size && !tx_abandoned; off += sizeof(chunk)) {
+                size_t n = size - off < sizeof(chunk) ? size - off : sizeof(chunk);
+                avr_iface()->read_flash(current_address * 2 + off, chunk, n);
+                for (size_t i = 0; i < n; i++) {
+                    rle_put(&enc, chunk[i]);
+                }
+            }
+            rle_finish(&enc);
+            put(Resp_STK_OK);
+            flush();
+            current_address += (size + 1) / 2;  /* Auto-increment */
+        } break;
+
         /*------------------------------------------------------------------
          * Default: Unknown command - respond with failure
          *------------------------------------------------------------------*/
@@ -370,6 +1203,72 @@ void stk500v1_init(void) {
     page_size_bytes = 128;            /* Default for ATmega328P */
     words_per_page = page_size_bytes / 2;
     rx_len = 0;
+    async_failed = false;
+    warm = false;
+    warm_timeout = 0;
+    session_failed = false;
+    warm_hits = 0;
+    enter_us = 0;
+    write_verify_enable(false);
+    write_verify_reset(page_size_bytes);
+    metrics_reset();
+    lz_reset();
+    target_cache_invalidate();
+    readahead_invalidate();
+}
+
+/**
+ * @brief Parse and dispatch the complete frames in the RX buffer
+ *
+ * Stops while a queued target operation is running; the remaining
+ * bytes stay buffered until stk500v1_task() finds the engine idle.
+ */
+static void process_frames(void) {
+    while (rx_len > 0 && !avr_async_busy() && !lz_active) {
+        /* Expected frame length (see stk500v1_frame.c) */
+        int length = stk500v1_frame_length(rx_buf, rx_len);
+        if (length == STK_FRAME_SKIP) {
+            /* Stray EOP, unknown command or bad size - drop byte and resync */
+            drop_rx(1);
+            continue;
+        }
+
+        /* Wait for more bytes if frame incomplete */
+        size_t needed = (size_t)length;
+        if (length == STK_FRAME_MORE || rx_len < needed) {
+            return;
+        }
+        
+        /* Verify EOP terminator */
+        if (rx_buf[needed - 1] != Sync_CRC_EOP) {
+            /* Frame error - try to resync */
+            void* eop_ptr = memchr(rx_buf, Sync_CRC_EOP, rx_len);
+            if (eop_ptr) {
+                size_t idx = (size_t)((uint8_t*)eop_ptr - rx_buf);
+                drop_rx(idx + 1);
+            } else {
+                drop_rx(1);
+            }
+            resp_nosync();
+            continue;
+        }
+
+        /* Frame complete - dispatch to handler */
+        uint8_t cmd = rx_buf[0];
+        const uint8_t* payload = rx_buf + 1;
+        size_t payload_len = needed - 2;  /* Exclude cmd and EOP */
+        if (warm) {
+            warm_deadline = make_timeout_time_ms((uint32_t)warm_timeout * 100u);
+        }
+        check_written_page();
+        tx_abandoned = false;
+        uint64_t start = time_us_64();
+        trace(TRACE_DISPATCH_BEGIN, cmd, (uint16_t)payload_len);
+        handle_frame(cmd, payload, payload_len);
+        trace(TRACE_DISPATCH_END, cmd, 0);
+        metrics_command(cmd, (uint32_t)(time_us_64() - start));
+        drop_rx(needed);
+    }
 }
 
 /**
@@ -378,7 +1277,8 @@ void stk500v1_init(void) {
  * This function accumulates incoming bytes in a buffer and parses
  * complete STK500v1 command frames. Each command is terminated by
  * Sync_CRC_EOP (0x20). When a complete frame is detected, it is
- * dispatched to handle_frame() for processing.
+ * dispatched to handle_frame() for processing. Frames arriving while a
+ * queued erase or page write is running are held until it completes.
  * 
  * Frame parsing handles:
  *   - Variable-length commands based on command type
@@ -390,6 +1290,9 @@ void stk500v1_init(void) {
  */
 void stk500v1_feed(const uint8_t* data, int len) {
     if (!data || len <= 0) return;
+    metrics_add(METRIC_BYTES_IN, (uint32_t)len);
+    trace(TRACE_RX, 0, (uint16_t)len);
+    capture_bytes(CAPTURE_HOST, data, (size_t)len);
 
     /* Append incoming data to RX buffer (truncate if overflow) */
     size_t to_copy = (size_t)len;
@@ -401,109 +1304,34 @@ void stk500v1_feed(const uint8_t* data, int len) {
         rx_len += to_copy;
     }
 
-    /* Parse and process complete frames */
-    while (rx_len > 0) {
-        /* Skip stray EOP bytes from previous desync */
-        if (rx_buf[0] == Sync_CRC_EOP) {
-            drop_rx(1);
-            continue;
-        }
-
-        uint8_t cmd = rx_buf[0];
-        size_t needed = 0;
-
-        /*--------------------------------------------------------------
-         * Determine expected frame length based on command type
-         *--------------------------------------------------------------*/
-        switch (cmd) {
-            /* Commands with no payload (just cmd + EOP) */
-            case Cmnd_STK_GET_SYNC:
-            case Cmnd_STK_GET_SIGN_ON:
-            case Cmnd_STK_ENTER_PROGMODE:
-            case Cmnd_STK_LEAVE_PROGMODE:
-            case Cmnd_STK_CHIP_ERASE:
-            case Cmnd_STK_CHECK_AUTOINC:
-            case Cmnd_STK_READ_SIGN:
-                needed = 1 + 1;  /* cmd + EOP */
-                break;
-
-            case Cmnd_STK_GET_PARAMETER:
-                needed = 1 + 1 + 1;  /* cmd + param + EOP */
-                break;
-
-            case Cmnd_STK_SET_PARAMETER:
-                needed = 1 + 2 + 1;  /* cmd + (param, value) + EOP */
-                break;
-
-            case Cmnd_STK_SET_DEVICE:
-                needed = 1 + 20 + 1;  /* cmd + 20 device bytes + EOP */
-                break;
-
-            case Cmnd_STK_SET_DEVICE_EXT:
-                needed = 1 + 5 + 1;  /* cmd + 5 extended bytes + EOP */
-                break;
-
-            case Cmnd_STK_LOAD_ADDRESS:
-                needed = 1 + 2 + 1;  /* cmd + (addr_lo, addr_hi) + EOP */
-                break;
-
-            case Cmnd_STK_UNIVERSAL:
-                needed = 1 + 4 + 1;  /* cmd + 4 SPI bytes + EOP */
-                break;
-
-            case Cmnd_STK_READ_PAGE:
-                needed = 1 + 3 + 1;  /* cmd + (size_hi, size_lo, memtype) + EOP */
-                break;
+    process_frames();
+}
 
-            /* PROG_PAGE has variable length based on embedded size */
-            case Cmnd_STK_PROG_PAGE: {
-                if (rx_len < 4) {
-                    /* Need header to determine total length */
-                    return;
-                }
-                int size = ((int)rx_buf[1] << 8) | rx_buf[2];
-                if (size < 0 || size > 256) {
-                    /* Invalid size - resync */
-                    drop_rx(1);
-                    continue;
-                }
-                needed = 1 + 3 + (size_t)size + 1;  /* cmd + header + data + EOP */
-            } break;
+/**
+ * @brief Drive queued target operations and parse frames held back meanwhile
+ *
+ * Call from the main loop next to tud_task(). With the engine idle and
+ * no frame waiting, one read-ahead chunk is fetched per call, so a new
+ * request never waits behind more than one chunk. Also releases a
+ * target held by a warm session once its idle timeout has passed.
+ */
+bool stk500v1_task(void) {
+    bool prefetching = false;
 
-            default:
-                /* Unknown command - drop byte and try again */
-                drop_rx(1);
-                continue;
+    if (!avr_async_poll()) {
+        check_written_page();   /* Overlaps with the next frame's reception */
+        if (lz_active) {
+            lz_continue();
         }
-
-        /* Wait for more bytes if frame incomplete */
-        if (needed == 0) {
-            drop_rx(1);
-            continue;
+        if (rx_len > 0) {
+            process_frames();
         }
-        if (rx_len < needed) {
-            return;
+        if (programming && rx_len == 0 && !avr_async_busy() && !lz_active) {
+            prefetching = readahead_step();
         }
-        
-        /* Verify EOP terminator */
-        if (rx_buf[needed - 1] != Sync_CRC_EOP) {
-            /* Frame error - try to resync */
-            void* eop_ptr = memchr(rx_buf, Sync_CRC_EOP, rx_len);
-            if (eop_ptr) {
-                size_t idx = (size_t)((uint8_t*)eop_ptr - rx_buf);
-                drop_rx(idx + 1);
-            } else {
-                drop_rx(1);
-            }
-            resp_nosync();
-            continue;
-        }
-
-        /* Frame complete - dispatch to handler */
-        const uint8_t* payload = rx_buf + 1;
-        size_t payload_len = needed - 2;  /* Exclude cmd and EOP */
-        (void)programming;  /* Suppress unused warning */
-        handle_frame(cmd, payload, payload_len);
-        drop_rx(needed);
     }
+    if (warm && time_reached(warm_deadline)) {
+        session_release();
+    }
+    return prefetching || avr_async_busy() || lz_active;
 }
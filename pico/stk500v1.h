@@ -20,6 +20,8 @@
 
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 /*******************************************************************************
  * STK500v1 Command Definitions
@@ -47,6 +49,7 @@
 /* Address and data commands */
 #define Cmnd_STK_LOAD_ADDRESS     0x55  /* Set current read/write address (word) */
 #define Cmnd_STK_UNIVERSAL        0x56  /* Raw 4-byte SPI transaction */
+#define Cmnd_STK_UNIVERSAL_MULTI  0x57  /* Raw n-byte SPI transaction (n-1 in first byte) */
 
 /* Flash programming commands */
 #define Cmnd_STK_PROG_PAGE        0x64  /* Program a page of flash/EEPROM */
@@ -61,6 +64,145 @@
 /* Signature reading */
 #define Cmnd_STK_READ_SIGN        0x75  /* Read target device signature (3 bytes) */
 
+/*******************************************************************************
+ * Vendor Extension Commands
+ * Not part of AVR061; only used by the host tools in this repository.
+ * Opcodes are picked from gaps in the STK500v1 command space.
+ ******************************************************************************/
+
+/* Compressed flash upload: [len_hi, len_lo, memtype, lzss_data...]
+ * Data is a continuous LZSS stream (see compress.h) expanded into pages
+ * starting at the current address. A zero-length frame ends the stream
+ * and programs any partially filled final page. */
+#define Cmnd_STK_PROG_PAGE_LZ     0x66
+
+/* Compressed bulk readback: [size_hi, size_mid, size_lo, memtype]
+ * Reads size bytes starting at the current address and replies with
+ * INSYNC, a run-length encoded stream (see compress.h), then OK. A range
+ * past the end of a known part's flash fails. */
+#define Cmnd_STK_READ_FLASH_RLE   0x79
+
+/* Batched ISP instructions: [count, count x 4 instruction bytes]
+ * Executes all instructions in one frame, polling RDY/BSY after each
+ * write (fuse, lock, EEPROM, page, erase). Replies with INSYNC, the 4th
+ * response byte of every instruction in order, then OK. */
+#define Cmnd_STK_UNIVERSAL_BATCH  0x58
+
+/** Maximum instructions per UNIVERSAL_BATCH frame */
+#define STK_BATCH_MAX_INSTR       64
+
+/* ISP transport benchmark: no payload, only outside programming mode.
+ * Streams all-zero instructions on the selected transport at each
+ * supported SCK rate and replies with INSYNC, the number of rates n,
+ * n x (sck_hz, instructions_per_s) as big-endian 32-bit values, then OK. */
+#define Cmnd_STK_SPI_BENCH        0x59
+
+/* Inline verify report: no payload. Replies with INSYNC, the bitmap
+ * length (big-endian 16-bit), a bitmap of pages that failed inline
+ * verify this session (bit n of byte n / 8 = page n), then OK. */
+#define Cmnd_STK_VERIFY_MAP       0x5A
+
+/* Session counters (see metrics.h): [flags], bit 0 = reset after reading.
+ * Replies with INSYNC, time since the last reset in us, the number of
+ * counters n, n counters in metric_t order, the number of commands seen
+ * m, m x (cmd, count, total_us, max_us), then OK. Multi-byte values are
+ * big-endian 32-bit. */
+#define Cmnd_STK_METRICS          0x5B
+
+/** METRICS flag: clear the counters once the reply is queued */
+#define STK_METRICS_RESET         0x01
+
+/* Event trace dump (see trace.h): [flags], bit 0 = clear after reading.
+ * Replies with INSYNC, the event count (big-endian 16-bit), events lost
+ * to overwriting (big-endian 32-bit), count x 8-byte records oldest
+ * first, then OK. Recording pauses while the dump is sent. */
+#define Cmnd_STK_TRACE_DUMP       0x5C
+
+/** TRACE_DUMP flag: drop the events once they are sent */
+#define STK_TRACE_CLEAR           0x01
+
+/* Stream capture dump (see capture.h): [flags], bit 0 = clear after
+ * reading. Replies with INSYNC, the capture length and the number of
+ * bytes lost to overflow (big-endian 32-bit each), the capture records,
+ * then OK. The dump itself is not captured. */
+#define Cmnd_STK_CAPTURE_DUMP     0x5D
+
+/** CAPTURE_DUMP flag: drop the records once they are sent */
+#define STK_CAPTURE_CLEAR         0x01
+
+/*******************************************************************************
+ * Standard Parameters Acted Upon (see target_clock.h)
+ ******************************************************************************/
+#define Parm_STK_OSC_PSCALE       0x86  /* Target clock prescaler, 0 = off */
+#define Parm_STK_OSC_CMATCH       0x87  /* Target clock compare match */
+#define Parm_STK_SCK_DURATION     0x89  /* ISP clock period (avrdude -B) */
+
+/*******************************************************************************
+ * Vendor Parameters (GET_PARAMETER / SET_PARAMETER)
+ * Counters saturate at 255 since GET_PARAMETER returns a single byte.
+ ******************************************************************************/
+#define Parm_VND_CACHE_HITS       0xC0  /* Target cache queries answered from RAM */
+#define Parm_VND_CACHE_MISSES     0xC1  /* Target cache queries that read the target */
+
+/* Read/write: programming interface (AVR_IFACE_*), only settable
+ * outside programming mode */
+#define Parm_VND_INTERFACE        0xC2
+
+/* Read/write: target clock output in MHz, 0 = off. Applied at the next
+ * ENTER_PROGMODE; overrides OSC_PSCALE/OSC_CMATCH */
+#define Parm_VND_TARGET_CLOCK     0xC3
+
+/* Read/write: ISP transport (AVR_SPI_*), only settable outside
+ * programming mode */
+#define Parm_VND_SPI_BACKEND      0xC4
+
+/* Read-only: last ISP Programming Enable sequence (see avr_entry_log()).
+ * Attempts made, and total time in units of 100us (saturating) */
+#define Parm_VND_ENTRY_ATTEMPTS   0xC5
+#define Parm_VND_ENTRY_TIME       0xC6
+
+/* Read/write: warm session idle timeout in units of 100ms, 0 = off.
+ * LEAVE_PROGMODE then holds the target in programming mode until the
+ * host has been idle this long; an ENTER_PROGMODE on the same signature
+ * in the meantime is answered without a new reset and sync */
+#define Parm_VND_WARM_TIMEOUT     0xC7
+
+/* Read-only: ENTER_PROGMODE requests served from a held target
+ * (saturating), and duration of the last ENTER_PROGMODE in units of
+ * 100us (saturating) */
+#define Parm_VND_WARM_HITS        0xC8
+#define Parm_VND_ENTER_TIME       0xC9
+
+/* Read-only: READ_PAGE requests served from the read-ahead window, and
+ * requests that read the target (see readahead.h) */
+#define Parm_VND_READAHEAD_HITS   0xCA
+#define Parm_VND_READAHEAD_MISSES 0xCB
+
+/* Read/write: inline verify after every flash page write, 0 = off
+ * (see write_verify.h). Read-only: pages recovered by a rewrite and
+ * pages that failed for good this session (saturating) */
+#define Parm_VND_VERIFY           0xCC
+#define Parm_VND_VERIFY_RETRIED   0xCD
+#define Parm_VND_VERIFY_FAILED    0xCE
+
+/* Read/write: event trace recording, 0 = off. Turning it on starts
+ * from an empty ring */
+#define Parm_VND_TRACE            0xCF
+
+/* Read/write: capture of both stream directions, 0 = off. Turning it on
+ * starts an empty capture at the next command */
+#define Parm_VND_CAPTURE          0xD0
+
+/* Read/write: debugWIRE fallback of ISP entry, 0 = off. When on, a
+ * target that never answers Programming Enable gets a dW disable and
+ * one more try (see avr_dw_fallback_enable()) */
+#define Parm_VND_DW_FALLBACK      0xD1
+
+/* Read/write: slowest target clock in MHz that learned ISP rates may
+ * assume, 0 = off. Off keeps sessions at the base rate (see
+ * avr_profile_set_clock_hz()) */
+#define Parm_VND_PROFILE_CLOCK    0xD2
+
 /*******************************************************************************
  * STK500v1 Framing and Response Codes
  ******************************************************************************/
@@ -76,6 +218,25 @@
  * Function Prototypes
  ******************************************************************************/
 
+/** stk500v1_frame_length() results other than a length */
+#define STK_FRAME_MORE            0
+#define STK_FRAME_SKIP            (-1)
+
+/**
+ * @brief Get the length of the command frame at the start of a buffer
+ * 
+ * Pure framing rule shared by the parser and the host tools (see
+ * stk500v1_frame.c, no SDK dependencies). The length is known once the
+ * header is: the frame itself may still be incomplete.
+ * 
+ * @param buf Received bytes, buf[0] being the command byte
+ * @param len Number of bytes in buf
+ * @return Total frame length including EOP, STK_FRAME_MORE if more
+ *         header bytes are needed, or STK_FRAME_SKIP if buf[0] cannot
+ *         start a frame (unknown command, stray EOP, bad page size)
+ */
+int stk500v1_frame_length(const uint8_t* buf, size_t len);
+
 /**
  * @brief Initialize STK500v1 protocol handler
  * 
@@ -94,3 +255,14 @@ void stk500v1_init(void);
  * @param len  Number of bytes in buffer
  */
 void stk500v1_feed(const uint8_t* data, int len);
+
+/**
+ * @brief Advance queued target operations
+ * 
+ * Call from the main loop on every pass. Runs the non-blocking ISP
+ * engine, parses frames that were held back while it was busy and
+ * prefetches flash for sequential READ_PAGE requests.
+ * 
+ * @return true while work is pending (the loop should not sleep)
+ */
+bool stk500v1_task(void);
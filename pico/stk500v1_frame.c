@@ -0,0 +1,94 @@
+/**
+ * @file stk500v1_frame.c
+ * @brief STK500v1 Command Frame Lengths
+ *
+ * Kept apart from stk500v1.c so the host tools (tools/) split captured
+ * streams with exactly the rule the firmware applies.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "stk500v1.h"
+
+/**
+ * @brief Get the length of the command frame at the start of a buffer
+ */
+int stk500v1_frame_length(const uint8_t* buf, size_t len) {
+    if (len == 0) {
+        return STK_FRAME_MORE;
+    }
+
+    switch (buf[0]) {
+        /* Commands with no payload (just cmd + EOP) */
+        case Cmnd_STK_GET_SYNC:
+        case Cmnd_STK_GET_SIGN_ON:
+        case Cmnd_STK_ENTER_PROGMODE:
+        case Cmnd_STK_LEAVE_PROGMODE:
+        case Cmnd_STK_CHIP_ERASE:
+        case Cmnd_STK_CHECK_AUTOINC:
+        case Cmnd_STK_READ_SIGN:
+        case Cmnd_STK_SPI_BENCH:
+        case Cmnd_STK_VERIFY_MAP:
+            return 1 + 1;  /* cmd + EOP */
+
+        case Cmnd_STK_GET_PARAMETER:
+        case Cmnd_STK_METRICS:
+        case Cmnd_STK_TRACE_DUMP:
+        case Cmnd_STK_CAPTURE_DUMP:
+            return 1 + 1 + 1;  /* cmd + param/flags + EOP */
+
+        case Cmnd_STK_SET_PARAMETER:
+            return 1 + 2 + 1;  /* cmd + (param, value) + EOP */
+
+        case Cmnd_STK_SET_DEVICE:
+            return 1 + 20 + 1;  /* cmd + 20 device bytes + EOP */
+
+        case Cmnd_STK_SET_DEVICE_EXT:
+            return 1 + 5 + 1;  /* cmd + 5 extended bytes + EOP */
+
+        case Cmnd_STK_LOAD_ADDRESS:
+            return 1 + 2 + 1;  /* cmd + (addr_lo, addr_hi) + EOP */
+
+        case Cmnd_STK_UNIVERSAL:
+            return 1 + 4 + 1;  /* cmd + 4 SPI bytes + EOP */
+
+        /* UNIVERSAL_MULTI and UNIVERSAL_BATCH carry a length byte */
+        case Cmnd_STK_UNIVERSAL_MULTI:
+        case Cmnd_STK_UNIVERSAL_BATCH: {
+            if (len < 2) {
+                return STK_FRAME_MORE;
+            }
+            int data_len = (buf[0] == Cmnd_STK_UNIVERSAL_MULTI)
+                         ? (int)buf[1] + 1      /* n-1 encoding */
+                         : (int)buf[1] * 4;     /* instruction count */
+            return 1 + 1 + data_len + 1;  /* cmd + length + data + EOP */
+        }
+
+        case Cmnd_STK_READ_PAGE:
+            return 1 + 3 + 1;  /* cmd + (size_hi, size_lo, memtype) + EOP */
+
+        case Cmnd_STK_READ_FLASH_RLE:
+            return 1 + 4 + 1;  /* cmd + (size x3, memtype) + EOP */
+
+        /* PROG_PAGE (and its compressed variant) has variable length
+         * based on embedded size */
+        case Cmnd_STK_PROG_PAGE:
+        case Cmnd_STK_PROG_PAGE_LZ: {
+            if (len < 4) {
+                /* Need header to determine total length */
+                return STK_FRAME_MORE;
+            }
+            int size = ((int)buf[1] << 8) | buf[2];
+            if (size > 256) {
+                /* Invalid size - resync */
+                return STK_FRAME_SKIP;
+            }
+            return 1 + 3 + size + 1;  /* cmd + header + data + EOP */
+        }
+
+        default:
+            /* Unknown command or stray EOP from a previous desync */
+            return STK_FRAME_SKIP;
+    }
+}
@@ -0,0 +1,196 @@
+/**
+ * @file target_cache.c
+ * @brief Per-Session Target Cache Implementation
+ *
+ * Each cacheable byte has a slot identified by the ISP read instruction
+ * that produces it. A bitmask records which slots hold a value read from
+ * the current target. Writes are recognized by opcode so only the slots
+ * they affect are dropped.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "target_cache.h"
+#include "avr_iface.h"
+#include <stddef.h>
+
+/*******************************************************************************
+ * Cache Slots
+ ******************************************************************************/
+enum {
+    SLOT_SIG0 = 0,
+    SLOT_SIG1,
+    SLOT_SIG2,
+    SLOT_LFUSE,
+    SLOT_HFUSE,
+    SLOT_EFUSE,
+    SLOT_LOCK,
+    SLOT_OSCCAL,
+    SLOT_COUNT
+};
+
+#define SIG_SLOTS_MASK  ((1u << SLOT_SIG0) | (1u << SLOT_SIG1) | (1u << SLOT_SIG2))
+
+/** Canonical read instruction for each slot (used when populating) */
+static const uint8_t slot_read_instr[SLOT_COUNT][4] = {
+    [SLOT_SIG0]   = {0x30, 0x00, 0x00, 0x00},
+    [SLOT_SIG1]   = {0x30, 0x00, 0x01, 0x00},
+    [SLOT_SIG2]   = {0x30, 0x00, 0x02, 0x00},
+    [SLOT_LFUSE]  = {0x50, 0x00, 0x00, 0x00},
+    [SLOT_HFUSE]  = {0x58, 0x08, 0x00, 0x00},
+    [SLOT_EFUSE]  = {0x50, 0x08, 0x00, 0x00},
+    [SLOT_LOCK]   = {0x58, 0x00, 0x00, 0x00},
+    [SLOT_OSCCAL] = {0x38, 0x00, 0x00, 0x00},
+};
+
+static uint8_t values[SLOT_COUNT];
+static uint8_t valid_mask = 0;
+
+/** Device profile for the cached signature (valid with SIG_SLOTS_MASK) */
+static const avr_device_t* device = NULL;
+
+static uint32_t hit_count = 0;
+static uint32_t miss_count = 0;
+
+/*******************************************************************************
+ * Instruction Classification
+ ******************************************************************************/
+
+/**
+ * @brief Map a read instruction to its cache slot
+ *
+ * @return Slot index, or -1 if the instruction is not a cacheable read
+ */
+static int read_slot(const uint8_t* instr) {
+    switch (instr[0]) {
+        case 0x30:
+            return (instr[2] & 0x03) <= 2 ? SLOT_SIG0 + (instr[2] & 0x03) : -1;
+        case 0x50:
+            if (instr[1] == 0x00) return SLOT_LFUSE;
+            if (instr[1] == 0x08) return SLOT_EFUSE;
+            return -1;
+        case 0x58:
+            if (instr[1] == 0x08) return SLOT_HFUSE;
+            if (instr[1] == 0x00) return SLOT_LOCK;
+            return -1;
+        case 0x38:
+            return (instr[1] == 0x00 && instr[2] == 0x00) ? SLOT_OSCCAL : -1;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Map a write instruction to the slots it invalidates
+ *
+ * @return Bitmask of affected slots (0 if not a configuration write)
+ */
+static uint8_t write_mask(const uint8_t* instr) {
+    if (instr[0] != 0xAC) return 0;
+    switch (instr[1]) {
+        case 0xA0: return 1u << SLOT_LFUSE;
+        case 0xA8: return 1u << SLOT_HFUSE;
+        case 0xA4: return 1u << SLOT_EFUSE;
+        case 0xE0: return 1u << SLOT_LOCK;
+        case 0x80: return 1u << SLOT_LOCK;   /* Chip erase clears lock bits */
+        default:   return 0;
+    }
+}
+
+/** Execute a slot's read instruction on the target and mark it valid */
+static uint8_t fetch_slot(int slot, const uint8_t* instr) {
+    uint8_t rx[4] = {0};
+    avr_iface()->universal(instr, rx);
+    values[slot] = rx[3];
+    valid_mask |= (uint8_t)(1u << slot);
+    if ((valid_mask & SIG_SLOTS_MASK) == SIG_SLOTS_MASK) {
+        device = avr_lookup_device_by_signature(&values[SLOT_SIG0]);
+    }
+    return rx[3];
+}
+
+/*******************************************************************************
+ * Public Functions
+ ******************************************************************************/
+
+/**
+ * @brief Read all cacheable bytes not yet valid
+ */
+void target_cache_populate(void) {
+    for (int slot = 0; slot < SLOT_COUNT; slot++) {
+        if (!(valid_mask & (1u << slot))) {
+            fetch_slot(slot, slot_read_instr[slot]);
+        }
+    }
+}
+
+/**
+ * @brief Forget everything about the current target
+ */
+void target_cache_invalidate(void) {
+    valid_mask = 0;
+    device = NULL;
+}
+
+/**
+ * @brief Execute an ISP instruction through the cache
+ *
+ * @param instr 4-byte ISP instruction
+ * @return 4th response byte
+ */
+uint8_t target_cache_instruction(const uint8_t instr[4]) {
+    int slot = read_slot(instr);
+    if (slot >= 0) {
+        if (valid_mask & (1u << slot)) {
+            hit_count++;
+            return values[slot];
+        }
+        miss_count++;
+        return fetch_slot(slot, instr);
+    }
+
+    /* Not cacheable: forward, then drop anything the instruction changes */
+    uint8_t rx[4] = {0};
+    avr_iface()->universal(instr, rx);
+    valid_mask &= (uint8_t)~write_mask(instr);
+    return rx[3];
+}
+
+/**
+ * @brief Get the target signature, reading it only if not cached
+ *
+ * @param sig Buffer receiving 3 signature bytes
+ */
+void target_cache_signature(uint8_t sig[3]) {
+    for (int i = 0; i < 3; i++) {
+        sig[i] = target_cache_instruction(slot_read_instr[SLOT_SIG0 + i]);
+    }
+}
+
+/**
+ * @brief Get the device profile for the cached signature
+ *
+ * @return Device profile, or NULL if unknown or not yet read
+ */
+const avr_device_t* target_cache_device(void) {
+    return ((valid_mask & SIG_SLOTS_MASK) == SIG_SLOTS_MASK) ? device : NULL;
+}
+
+/**
+ * @brief Invalidate lock bits after a chip erase
+ */
+void target_cache_note_erase(void) {
+    valid_mask &= (uint8_t)~(1u << SLOT_LOCK);
+}
+
+/**
+ * @brief Report cache hit and miss counters
+ *
+ * @param hits   Receives hit count
+ * @param misses Receives miss count
+ */
+void target_cache_stats(uint32_t *hits, uint32_t *misses) {
+    if (hits) *hits = hit_count;
+    if (misses) *misses = miss_count;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file target_cache.h
+ * @brief Per-Session Cache of Target Identification and Configuration Bytes
+ *
+ * avrdude asks for the signature, fuses and lock byte several times per
+ * session, each time as a separate ISP instruction. None of these values
+ * can change behind our back while the target is held in programming mode,
+ * so they are read once on ENTER_PROGMODE and answered from RAM afterwards.
+ *
+ * Cached Values:
+ *   - Signature bytes 0..2     (0x30 0x00 <n> 0x00)
+ *   - Low / high / extended fuse (0x50 0x00, 0x58 0x08, 0x50 0x08)
+ *   - Lock bits                (0x58 0x00)
+ *   - Calibration byte 0       (0x38 0x00 0x00)
+ *   - Device profile looked up from the signature
+ *
+ * Invalidation Rules:
+ *   - Fuse or lock write: that byte only (value re-read on next query)
+ *   - Chip erase: lock bits (erase clears them, fuses are unaffected)
+ *   - Leaving programming mode or resetting the target: everything
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "avr_devices.h"
+
+/**
+ * @brief Read every cacheable byte from the target
+ *
+ * Call right after programming mode was entered. Values that are already
+ * valid are not read again.
+ */
+void target_cache_populate(void);
+
+/**
+ * @brief Drop all cached values
+ *
+ * Call whenever the target may have changed (reset, programming mode
+ * left, different board connected).
+ */
+void target_cache_invalidate(void);
+
+/**
+ * @brief Execute one ISP instruction, answering cacheable reads from RAM
+ *
+ * Reads of cached bytes are served without touching the ISP bus. Other
+ * instructions go to the target; writes and erases invalidate the
+ * affected entries.
+ *
+ * @param instr 4-byte ISP instruction
+ * @return 4th response byte (the value the target would return)
+ */
+uint8_t target_cache_instruction(const uint8_t instr[4]);
+
+/**
+ * @brief Get the cached 3-byte signature (read from target on a miss)
+ *
+ * @param sig Buffer receiving 3 signature bytes
+ */
+void target_cache_signature(uint8_t sig[3]);
+
+/**
+ * @brief Get the device profile matching the cached signature
+ *
+ * @return Device profile, or NULL if the signature is unknown
+ */
+const avr_device_t* target_cache_device(void);
+
+/**
+ * @brief Note a chip erase so the lock bits are re-read afterwards
+ */
+void target_cache_note_erase(void);
+
+/**
+ * @brief Diagnostic counters
+ *
+ * @param hits   Receives number of queries answered from RAM
+ * @param misses Receives number of cacheable queries that read the target
+ */
+void target_cache_stats(uint32_t *hits, uint32_t *misses);
@@ -0,0 +1,122 @@
+/**
+ * @file target_clock.c
+ * @brief Target Clock Output (PWM) and ISP Rate Selection
+ *
+ * The clock is a 50% duty PWM output at clk_sys / period. At 125 MHz
+ * this gives e.g. 15.6, 8.0 (7.81) or 1.0 MHz; the actual rate is used
+ * for the ISP rate so the datasheet SCK limit always holds.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "target_clock.h"
+#include "avrprog.h"
+#include <pico/stdlib.h>
+#include "hardware/clocks.h"
+#include "hardware/pwm.h"
+
+/*******************************************************************************
+ * Private Variables
+ ******************************************************************************/
+static uint32_t clock_hz = 0;        /* Requested output, 0 = off */
+static uint32_t running_hz = 0;      /* Actual output while started */
+static uint32_t sck_hz = 0;          /* Host ISP rate, 0 = not set */
+
+/** STK500 OSC_PSCALE values 1..7 */
+static const uint16_t stk_prescale[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+/**
+ * @brief Set the clock driven during programming (0 = none)
+ */
+void target_clock_set_hz(uint32_t hz) {
+    clock_hz = hz;
+}
+
+/**
+ * @brief Set the clock from the STK500 OSC_PSCALE / OSC_CMATCH pair
+ */
+void target_clock_set_stk(uint8_t pscale, uint8_t cmatch) {
+    uint32_t ps = stk_prescale[pscale & 0x07];
+    clock_hz = ps ? STK500_XTAL_HZ / (2u * ps * ((uint32_t)cmatch + 1u)) : 0;
+}
+
+/**
+ * @brief Get the requested clock in Hz (0 = none)
+ */
+uint32_t target_clock_hz(void) {
+    return clock_hz;
+}
+
+/**
+ * @brief Set the ISP rate requested by the host from SCK_DURATION
+ */
+void target_clock_set_sck_duration(uint8_t duration) {
+    /* Period is duration * 8 / 7.3728 MHz; 0 is the STK500's fastest */
+    sck_hz = (STK500_XTAL_HZ / 8u) / (duration ? duration : 1u);
+}
+
+/**
+ * @brief Pick the ISP SCK rate
+ */
+uint32_t target_clock_isp_rate(uint32_t target_hz, uint32_t requested_hz) {
+    if (target_hz == 0) {
+        return requested_hz ? requested_hz : TARGET_ISP_DEFAULT_HZ;
+    }
+    /* SCK phases > 2 target clocks below 12 MHz, >= 3 clocks from 12 MHz */
+    uint32_t limit = target_hz >= TARGET_ISP_FAST_CLOCK_HZ ? target_hz / 6u : (target_hz - 1u) / 4u;
+    return (requested_hz && requested_hz < limit) ? requested_hz : limit;
+}
+
+/*******************************************************************************
+ * Clock Output
+ ******************************************************************************/
+
+/**
+ * @brief Start the clock output (if one is set) and apply the ISP rate
+ */
+uint32_t target_clock_start(void) {
+    running_hz = 0;
+
+    if (clock_hz) {
+        uint32_t sys_hz = clock_get_hz(clk_sys);
+        uint32_t period = (sys_hz + clock_hz / 2) / clock_hz;
+        uint32_t div = period / 65536u + 1u;   /* Keep wrap within 16 bits */
+        if (div > 255) {
+            div = 255;
+        }
+        uint32_t top = period / div;
+        if (top < 2) {
+            top = 2;
+        }
+        if (top > 65536u) {
+            top = 65536u;
+        }
+
+        uint slice = pwm_gpio_to_slice_num(TARGET_CLOCK_PIN);
+        pwm_set_clkdiv_int_frac(slice, (uint8_t)div, 0);
+        pwm_set_wrap(slice, (uint16_t)(top - 1));
+        pwm_set_gpio_level(TARGET_CLOCK_PIN, (uint16_t)(top / 2));
+        gpio_set_function(TARGET_CLOCK_PIN, GPIO_FUNC_PWM);
+        pwm_set_enabled(slice, true);
+        running_hz = sys_hz / (div * top);
+    }
+
+    avr_set_sck_frequency(target_clock_isp_rate(running_hz, sck_hz));
+    return running_hz;
+}
+
+/**
+ * @brief Stop the clock output and release the pin
+ */
+void target_clock_stop(void) {
+    if (running_hz) {
+        pwm_set_enabled(pwm_gpio_to_slice_num(TARGET_CLOCK_PIN), false);
+        gpio_init(TARGET_CLOCK_PIN);   /* Input, high impedance */
+        running_hz = 0;
+    }
+}
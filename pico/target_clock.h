@@ -0,0 +1,99 @@
+/**
+ * @file target_clock.h
+ * @brief Clock Output for Targets Without a Working Oscillator
+ *
+ * A target fused for an external clock (or for a crystal that is not
+ * fitted) does not run, so it never answers Programming Enable. This
+ * module drives a square wave on TARGET_CLOCK_PIN while programming mode
+ * is active; wire it to the target's XTAL1/CLKI pin.
+ *
+ * It also owns the ISP rate choice. The datasheet wants each SCK phase
+ * longer than 2 target clocks below 12 MHz and at least 3 clocks from
+ * 12 MHz, i.e. SCK strictly below f/4, or at most f/6 for fast parts.
+ * With a known clock the rate is raised to that limit instead of the
+ * 50 kHz that a CKDIV8 part on an unknown clock requires.
+ *
+ * Host Control (SET_PARAMETER, outside programming mode):
+ *   - Parm_STK_OSC_PSCALE / Parm_STK_OSC_CMATCH: STK500 oscillator,
+ *     f = 7.3728 MHz / (2 * prescale * (cmatch + 1)), prescale 0 = off
+ *     (avrdude terminal "fosc")
+ *   - Parm_VND_TARGET_CLOCK: clock in MHz, 0 = off
+ *   - Parm_STK_SCK_DURATION: ISP period in 8/7.3728 MHz units (avrdude -B)
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+#ifndef TARGET_CLOCK_PIN
+#define TARGET_CLOCK_PIN   21
+#endif
+
+/** ISP rate used when neither a clock nor SCK_DURATION is known */
+#define TARGET_ISP_DEFAULT_HZ   50000u
+
+/** Target clock from which SCK may run at f/6 instead of below f/4 */
+#define TARGET_ISP_FAST_CLOCK_HZ 12000000u
+
+/** STK500 reference crystal used by the oscillator and SCK parameters */
+#define STK500_XTAL_HZ          7372800u
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/**
+ * @brief Set the clock driven during programming (0 = none)
+ *
+ * Takes effect at the next target_clock_start().
+ */
+void target_clock_set_hz(uint32_t hz);
+
+/**
+ * @brief Set the clock from the STK500 OSC_PSCALE / OSC_CMATCH pair
+ */
+void target_clock_set_stk(uint8_t pscale, uint8_t cmatch);
+
+/**
+ * @brief Get the requested clock in Hz (0 = none)
+ */
+uint32_t target_clock_hz(void);
+
+/**
+ * @brief Set the ISP rate requested by the host from SCK_DURATION
+ *
+ * @param duration STK500 SCK_DURATION (0 = fastest)
+ */
+void target_clock_set_sck_duration(uint8_t duration);
+
+/**
+ * @brief Start the clock output (if one is set) and apply the ISP rate
+ *
+ * @return Actual output frequency in Hz, 0 if no clock is driven
+ */
+uint32_t target_clock_start(void);
+
+/**
+ * @brief Stop the clock output and release the pin
+ */
+void target_clock_stop(void);
+
+/**
+ * @brief Pick the ISP SCK rate
+ *
+ * Without a target clock the host's rate (or the safe default) is used.
+ * With one, the rate is the datasheet limit (just below f/4 under
+ * 12 MHz, f/6 from 12 MHz), or the host's rate if that is lower.
+ *
+ * @param target_hz    Clock supplied to the target, 0 if unknown
+ * @param requested_hz Rate from SCK_DURATION, 0 if the host set none
+ * @return SCK frequency in Hz
+ */
+uint32_t target_clock_isp_rate(uint32_t target_hz, uint32_t requested_hz);
@@ -2,26 +2,28 @@
 """
 test.py - STK500v1 Protocol Trace Parser and Analyzer
 
-This script parses raw STK500v1 protocol traces captured from USB CDC
-communication between avrdude (or similar host) and the AVR ISP programmer.
+This script parses STK500v1 protocol traces between avrdude (or similar
+host) and the AVR ISP programmer, decodes every command the firmware
+supports, pairs it with its reply and reports where the time went.
 
-*** WORK IN PROGRESS ***
-This parser is currently under development. Features being implemented:
-- Full command decoding with parameter interpretation
-- Response validation and error detection  
-- Flash data hex dump and analysis
-- Protocol timing analysis
+Sources:
+    - Firmware capture (Parm_VND_CAPTURE / Cmnd_STK_CAPTURE_DUMP, see
+      capture.h): both directions with microsecond timestamps
+    - Hand captures: raw host bytes in 'in.txt', programmer bytes in
+      'out.txt' (pairing and decoding only, no timing)
 
 Usage:
-    Place captured input bytes in 'in.txt' and responses in 'out.txt'
-    Run: python3 test.py
-
-Input Format:
-    Raw binary files containing the byte stream from host (in.txt) 
-    and programmer responses (out.txt)
+    python3 test.py --port /dev/ttyACM0 --enable      (then run avrdude)
+    python3 test.py --port /dev/ttyACM0 [--save cap.bin] [--clear]
+    python3 test.py --capture cap.bin [--list]
+    python3 test.py [in.txt out.txt]
 
 Output:
-    Paired command/response trace with hex dump
+    - Paired command/response trace with decoded command names (--list,
+      always on for hand captures)
+    - Per-command count, bytes, latency percentiles and histograms
+    - Session breakdown: time in the programmer vs. between replies and
+      the next command (host and USB), flash throughput
 
 STK500v1 Frame Format:
     - Commands: <cmd> [payload...] <EOP=0x20>
@@ -31,77 +33,389 @@ Author: MUdroThe1
 Date: 2026
 """
 
+import argparse
+import bisect
+import sys
 from pathlib import Path
 
 # STK500v1 Protocol Constants
 INSYNC = 0x14  # Response sync byte - indicates programmer is synchronized
-OK     = 0x10  # Response OK byte - command executed successfully  
+NOSYNC = 0x15  # Frame not understood
+OK     = 0x10  # Response OK byte - command executed successfully
+FAILED = 0x11  # Command failed
 EOP    = 0x20  # End Of Packet marker - terminates all commands
 
+SET_PARAMETER = 0x40
+CAPTURE_DUMP = 0x5D
+PARM_VND_CAPTURE = 0xD0
+
+# Command byte -> (name, payload bytes or None if it carries a length)
+COMMANDS = {
+    0x30: ("GET_SYNC", 0),
+    0x31: ("GET_SIGN_ON", 0),
+    0x40: ("SET_PARAMETER", 2),
+    0x41: ("GET_PARAMETER", 1),
+    0x42: ("SET_DEVICE", 20),
+    0x45: ("SET_DEVICE_EXT", 5),
+    0x50: ("ENTER_PROGMODE", 0),
+    0x51: ("LEAVE_PROGMODE", 0),
+    0x52: ("CHIP_ERASE", 0),
+    0x53: ("CHECK_AUTOINC", 0),
+    0x55: ("LOAD_ADDRESS", 2),
+    0x56: ("UNIVERSAL", 4),
+    0x57: ("UNIVERSAL_MULTI", None),
+    0x58: ("UNIVERSAL_BATCH", None),
+    0x59: ("SPI_BENCH", 0),
+    0x5A: ("VERIFY_MAP", 0),
+    0x5B: ("METRICS", 1),
+    0x5C: ("TRACE_DUMP", 1),
+    0x5D: ("CAPTURE_DUMP", 1),
+    0x64: ("PROG_PAGE", None),
+    0x66: ("PROG_PAGE_LZ", None),
+    0x74: ("READ_PAGE", 3),
+    0x75: ("READ_SIGN", 0),
+    0x79: ("READ_FLASH_RLE", 4),
+}
+
 def read_bytes(p: str) -> bytes:
     return Path(p).read_bytes()
 
+def hx(bs: bytes) -> str:
+    return " ".join(f"{b:02X}" for b in bs)
+
+
+# =============================================================================
+# Frame Splitting
+# =============================================================================
+
+def command_length(buf: bytes, i: int):
+    """
+    Length of the command frame starting at buf[i], mirroring the
+    firmware's parser. Returns None for an unknown command byte or a
+    truncated frame.
+    """
+    cmd = buf[i]
+    if cmd not in COMMANDS:
+        return None
+    payload = COMMANDS[cmd][1]
+    if payload is None:
+        if cmd in (0x57, 0x58):
+            if i + 1 >= len(buf):
+                return None
+            payload = 1 + (buf[i + 1] + 1 if cmd == 0x57 else buf[i + 1] * 4)
+        else:
+            if i + 2 >= len(buf):
+                return None
+            payload = 3 + (buf[i + 1] << 8 | buf[i + 2])
+    n = 1 + payload + 1
+    return n if i + n <= len(buf) else None
+
 def split_commands(in_bytes: bytes):
-    # STK500v1 commands from host end with CRC_EOP (0x20).
+    """
+    Split the host stream into (offset, frame) pairs the way the firmware
+    does: unknown bytes are skipped, and a frame without its EOP is cut
+    at the next EOP (the firmware answers it with NOSYNC).
+    """
     cmds = []
-    cur = bytearray()
-    for b in in_bytes:
-        cur.append(b)
-        if b == EOP:
-            cmds.append(bytes(cur))
-            cur.clear()
-    if cur:
-        cmds.append(bytes(cur))
+    i = 0
+    while i < len(in_bytes):
+        if in_bytes[i] not in COMMANDS:
+            i += 1  # stray EOP or noise
+            continue
+        n = command_length(in_bytes, i)
+        if n is None:
+            break   # capture ends mid-frame
+        if in_bytes[i + n - 1] != EOP:
+            j = in_bytes.find(EOP, i)
+            n = j - i + 1 if j >= 0 else 1
+        cmds.append((i, in_bytes[i:i + n]))
+        i += n
     return cmds
 
-def split_replies(out_bytes: bytes):
-    # Typical reply: 0x14 [payload...] 0x10
+def rle_length(buf: bytes, i: int, size: int):
+    """Bytes of a READ_FLASH_RLE stream at buf[i] that decode to size bytes."""
+    start = i
+    while size > 0:
+        if i >= len(buf):
+            return None
+        c = buf[i]
+        if c < 0x80:
+            i += 2 + c
+            size -= c + 1
+        else:
+            if i + 1 >= len(buf):
+                return None
+            size -= ((c & 0x7F) << 8 | buf[i + 1]) + 3
+            i += 3
+    return i - start
+
+def success_length(cmd: bytes, out: bytes, i: int):
+    """Length of a successful reply to cmd at out[i], None if unknown."""
+    c = cmd[0]
+    if c == 0x31:
+        return 9                                     # INSYNC "AVR ISP" OK
+    if c in (0x41, 0x53, 0x56):
+        return 3
+    if c == 0x75:
+        return 5
+    if c == 0x74:
+        return (cmd[1] << 8 | cmd[2]) + 2
+    if c == 0x58:
+        return cmd[1] + 2
+    if c == 0x59 and i + 1 < len(out):
+        return 2 + out[i + 1] * 8 + 1
+    if c == 0x5A and i + 2 < len(out):
+        return 3 + (out[i + 1] << 8 | out[i + 2]) + 1
+    if c == 0x5B and i + 5 < len(out):
+        counters = out[i + 5]
+        j = i + 6 + counters * 4
+        return j - i + 1 + out[j] * 13 + 1 if j < len(out) else None
+    if c == 0x5C and i + 2 < len(out):
+        return 7 + (out[i + 1] << 8 | out[i + 2]) * 8 + 1
+    if c == 0x5D and i + 4 < len(out):
+        return 9 + int.from_bytes(out[i + 1:i + 5], "big") + 1
+    if c == 0x79:
+        size = cmd[1] << 16 | cmd[2] << 8 | cmd[3]
+        n = rle_length(out, i + 1, size)
+        return None if n is None else n + 2
+    return 2
+
+def split_replies(cmds, out_bytes: bytes):
+    """
+    Cut the programmer stream into one (offset, reply) per command.
+
+    A reply is a NOSYNC byte, INSYNC FAILED, or the success layout of its
+    command. Success wins when both fit (e.g. READ_PAGE data that starts
+    with 0x11).
+    """
     replies = []
     i = 0
-    n = len(out_bytes)
-    while i < n:
-        if out_bytes[i] != INSYNC:
-            # skip noise bytes (shouldn't happen in clean captures)
+    for _, cmd in cmds:
+        if i >= len(out_bytes):
+            break
+        if out_bytes[i] == NOSYNC:
+            replies.append((i, out_bytes[i:i + 1]))
             i += 1
             continue
-        j = i + 1
-        while j < n and out_bytes[j] != OK:
-            j += 1
-        if j < n and out_bytes[j] == OK:
-            replies.append(out_bytes[i:j+1])
-            i = j + 1
-        else:
+        if out_bytes[i] != INSYNC:
+            break  # lost track; the rest cannot be paired
+        n = success_length(cmd, out_bytes, i)
+        if n is None or i + n > len(out_bytes) or out_bytes[i + n - 1] != OK:
+            n = 2 if i + 1 < len(out_bytes) and out_bytes[i + 1] == FAILED else None
+        if n is None:
             break
+        replies.append((i, out_bytes[i:i + n]))
+        i += n
     return replies
 
-def hx(bs: bytes) -> str:
-    return " ".join(f"{b:02X}" for b in bs)
+
+# =============================================================================
+# Capture Records
+# =============================================================================
+
+def parse_capture(raw: bytes):
+    """
+    Split a firmware capture into the two streams.
+
+    Returns (in_bytes, in_marks, out_bytes, out_marks), where marks are
+    (end_offset, time_us) per record: every byte before end_offset and at
+    or after the previous mark was stamped with time_us.
+    """
+    streams = {0: bytearray(), 1: bytearray()}
+    marks = {0: [], 1: []}
+    base = 0
+    prev = None
+    i = 0
+    while i + 7 <= len(raw):
+        t = int.from_bytes(raw[i:i + 4], "little")
+        if prev is not None and t < prev and prev - t > 1 << 31:
+            base += 1 << 32  # time_us_32() wrapped
+        prev = t
+        d = raw[i + 4]
+        n = raw[i + 5] | raw[i + 6] << 8
+        streams[d] += raw[i + 7:i + 7 + n]
+        marks[d].append((len(streams[d]), base + t))
+        i += 7 + n
+    return bytes(streams[0]), marks[0], bytes(streams[1]), marks[1]
+
+def time_at(marks, offset: int):
+    """Timestamp of the byte at offset, None without marks."""
+    if not marks:
+        return None
+    k = bisect.bisect_right([m[0] for m in marks], offset)
+    return marks[min(k, len(marks) - 1)][1]
+
+
+# =============================================================================
+# Analysis
+# =============================================================================
+
+def name_of(cmd: bytes) -> str:
+    return COMMANDS.get(cmd[0], (f"0x{cmd[0]:02X}", 0))[0]
+
+def percentile(values, p):
+    s = sorted(values)
+    return s[min(len(s) - 1, int(p / 100 * len(s)))]
+
+def histogram(values, width=30):
+    """Log2 latency buckets as text lines."""
+    buckets = {}
+    for v in values:
+        b = max(4, int(v).bit_length())
+        buckets[b] = buckets.get(b, 0) + 1
+    peak = max(buckets.values())
+    lines = []
+    for b in range(min(buckets), max(buckets) + 1):
+        n = buckets.get(b, 0)
+        lo = 0 if b == 4 else 1 << (b - 1)
+        lines.append(f"    {lo:>8}-{(1 << b) - 1:<8} us {n:6d} {'#' * max(n * width // peak, 1 if n else 0)}")
+    return lines
+
+def analyze(pairs, show_hist: bool):
+    """Per-command table, latency histograms and session breakdown."""
+    stats = {}
+    for p in pairs:
+        s = stats.setdefault(p["name"], {"lat": [], "in": 0, "out": 0, "failed": 0})
+        s["in"] += len(p["cmd"])
+        s["out"] += len(p["rsp"])
+        s["failed"] += p["rsp"][-1:] != bytes((OK,))
+        if p["lat"] is not None:
+            s["lat"].append(p["lat"])
+
+    timed = any(s["lat"] for s in stats.values())
+    print(f"{'command':16s} {'count':>6s} {'fail':>5s} {'in B':>8s} {'out B':>8s}"
+          + (f" {'total ms':>9s} {'p50 us':>8s} {'p95 us':>8s} {'max us':>8s}" if timed else ""))
+    order = sorted(stats.items(), key=lambda kv: -sum(kv[1]["lat"]) if timed else kv[0])
+    for name, s in order:
+        count = sum(1 for p in pairs if p["name"] == name)
+        line = f"{name:16s} {count:6d} {s['failed']:5d} {s['in']:8d} {s['out']:8d}"
+        if s["lat"]:
+            line += (f" {sum(s['lat']) / 1e3:9.1f} {percentile(s['lat'], 50):8d}"
+                     f" {percentile(s['lat'], 95):8d} {max(s['lat']):8d}")
+        print(line)
+    if not timed:
+        return
+
+    if show_hist:
+        print("\nLatency histograms (command start -> reply flushed):")
+        for name, s in order:
+            if s["lat"]:
+                print(f"  {name}")
+                print("\n".join(histogram(s["lat"])))
+
+    first = pairs[0]["t_cmd"]
+    last = pairs[-1]["t_rsp"]
+    span = max(last - first, 1)
+    device = sum(p["lat"] for p in pairs)
+    host = span - device
+    written = sum(len(p["cmd"]) - 5 for p in pairs if p["cmd"][0] == 0x64 and p["rsp"][-1] == OK)
+    read = sum(len(p["rsp"]) - 2 for p in pairs if p["cmd"][0] == 0x74 and p["rsp"][-1] == OK)
+    print(f"\nSession {span / 1e3:.1f} ms over {len(pairs)} commands")
+    print(f"  programmer   {device / 1e3:10.1f} ms {device / span:6.1%}")
+    print(f"  host + USB   {host / 1e3:10.1f} ms {host / span:6.1%}  "
+          f"(avg {host / len(pairs):.0f} us between reply and next command)")
+    if written:
+        print(f"  PROG_PAGE    {written:10d} B  {written / span * 1e3:8.1f} kB/s")
+    if read:
+        print(f"  READ_PAGE    {read:10d} B  {read / span * 1e3:8.1f} kB/s")
+
+def pair_frames(in_b, in_marks, out_b, out_marks):
+    cmds = split_commands(in_b)
+    reps = split_replies(cmds, out_b)
+    pairs = []
+    prev_rsp = None
+    for (ci, cmd), (ri, rsp) in zip(cmds, reps):
+        t_cmd = time_at(in_marks, ci + len(cmd) - 1)
+        t_rsp = time_at(out_marks, ri + len(rsp) - 1)
+        lat = None
+        if t_cmd is not None and t_rsp is not None:
+            # A command sent ahead of the previous reply starts at that
+            # reply, so latencies never overlap and sum with the host gaps
+            start = max(t_cmd, prev_rsp) if prev_rsp is not None else t_cmd
+            t_rsp = max(t_rsp, start)
+            lat = t_rsp - start
+            prev_rsp = t_rsp
+        pairs.append({"name": name_of(cmd), "cmd": cmd, "rsp": rsp,
+                      "t_cmd": t_cmd, "t_rsp": t_rsp, "lat": lat})
+    return cmds, reps, pairs
+
+
+# =============================================================================
+# Capture Retrieval
+# =============================================================================
+
+def fetch_capture(args) -> bytes:
+    import serial  # pyserial, only needed for live captures
+
+    with serial.Serial(args.port, 115200, timeout=5) as port:
+        if args.enable or args.disable:
+            port.write(bytes((SET_PARAMETER, PARM_VND_CAPTURE, int(args.enable), EOP)))
+            if port.read(2) != bytes((INSYNC, OK)):
+                raise IOError("capture parameter rejected")
+            print(f"capture {'on' if args.enable else 'off'}")
+            return None
+        port.write(bytes((CAPTURE_DUMP, int(args.clear), EOP)))
+        hdr = port.read(9)
+        if len(hdr) != 9 or hdr[0] != INSYNC:
+            raise IOError(f"bad reply to CAPTURE_DUMP: {hdr.hex()}")
+        n = int.from_bytes(hdr[1:5], "big")
+        lost = int.from_bytes(hdr[5:9], "big")
+        raw = port.read(n + 1)
+        if len(raw) != n + 1 or raw[-1] != OK:
+            raise IOError("truncated CAPTURE_DUMP reply")
+    if lost:
+        print(f"capture buffer overflowed: {lost} bytes not recorded", file=sys.stderr)
+    if args.save:
+        Path(args.save).write_bytes(raw[:-1])
+    return raw[:-1]
 
 
 # =============================================================================
 # Main Execution - Parse and display protocol trace
 # =============================================================================
 
-# Read captured protocol data from files
-# in.txt: Commands from host (avrdude) to programmer
-# out.txt: Responses from programmer to host
-in_b  = read_bytes("in.txt")
-out_b = read_bytes("out.txt")
-
-# Split byte streams into individual frames
-cmds = split_commands(in_b)
-reps = split_replies(out_b)
-
-# Display summary and paired command/response trace
-m = min(len(cmds), len(reps))  # Number of complete pairs
-print(f"commands={len(cmds)} replies={len(reps)} paired={m}\n")
-
-# Print each command with its corresponding response
-for k in range(m):
-    print(f"{k+1:04d} CMD: {hx(cmds[k])}")
-    print(f"     RSP: {hx(reps[k])}\n")
-
-# TODO: Add command type decoding
-# TODO: Add response validation
-# TODO: Add flash data extraction and hex dump
-# TODO: Add error detection and reporting
\ No newline at end of file
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("files", nargs="*", default=["in.txt", "out.txt"],
+                    help="hand captures: host bytes, programmer bytes")
+    src = ap.add_mutually_exclusive_group()
+    src.add_argument("--port", help="read the firmware capture over CDC")
+    src.add_argument("--capture", help="firmware capture saved with --save")
+    ap.add_argument("--save", help="also save the fetched capture")
+    ap.add_argument("--clear", action="store_true", help="drop the capture on the device after reading")
+    ap.add_argument("--enable", action="store_true", help="start capturing (from the next command)")
+    ap.add_argument("--disable", action="store_true", help="stop capturing")
+    ap.add_argument("--list", action="store_true", help="print every command/response pair")
+    ap.add_argument("--no-hist", action="store_true", help="skip latency histograms")
+    args = ap.parse_args()
+
+    if args.port or args.capture:
+        raw = fetch_capture(args) if args.port else read_bytes(args.capture)
+        if raw is None:
+            return 0
+        in_b, in_marks, out_b, out_marks = parse_capture(raw)
+    else:
+        # in.txt: Commands from host (avrdude) to programmer
+        # out.txt: Responses from programmer to host
+        in_b, out_b = read_bytes(args.files[0]), read_bytes(args.files[1])
+        in_marks, out_marks = [], []
+        args.list = True
+
+    cmds, reps, pairs = pair_frames(in_b, in_marks, out_b, out_marks)
+    print(f"commands={len(cmds)} replies={len(reps)} paired={len(pairs)}\n")
+
+    if args.list:
+        for k, p in enumerate(pairs):
+            when = f" +{(p['t_cmd'] - pairs[0]['t_cmd']) / 1e3:9.3f} ms" if p["lat"] is not None else ""
+            took = f"  ({p['lat']} us)" if p["lat"] is not None else ""
+            print(f"{k + 1:04d}{when} {p['name']}{took}")
+            print(f"     CMD: {hx(p['cmd'])}")
+            print(f"     RSP: {hx(p['rsp'])}\n")
+
+    if pairs:
+        analyze(pairs, not args.no_hist)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,437 @@
+/**
+ * @file tpi.c
+ * @brief Tiny Programming Interface (TPI) Implementation
+ *
+ * Software implementation of the TPI physical layer on SIO-controlled
+ * GPIOs, plus the access layer (SLD/SST/SSTPR/SIN/SOUT/SLDCS/SSTCS/SKEY)
+ * and NVM controller sequences on top of it.
+ *
+ * Speed Notes:
+ *   - Reads use SLD with pointer post-increment, so a burst read costs one
+ *     instruction frame plus one response frame per byte and no pointer
+ *     reloads.
+ *   - The guard time is shortened from the 128-bit reset default to
+ *     2 bits right after connecting, which removes most of the
+ *     turnaround cost of every read.
+ *   - Erased (0xFFFF) words are skipped during flash writes.
+ *   - Half-bits are timed in system clock cycles by a busy-wait, and the
+ *     bit loops run from RAM, so TPICLK holds its rate without flash
+ *     cache misses or the microsecond granularity of sleep_us().
+ *
+ * The link stays on SIO rather than a PIO program like pdi.pio or
+ * debugwire.pio: TPICLK may not exceed the target clock, so its rate is
+ * set by the target rather than by how fast the RP2040 can toggle pins.
+ * A cycle-counted loop already runs the link at that rate, and the
+ * two-way TPIDATA turnaround with its variable guard time stays simple.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "tpi.h"
+#include "avrprog.h"
+#include <pico/stdlib.h>
+#include "hardware/clocks.h"
+
+/*******************************************************************************
+ * TPI Instruction Set
+ ******************************************************************************/
+#define TPI_SLD           0x20                    /* Load data, pointer unchanged */
+#define TPI_SLD_PI        0x24                    /* Load data, post-increment */
+#define TPI_SST           0x60                    /* Store data, pointer unchanged */
+#define TPI_SST_PI        0x64                    /* Store data, post-increment */
+#define TPI_SSTPR(n)      (0x68 | (n))            /* Store pointer byte n */
+#define TPI_SIN(a)        (0x10 | (((a) & 0x30) << 1) | ((a) & 0x0F))
+#define TPI_SOUT(a)       (0x90 | (((a) & 0x30) << 1) | ((a) & 0x0F))
+#define TPI_SLDCS(a)      (0x80 | (a))            /* Load control/status register */
+#define TPI_SSTCS(a)      (0xC0 | (a))            /* Store control/status register */
+#define TPI_SKEY          0xE0                    /* Send key */
+
+/* Control and status space */
+#define TPI_TPISR         0x00
+#define TPI_TPIPCR        0x02
+#define TPI_TPIIR         0x0F
+#define TPISR_NVMEN       0x02
+#define TPIIR_ID          0x80
+
+/* NVM controller (I/O space) */
+#define NVMCSR            0x32
+#define NVMCMD            0x33
+#define NVMCSR_BSY        0x80
+
+#define NVM_CMD_NO_OP          0x00
+#define NVM_CMD_CHIP_ERASE     0x10
+#define NVM_CMD_SECTION_ERASE  0x14
+#define NVM_CMD_WORD_WRITE     0x1D
+
+/* Data space addresses */
+#define TPI_ADDR_LOCK     0x3F00
+#define TPI_ADDR_CONFIG   0x3F40
+#define TPI_ADDR_CALIB    0x3F80
+#define TPI_ADDR_SIG      0x3FC0
+#define TPI_ADDR_FLASH    0x4000
+
+/** NVM enable key, sent least significant byte first */
+static const uint8_t nvm_key[8] = {0xFF, 0x88, 0xD8, 0xCD, 0x45, 0xAB, 0x89, 0x12};
+
+/** Idle bits to wait for a response start bit (GT 128 + margin) */
+#define TPI_START_TIMEOUT_BITS  160
+
+/** NVM operation timeout (chip erase is the slowest) */
+#define TPI_NVM_TIMEOUT_US      20000
+
+/*******************************************************************************
+ * Private Variables
+ ******************************************************************************/
+static uint32_t tpi_delay_us = TPI_DELAY_US;
+static uint32_t tpi_half_cycles = 0;
+static uint8_t guard_time = TPI_GT_2;
+static bool link_error = false;
+
+/*******************************************************************************
+ * Physical Layer
+ ******************************************************************************/
+
+/**
+ * @brief Convert the half-period to system clock cycles
+ *
+ * Rounded up so TPICLK never runs faster than requested; called on
+ * enter so a clk_sys change since the last session is picked up.
+ */
+static void tpi_update_half_cycles(void) {
+    uint64_t cycles = (uint64_t)clock_get_hz(clk_sys) * tpi_delay_us + 999999u;
+    tpi_half_cycles = (uint32_t)(cycles / 1000000u);
+}
+
+static inline void tpi_delay(void) {
+    busy_wait_at_least_cycles(tpi_half_cycles);
+}
+
+/** One clock cycle driving a bit (changed while TPICLK is low) */
+static void __not_in_flash_func(clock_out)(bool bit) {
+    gpio_put(TPI_DATA_PIN, bit);
+    tpi_delay();
+    gpio_put(TPI_CLK_PIN, 1);
+    tpi_delay();
+    gpio_put(TPI_CLK_PIN, 0);
+}
+
+/** One clock cycle sampling TPIDATA at the rising edge */
+static bool __not_in_flash_func(clock_in)(void) {
+    tpi_delay();
+    gpio_put(TPI_CLK_PIN, 1);
+    bool bit = gpio_get(TPI_DATA_PIN);
+    tpi_delay();
+    gpio_put(TPI_CLK_PIN, 0);
+    return bit;
+}
+
+static void __not_in_flash_func(data_drive)(void) {
+    gpio_put(TPI_DATA_PIN, 1);
+    gpio_set_dir(TPI_DATA_PIN, GPIO_OUT);
+}
+
+static void __not_in_flash_func(data_release)(void) {
+    gpio_set_dir(TPI_DATA_PIN, GPIO_IN);
+}
+
+/** Send one frame: start, 8 data bits LSB first, even parity, 2 stop bits */
+static void __not_in_flash_func(tpi_send)(uint8_t b) {
+    uint8_t parity = 0;
+    clock_out(0);
+    for (int i = 0; i < 8; i++) {
+        bool bit = (b >> i) & 1;
+        parity ^= bit;
+        clock_out(bit);
+    }
+    clock_out(parity);
+    clock_out(1);
+    clock_out(1);
+}
+
+/**
+ * @brief Receive one response frame
+ *
+ * Releases TPIDATA, clocks through the target's guard time until the
+ * start bit, then reads data, parity and stop bits. Any framing or parity
+ * error sets link_error.
+ */
+static uint8_t __not_in_flash_func(tpi_recv)(void) {
+    data_release();
+
+    int idle = 0;
+    while (clock_in()) {
+        if (++idle > TPI_START_TIMEOUT_BITS) {
+            link_error = true;
+            data_drive();
+            return 0xFF;
+        }
+    }
+
+    uint8_t b = 0;
+    uint8_t parity = 0;
+    for (int i = 0; i < 8; i++) {
+        if (clock_in()) {
+            b |= (uint8_t)(1u << i);
+            parity ^= 1;
+        }
+    }
+    bool p = clock_in();
+    bool sp1 = clock_in();
+    bool sp2 = clock_in();
+    if (p != parity || !sp1 || !sp2) {
+        link_error = true;
+    }
+
+    data_drive();
+    clock_out(1);  /* One idle bit before we drive the next frame */
+    return b;
+}
+
+/*******************************************************************************
+ * Access Layer
+ ******************************************************************************/
+
+static void set_pointer(uint16_t addr) {
+    tpi_send(TPI_SSTPR(0));
+    tpi_send((uint8_t)(addr & 0xFF));
+    tpi_send(TPI_SSTPR(1));
+    tpi_send((uint8_t)(addr >> 8));
+}
+
+static void io_write(uint8_t addr, uint8_t value) {
+    tpi_send(TPI_SOUT(addr));
+    tpi_send(value);
+}
+
+static uint8_t io_read(uint8_t addr) {
+    tpi_send(TPI_SIN(addr));
+    return tpi_recv();
+}
+
+static uint8_t cs_read(uint8_t addr) {
+    tpi_send(TPI_SLDCS(addr));
+    return tpi_recv();
+}
+
+static void cs_write(uint8_t addr, uint8_t value) {
+    tpi_send(TPI_SSTCS(addr));
+    tpi_send(value);
+}
+
+/** Read len bytes from the data space with post-increment loads */
+static void read_block(uint16_t addr, uint8_t* out, size_t len) {
+    set_pointer(addr);
+    for (size_t i = 0; i < len; i++) {
+        tpi_send(TPI_SLD_PI);
+        out[i] = tpi_recv();
+    }
+}
+
+static uint8_t read_byte(uint16_t addr) {
+    uint8_t b;
+    read_block(addr, &b, 1);
+    return b;
+}
+
+/*******************************************************************************
+ * NVM Controller
+ ******************************************************************************/
+
+static bool nvm_wait(uint32_t timeout_us) {
+    absolute_time_t deadline = make_timeout_time_us(timeout_us);
+    while (io_read(NVMCSR) & NVMCSR_BSY) {
+        if (link_error || time_reached(deadline)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Erase the section containing addr (dummy write to a high byte) */
+static void nvm_erase(uint8_t cmd, uint16_t addr) {
+    io_write(NVMCMD, cmd);
+    set_pointer(addr | 1);
+    tpi_send(TPI_SST);
+    tpi_send(0xFF);
+    nvm_wait(TPI_NVM_TIMEOUT_US);
+}
+
+/** Write one word at the current pointer (pointer advances by 2) */
+static void nvm_write_word(uint8_t low, uint8_t high) {
+    tpi_send(TPI_SST_PI);
+    tpi_send(low);
+    tpi_send(TPI_SST_PI);
+    tpi_send(high);
+    nvm_wait(TPI_NVM_TIMEOUT_US);
+}
+
+static void write_config_byte(uint16_t addr, uint8_t value, bool erase_first) {
+    if (erase_first) {
+        nvm_erase(NVM_CMD_SECTION_ERASE, addr);
+    }
+    io_write(NVMCMD, NVM_CMD_WORD_WRITE);
+    set_pointer(addr);
+    nvm_write_word(value, 0xFF);
+    io_write(NVMCMD, NVM_CMD_NO_OP);
+}
+
+/*******************************************************************************
+ * Interface Operations
+ ******************************************************************************/
+
+/**
+ * @brief Connect over TPI and enable NVM programming
+ *
+ * Sequence:
+ *   1. RESET low, TPIDATA high for 32 clocks (datasheet minimum 16)
+ *   2. Program the guard time, check TPIIR identification (0x80)
+ *   3. SKEY + 8-byte NVM key, poll TPISR.NVMEN
+ */
+static bool tpi_enter(void) {
+    tpi_update_half_cycles();
+
+    gpio_init(TPI_CLK_PIN);
+    gpio_set_dir(TPI_CLK_PIN, GPIO_OUT);
+    gpio_put(TPI_CLK_PIN, 0);
+
+    gpio_init(TPI_DATA_PIN);
+    gpio_pull_up(TPI_DATA_PIN);
+    data_drive();
+
+    gpio_init(TPI_RESET_PIN);
+    gpio_set_dir(TPI_RESET_PIN, GPIO_OUT);
+    gpio_put(TPI_RESET_PIN, 1);
+    sleep_ms(2);
+    gpio_put(TPI_RESET_PIN, 0);
+    sleep_ms(1);
+
+    link_error = false;
+    for (int i = 0; i < 32; i++) {
+        clock_out(1);
+    }
+
+    cs_write(TPI_TPIPCR, guard_time);
+    if (cs_read(TPI_TPIIR) != TPIIR_ID || link_error) {
+        avr_iface_tpi.leave();
+        return false;
+    }
+
+    tpi_send(TPI_SKEY);
+    for (int i = 0; i < 8; i++) {
+        tpi_send(nvm_key[i]);
+    }
+
+    for (int attempt = 0; attempt < 32; attempt++) {
+        if (cs_read(TPI_TPISR) & TPISR_NVMEN) {
+            return !link_error;
+        }
+    }
+    avr_iface_tpi.leave();
+    return false;
+}
+
+/**
+ * @brief Disable NVM programming, release RESET and restore ISP pins
+ */
+static void tpi_leave(void) {
+    cs_write(TPI_TPISR, 0x00);
+    gpio_put(TPI_RESET_PIN, 1);
+    sleep_ms(2);
+    avr_spi_init();
+}
+
+/**
+ * @brief Emulate the ISP instructions that have a TPI equivalent
+ *
+ * Signature, configuration byte (reported as low fuse), lock bits and
+ * calibration reads; configuration/lock writes and chip erase.
+ */
+static void tpi_universal(const uint8_t cmd[4], uint8_t rx[4]) {
+    rx[0] = rx[1] = rx[2] = rx[3] = 0;
+    switch (cmd[0]) {
+        case 0x30: rx[3] = read_byte(TPI_ADDR_SIG + (cmd[2] & 0x03)); break;
+        case 0x50: rx[3] = cmd[1] == 0x00 ? read_byte(TPI_ADDR_CONFIG) : 0xFF; break;
+        case 0x58: rx[3] = cmd[1] == 0x00 ? read_byte(TPI_ADDR_LOCK) : 0xFF; break;
+        case 0x38: rx[3] = read_byte(TPI_ADDR_CALIB); break;
+        case 0xAC:
+            if (cmd[1] == 0x80) {
+                avr_iface_tpi.chip_erase();
+            } else if (cmd[1] == 0xA0) {
+                write_config_byte(TPI_ADDR_CONFIG, cmd[3], true);
+            } else if (cmd[1] == 0xE0) {
+                write_config_byte(TPI_ADDR_LOCK, cmd[3], false);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static bool tpi_poll_ready(uint32_t timeout_us) {
+    return nvm_wait(timeout_us);
+}
+
+static void tpi_chip_erase(void) {
+    nvm_erase(NVM_CMD_CHIP_ERASE, TPI_ADDR_FLASH);
+    io_write(NVMCMD, NVM_CMD_NO_OP);
+}
+
+/**
+ * @brief Program flash word by word (reduced-core parts have no page buffer)
+ *
+ * The pointer post-increments through the page; it is only reloaded after
+ * skipping erased words.
+ */
+static void tpi_write_flash_page(uint32_t byte_addr, const uint8_t* data, size_t len) {
+    uint16_t addr = (uint16_t)(TPI_ADDR_FLASH + byte_addr);
+    bool pointer_valid = false;
+
+    io_write(NVMCMD, NVM_CMD_WORD_WRITE);
+    for (size_t i = 0; i + 1 < len; i += 2, addr += 2) {
+        if (data[i] == 0xFF && data[i + 1] == 0xFF) {
+            pointer_valid = false;
+            continue;
+        }
+        if (!pointer_valid) {
+            set_pointer(addr);
+            pointer_valid = true;
+        }
+        nvm_write_word(data[i], data[i + 1]);
+    }
+    io_write(NVMCMD, NVM_CMD_NO_OP);
+}
+
+static void tpi_read_flash(uint32_t byte_addr, uint8_t* out, size_t len) {
+    read_block((uint16_t)(TPI_ADDR_FLASH + byte_addr), out, len);
+}
+
+const avr_iface_t avr_iface_tpi = {
+    .name = "TPI",
+    .enter = tpi_enter,
+    .leave = tpi_leave,
+    .universal = tpi_universal,
+    .poll_ready = tpi_poll_ready,
+    .chip_erase = tpi_chip_erase,
+    .write_flash_page = tpi_write_flash_page,
+    .read_flash = tpi_read_flash,
+};
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+/**
+ * @brief Set the guard time programmed on the next enter
+ */
+void tpi_set_guard_time(uint8_t gt) {
+    guard_time = gt & 0x07;
+}
+
+/**
+ * @brief Set the TPICLK half-period
+ */
+void tpi_set_speed(uint32_t delay_us) {
+    tpi_delay_us = delay_us ? delay_us : 1;
+    tpi_update_half_cycles();
+}
@@ -0,0 +1,93 @@
+/**
+ * @file tpi.h
+ * @brief Tiny Programming Interface (TPI) for Reduced-Core ATtiny Parts
+ *
+ * ATtiny4/5/9/10 (and 20/40/102/104) have no SPI programming mode. They
+ * are programmed over TPI: a synchronous half-duplex serial link using
+ * RESET (held low), TPICLK and a single bidirectional TPIDATA line.
+ *
+ * Wiring (same 6-pin header as ISP):
+ *   - TPICLK  -> ISP SCK pin
+ *   - TPIDATA -> ISP MOSI pin (driven and sampled, pull-up when released)
+ *   - RESET   -> ISP RESET pin
+ *
+ * Frame Format:
+ *   IDLE(1) | ST(0) | D0..D7 (LSB first) | P (even) | SP1 SP2 (1)
+ *   Programmer changes TPIDATA after the falling edge of TPICLK, the
+ *   target samples on the rising edge (and vice versa for responses).
+ *
+ * Memory Map (data space, 16-bit pointer):
+ *   - 0x3F00 NVM lock bits
+ *   - 0x3F40 Configuration byte (fuses)
+ *   - 0x3F80 Calibration byte
+ *   - 0x3FC0 Device signature (3 bytes)
+ *   - 0x4000 Flash (mapped program memory)
+ *
+ * Reference: ATtiny4/5/9/10 datasheet, section "Programming interface"
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "avr_iface.h"
+
+/*******************************************************************************
+ * Configuration - TPI Pin Definitions
+ ******************************************************************************/
+#ifndef TPI_CLK_PIN
+#define TPI_CLK_PIN    18   /* TPICLK on the ISP SCK pin */
+#endif
+
+#ifndef TPI_DATA_PIN
+#define TPI_DATA_PIN   19   /* TPIDATA on the ISP MOSI pin */
+#endif
+
+#ifndef TPI_RESET_PIN
+#define TPI_RESET_PIN  17   /* Held low while TPI is enabled */
+#endif
+
+/**
+ * @brief TPICLK half-period in microseconds (default ~250 kHz)
+ *
+ * TPICLK must not exceed the target's clock; reduced-core tinies start
+ * at 1 MHz (8 MHz RC with CLKPS = 8), so 250 kHz leaves margin.
+ */
+#ifndef TPI_DELAY_US
+#define TPI_DELAY_US   2
+#endif
+
+/*******************************************************************************
+ * Guard Time (TPIPCR.GT) - idle bits the target inserts before a response
+ ******************************************************************************/
+#define TPI_GT_128    0x00  /* Reset default */
+#define TPI_GT_64     0x01
+#define TPI_GT_32     0x02
+#define TPI_GT_16     0x03
+#define TPI_GT_8      0x04
+#define TPI_GT_4      0x05
+#define TPI_GT_2      0x06
+#define TPI_GT_0      0x07
+
+/**
+ * @brief Set the guard time programmed on the next enter
+ *
+ * Shorter guard times speed up every read (SLD, SIN, SLDCS); long ones
+ * tolerate slow or noisy lines.
+ *
+ * @param gt TPI_GT_* code
+ */
+void tpi_set_guard_time(uint8_t gt);
+
+/**
+ * @brief Set the TPICLK half-period
+ *
+ * @param delay_us Half-period in microseconds (minimum 1)
+ */
+void tpi_set_speed(uint32_t delay_us);
+
+/** TPI implementation of the programming interface operations */
+extern const avr_iface_t avr_iface_tpi;
@@ -0,0 +1,95 @@
+/**
+ * @file trace.c
+ * @brief Timestamped Event Trace Ring
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "trace.h"
+#include <pico/stdlib.h>
+
+_Static_assert((TRACE_EVENTS & (TRACE_EVENTS - 1)) == 0, "ring size");
+
+/*******************************************************************************
+ * Ring
+ ******************************************************************************/
+
+typedef struct {
+    uint32_t t;
+    uint8_t type;
+    uint8_t arg8;
+    uint16_t arg16;
+} trace_entry_t;
+
+static trace_entry_t ring[TRACE_EVENTS];
+static uint32_t head;           /* Events written since the last clear */
+static bool on;
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/**
+ * @brief Start or stop recording
+ */
+void trace_enable(bool enable) {
+    on = enable;
+}
+
+/**
+ * @brief Check whether recording is on
+ */
+bool trace_enabled(void) {
+    return on;
+}
+
+/**
+ * @brief Record an event (no-op while disabled)
+ */
+void __not_in_flash_func(trace)(trace_event_t type, uint8_t arg8, uint16_t arg16) {
+    if (!on) {
+        return;
+    }
+    trace_entry_t *e = &ring[head++ & (TRACE_EVENTS - 1)];
+    e->t = time_us_32();
+    e->type = (uint8_t)type;
+    e->arg8 = arg8;
+    e->arg16 = arg16;
+}
+
+/**
+ * @brief Drop all recorded events
+ */
+void trace_clear(void) {
+    head = 0;
+}
+
+/**
+ * @brief Get the number of recorded events (at most TRACE_EVENTS)
+ */
+size_t trace_count(void) {
+    return head < TRACE_EVENTS ? head : TRACE_EVENTS;
+}
+
+/**
+ * @brief Get the number of events lost to overwriting since the last clear
+ */
+uint32_t trace_dropped(void) {
+    return head > TRACE_EVENTS ? head - TRACE_EVENTS : 0;
+}
+
+/**
+ * @brief Encode one recorded event, oldest first
+ */
+void trace_record(size_t index, uint8_t out[TRACE_RECORD_BYTES]) {
+    const trace_entry_t *e = &ring[(head - trace_count() + index) & (TRACE_EVENTS - 1)];
+    out[0] = (uint8_t)e->t;
+    out[1] = (uint8_t)(e->t >> 8);
+    out[2] = (uint8_t)(e->t >> 16);
+    out[3] = (uint8_t)(e->t >> 24);
+    out[4] = e->type;
+    out[5] = e->arg8;
+    out[6] = (uint8_t)e->arg16;
+    out[7] = (uint8_t)(e->arg16 >> 8);
+}
@@ -0,0 +1,89 @@
+/**
+ * @file trace.h
+ * @brief Timestamped Event Trace Ring
+ *
+ * Session counters (metrics.h) tell how much time went where in total;
+ * the trace shows the order. While enabled (Parm_VND_TRACE), the protocol
+ * handler and the ISP layer record fixed-size events into a RAM ring that
+ * the host dumps with Cmnd_STK_TRACE_DUMP and turns into a timeline
+ * (progctl.py trace, Chrome trace / Perfetto JSON).
+ *
+ * Record Format (8 bytes, little-endian, as dumped):
+ *   [0..3] time_us_32() timestamp (wraps every ~71 minutes)
+ *   [4]    Event type (trace_event_t)
+ *   [5]    8-bit argument
+ *   [6..7] 16-bit argument
+ *
+ * Overhead:
+ *   Recording is a flag test and one 8-byte store, run from RAM. When
+ *   the ring is full the oldest events are overwritten and counted.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Events held by the ring (power of two) */
+#define TRACE_EVENTS    1024
+
+/** Bytes per dumped record */
+#define TRACE_RECORD_BYTES  8
+
+/*******************************************************************************
+ * Event Types (arguments in brackets: 8-bit, 16-bit)
+ ******************************************************************************/
+typedef enum {
+    TRACE_RX = 1,           /* CDC bytes fed to the parser (-, byte count) */
+    TRACE_DISPATCH_BEGIN,   /* Frame handling starts (command, payload length) */
+    TRACE_DISPATCH_END,     /* Frame handling ends (command, -) */
+    TRACE_ISP_BEGIN,        /* ISP transfer starts (-, instructions) */
+    TRACE_ISP_END,          /* ISP transfer ends (-, instructions) */
+    TRACE_POLL,             /* RDY/BSY query (1 = busy, -) */
+    TRACE_WAIT_BEGIN,       /* Queued write waits for the target (-, -) */
+    TRACE_WAIT_END,         /* Wait over (1 = ok, -) */
+    TRACE_FLUSH,            /* Reply flushed to USB (-, -) */
+    TRACE_NOSYNC,           /* Frame rejected with NOSYNC (-, -) */
+} trace_event_t;
+
+/**
+ * @brief Start or stop recording
+ */
+void trace_enable(bool on);
+
+/**
+ * @brief Check whether recording is on
+ */
+bool trace_enabled(void);
+
+/**
+ * @brief Record an event (no-op while disabled)
+ */
+void trace(trace_event_t type, uint8_t arg8, uint16_t arg16);
+
+/**
+ * @brief Drop all recorded events
+ */
+void trace_clear(void);
+
+/**
+ * @brief Get the number of recorded events (at most TRACE_EVENTS)
+ */
+size_t trace_count(void);
+
+/**
+ * @brief Get the number of events lost to overwriting since the last clear
+ */
+uint32_t trace_dropped(void);
+
+/**
+ * @brief Encode one recorded event, oldest first
+ *
+ * @param index Event index, 0 .. trace_count() - 1
+ * @param out   Receives TRACE_RECORD_BYTES bytes
+ */
+void trace_record(size_t index, uint8_t out[TRACE_RECORD_BYTES]);
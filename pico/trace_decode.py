@@ -0,0 +1,100 @@
+"""
+trace_decode.py - Event Trace Decoder (TRACE_DUMP to Chrome/Perfetto JSON)
+
+Host-side companion to pico/trace.c. Splits the records returned by the
+Cmnd_STK_TRACE_DUMP (0x5C) vendor command into events and converts them
+to Chrome trace JSON for chrome://tracing or ui.perfetto.dev. Used by
+progctl.py trace; no serial port or pyserial needed.
+
+Trace Record Format (see trace.h):
+    - u32 time (microseconds, little endian), type, arg8, u16 arg16
+    - Types 1..10: RX, DISPATCH_BEGIN/END, ISP_BEGIN/END, POLL,
+      WAIT_BEGIN/END, FLUSH, NOSYNC
+
+Author: MUdroThe1
+Date: 2026
+"""
+
+# Command bytes as named in stk500v1.h (also used by progctl.py metrics)
+COMMAND_NAMES = {
+    0x30: "GET_SYNC", 0x31: "GET_SIGN_ON", 0x40: "SET_PARAMETER", 0x41: "GET_PARAMETER",
+    0x42: "SET_DEVICE", 0x45: "SET_DEVICE_EXT", 0x50: "ENTER_PROGMODE", 0x51: "LEAVE_PROGMODE",
+    0x52: "CHIP_ERASE", 0x53: "CHECK_AUTOINC", 0x55: "LOAD_ADDRESS", 0x56: "UNIVERSAL",
+    0x57: "UNIVERSAL_MULTI", 0x58: "UNIVERSAL_BATCH", 0x59: "SPI_BENCH", 0x5A: "VERIFY_MAP",
+    0x5B: "METRICS", 0x64: "PROG_PAGE", 0x66: "PROG_PAGE_LZ", 0x74: "READ_PAGE",
+    0x75: "READ_SIGN", 0x79: "READ_FLASH_RLE",
+}
+
+# Event trace records (see trace.h): u32 time, type, arg8, u16 arg16
+TRACE_RECORD = 8
+TRACE_RX, TRACE_DISPATCH_BEGIN, TRACE_DISPATCH_END, TRACE_ISP_BEGIN, TRACE_ISP_END, \
+    TRACE_POLL, TRACE_WAIT_BEGIN, TRACE_WAIT_END, TRACE_FLUSH, TRACE_NOSYNC = range(1, 11)
+
+
+def trace_decode(raw: bytes) -> list:
+    """
+    Split a TRACE_DUMP body into (time_us, type, arg8, arg16) tuples.
+
+    Timestamps are the device's 32-bit microsecond clock; wraps between
+    consecutive events are undone so times only increase.
+    """
+    events = []
+    base = 0
+    prev = None
+    for i in range(0, len(raw) - len(raw) % TRACE_RECORD, TRACE_RECORD):
+        t = int.from_bytes(raw[i:i + 4], "little")
+        if prev is not None and t < prev:
+            base += 1 << 32
+        prev = t
+        events.append((base + t, raw[i + 4], raw[i + 5], int.from_bytes(raw[i + 6:i + 8], "little")))
+    return events
+
+
+def trace_to_chrome(events: list) -> dict:
+    """
+    Convert decoded events to Chrome trace JSON (also read by Perfetto).
+
+    Three tracks: frame handling, ISP transfers and target waits. Ends
+    whose begin was overwritten in the ring are dropped.
+    """
+    tracks = {"protocol": 1, "isp": 2, "target": 3}
+    out = [{"ph": "M", "pid": 1, "tid": tid, "name": "thread_name", "args": {"name": name}}
+           for name, tid in tracks.items()]
+    open_spans = {tid: 0 for tid in tracks.values()}
+    t0 = events[0][0] if events else 0
+
+    def span(ph, tid, name, ts, args=None):
+        if ph == "E":
+            if not open_spans[tid]:
+                return
+            open_spans[tid] -= 1
+        else:
+            open_spans[tid] += 1
+        out.append({"ph": ph, "pid": 1, "tid": tid, "name": name, "ts": ts, "args": args or {}})
+
+    def instant(tid, name, ts, args=None):
+        out.append({"ph": "i", "s": "t", "pid": 1, "tid": tid, "name": name, "ts": ts, "args": args or {}})
+
+    for t, kind, a8, a16 in events:
+        ts = t - t0
+        if kind == TRACE_DISPATCH_BEGIN:
+            span("B", 1, COMMAND_NAMES.get(a8, f"0x{a8:02X}"), ts, {"payload": a16})
+        elif kind == TRACE_DISPATCH_END:
+            span("E", 1, COMMAND_NAMES.get(a8, f"0x{a8:02X}"), ts)
+        elif kind == TRACE_ISP_BEGIN:
+            span("B", 2, "ISP", ts, {"instructions": a16})
+        elif kind == TRACE_ISP_END:
+            span("E", 2, "ISP", ts)
+        elif kind == TRACE_WAIT_BEGIN:
+            span("B", 3, "busy", ts)
+        elif kind == TRACE_WAIT_END:
+            span("E", 3, "busy", ts, {"ok": bool(a8)})
+        elif kind == TRACE_RX:
+            instant(1, "rx", ts, {"bytes": a16})
+        elif kind == TRACE_FLUSH:
+            instant(1, "flush", ts)
+        elif kind == TRACE_NOSYNC:
+            instant(1, "NOSYNC", ts)
+        elif kind == TRACE_POLL:
+            instant(2, "poll", ts, {"busy": bool(a8)})
+    return {"traceEvents": out, "displayTimeUnit": "ms"}
@@ -0,0 +1,431 @@
+/**
+ * @file updi.c
+ * @brief UPDI Link, Access Layer and NVM Controller Implementation
+ *
+ * Layers:
+ *   - Link: UART1 in 8E2 with echo removal and per-byte timeouts
+ *   - Access: LDS/STS, LD/ST through the pointer register, LDCS/STCS,
+ *     REPEAT and KEY instructions
+ *   - NVM: NVMCTRL (0x1000) page buffer clear, write page, chip erase
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "updi.h"
+#include "avr_devices.h"
+#include <string.h>
+#include <pico/stdlib.h>
+#include "hardware/uart.h"
+
+#define UPDI_UART        uart1
+
+/*******************************************************************************
+ * UPDI Instruction Set
+ ******************************************************************************/
+#define UPDI_SYNC        0x55
+#define UPDI_ACK         0x40
+
+#define UPDI_LDS         0x00
+#define UPDI_STS         0x40
+#define UPDI_LD          0x20
+#define UPDI_ST          0x60
+#define UPDI_LDCS        0x80
+#define UPDI_STCS        0xC0
+#define UPDI_REPEAT      0xA0
+#define UPDI_KEY         0xE0
+
+#define UPDI_ADDR_16     0x04   /* LDS/STS address size: 16 bit */
+#define UPDI_DATA_8      0x00
+#define UPDI_PTR_INC     0x04   /* LD/ST *(ptr++) */
+#define UPDI_PTR_ADDR    0x08   /* LD/ST ptr (pointer register itself) */
+#define UPDI_PTR_16      0x01   /* Pointer write: 16-bit address */
+
+/* Control/status registers */
+#define UPDI_CS_STATUSA         0x00
+#define UPDI_CS_CTRLA           0x02
+#define UPDI_CS_CTRLB           0x03
+#define UPDI_ASI_KEY_STATUS     0x07
+#define UPDI_ASI_RESET_REQ      0x08
+#define UPDI_ASI_CTRLA          0x09
+#define UPDI_ASI_SYS_STATUS     0x0B
+
+#define UPDI_CTRLA_IBDLY        0x80
+#define UPDI_CTRLA_RSD          0x08
+#define UPDI_CTRLB_UPDIDIS      0x04
+#define UPDI_CTRLB_CCDETDIS     0x08
+#define UPDI_KEY_NVMPROG        0x10
+#define UPDI_SYS_LOCKSTATUS     0x01
+#define UPDI_SYS_NVMPROG        0x08
+#define UPDI_RESET_SIGNATURE    0x59
+#define UPDI_CLKSEL_16M         0x01
+
+/** NVM programming key "NVMProg ", sent least significant byte first */
+static const uint8_t key_nvmprog[8] = {' ', 'g', 'o', 'r', 'P', 'M', 'V', 'N'};
+
+/* NVMCTRL (version 0) */
+#define NVMCTRL_BASE            0x1000
+#define NVMCTRL_CTRLA           (NVMCTRL_BASE + 0x00)
+#define NVMCTRL_STATUS          (NVMCTRL_BASE + 0x02)
+#define NVMCTRL_STATUS_BUSY     0x03    /* FBUSY | EEBUSY */
+#define NVMCTRL_STATUS_WRERROR  0x04
+
+#define NVM_CMD_WP              0x01    /* Write page buffer to memory */
+#define NVM_CMD_PBC             0x04    /* Page buffer clear */
+#define NVM_CMD_CHER            0x05    /* Chip erase */
+
+/* Data space */
+#define UPDI_ADDR_SIGROW        0x1100
+#define UPDI_ADDR_LOCKBIT       0x128A
+#define UPDI_FLASH_TINY         0x8000
+#define UPDI_FLASH_MEGA0        0x4000
+
+#define UPDI_MAX_BURST          256     /* REPEAT count is one byte (n - 1) */
+#define UPDI_NVM_TIMEOUT_US     50000
+
+/*******************************************************************************
+ * Private Variables
+ ******************************************************************************/
+static uint32_t high_baud = UPDI_HIGH_BAUD;
+static uint32_t baud = UPDI_BAUD;
+static uint32_t byte_timeout_us = 1000;
+static uint16_t flash_base = UPDI_FLASH_TINY;
+static bool link_error = false;
+
+/*******************************************************************************
+ * Link Layer
+ ******************************************************************************/
+
+static void set_baud(uint32_t rate) {
+    baud = uart_set_baudrate(UPDI_UART, rate);
+    /* The 128-bit default guard time before a reply, four character times
+     * (12 bits each) and turnaround slack */
+    byte_timeout_us = (uint32_t)((128u + 48u) * 1000000u / baud) + 200u;
+}
+
+static void drain_rx(void) {
+    while (uart_is_readable(UPDI_UART)) {
+        (void)uart_getc(UPDI_UART);
+    }
+}
+
+static bool read_byte(uint8_t* out) {
+    if (!uart_is_readable_within_us(UPDI_UART, byte_timeout_us)) {
+        link_error = true;
+        return false;
+    }
+    *out = (uint8_t)uart_getc(UPDI_UART);
+    return true;
+}
+
+/**
+ * @brief Send bytes and swallow their echo
+ *
+ * Bytes go out in blocks that fit the 32-entry RX FIFO, so the line stays
+ * busy while echoes are collected.
+ */
+static void updi_send(const uint8_t* data, size_t len) {
+    while (len > 0 && !link_error) {
+        size_t n = len < 16 ? len : 16;
+        uart_write_blocking(UPDI_UART, data, n);
+        for (size_t i = 0; i < n; i++) {
+            uint8_t echo;
+            if (!read_byte(&echo) || echo != data[i]) {
+                link_error = true;
+                return;
+            }
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+static void updi_recv(uint8_t* out, size_t len) {
+    for (size_t i = 0; i < len && !link_error; i++) {
+        read_byte(&out[i]);
+    }
+}
+
+static void expect_ack(void) {
+    uint8_t ack = 0;
+    if (!read_byte(&ack) || ack != UPDI_ACK) {
+        link_error = true;
+    }
+}
+
+/** Hold the line low for longer than two frames at the slowest rate */
+static void double_break(void) {
+    for (int i = 0; i < 2; i++) {
+        uart_set_break(UPDI_UART, true);
+        sleep_ms(25);
+        uart_set_break(UPDI_UART, false);
+        sleep_ms(1);
+    }
+    drain_rx();
+}
+
+/*******************************************************************************
+ * Access Layer
+ ******************************************************************************/
+
+static uint8_t ldcs(uint8_t reg) {
+    uint8_t frame[2] = {UPDI_SYNC, (uint8_t)(UPDI_LDCS | reg)};
+    uint8_t v = 0;
+    updi_send(frame, sizeof(frame));
+    updi_recv(&v, 1);
+    return v;
+}
+
+static void stcs(uint8_t reg, uint8_t value) {
+    uint8_t frame[3] = {UPDI_SYNC, (uint8_t)(UPDI_STCS | reg), value};
+    updi_send(frame, sizeof(frame));
+}
+
+static uint8_t lds8(uint16_t addr) {
+    uint8_t frame[4] = {UPDI_SYNC, UPDI_LDS | UPDI_ADDR_16 | UPDI_DATA_8,
+                        (uint8_t)addr, (uint8_t)(addr >> 8)};
+    uint8_t v = 0;
+    updi_send(frame, sizeof(frame));
+    updi_recv(&v, 1);
+    return v;
+}
+
+static void sts8(uint16_t addr, uint8_t value) {
+    uint8_t frame[4] = {UPDI_SYNC, UPDI_STS | UPDI_ADDR_16 | UPDI_DATA_8,
+                        (uint8_t)addr, (uint8_t)(addr >> 8)};
+    updi_send(frame, sizeof(frame));
+    expect_ack();
+    updi_send(&value, 1);
+    expect_ack();
+}
+
+static void set_pointer(uint16_t addr) {
+    uint8_t frame[4] = {UPDI_SYNC, UPDI_ST | UPDI_PTR_ADDR | UPDI_PTR_16,
+                        (uint8_t)addr, (uint8_t)(addr >> 8)};
+    updi_send(frame, sizeof(frame));
+    expect_ack();
+}
+
+static void repeat(size_t count) {
+    uint8_t frame[3] = {UPDI_SYNC, UPDI_REPEAT, (uint8_t)(count - 1)};
+    updi_send(frame, sizeof(frame));
+}
+
+/** Store up to 256 bytes with REPEAT + ST *(ptr++), ACKs disabled */
+static void burst_store(uint16_t addr, const uint8_t* data, size_t len) {
+    static const uint8_t st_inc[2] = {UPDI_SYNC, UPDI_ST | UPDI_PTR_INC | UPDI_DATA_8};
+    set_pointer(addr);
+    stcs(UPDI_CS_CTRLA, UPDI_CTRLA_IBDLY | UPDI_CTRLA_RSD);
+    repeat(len);
+    updi_send(st_inc, sizeof(st_inc));
+    updi_send(data, len);
+    stcs(UPDI_CS_CTRLA, UPDI_CTRLA_IBDLY);
+}
+
+/** Load up to 256 bytes with REPEAT + LD *(ptr++) */
+static void burst_load(uint16_t addr, uint8_t* out, size_t len) {
+    static const uint8_t ld_inc[2] = {UPDI_SYNC, UPDI_LD | UPDI_PTR_INC | UPDI_DATA_8};
+    set_pointer(addr);
+    repeat(len);
+    updi_send(ld_inc, sizeof(ld_inc));
+    updi_recv(out, len);
+}
+
+static void send_key(const uint8_t key[8]) {
+    uint8_t frame[2] = {UPDI_SYNC, UPDI_KEY};
+    updi_send(frame, sizeof(frame));
+    updi_send(key, 8);
+}
+
+/*******************************************************************************
+ * NVM Controller
+ ******************************************************************************/
+
+static bool nvm_wait(uint32_t timeout_us) {
+    absolute_time_t deadline = make_timeout_time_us(timeout_us);
+    for (;;) {
+        uint8_t status = lds8(NVMCTRL_STATUS);
+        if (link_error || (status & NVMCTRL_STATUS_WRERROR)) {
+            return false;
+        }
+        if (!(status & NVMCTRL_STATUS_BUSY)) {
+            return true;
+        }
+        if (time_reached(deadline)) {
+            return false;
+        }
+    }
+}
+
+static void nvm_command(uint8_t cmd) {
+    nvm_wait(UPDI_NVM_TIMEOUT_US);
+    sts8(NVMCTRL_CTRLA, cmd);
+}
+
+/*******************************************************************************
+ * Interface Operations
+ ******************************************************************************/
+
+static void updi_leave(void);
+
+/**
+ * @brief Switch the UPDI clock to 16 MHz and the UART to high_baud
+ *
+ * Falls back to the connection rate if the target stops answering.
+ */
+static void raise_baud(void) {
+    if (high_baud <= UPDI_BAUD) {
+        return;
+    }
+    stcs(UPDI_ASI_CTRLA, UPDI_CLKSEL_16M);
+    set_baud(high_baud);
+    if (ldcs(UPDI_CS_STATUSA) != 0 && !link_error) {
+        return;
+    }
+
+    /* Target did not follow - resynchronize at the safe rate */
+    link_error = false;
+    set_baud(UPDI_BAUD);
+    uart_set_break(UPDI_UART, true);
+    sleep_ms(25);
+    uart_set_break(UPDI_UART, false);
+    drain_rx();
+}
+
+/**
+ * @brief Connect over UPDI and enter NVM programming mode
+ *
+ * Sequence: double BREAK, link setup (collision detection off, inter-byte
+ * delay on), NVMProg key, system reset, wait for ASI_SYS_STATUS.NVMPROG.
+ */
+static bool updi_enter(void) {
+    uart_init(UPDI_UART, UPDI_BAUD);
+    uart_set_format(UPDI_UART, 8, 2, UART_PARITY_EVEN);
+    uart_set_hw_flow(UPDI_UART, false, false);
+    uart_set_fifo_enabled(UPDI_UART, true);
+    gpio_set_function(UPDI_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(UPDI_RX_PIN, GPIO_FUNC_UART);
+    gpio_pull_up(UPDI_RX_PIN);
+    set_baud(UPDI_BAUD);
+
+    link_error = false;
+    double_break();
+
+    stcs(UPDI_CS_CTRLB, UPDI_CTRLB_CCDETDIS);
+    stcs(UPDI_CS_CTRLA, UPDI_CTRLA_IBDLY);
+    if (ldcs(UPDI_CS_STATUSA) == 0 || link_error) {
+        updi_leave();
+        return false;
+    }
+
+    send_key(key_nvmprog);
+    if (!(ldcs(UPDI_ASI_KEY_STATUS) & UPDI_KEY_NVMPROG)) {
+        updi_leave();
+        return false;
+    }
+
+    stcs(UPDI_ASI_RESET_REQ, UPDI_RESET_SIGNATURE);
+    stcs(UPDI_ASI_RESET_REQ, 0x00);
+
+    absolute_time_t deadline = make_timeout_time_us(UPDI_NVM_TIMEOUT_US);
+    uint8_t sys;
+    while (!((sys = ldcs(UPDI_ASI_SYS_STATUS)) & UPDI_SYS_NVMPROG)) {
+        if (link_error || (sys & UPDI_SYS_LOCKSTATUS) || time_reached(deadline)) {
+            updi_leave();
+            return false;
+        }
+    }
+
+    raise_baud();
+
+    /* megaAVR 0 maps flash at 0x4000, tinyAVR at 0x8000 */
+    uint8_t sig[3];
+    burst_load(UPDI_ADDR_SIGROW, sig, sizeof(sig));
+    const avr_device_t* dev = avr_lookup_device_by_signature(sig);
+    flash_base = (dev && strncmp(dev->name, "ATmega", 6) == 0) ? UPDI_FLASH_MEGA0 : UPDI_FLASH_TINY;
+    return !link_error;
+}
+
+/**
+ * @brief Reset the target out of programming mode and disable UPDI
+ */
+static void updi_leave(void) {
+    link_error = false;
+    stcs(UPDI_ASI_RESET_REQ, UPDI_RESET_SIGNATURE);
+    stcs(UPDI_ASI_RESET_REQ, 0x00);
+    stcs(UPDI_CS_CTRLB, UPDI_CTRLB_UPDIDIS | UPDI_CTRLB_CCDETDIS);
+    uart_deinit(UPDI_UART);
+    gpio_init(UPDI_TX_PIN);
+    gpio_init(UPDI_RX_PIN);
+}
+
+/**
+ * @brief Emulate the ISP instructions that have a UPDI equivalent
+ *
+ * Signature and lock byte reads and chip erase; everything else reads 0.
+ */
+static void updi_universal(const uint8_t cmd[4], uint8_t rx[4]) {
+    rx[0] = rx[1] = rx[2] = rx[3] = 0;
+    switch (cmd[0]) {
+        case 0x30: rx[3] = lds8(UPDI_ADDR_SIGROW + (cmd[2] & 0x03)); break;
+        case 0x58: rx[3] = cmd[1] == 0x00 ? lds8(UPDI_ADDR_LOCKBIT) : 0; break;
+        case 0xAC:
+            if (cmd[1] == 0x80) {
+                avr_iface_updi.chip_erase();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static bool updi_poll_ready(uint32_t timeout_us) {
+    return nvm_wait(timeout_us);
+}
+
+static void updi_chip_erase(void) {
+    nvm_command(NVM_CMD_CHER);
+    nvm_wait(UPDI_NVM_TIMEOUT_US);
+}
+
+/**
+ * @brief Clear the page buffer, burst-load it and write the page
+ */
+static void updi_write_flash_page(uint32_t byte_addr, const uint8_t* data, size_t len) {
+    nvm_command(NVM_CMD_PBC);
+    for (size_t off = 0; off < len; off += UPDI_MAX_BURST) {
+        size_t n = len - off < UPDI_MAX_BURST ? len - off : UPDI_MAX_BURST;
+        burst_store((uint16_t)(flash_base + byte_addr + off), data + off, n);
+    }
+    nvm_command(NVM_CMD_WP);
+    nvm_wait(UPDI_NVM_TIMEOUT_US);
+}
+
+static void updi_read_flash(uint32_t byte_addr, uint8_t* out, size_t len) {
+    for (size_t off = 0; off < len; off += UPDI_MAX_BURST) {
+        size_t n = len - off < UPDI_MAX_BURST ? len - off : UPDI_MAX_BURST;
+        burst_load((uint16_t)(flash_base + byte_addr + off), out + off, n);
+    }
+}
+
+const avr_iface_t avr_iface_updi = {
+    .name = "UPDI",
+    .enter = updi_enter,
+    .leave = updi_leave,
+    .universal = updi_universal,
+    .poll_ready = updi_poll_ready,
+    .chip_erase = updi_chip_erase,
+    .write_flash_page = updi_write_flash_page,
+    .read_flash = updi_read_flash,
+};
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+
+/**
+ * @brief Set the baud rate used after the high-speed switch
+ */
+void updi_set_high_baud(uint32_t rate) {
+    high_baud = rate ? rate : UPDI_BAUD;
+}
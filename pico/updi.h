@@ -0,0 +1,69 @@
+/**
+ * @file updi.h
+ * @brief Unified Program and Debug Interface (UPDI) for tinyAVR 0/1/2 and megaAVR 0
+ *
+ * UPDI is a half-duplex asynchronous link on a single pin. We run it on
+ * RP2040 UART1 with TX and RX joined onto the UPDI line, so every byte we
+ * send is also received and has to be discarded as echo.
+ *
+ * Wiring:
+ *   - GPIO 4 (UART1 TX) -> 1 kOhm -> UPDI
+ *   - GPIO 5 (UART1 RX) ---------> UPDI
+ *
+ * Link Format:
+ *   - 8 data bits, even parity, 2 stop bits (8E2)
+ *   - Every instruction starts with SYNC (0x55), which the target uses to
+ *     measure the baud rate, so no explicit baud negotiation is needed
+ *   - A double BREAK resets the target's UPDI state machine
+ *
+ * Speed:
+ *   - Connection starts at UPDI_BAUD (safe at the 4 MHz default UPDI clock)
+ *   - After the NVM key is accepted, the UPDI clock is raised to 16 MHz
+ *     (ASI_CTRLA.UPDICLKSEL) and the UART switched to UPDI_HIGH_BAUD; if
+ *     the target does not answer at the new rate we fall back
+ *   - Page loads and reads use REPEAT + ST/LD *(ptr++) bursts; during
+ *     loads the ACK after each byte is disabled (CTRLA.RSD)
+ *
+ * Scope: NVMCTRL version 0 parts (tinyAVR 0/1/2, megaAVR 0). Locked parts
+ * must be unlocked with a chip erase by another tool first.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "avr_iface.h"
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+#ifndef UPDI_TX_PIN
+#define UPDI_TX_PIN      4
+#endif
+
+#ifndef UPDI_RX_PIN
+#define UPDI_RX_PIN      5
+#endif
+
+/** Baud rate used while connecting (UPDI clock 4 MHz) */
+#ifndef UPDI_BAUD
+#define UPDI_BAUD        115200
+#endif
+
+/** Baud rate after switching the UPDI clock to 16 MHz (max ~0.9 Mbit/s) */
+#ifndef UPDI_HIGH_BAUD
+#define UPDI_HIGH_BAUD   460800
+#endif
+
+/**
+ * @brief Set the baud rate used after the high-speed switch
+ *
+ * @param baud Baud rate, 0 to stay at UPDI_BAUD
+ */
+void updi_set_high_baud(uint32_t baud);
+
+/** UPDI implementation of the programming interface operations */
+extern const avr_iface_t avr_iface_updi;
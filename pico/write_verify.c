@@ -0,0 +1,184 @@
+/**
+ * @file write_verify.c
+ * @brief Inline Verify-after-write with Page Retry
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "write_verify.h"
+#include "avr_iface.h"
+#include "avrprog.h"
+#include "metrics.h"
+#include <string.h>
+
+/*******************************************************************************
+ * State
+ ******************************************************************************/
+
+static bool enabled;
+static uint16_t page_bytes = 128;
+
+static uint8_t bad_map[WRITE_VERIFY_MAX_PAGES / 8];
+static size_t map_bytes;        /* Bytes up to the last marked page */
+
+static uint32_t retried_count;
+static uint32_t failed_count;
+
+/** Queued page waiting for its write to complete */
+static uint8_t deferred[WRITE_VERIFY_PAGE_BYTES];
+static uint32_t deferred_addr;
+static size_t deferred_len;
+static bool deferred_waiting;   /* Write still queued */
+static bool deferred_ready;     /* Write completed, check due */
+static bool deferred_ok;
+
+/*******************************************************************************
+ * Checks
+ ******************************************************************************/
+
+/** Compare target flash against data */
+static bool matches(uint32_t byte_addr, const uint8_t* data, size_t len) {
+    /* ISP parts within the 16-bit word range: batched readback */
+    if (avr_iface_selected() == AVR_IFACE_ISP && byte_addr / 2 + len / 2 <= 0x10000) {
+        uint16_t words[WRITE_VERIFY_PAGE_BYTES / 2];
+        for (size_t i = 0; i < len / 2; i++) {
+            words[i] = (uint16_t)(data[i * 2] | data[i * 2 + 1] << 8);
+        }
+        return avr_verify_program_memory_page((uint16_t)(byte_addr / 2), words, len / 2);
+    }
+
+    uint8_t chunk[64];
+    for (size_t off = 0; off < len; off += sizeof(chunk)) {
+        size_t n = len - off < sizeof(chunk) ? len - off : sizeof(chunk);
+        avr_iface()->read_flash(byte_addr + (uint32_t)off, chunk, n);
+        if (memcmp(chunk, data + off, n) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Halve SCK for the next attempt (ISP only) */
+static void slow_down(void) {
+    if (avr_iface_selected() != AVR_IFACE_ISP) {
+        return;
+    }
+    uint32_t hz = avr_get_sck_frequency() / 2;
+    avr_set_sck_frequency(hz > WRITE_VERIFY_MIN_SCK_HZ ? hz : WRITE_VERIFY_MIN_SCK_HZ);
+}
+
+static void mark_bad(uint32_t byte_addr) {
+    uint32_t page = byte_addr / page_bytes;
+    failed_count++;
+    if (page >= WRITE_VERIFY_MAX_PAGES) {
+        return;     /* Still counted; the write fails either way */
+    }
+    bad_map[page / 8] |= (uint8_t)(1u << (page % 8));
+    if (page / 8 + 1 > map_bytes) {
+        map_bytes = page / 8 + 1;
+    }
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/**
+ * @brief Enable or disable inline verify
+ */
+void write_verify_enable(bool on) {
+    enabled = on;
+}
+
+/**
+ * @brief Check whether inline verify is enabled
+ */
+bool write_verify_enabled(void) {
+    return enabled;
+}
+
+/**
+ * @brief Clear the bitmap and counters for a new session
+ */
+void write_verify_reset(uint16_t page) {
+    page_bytes = page ? page : 128;
+    memset(bad_map, 0, sizeof(bad_map));
+    map_bytes = 0;
+    retried_count = 0;
+    failed_count = 0;
+    deferred_waiting = false;
+    deferred_ready = false;
+}
+
+/**
+ * @brief Verify a page written synchronously, retrying if needed
+ */
+bool write_verify_page(uint32_t byte_addr, const uint8_t* data, size_t len, bool write_ok) {
+    if (write_ok && matches(byte_addr, data, len)) {
+        return true;
+    }
+    for (int attempt = 0; attempt < WRITE_VERIFY_RETRIES; attempt++) {
+        slow_down();
+        metrics_add(METRIC_RETRIES, 1);
+        avr_iface()->write_flash_page(byte_addr, data, len);
+        if (matches(byte_addr, data, len)) {
+            retried_count++;
+            return true;
+        }
+    }
+    mark_bad(byte_addr);
+    return false;
+}
+
+/**
+ * @brief Remember a queued page write for a check once it completes
+ */
+void write_verify_defer(uint32_t byte_addr, const uint8_t* data, size_t len) {
+    if (len > sizeof(deferred)) {
+        len = sizeof(deferred);
+    }
+    memcpy(deferred, data, len);
+    deferred_addr = byte_addr;
+    deferred_len = len;
+    deferred_waiting = true;
+    deferred_ready = false;
+}
+
+/**
+ * @brief Report the completion of the deferred page's write
+ */
+void write_verify_complete(bool ok) {
+    if (deferred_waiting) {
+        deferred_waiting = false;
+        deferred_ready = true;
+        deferred_ok = ok;
+    }
+}
+
+/**
+ * @brief Check the deferred page if its write has completed
+ */
+bool write_verify_run_deferred(void) {
+    if (!deferred_ready) {
+        return true;
+    }
+    deferred_ready = false;
+    return write_verify_page(deferred_addr, deferred, deferred_len, deferred_ok);
+}
+
+/**
+ * @brief Get the bitmap of unrecoverable pages
+ */
+const uint8_t* write_verify_map(size_t* bytes) {
+    *bytes = map_bytes;
+    return bad_map;
+}
+
+/**
+ * @brief Get counters since the last reset
+ */
+void write_verify_stats(uint32_t* retried, uint32_t* failed) {
+    *retried = retried_count;
+    *failed = failed_count;
+}
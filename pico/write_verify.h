@@ -0,0 +1,114 @@
+/**
+ * @file write_verify.h
+ * @brief Inline Verify-after-write with Page Retry
+ *
+ * Without it, a page that did not program correctly is only noticed by
+ * the host's readback pass after the whole upload. With inline verify
+ * enabled (Parm_VND_VERIFY), every flash page is read back as soon as its
+ * write has completed. For queued writes that happens from the main loop
+ * while the next PROG_PAGE frame is still arriving over USB.
+ *
+ * Retry:
+ *   A page that reads back wrong (or whose write reported a failure) is
+ *   written again, up to WRITE_VERIFY_RETRIES times. On ISP each retry
+ *   first halves SCK, down to WRITE_VERIFY_MIN_SCK_HZ; the slower rate is
+ *   kept for the rest of the session. A page write can only clear bits,
+ *   so a page with bits cleared that should be set stays bad until the
+ *   next chip erase.
+ *
+ * Reporting:
+ *   Pages still wrong after the retries are marked in a bitmap (bit n of
+ *   byte n / 8 = page n, LSB first) read with Cmnd_STK_VERIFY_MAP, and
+ *   fail the next PROG_PAGE or LEAVE_PROGMODE. A session that ends
+ *   without failure has verified every page, so the host can skip its
+ *   own verify pass.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Rewrites per page before it is reported */
+#define WRITE_VERIFY_RETRIES     2
+
+/** Slowest SCK rate retries step down to */
+#define WRITE_VERIFY_MIN_SCK_HZ  50000
+
+/** Largest page index the bitmap can record */
+#define WRITE_VERIFY_MAX_PAGES   2048
+
+/** Largest page that can wait for a deferred check */
+#define WRITE_VERIFY_PAGE_BYTES  256
+
+/**
+ * @brief Enable or disable inline verify
+ */
+void write_verify_enable(bool on);
+
+/**
+ * @brief Check whether inline verify is enabled
+ */
+bool write_verify_enabled(void);
+
+/**
+ * @brief Clear the bitmap and counters for a new session
+ *
+ * @param page_bytes Flash page size of the target (bitmap granularity)
+ */
+void write_verify_reset(uint16_t page_bytes);
+
+/**
+ * @brief Verify a page written synchronously, retrying if needed
+ *
+ * @param byte_addr Start address in bytes
+ * @param data      Bytes that were written
+ * @param len       Number of bytes (whole words)
+ * @param write_ok  false if the write itself reported a failure
+ * @return false if the page is still wrong after the retries
+ */
+bool write_verify_page(uint32_t byte_addr, const uint8_t* data, size_t len, bool write_ok);
+
+/**
+ * @brief Remember a queued page write for a check once it completes
+ *
+ * Holds one page; run write_verify_run_deferred() before queuing the next.
+ */
+void write_verify_defer(uint32_t byte_addr, const uint8_t* data, size_t len);
+
+/**
+ * @brief Report the completion of the deferred page's write
+ *
+ * @param ok false if the queued write failed
+ */
+void write_verify_complete(bool ok);
+
+/**
+ * @brief Check the deferred page if its write has completed
+ *
+ * Does nothing while the write is still queued or no page is deferred.
+ *
+ * @return true if the page verified (or nothing was due), false if it is
+ *         still wrong after the retries
+ */
+bool write_verify_run_deferred(void);
+
+/**
+ * @brief Get the bitmap of unrecoverable pages
+ *
+ * @param bytes Receives the bitmap length up to the last marked page
+ * @return Bitmap (bit n of byte n / 8 = page n)
+ */
+const uint8_t* write_verify_map(size_t* bytes);
+
+/**
+ * @brief Get counters since the last reset
+ *
+ * @param retried Pages that verified after one or more rewrites
+ * @param failed  Pages that did not
+ */
+void write_verify_stats(uint32_t* retried, uint32_t* failed);
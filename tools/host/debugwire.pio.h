@@ -0,0 +1,42 @@
+/**
+ * @file debugwire.pio.h
+ * @brief Host Stand-in for the pioasm Output of debugwire.pio
+ *
+ * Same programs (lengths only) and init helpers; the state machines get
+ * the debugWIRE roles of host_dw.c instead of running the instructions.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <hardware/pio.h>
+#include "host_phy.h"
+
+static const uint16_t dw_tx_program_instructions[4];
+static const uint16_t dw_rx_program_instructions[8];
+
+static const pio_program_t dw_tx_program = {
+    .instructions = dw_tx_program_instructions,
+    .length = 4,
+    .origin = -1,
+};
+
+static const pio_program_t dw_rx_program = {
+    .instructions = dw_rx_program_instructions,
+    .length = 8,
+    .origin = -1,
+};
+
+static inline void dw_tx_program_init(PIO pio, uint sm, uint offset, uint pin, float clkdiv) {
+    (void)offset;
+    pio_gpio_init(pio, pin);
+    gpio_pull_up(pin);
+    host_pio_sm_init(pio, sm, &host_pio_dw_tx, pin, clkdiv);
+}
+
+static inline void dw_rx_program_init(PIO pio, uint sm, uint offset, uint pin, float clkdiv) {
+    (void)offset;
+    host_pio_sm_init(pio, sm, &host_pio_dw_rx, pin, clkdiv);
+}
@@ -0,0 +1,22 @@
+/**
+ * @file clocks.h
+ * @brief Host Stand-in for hardware/clocks.h
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+enum clock_index {
+    clk_sys = 5,
+    clk_peri = 6,
+};
+
+/** The default 125 MHz system clock (clk_peri runs from it) */
+static inline uint32_t clock_get_hz(enum clock_index clk) {
+    (void)clk;
+    return 125000000u;
+}
@@ -0,0 +1,21 @@
+/**
+ * @file flash.h
+ * @brief Host Stand-in for hardware/flash.h
+ *
+ * Erase and program act on host_xip_flash with the real NOR rules
+ * (erase to 0xFF, programming only clears bits).
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FLASH_SECTOR_SIZE   4096u
+#define FLASH_PAGE_SIZE     256u
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count);
@@ -0,0 +1,84 @@
+/**
+ * @file pio.h
+ * @brief Host Stand-in for hardware/pio.h (state machines in host_pio.c)
+ *
+ * Program memory and state machine claims behave like the SDK's. What a
+ * state machine does is modelled per program rather than per
+ * instruction: each *_program_init() stand-in (e.g. host/debugwire.pio.h)
+ * gives its state machine a role from host_phy.h, which times the FIFOs
+ * and the pins. FIFO and register accesses cost bus cycles.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pico/stdlib.h>
+
+typedef struct pio_inst* PIO;
+
+#define pio0 ((PIO)1)
+
+#define HOST_PIO_SMS            4u
+#define HOST_PIO_INSTRUCTIONS   32u
+
+typedef struct {
+    const uint16_t* instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+/** Sources and destinations of SET and MOV (the values are the instruction's field) */
+enum pio_src_dest {
+    pio_pins = 0,
+    pio_x = 1,
+    pio_y = 2,
+    pio_pindirs = 4,
+    pio_isr = 6,
+    pio_osr = 7,
+};
+
+bool pio_can_add_program(PIO pio, const pio_program_t* program);
+uint pio_add_program(PIO pio, const pio_program_t* program);
+void pio_remove_program(PIO pio, const pio_program_t* program, uint loaded_offset);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_unclaim(PIO pio, uint sm);
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+void pio_sm_exec(PIO pio, uint sm, uint instr);
+
+void pio_sm_restart(PIO pio, uint sm);
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+uint32_t pio_sm_get(PIO pio, uint sm);
+
+void pio_gpio_init(PIO pio, uint pin);
+
+static inline uint pio_encode_jmp(uint addr) {
+    return addr & 0x1Fu;
+}
+
+static inline uint pio_encode_pull(bool if_empty, bool block) {
+    return 0x8080u | (if_empty ? 0x40u : 0u) | (block ? 0x20u : 0u);
+}
+
+static inline uint pio_encode_mov(enum pio_src_dest dest, enum pio_src_dest src) {
+    return 0xA000u | ((uint)dest << 5) | (uint)src;
+}
+
+static inline uint pio_encode_set(enum pio_src_dest dest, uint value) {
+    return 0xE000u | ((uint)dest << 5) | (value & 0x1Fu);
+}
+
+/** Side-set field for an instruction (OR it in) */
+static inline uint pio_encode_sideset(uint sideset_bit_count, uint value) {
+    return value << (13u - sideset_bit_count);
+}
@@ -0,0 +1,24 @@
+/**
+ * @file pwm.h
+ * @brief Host Stand-in for hardware/pwm.h (no-ops)
+ *
+ * The simulated target has its own clock, so the target clock output
+ * only matters for the ISP rate target_clock.c derives from it.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pico/stdlib.h>
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) { return (gpio >> 1) & 7u; }
+static inline void pwm_set_clkdiv_int_frac(uint slice, uint8_t integer, uint8_t fract) {
+    (void)slice; (void)integer; (void)fract;
+}
+static inline void pwm_set_wrap(uint slice, uint16_t wrap) { (void)slice; (void)wrap; }
+static inline void pwm_set_gpio_level(uint gpio, uint16_t level) { (void)gpio; (void)level; }
+static inline void pwm_set_enabled(uint slice, bool enabled) { (void)slice; (void)enabled; }
@@ -0,0 +1,41 @@
+/**
+ * @file spi.h
+ * @brief Host Stand-in for hardware/spi.h (PL022 model in host_isp.c)
+ *
+ * Frames shift at the rate spi_set_baudrate() really gets from clk_peri
+ * and clock the simulated target bit by bit. The status calls cost bus
+ * cycles like the register reads they stand for. dr is read and written
+ * through spi_get_hw(spi0)->dr, each access on a fresh spi_get_hw() call,
+ * which is how host_isp.c tells reads from writes.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pico/stdlib.h>
+
+typedef struct spi_inst spi_inst_t;
+
+typedef struct {
+    volatile uint32_t dr;
+} spi_hw_t;
+
+#define spi0 ((spi_inst_t*)1)
+
+typedef enum { SPI_CPOL_0 = 0, SPI_CPOL_1 = 1 } spi_cpol_t;
+typedef enum { SPI_CPHA_0 = 0, SPI_CPHA_1 = 1 } spi_cpha_t;
+typedef enum { SPI_LSB_FIRST = 0, SPI_MSB_FIRST = 1 } spi_order_t;
+
+uint spi_init(spi_inst_t* spi, uint baudrate);
+uint spi_set_baudrate(spi_inst_t* spi, uint baudrate);
+void spi_set_format(spi_inst_t* spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha,
+                    spi_order_t order);
+int spi_write_read_blocking(spi_inst_t* spi, const uint8_t* src, uint8_t* dst, size_t len);
+spi_hw_t* spi_get_hw(spi_inst_t* spi);
+bool spi_is_writable(const spi_inst_t* spi);
+bool spi_is_readable(const spi_inst_t* spi);
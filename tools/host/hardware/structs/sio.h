@@ -0,0 +1,26 @@
+/**
+ * @file sio.h
+ * @brief Host Stand-in for hardware/structs/sio.h
+ *
+ * sio_hw is a call, so every access can be timed: it applies the
+ * gpio_set/gpio_clr writes of the previous access to host_sim.c's pins,
+ * costs HOST_SIO_CYCLES and refreshes gpio_in.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t gpio_in;
+    volatile uint32_t gpio_out;
+    volatile uint32_t gpio_set;
+    volatile uint32_t gpio_clr;
+} sio_hw_t;
+
+sio_hw_t* host_sio_access(void);
+
+#define sio_hw (host_sio_access())
@@ -0,0 +1,27 @@
+/**
+ * @file systick.h
+ * @brief Host Stand-in for hardware/structs/systick.h
+ *
+ * systick_hw is a call that refreshes cvr from the simulated clock: a
+ * free-running 24-bit down-counter at the system clock. Writes are
+ * ignored, which the firmware's (start - end) & 0xFFFFFF differences do
+ * not notice.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t rvr;
+    volatile uint32_t cvr;
+    volatile uint32_t calib;
+} systick_hw_t;
+
+systick_hw_t* host_systick(void);
+
+#define systick_hw (host_systick())
@@ -0,0 +1,14 @@
+/**
+ * @file sync.h
+ * @brief Host Stand-in for hardware/sync.h
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+static inline uint32_t save_and_disable_interrupts(void) { return 0; }
+static inline void restore_interrupts(uint32_t status) { (void)status; }
@@ -0,0 +1,41 @@
+/**
+ * @file uart.h
+ * @brief Host Stand-in for hardware/uart.h (PL011 model in host_updi.c)
+ *
+ * Only UART1 exists, wired with TX and RX joined onto the simulated UPDI
+ * line. Frames take the time of the rate uart_set_baudrate() really gets
+ * from clk_peri; received bytes (echo and target replies) become readable
+ * when their stop bits are done. Waiting calls move the simulated clock.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pico/stdlib.h>
+
+typedef struct uart_inst uart_inst_t;
+
+#define uart1 ((uart_inst_t*)1)
+
+typedef enum {
+    UART_PARITY_NONE,
+    UART_PARITY_EVEN,
+    UART_PARITY_ODD,
+} uart_parity_t;
+
+uint uart_init(uart_inst_t* uart, uint baudrate);
+void uart_deinit(uart_inst_t* uart);
+uint uart_set_baudrate(uart_inst_t* uart, uint baudrate);
+void uart_set_format(uart_inst_t* uart, uint data_bits, uint stop_bits, uart_parity_t parity);
+void uart_set_hw_flow(uart_inst_t* uart, bool cts, bool rts);
+void uart_set_fifo_enabled(uart_inst_t* uart, bool enabled);
+void uart_set_break(uart_inst_t* uart, bool en);
+void uart_write_blocking(uart_inst_t* uart, const uint8_t* src, size_t len);
+bool uart_is_readable(uart_inst_t* uart);
+bool uart_is_readable_within_us(uart_inst_t* uart, uint32_t us);
+char uart_getc(uart_inst_t* uart);
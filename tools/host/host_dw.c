@@ -0,0 +1,669 @@
+/**
+ * @file host_dw.c
+ * @brief Simulated debugWIRE: the RESET Line, the PIO UART and the Target
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_sim.h"
+#include "host_phy.h"
+#include <string.h>
+
+/*******************************************************************************
+ * The Line
+ ******************************************************************************/
+
+/**
+ * RESET is open drain with DWEN programmed: the line is low whenever
+ * either side pulls it low. It is kept as a list of segments, each a UART
+ * frame (start bit, 8 data bits LSB first, stop bit) or a plain low pulse
+ * such as a break. The Pico's frames are added when the TX state machine
+ * pulls them, the target's when it decides to answer; pulses come from
+ * the Pico's drive of the pin (SIO, or set pindirs on the TX state
+ * machine).
+ *
+ * Two receivers read the line: the target's at f_cpu/128 and the Pico's
+ * RX state machine at its clock divider. Each waits for a start bit,
+ * samples the data bits at their middle by its own clock (1.5, 2.5, ...
+ * bits after the falling edge) and checks the stop bit at 9.5 bits, so a
+ * rate mismatch garbles bytes as on hardware. After a bad stop bit a
+ * receiver waits for the line to go high; the target takes a low longer
+ * than a frame for a break. Receivers resynchronise on the next
+ * segment's start bit.
+ *
+ * Events are worked through lazily, in time order, whenever the firmware
+ * looks at the line or the RX FIFO.
+ */
+
+#define DW_SEGMENTS         1024u
+#define DW_NEVER            UINT64_MAX
+#define DW_BREAK_BITS       10u         /* Low this long (target bits) is a break */
+#define DW_REPLY_GAP_BITS   2u          /* Idle bits before the target answers */
+#define DW_RX_FIFO          4u          /* The RX state machine's FIFO (push noblock) */
+#define DW_POLL_STEP_NS     1000u       /* Fast-forward of an empty RX FIFO poll */
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;           /* Released for good (DW_NEVER: still held low) */
+    double bit_ns;          /* Frame bit time; 0 for a plain low pulse */
+    uint8_t byte;
+    bool from_target;
+} segment_t;
+
+typedef struct {
+    bool on;
+    bool target;            /* The target's receiver: deaf to its own frames */
+    double bit_ns;
+    uint64_t armed;         /* Waits for a start bit from here on */
+} receiver_t;
+
+static segment_t segs[DW_SEGMENTS];
+static uint32_t seg_count;
+static receiver_t target_rx = {.target = true};
+static receiver_t pico_rx;
+
+/** First whole ns inside bit number bits (may be fractional) of a frame */
+static uint64_t bit_time(uint64_t start, double bits, double bit_ns) {
+    double ns = bits * bit_ns;
+    uint64_t whole = (uint64_t)ns;
+    return start + whole + ((double)whole < ns);
+}
+
+static void add_segment(uint64_t start, uint64_t end, double bit_ns, uint8_t byte, bool from_target) {
+    if (seg_count == DW_SEGMENTS) {
+        return;     /* Nobody reads the line this far ahead */
+    }
+    uint32_t i = seg_count++;
+    while (i > 0 && segs[i - 1].start > start) {
+        segs[i] = segs[i - 1];
+        i--;
+    }
+    segs[i] = (segment_t){start, end, bit_ns, byte, from_target};
+}
+
+static void add_frame(uint64_t start, double bit_ns, uint8_t byte, bool from_target) {
+    add_segment(start, bit_time(start, 10, bit_ns), bit_ns, byte, from_target);
+}
+
+/** Bit number of t inside a frame (0: start bit, 9: stop bit) */
+static uint32_t frame_bit(const segment_t* s, uint64_t t) {
+    return (uint32_t)((double)(t - s->start) / s->bit_ns);
+}
+
+static bool frame_bit_low(const segment_t* s, uint32_t bit) {
+    return bit == 0 || (bit <= 8 && !((s->byte >> (bit - 1)) & 1u));
+}
+
+static bool segment_low(const segment_t* s, uint64_t t) {
+    if (t < s->start || t >= s->end) {
+        return false;
+    }
+    return s->bit_ns == 0 || frame_bit_low(s, frame_bit(s, t));
+}
+
+/** End of the low stretch of s that t is in */
+static uint64_t segment_low_end(const segment_t* s, uint64_t t) {
+    if (s->bit_ns == 0) {
+        return s->end;
+    }
+    uint32_t bit = frame_bit(s, t);
+    while (bit < 9 && frame_bit_low(s, bit)) {
+        bit++;
+    }
+    return bit_time(s->start, bit, s->bit_ns);
+}
+
+static bool line_low(uint64_t t) {
+    for (uint32_t i = 0; i < seg_count; i++) {
+        if (segment_low(&segs[i], t)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** First time from t on that nothing pulls the line low (DW_NEVER: unknown yet) */
+static uint64_t line_high_from(uint64_t t) {
+    for (;;) {
+        uint64_t next = t;
+        for (uint32_t i = 0; i < seg_count; i++) {
+            if (segment_low(&segs[i], t)) {
+                uint64_t end = segment_low_end(&segs[i], t);
+                if (end == DW_NEVER) {
+                    return DW_NEVER;
+                }
+                next = end > next ? end : next;
+            }
+        }
+        if (next == t) {
+            return t;
+        }
+        t = next;
+    }
+}
+
+/** Drop what no receiver and no drive query can look at any more */
+static void prune(uint64_t now) {
+    uint64_t keep = now;
+    if (target_rx.on && target_rx.armed < keep) {
+        keep = target_rx.armed;
+    }
+    if (pico_rx.on && pico_rx.armed < keep) {
+        keep = pico_rx.armed;
+    }
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < seg_count; i++) {
+        if (segs[i].end > keep) {
+            segs[n++] = segs[i];
+        }
+    }
+    seg_count = n;
+}
+
+/*******************************************************************************
+ * Receivers
+ ******************************************************************************/
+
+typedef struct {
+    uint64_t at;            /* When the receiver knows */
+    uint64_t start;         /* Start bit it triggered on */
+    bool framed;            /* Good stop bit */
+    uint8_t byte;
+} reception_t;
+
+/**
+ * @brief Next thing rx makes of the line, if it can be known yet
+ *
+ * @return false if no segment is coming, or the line has not gone high
+ *         again after a bad stop bit
+ */
+static bool next_reception(const receiver_t* rx, reception_t* r) {
+    if (!rx->on) {
+        return false;
+    }
+    const segment_t* s = NULL;
+    for (uint32_t i = 0; i < seg_count; i++) {
+        if (segs[i].start >= rx->armed && !(rx->target && segs[i].from_target)) {
+            s = &segs[i];
+            break;
+        }
+    }
+    if (!s) {
+        return false;
+    }
+    r->start = s->start;
+    r->byte = 0;
+    for (uint32_t k = 0; k < 8; k++) {
+        if (!line_low(bit_time(s->start, 1.5 + k, rx->bit_ns))) {
+            r->byte |= (uint8_t)(1u << k);
+        }
+    }
+    r->at = bit_time(s->start, 9.5, rx->bit_ns);
+    r->framed = !line_low(r->at);
+    if (!r->framed) {
+        r->at = line_high_from(r->at);
+    }
+    return r->at != DW_NEVER;
+}
+
+static void target_byte(uint8_t byte, uint64_t t);
+static void target_break(uint64_t high_ns);
+static void pico_push(uint32_t word);
+
+/** Work through every reception up to now, in time order */
+static void advance(uint64_t now) {
+    target_rx.on = host_dw_active();
+    target_rx.bit_ns = 128e9 / host_target()->cpu_hz;
+
+    for (;;) {
+        reception_t t, p;
+        bool have_t = next_reception(&target_rx, &t) && t.at <= now;
+        bool have_p = next_reception(&pico_rx, &p) && p.at <= now;
+
+        if (have_t && (!have_p || t.at <= p.at)) {
+            target_rx.armed = t.at;
+            if (t.framed) {
+                target_byte(t.byte, t.at);
+            } else if (t.at - t.start >= (uint64_t)(DW_BREAK_BITS * target_rx.bit_ns)) {
+                target_break(t.at);
+            } else {
+                host_target()->dw_garbled++;
+            }
+        } else if (have_p) {
+            pico_rx.armed = p.at;
+            if (p.framed) {
+                pico_push((uint32_t)p.byte << 24);
+            }
+        } else {
+            break;
+        }
+    }
+    prune(now);
+}
+
+/*******************************************************************************
+ * Target
+ ******************************************************************************/
+
+/**
+ * A break halts the target (or ends its SPM wait) and it answers 0x55;
+ * it then takes the command bytes below. GO lets it run until the next
+ * break. Memory access goes through Z, which ends up past the last byte.
+ * SPM (page buffer fill, page erase, page write) is only taken with the
+ * PC in the boot section (BOOTSZ in the high fuse, ATmega328P layout);
+ * an erase or write leaves the link deaf until the next break, which is
+ * answered once the write is done.
+ */
+
+#define DW_DATA_BYTES       0x900u      /* Registers, I/O and SRAM (ATmega328P) */
+
+static struct {
+    bool halted;            /* Stopped by a break: takes commands */
+    bool deaf;              /* Busy after SPM: needs a break */
+    uint64_t busy_until;
+    uint64_t tx_free;       /* Its next frame may start here */
+    uint8_t cmd;            /* Command still taking argument bytes */
+    uint16_t need;
+    uint16_t got;
+    uint8_t arg[2];
+    uint8_t ctx;
+    uint8_t mode;
+    uint16_t pc;
+    uint16_t bp;
+    uint16_t ir;
+    uint8_t spmcsr;
+    uint8_t data[DW_DATA_BYTES];    /* r0..r31 at 0..31 */
+    uint8_t page_buf[256];
+} dw;
+
+bool host_dw_active(void) {
+    const host_target_t* t = host_target();
+    return !(t->hfuse & 0x40) && !t->dw_disabled;
+}
+
+/** Answer bytes back to back, after a short gap */
+static void target_send(const uint8_t* data, size_t len, uint64_t t) {
+    double bit_ns = target_rx.bit_ns;
+    uint64_t start = bit_time(t, DW_REPLY_GAP_BITS, bit_ns);
+    if (start < dw.tx_free) {
+        start = dw.tx_free;
+    }
+    for (size_t i = 0; i < len; i++) {
+        add_frame(start, bit_ns, data[i], true);
+        start = bit_time(start, 10, bit_ns);
+    }
+    dw.tx_free = start;
+}
+
+static uint16_t z_reg(void) {
+    return (uint16_t)(dw.data[30] | dw.data[31] << 8);
+}
+
+static void set_z(uint16_t z) {
+    dw.data[30] = (uint8_t)z;
+    dw.data[31] = (uint8_t)(z >> 8);
+}
+
+/** Memory command started by MEM_GO: PC = start, BP = end */
+static void mem_go(uint64_t t) {
+    host_target_t* tg = host_target();
+    uint8_t out[256];
+    uint16_t n = (uint16_t)(dw.bp - dw.pc);
+
+    if (dw.ctx != 0x66) {
+        return;
+    }
+    switch (dw.mode) {
+        case 0x00:      /* Read data space at Z+ (BP counts 2 per byte) */
+        case 0x02: {    /* Read flash at Z+ */
+            n /= 2u;
+            n = n < sizeof(out) ? n : (uint16_t)sizeof(out);
+            uint16_t z = z_reg();
+            for (uint16_t i = 0; i < n; i++, z++) {
+                out[i] = dw.mode == 0x00 ? dw.data[z % DW_DATA_BYTES] : tg->flash[z % tg->flash_bytes];
+            }
+            set_z(z);
+            target_send(out, n, t);
+        } break;
+        case 0x01:      /* Read registers PC..BP-1 */
+            for (uint16_t i = 0; i < n && i < 32u; i++) {
+                out[i] = dw.data[(dw.pc + i) & 31u];
+            }
+            target_send(out, n < 32u ? n : 32u, t);
+            break;
+        case 0x05:      /* Write registers PC..BP-1: the data bytes follow */
+            dw.cmd = 0x20;
+            dw.need = n;
+            dw.got = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+static void spm(uint64_t t) {
+    host_target_t* tg = host_target();
+    uint32_t boot_words = 256u << (3u - ((tg->hfuse >> 1) & 3u));
+    uint32_t page = z_reg() % tg->flash_bytes & ~(uint32_t)(tg->page_bytes - 1u);
+    uint8_t op = dw.spmcsr & 0x1F;
+
+    dw.spmcsr = 0;
+    if (dw.pc < tg->flash_bytes / 2u - boot_words) {
+        return;     /* SPM outside the boot section does nothing */
+    }
+    switch (op) {
+        case 0x01: {
+            uint32_t off = z_reg() % tg->page_bytes & ~1u;
+            dw.page_buf[off] = dw.data[0];
+            dw.page_buf[off + 1] = dw.data[1];
+        } break;
+        case 0x03:
+            memset(tg->flash + page, 0xFF, tg->page_bytes);
+            dw.busy_until = t + (uint64_t)tg->flash_write_us * 1000u;
+            dw.deaf = true;
+            break;
+        case 0x05:
+            for (uint32_t i = 0; i < tg->page_bytes; i++) {
+                tg->flash[page + i] &= dw.page_buf[i];
+            }
+            memset(dw.page_buf, 0xFF, sizeof(dw.page_buf));
+            tg->page_writes++;
+            dw.busy_until = t + (uint64_t)tg->flash_write_us * 1000u;
+            dw.deaf = true;
+            break;
+        default:
+            break;  /* RWWSRE: nothing to model */
+    }
+}
+
+/** The instruction in IR (only what the firmware executes) */
+static void execute(uint64_t t, bool spm_slot) {
+    if (spm_slot) {
+        if (dw.ir == 0x95E8) {
+            spm(t);
+        }
+    } else if (dw.ir == 0xBFD7) {
+        dw.spmcsr = dw.data[29];            /* OUT SPMCSR, r29 */
+    } else if (dw.ir == 0x9632) {
+        set_z((uint16_t)(z_reg() + 2u));    /* ADIW Z, 2 */
+    }
+}
+
+static void command(uint8_t cmd, uint64_t t) {
+    host_target_t* tg = host_target();
+
+    tg->dw_commands++;
+    switch (cmd) {
+        case 0x06:
+            tg->dw_disabled = true;
+            dw.halted = false;
+            break;
+        case 0x07: {
+            static const uint8_t sync = 0x55;
+            uint64_t low = bit_time(t, DW_REPLY_GAP_BITS, target_rx.bit_ns);
+            uint64_t high = bit_time(low, 2u * DW_BREAK_BITS, target_rx.bit_ns);
+            add_segment(low, high, 0, 0, true);
+            dw.tx_free = high;
+            target_send(&sync, 1, high);
+        } break;
+        case 0x20:
+            mem_go(t);
+            break;
+        case 0x23:
+        case 0x33:
+            execute(t, cmd == 0x33);
+            break;
+        case 0x30:
+            dw.halted = false;
+            break;
+        case 0x60:
+        case 0x64:
+        case 0x66:
+            dw.ctx = cmd;
+            break;
+        case 0xC2:
+        case 0xD0:
+        case 0xD1:
+        case 0xD2:
+            dw.cmd = cmd;
+            dw.need = cmd == 0xC2 ? 1u : 2u;
+            dw.got = 0;
+            break;
+        case 0xF3: {
+            uint8_t id[2] = {tg->signature[1], tg->signature[2]};
+            target_send(id, 2, t);
+        } break;
+        default:
+            break;
+    }
+}
+
+static void argument(uint8_t byte) {
+    if (dw.cmd == 0x20) {
+        dw.data[(dw.pc + dw.got) & 31u] = byte;
+    } else if (dw.got < 2u) {
+        dw.arg[dw.got] = byte;
+    }
+    if (++dw.got < dw.need) {
+        return;
+    }
+    uint16_t word = (uint16_t)(dw.arg[0] << 8 | dw.arg[1]);
+    switch (dw.cmd) {
+        case 0xC2: dw.mode = dw.arg[0]; break;
+        case 0xD0: dw.pc = word; break;
+        case 0xD1: dw.bp = word; break;
+        case 0xD2: dw.ir = word; break;
+        default: break;
+    }
+    dw.cmd = 0;
+    dw.need = 0;
+}
+
+static void target_byte(uint8_t byte, uint64_t t) {
+    if (!dw.halted || dw.deaf || t < dw.busy_until) {
+        return;
+    }
+    if (dw.need) {
+        argument(byte);
+    } else {
+        command(byte, t);
+    }
+}
+
+static void target_break(uint64_t high_ns) {
+    static const uint8_t sync = 0x55;
+    uint64_t t = high_ns > dw.busy_until ? high_ns : dw.busy_until;
+
+    host_target()->dw_breaks++;
+    dw.halted = true;
+    dw.deaf = false;
+    dw.cmd = 0;
+    dw.need = 0;
+    target_send(&sync, 1, t);
+}
+
+void host_dw_pico_drive(int level, uint64_t t_ns) {
+    for (uint32_t i = 0; i < seg_count; i++) {
+        segment_t* s = &segs[i];
+        if (!s->from_target && s->bit_ns == 0 && s->end == DW_NEVER) {
+            if (level != 0) {
+                s->end = t_ns;
+            }
+            return;
+        }
+    }
+    if (level == 0) {
+        add_segment(t_ns, DW_NEVER, 0, 0, false);
+    }
+}
+
+int host_dw_drive(void) {
+    uint64_t now = host_sim_now_ns();
+
+    advance(now);
+    for (uint32_t i = 0; i < seg_count; i++) {
+        if (segs[i].from_target && segment_low(&segs[i], now)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*******************************************************************************
+ * PIO UART (debugwire.pio)
+ ******************************************************************************/
+
+/**
+ * TX: a word pulled from the FIFO goes out one bit after the pull, or
+ * right after the previous frame's stop bit; each 1 in the word pulls the
+ * line low for a bit. set pindirs (exec) holds the line low until undone.
+ * RX: one push per frame with a good stop bit, the byte in bits 24..31;
+ * pushes into a full FIFO are lost.
+ */
+
+static struct {
+    uint pin;
+    double bit_ns;
+    bool on;
+    bool held;              /* set pindirs, 1 */
+    uint64_t next_start;    /* Earliest start bit after the queued frames */
+} tx;
+
+static struct {
+    uint32_t word[DW_RX_FIFO];
+    uint32_t head;
+    uint32_t count;
+} rx_fifo;
+
+static void pico_push(uint32_t word) {
+    if (rx_fifo.count < DW_RX_FIFO) {
+        rx_fifo.word[(rx_fifo.head + rx_fifo.count++) % DW_RX_FIFO] = word;
+    }
+}
+
+static void tx_init(uint pin, double cycle_ns) {
+    tx.pin = pin;
+    tx.bit_ns = 8.0 * cycle_ns;
+    tx.held = false;
+    tx.next_start = 0;
+}
+
+static void tx_enable(bool enabled) {
+    tx.on = enabled;
+}
+
+/** Frames not pulled yet leave with the FIFO */
+static void tx_clear_fifos(void) {
+    uint64_t pulled = host_sim_now_ns() + (uint64_t)tx.bit_ns;
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < seg_count; i++) {
+        if (segs[i].from_target || segs[i].bit_ns == 0 || segs[i].start <= pulled) {
+            segs[n++] = segs[i];
+        }
+    }
+    seg_count = n;
+    tx.next_start = 0;
+}
+
+static void tx_exec(uint instr) {
+    if ((instr & 0xE0E0u) == 0xE080u) {
+        tx.held = instr & 1u;
+        host_pin_update(tx.pin, host_sim_now_ns());
+    }
+}
+
+static void tx_put(uint32_t data) {
+    uint64_t now = host_sim_now_ns();
+
+    if (!tx.on) {
+        return;
+    }
+    uint64_t start = bit_time(now, 1, tx.bit_ns);
+    if (start < tx.next_start) {
+        start = tx.next_start;
+    }
+    add_frame(start, tx.bit_ns, (uint8_t)~data, false);
+    tx.next_start = bit_time(start, 10, tx.bit_ns);
+}
+
+static int tx_drive(uint pin) {
+    return pin == tx.pin && tx.held ? 0 : -1;
+}
+
+const host_pio_role_t host_pio_dw_tx = {
+    .init = tx_init,
+    .enable = tx_enable,
+    .clear_fifos = tx_clear_fifos,
+    .exec = tx_exec,
+    .put = tx_put,
+    .drive = tx_drive,
+};
+
+static void rx_init(uint pin, double cycle_ns) {
+    (void)pin;
+    pico_rx.bit_ns = 8.0 * cycle_ns;
+}
+
+static void rx_enable(bool enabled) {
+    uint64_t now = host_sim_now_ns();
+
+    advance(now);
+    pico_rx.on = enabled;
+    pico_rx.armed = now;
+}
+
+static void rx_clear_fifos(void) {
+    advance(host_sim_now_ns());
+    rx_fifo.count = 0;
+}
+
+/** An empty poll also lets time run to the next byte, in small steps */
+static bool rx_empty(void) {
+    uint64_t now = host_sim_now_ns();
+    reception_t r;
+
+    advance(now);
+    if (rx_fifo.count) {
+        return false;
+    }
+    uint64_t step = DW_POLL_STEP_NS;
+    if (next_reception(&pico_rx, &r) && r.at > now && r.at - now < step) {
+        step = r.at - now;
+    }
+    host_sim_advance_ns(step);
+    return true;
+}
+
+static uint32_t rx_get(void) {
+    advance(host_sim_now_ns());
+    if (!rx_fifo.count) {
+        return 0;
+    }
+    uint32_t word = rx_fifo.word[rx_fifo.head];
+    rx_fifo.head = (rx_fifo.head + 1u) % DW_RX_FIFO;
+    rx_fifo.count--;
+    return word;
+}
+
+const host_pio_role_t host_pio_dw_rx = {
+    .init = rx_init,
+    .enable = rx_enable,
+    .clear_fifos = rx_clear_fifos,
+    .rx_empty = rx_empty,
+    .get = rx_get,
+};
+
+/*******************************************************************************
+ * Reset
+ ******************************************************************************/
+
+void host_dw_reset(void) {
+    seg_count = 0;
+    memset(&dw, 0, sizeof(dw));
+    memset(dw.page_buf, 0xFF, sizeof(dw.page_buf));
+    memset(&tx, 0, sizeof(tx));
+    memset(&rx_fifo, 0, sizeof(rx_fifo));
+    target_rx = (receiver_t){.target = true};
+    pico_rx = (receiver_t){0};
+}
@@ -0,0 +1,614 @@
+/**
+ * @file host_isp.c
+ * @brief Simulated Classic AVR on the ISP Header, and the PL022 SPI0
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_sim.h"
+#include "host_phy.h"
+#include "avr_devices.h"
+#include "avrprog_bitbang.h"
+#include <string.h>
+#include <hardware/spi.h>
+
+#define ISP_MISO_PIN    BB_MISO_PIN
+#define ISP_RESET_PIN   BB_RESET_PIN
+#define ISP_SCK_PIN     BB_SCK_PIN
+#define ISP_MOSI_PIN    BB_MOSI_PIN
+
+/*******************************************************************************
+ * Target Memories
+ ******************************************************************************/
+
+static host_target_t target;
+
+static uint64_t busy_until_ns;
+static uint8_t ext_addr;
+static uint8_t page_buf[256];
+static uint8_t eeprom_page_buf[HOST_TARGET_MAX_EEPROM];
+
+host_target_t* host_target(void) {
+    host_sio_flush();   /* The firmware's last SIO write reaches the target */
+    return &target;
+}
+
+uint32_t host_target_clock_from_fuses(uint8_t lfuse) {
+    uint32_t hz = (lfuse & 0x0F) == 0x02 ? 8000000u : 16000000u;
+    return (lfuse & 0x80) ? hz : hz / 8u;
+}
+
+void host_target_init(const uint8_t sig[3]) {
+    const avr_device_t* dev = avr_lookup_device_by_signature(sig);
+
+    memset(&target, 0, sizeof(target));
+    memcpy(target.signature, sig, 3);
+    target.calibration = 0x80;
+    target.lfuse = 0x62;
+    target.hfuse = 0xD9;
+    target.efuse = 0xFF;
+    target.lock = 0xFF;
+    target.cpu_hz = host_target_clock_from_fuses(target.lfuse);
+
+    target.flash_bytes = dev ? dev->flash_size_bytes : 32768u;
+    target.page_bytes = dev ? dev->page_size_bytes : 128u;
+    target.eeprom_bytes = dev ? dev->eeprom_size_bytes : 1024u;
+    target.eeprom_page_bytes = dev ? dev->eeprom_page_bytes : 4u;
+    target.flash_write_us = dev && dev->flash_write_us ? dev->flash_write_us : 4500u;
+    target.eeprom_write_us = dev && dev->eeprom_write_us ? dev->eeprom_write_us : 3600u;
+    target.erase_us = dev && dev->erase_us ? dev->erase_us : 9000u;
+    target.fuse_write_us = 4500u;
+    if (target.flash_bytes > HOST_TARGET_MAX_FLASH) {
+        target.flash_bytes = HOST_TARGET_MAX_FLASH;
+    }
+    if (target.page_bytes > sizeof(page_buf) || target.page_bytes == 0) {
+        target.page_bytes = 128u;
+    }
+    if (target.eeprom_bytes > HOST_TARGET_MAX_EEPROM) {
+        target.eeprom_bytes = HOST_TARGET_MAX_EEPROM;
+    }
+    memset(target.flash, 0xFF, sizeof(target.flash));
+    memset(target.eeprom, 0xFF, sizeof(target.eeprom));
+
+    busy_until_ns = 0;
+    ext_addr = 0;
+    memset(page_buf, 0xFF, sizeof(page_buf));
+    memset(eeprom_page_buf, 0xFF, sizeof(eeprom_page_buf));
+}
+
+/** Start a self-timed write */
+static void start_busy(uint64_t t_ns, uint32_t us) {
+    busy_until_ns = t_ns + (uint64_t)us * 1000u;
+}
+
+static uint32_t flash_byte_addr(const uint8_t* tx) {
+    uint32_t word = ((uint32_t)ext_addr << 16) | ((uint32_t)tx[1] << 8) | tx[2];
+    return (word * 2u) % target.flash_bytes;
+}
+
+static void chip_erase(uint64_t t_ns) {
+    memset(target.flash, 0xFF, target.flash_bytes);
+    if (target.hfuse & 0x08) {
+        memset(target.eeprom, 0xFF, target.eeprom_bytes);  /* EESAVE unprogrammed */
+    }
+    target.lock = 0xFF;
+    target.chip_erases++;
+    start_busy(t_ns, target.erase_us);
+}
+
+/*******************************************************************************
+ * Serial Programming Instructions
+ ******************************************************************************/
+
+/** Programming Enable wait after RESET goes low on a running target */
+#define ISP_ENABLE_WAIT_NS  20000000u
+
+static bool enabled;                /* Programming Enable accepted */
+static uint64_t enable_ns;          /* Programming Enable is accepted from here on */
+
+/** The serial interface listens once the target settled in reset */
+static bool in_sync(uint64_t t_ns) {
+    return t_ns >= enable_ns;
+}
+
+/**
+ * @brief Byte shifted out while the 4th byte of an instruction comes in
+ *
+ * Reads answer here; everything else echoes the 3rd byte.
+ */
+static uint8_t result_byte(const uint8_t* tx, uint64_t t_ns) {
+    bool busy = t_ns < busy_until_ns;
+
+    if (!enabled) {
+        return tx[2];
+    }
+    switch (tx[0]) {
+        case 0xF0:
+            return busy ? 0xFF : 0xFE;
+        case 0x30:
+            return (tx[2] & 3) < 3 ? target.signature[tx[2] & 3] : 0xFF;
+        case 0x38:
+            return target.calibration;
+        case 0x50:
+            return tx[1] == 0x08 ? target.efuse : target.lfuse;
+        case 0x58:
+            return tx[1] == 0x08 ? target.hfuse : target.lock;
+        case 0x20:
+        case 0x28:
+            return target.flash[flash_byte_addr(tx) + (tx[0] == 0x28)];
+        case 0xA0:
+            return target.eeprom[(((uint32_t)tx[1] << 8) | tx[2]) % target.eeprom_bytes];
+        default:
+            return tx[2];
+    }
+}
+
+/**
+ * @brief Execute one serial programming instruction after its 32nd bit
+ */
+static void execute(const uint8_t* tx, uint64_t t_ns) {
+    target.instructions++;
+
+    if (!enabled) {
+        if (tx[0] == 0xAC && tx[1] == 0x53) {
+            if (in_sync(t_ns)) {
+                enabled = true;
+                target.enables++;
+            } else {
+                target.early_enables++;
+            }
+        }
+        return;
+    }
+    if (tx[0] == 0xF0) {
+        return;
+    }
+    if (t_ns < busy_until_ns) {
+        target.busy_violations++;
+        return;     /* Writes are ignored until the running one ends */
+    }
+
+    switch (tx[0]) {
+        case 0xAC:
+            switch (tx[1]) {
+                case 0x80: chip_erase(t_ns); break;
+                case 0xA0: target.lfuse = tx[3]; start_busy(t_ns, target.fuse_write_us); break;
+                case 0xA8: target.hfuse = tx[3]; start_busy(t_ns, target.fuse_write_us); break;
+                case 0xA4: target.efuse = tx[3]; start_busy(t_ns, target.fuse_write_us); break;
+                case 0xE0:
+                    target.lock &= tx[3] | 0xC0;
+                    start_busy(t_ns, target.fuse_write_us);
+                    break;
+                default: break;
+            }
+            break;
+        case 0x4D:
+            ext_addr = tx[2];
+            break;
+        case 0x40:
+        case 0x48: {
+            uint32_t word = (((uint32_t)tx[1] << 8) | tx[2]) % (target.page_bytes / 2u);
+            page_buf[word * 2u + (tx[0] == 0x48)] = tx[3];
+        } break;
+        case 0x4C: {
+            uint32_t page = flash_byte_addr(tx) & ~(uint32_t)(target.page_bytes - 1u);
+            for (uint32_t i = 0; i < target.page_bytes; i++) {
+                target.flash[page + i] &= page_buf[i];
+            }
+            memset(page_buf, 0xFF, sizeof(page_buf));
+            target.page_writes++;
+            start_busy(t_ns, target.flash_write_us);
+        } break;
+        case 0xC0:
+            target.eeprom[(((uint32_t)tx[1] << 8) | tx[2]) % target.eeprom_bytes] = tx[3];
+            start_busy(t_ns, target.eeprom_write_us);
+            break;
+        case 0xC1:
+            if (target.eeprom_page_bytes) {
+                eeprom_page_buf[tx[2] % target.eeprom_page_bytes] = tx[3];
+            }
+            break;
+        case 0xC2:
+            if (target.eeprom_page_bytes) {
+                uint32_t base = ((((uint32_t)tx[1] << 8) | tx[2]) % target.eeprom_bytes)
+                              & ~(uint32_t)(target.eeprom_page_bytes - 1u);
+                memcpy(target.eeprom + base, eeprom_page_buf, target.eeprom_page_bytes);
+                memset(eeprom_page_buf, 0xFF, sizeof(eeprom_page_buf));
+                start_busy(t_ns, target.eeprom_write_us);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*******************************************************************************
+ * Serial Interface (bit level)
+ ******************************************************************************/
+
+/**
+ * The target samples MOSI on SCK rising edges and shifts MISO out on
+ * falling edges, 32 bits per instruction counted from RESET going low.
+ * Each byte shifted out is the one shifted in before it, except the
+ * 3rd byte of Programming Enable (0x53 only once the target is in sync)
+ * and the result byte of reads.
+ *
+ * RESET timing: a positive pulse shorter than 2 target clocks is not
+ * seen. One longer than ISP_RUN_NS lets the target start running, and
+ * Programming Enable is then refused for ISP_ENABLE_WAIT_NS after RESET
+ * goes low again, as after power-up (time 0). Shorter pulses (the
+ * resync) only restart the bit count.
+ *
+ * With DWEN programmed (and dW not disabled) RESET is the debugWIRE line
+ * of host_dw.c instead, and SCK and MISO are idle.
+ */
+
+/** RESET high for longer than this: the target leaves reset and runs */
+#define ISP_RUN_NS          1000000u
+
+static struct {
+    bool reset;                     /* RESET line level */
+    bool sck;
+    uint8_t bit;                    /* Position in the instruction, 0..31 */
+    uint8_t in[4];
+    uint8_t out;                    /* Byte being shifted out */
+    bool garbled;                   /* A phase of this instruction was too short */
+    uint64_t reset_ns;              /* Last RESET edge */
+    uint64_t rise_ns;
+    uint64_t fall_ns;
+    uint32_t fastest_hz;            /* Fastest SCK seen in this instruction */
+    uint32_t last_hz;
+} isp;
+
+uint32_t host_target_sck_hz(void) {
+    host_sio_flush();
+    return isp.last_hz;
+}
+
+/**
+ * @brief Check one SCK phase against the datasheet minimum (and log it)
+ *
+ * High and low phases must each last more than 2 target clocks below
+ * 12 MHz and at least 3 clocks from 12 MHz.
+ */
+static bool phase_too_short(uint64_t phase_ns) {
+    if (target.min_phase_ns == 0 || phase_ns < target.min_phase_ns) {
+        target.min_phase_ns = (uint32_t)(phase_ns < UINT32_MAX ? phase_ns : UINT32_MAX);
+    }
+    if (phase_ns >= 1000000u) {
+        return false;
+    }
+    uint64_t clocks_x1e9 = phase_ns * target.cpu_hz;
+    if (target.cpu_hz >= 12000000u) {
+        return clocks_x1e9 < 3000000000u;
+    }
+    return clocks_x1e9 <= 2000000000u;
+}
+
+/** Load the byte to shift out next, once byte k-1 is complete */
+static void load_out(uint8_t k, uint64_t t_ns) {
+    if (isp.garbled) {
+        isp.out = 0x00;     /* Sampled too fast: garbage in, nothing out */
+    } else if (k == 3) {
+        isp.out = result_byte(isp.in, t_ns);
+    } else if (k == 2 && !enabled) {
+        isp.out = isp.in[0] == 0xAC && isp.in[1] == 0x53 && in_sync(t_ns) ? 0x53 : 0x00;
+    } else {
+        isp.out = isp.in[(k + 3u) & 3u];
+    }
+}
+
+static void sck_rise(uint64_t t_ns) {
+    if (isp.bit > 0) {
+        uint64_t period = t_ns - isp.rise_ns;
+        uint32_t hz = period ? (uint32_t)(1000000000u / period) : UINT32_MAX;
+        if (hz > isp.fastest_hz) {
+            isp.fastest_hz = hz;
+        }
+    }
+    if (isp.fall_ns && phase_too_short(t_ns - isp.fall_ns)) {
+        isp.garbled = true;
+    }
+    isp.rise_ns = t_ns;
+
+    uint8_t k = isp.bit >> 3;
+    isp.in[k] = (uint8_t)(isp.in[k] << 1 | host_pin_level(ISP_MOSI_PIN));
+}
+
+static void sck_fall(uint64_t t_ns) {
+    if (phase_too_short(t_ns - isp.rise_ns)) {
+        isp.garbled = true;
+    }
+    isp.fall_ns = t_ns;
+    isp.out <<= 1;
+
+    if (++isp.bit == 32) {
+        if (isp.garbled) {
+            target.misreads++;
+            target.instructions++;
+        } else {
+            execute(isp.in, t_ns);
+        }
+        isp.last_hz = isp.fastest_hz;
+        isp.fastest_hz = 0;
+        isp.bit = 0;
+        isp.garbled = false;
+        load_out(0, t_ns);
+    } else if ((isp.bit & 7) == 0) {
+        load_out(isp.bit >> 3, t_ns);
+    }
+}
+
+static void isp_pico_drive(uint pin, int level, uint64_t t_ns) {
+    switch (pin) {
+        case ISP_RESET_PIN: {
+            bool reset = level != 0;    /* Pulled up on the target */
+            if (host_dw_active()) {
+                host_dw_pico_drive(level, t_ns);   /* RESET is the dW line */
+                isp.reset = reset;
+                isp.reset_ns = t_ns;
+                break;
+            }
+            if (reset == isp.reset) {
+                break;
+            }
+            isp.reset = reset;
+            if (reset) {
+                isp.reset_ns = t_ns;
+                break;
+            }
+            uint64_t high_ns = t_ns - isp.reset_ns;
+            isp.reset_ns = t_ns;
+            if (high_ns < 1000000u && high_ns * target.cpu_hz < 2000000000u) {
+                break;                  /* Too short to reset anything */
+            }
+            enabled = false;            /* Leaving reset ends programming mode */
+            if (high_ns > ISP_RUN_NS) {
+                enable_ns = t_ns + ISP_ENABLE_WAIT_NS;
+            }
+            isp.bit = target.glitch_bits & 31u;    /* Bit count restarts */
+            target.glitch_bits = 0;
+            isp.garbled = false;
+            isp.out = 0x00;
+            isp.fall_ns = 0;
+        } break;
+        case ISP_SCK_PIN: {
+            bool sck = level == 1;
+            if (sck == isp.sck) {
+                break;
+            }
+            isp.sck = sck;
+            if (isp.reset || host_dw_active()) {
+                break;                  /* Running: SCK is an ordinary input */
+            }
+            if (sck) {
+                sck_rise(t_ns);
+            } else {
+                sck_fall(t_ns);
+            }
+        } break;
+        default:
+            break;
+    }
+}
+
+/** MISO is only driven while RESET is low; with dW on, RESET is the dW line */
+static int isp_drive(uint pin) {
+    if (host_dw_active()) {
+        return pin == ISP_RESET_PIN ? host_dw_drive() : -1;
+    }
+    if (pin == ISP_MISO_PIN && !isp.reset) {
+        return isp.out >> 7;
+    }
+    return -1;
+}
+
+const host_board_t host_board_isp = {
+    .pico_drive = isp_pico_drive,
+    .drive = isp_drive,
+};
+
+void host_isp_reset(void) {
+    memset(&isp, 0, sizeof(isp));
+    isp.reset = true;
+    enabled = false;
+    enable_ns = ISP_ENABLE_WAIT_NS;     /* Powered up at time 0 */
+}
+
+/*******************************************************************************
+ * SPI0 (PL022)
+ ******************************************************************************/
+
+/**
+ * Frames start when queued or when the previous one ends, whichever is
+ * later, and are clocked into the target right away (Mode 0: MOSI set a
+ * half bit before each rising edge). The TX FIFO holds the frames not
+ * started yet; a frame is readable once its last bit is done.
+ *
+ * spi_get_hw(spi0)->dr accesses: a value up to 0xFFFF found in dr at the
+ * next SPI call was written by the firmware and is queued. A readable
+ * frame is popped by spi_is_readable() into dr, tagged above 16 bits so
+ * it is never taken for a write.
+ */
+
+#define PL022_FIFO_DEPTH    8u
+#define PL022_FRAMES        16u             /* Queued plus unread, power of 2 */
+#define PL022_STATUS_CYCLES 2u              /* One bus read of SSPSR */
+#define PL022_DR_READ       0x80000000u
+#define PL022_DR_EMPTY      0x40000000u
+
+typedef struct {
+    uint16_t rx;
+    uint64_t start_ns;
+    uint64_t done_ns;
+} spi_frame_t;
+
+static spi_hw_t spi_regs = {PL022_DR_EMPTY};
+static spi_frame_t frames[PL022_FRAMES];
+static uint32_t frame_head;                 /* Oldest unread frame */
+static uint32_t frame_count;
+static uint32_t spi_bits = 8;
+static uint32_t spi_bit_ns = 20000;
+static uint64_t spi_free_ns;                /* Last queued frame done */
+static bool spi_sck;
+static bool spi_mosi;
+
+int host_spi_drive(uint pin) {
+    if (pin == ISP_SCK_PIN) {
+        return spi_sck;
+    }
+    if (pin == ISP_MOSI_PIN) {
+        return spi_mosi;
+    }
+    return -1;
+}
+
+void host_spi_reset(void) {
+    memset(frames, 0, sizeof(frames));
+    spi_regs.dr = PL022_DR_EMPTY;
+    frame_head = 0;
+    frame_count = 0;
+    spi_bits = 8;
+    spi_bit_ns = 20000;
+    spi_free_ns = 0;
+    spi_sck = false;
+    spi_mosi = false;
+}
+
+/** Shift one frame out, clocking the target, and queue what came back */
+static void spi_push(uint16_t data) {
+    uint64_t now = host_sim_now_ns();
+    uint64_t t = spi_free_ns > now ? spi_free_ns : now;
+    uint32_t half = spi_bit_ns / 2u;
+    spi_frame_t* f = &frames[(frame_head + frame_count) & (PL022_FRAMES - 1u)];
+
+    f->start_ns = t;
+    f->rx = 0;
+    for (int bit = (int)spi_bits - 1; bit >= 0; bit--) {
+        spi_mosi = (data >> bit) & 1u;
+        host_pin_update(ISP_MOSI_PIN, t);
+        spi_sck = true;
+        host_pin_update(ISP_SCK_PIN, t + half);
+        f->rx = (uint16_t)(f->rx << 1 | host_pin_level(ISP_MISO_PIN));
+        spi_sck = false;
+        host_pin_update(ISP_SCK_PIN, t + spi_bit_ns);
+        t += spi_bit_ns;
+    }
+    f->done_ns = t;
+    spi_free_ns = t;
+    if (frame_count < PL022_FRAMES) {
+        frame_count++;
+    }
+}
+
+/** Queue a frame the firmware wrote to dr since the last SPI call */
+static void spi_commit(void) {
+    if (spi_regs.dr <= 0xFFFFu) {
+        spi_push((uint16_t)spi_regs.dr);
+        spi_regs.dr = PL022_DR_EMPTY;
+    }
+}
+
+/** Frames queued but not started yet */
+static uint32_t tx_level(void) {
+    uint64_t now = host_sim_now_ns();
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < frame_count; i++) {
+        if (frames[(frame_head + i) & (PL022_FRAMES - 1u)].start_ns > now) {
+            n++;
+        }
+    }
+    return n;
+}
+
+spi_hw_t* spi_get_hw(spi_inst_t* spi) {
+    (void)spi;
+    spi_commit();
+    return &spi_regs;
+}
+
+bool spi_is_writable(const spi_inst_t* spi) {
+    (void)spi;
+    spi_commit();
+    host_sim_cycles(PL022_STATUS_CYCLES);
+    return tx_level() < PL022_FIFO_DEPTH;
+}
+
+/**
+ * @brief RX FIFO not empty; a firmware spinning on it skips ahead
+ *
+ * Nothing the firmware can do changes the FIFOs before the oldest frame
+ * is done, so a false answer moves the clock there in one step.
+ */
+bool spi_is_readable(const spi_inst_t* spi) {
+    (void)spi;
+    spi_commit();
+    host_sim_cycles(PL022_STATUS_CYCLES);
+    if (frame_count == 0) {
+        return false;
+    }
+
+    spi_frame_t* f = &frames[frame_head];
+    uint64_t now = host_sim_now_ns();
+    if (f->done_ns > now) {
+        host_sim_advance_ns(f->done_ns - now);
+        return false;
+    }
+    spi_regs.dr = PL022_DR_READ | f->rx;
+    frame_head = (frame_head + 1u) & (PL022_FRAMES - 1u);
+    frame_count--;
+    return true;
+}
+
+/** The SDK's prescale/post-divide search on clk_peri */
+uint spi_set_baudrate(spi_inst_t* spi, uint baudrate) {
+    uint prescale;
+    uint postdiv;
+
+    (void)spi;
+    spi_commit();
+    for (prescale = 2; prescale <= 254; prescale += 2) {
+        if (HOST_SYS_HZ < prescale * 256 * (uint64_t)baudrate) {
+            break;
+        }
+    }
+    if (prescale > 254) {
+        prescale = 254;
+    }
+    for (postdiv = 256; postdiv > 1; --postdiv) {
+        if (HOST_SYS_HZ / (prescale * (postdiv - 1)) > baudrate) {
+            break;
+        }
+    }
+    spi_bit_ns = prescale * postdiv * HOST_CYCLE_NS;
+    return HOST_SYS_HZ / (prescale * postdiv);
+}
+
+uint spi_init(spi_inst_t* spi, uint baudrate) {
+    host_spi_reset();
+    return spi_set_baudrate(spi, baudrate);
+}
+
+void spi_set_format(spi_inst_t* spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha,
+                    spi_order_t order) {
+    (void)spi;
+    (void)cpol;
+    (void)cpha;
+    (void)order;
+    spi_commit();
+    spi_bits = data_bits;
+}
+
+int spi_write_read_blocking(spi_inst_t* spi, const uint8_t* src, uint8_t* dst, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        uint8_t byte = src[i];
+        while (!spi_is_writable(spi)) {
+        }
+        spi_get_hw(spi)->dr = byte;
+        while (!spi_is_readable(spi)) {
+        }
+        dst[i] = (uint8_t)spi_get_hw(spi)->dr;
+    }
+    return (int)len;
+}
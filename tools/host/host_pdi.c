@@ -0,0 +1,778 @@
+/**
+ * @file host_pdi.c
+ * @brief Simulated PDI State Machine (pdi.pio) and an XMEGA on PDI
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_sim.h"
+#include "host_phy.h"
+#include "pdi.h"
+#include <string.h>
+
+/*******************************************************************************
+ * PDI State Machine
+ ******************************************************************************/
+
+/**
+ * pdi.pio cycle by cycle at the state machine's clock: every word it pulls
+ * (from the TX FIFO, else the idle word in X) is a 12-bit frame sent, or a
+ * wait for a start bit followed by an 11-bit receive that is pushed with
+ * noblock. PDI_CLK (side-set) and PDI_DATA change at the cycle they would
+ * on hardware; the state machine runs lazily up to the simulated clock
+ * whenever the firmware touches it, so a frame may clock the target ahead
+ * of the clock like a PL022 frame does.
+ */
+
+#define SM_FIFO_DEPTH       4u
+
+static struct {
+    bool configured;
+    bool enabled;
+    uint32_t cycle_ns;
+    uint64_t t_ns;              /* Time of the next instruction */
+    bool waiting;               /* In wait_start (receive word) */
+    uint32_t x;
+    uint32_t tx[SM_FIFO_DEPTH];
+    uint32_t tx_count;
+    uint32_t rx[SM_FIFO_DEPTH];
+    uint64_t rx_ns[SM_FIFO_DEPTH];
+    uint32_t rx_count;
+    bool clk;
+    bool data;
+    bool data_out;              /* pindirs */
+} sm;
+
+static void set_clk(bool level, uint64_t t) {
+    if (level != sm.clk) {
+        sm.clk = level;
+        host_pin_update(PDI_CLK_PIN, t);
+    }
+}
+
+static void set_data(bool level, bool out, uint64_t t) {
+    if (level != sm.data || out != sm.data_out) {
+        sm.data = level;
+        sm.data_out = out;
+        host_pin_update(PDI_DATA_PIN, t);
+    }
+}
+
+/** The rest of a receive word after the start bit: 11 bits, then push */
+static void receive_frame(void) {
+    uint32_t c = sm.cycle_ns;
+    uint64_t t = sm.t_ns;
+    uint32_t isr = 0;
+
+    t += c;                                         /* set y, 10 (clock fell) */
+    for (int i = 0; i < 11; i++) {
+        t += 2u * c;                                /* nop [1] */
+        set_clk(true, t);                           /* in pins, 1 side 1 */
+        isr = (isr >> 1) | ((uint32_t)host_pin_level(PDI_DATA_PIN) << 31);
+        t += 2u * c;                                /* in, jmp y-- side 1 */
+        set_clk(false, t);
+    }
+    t += c;                                         /* push noblock */
+    if (sm.rx_count < SM_FIFO_DEPTH) {
+        sm.rx[sm.rx_count] = isr;
+        sm.rx_ns[sm.rx_count] = t;
+        sm.rx_count++;
+    }
+    sm.t_ns = t;
+    sm.waiting = false;
+}
+
+/** One wait_start pass: nop [1], then jmp pin with the clock high */
+static void wait_start_step(void) {
+    uint32_t c = sm.cycle_ns;
+    uint64_t t = sm.t_ns + 2u * c;
+    bool bit;
+
+    set_clk(true, t);
+    bit = host_pin_level(PDI_DATA_PIN);
+    t += 2u * c;
+    set_clk(false, t);
+    sm.t_ns = t;
+    if (!bit) {
+        receive_frame();
+    }
+}
+
+/** From top: pull a word and run it (a receive stops at wait_start) */
+static void run_word(void) {
+    uint32_t c = sm.cycle_ns;
+    uint64_t t = sm.t_ns;
+    uint32_t w = sm.x;
+
+    if (sm.tx_count) {
+        w = sm.tx[0];
+        memmove(sm.tx, sm.tx + 1, --sm.tx_count * sizeof(sm.tx[0]));
+    }
+    set_clk(false, t);
+    t += 3u * c;                                    /* pull, out y, jmp !y */
+    if (!(w & 1u)) {
+        set_data(sm.data, false, t);                /* set pindirs, 0 */
+        sm.t_ns = t + c;
+        sm.waiting = true;
+        return;
+    }
+    set_data(sm.data, true, t);                     /* set pindirs, 1 */
+    t += 2u * c;                                    /* set y, 11 */
+    for (int i = 0; i < 12; i++) {
+        set_clk(false, t);
+        set_data((w >> (1 + i)) & 1u, true, t);     /* out pins, 1 [1] */
+        t += 2u * c;
+        set_clk(true, t);                           /* jmp y-- side 1 [1] */
+        t += 2u * c;
+    }
+    set_clk(false, t);                              /* jmp top side 0 */
+    sm.t_ns = t + c;
+}
+
+/** Run the state machine up to now */
+static void sm_advance(void) {
+    uint64_t now = host_sim_now_ns();
+
+    while (sm.enabled && sm.t_ns <= now) {
+        if (sm.waiting) {
+            wait_start_step();
+        } else {
+            run_word();
+        }
+    }
+}
+
+static void sm_init(uint pin, double cycle_ns) {
+    (void)pin;
+    memset(&sm, 0, sizeof(sm));
+    sm.configured = true;
+    sm.cycle_ns = (uint32_t)(cycle_ns + 0.5);
+    /* pdi_program_init(): both pins driven high */
+    sm.clk = true;
+    sm.data = true;
+    sm.data_out = true;
+    host_pin_update(PDI_CLK_PIN, host_sim_now_ns());
+    host_pin_update(PDI_DATA_PIN, host_sim_now_ns());
+}
+
+static void sm_enable(bool enabled) {
+    sm_advance();
+    if (enabled && !sm.enabled && sm.t_ns < host_sim_now_ns()) {
+        sm.t_ns = host_sim_now_ns();
+    }
+    sm.enabled = enabled;
+}
+
+static void sm_clear_fifos(void) {
+    sm_advance();
+    sm.tx_count = 0;
+    sm.rx_count = 0;
+}
+
+static void sm_restart(void) {
+    sm_advance();
+}
+
+/** The instructions pdi.c executes: pull, mov x, osr and jmp */
+static void sm_exec(uint instr) {
+    static uint32_t osr;
+
+    sm_advance();
+    if ((instr & 0xE080u) == 0x8080u) {
+        if (sm.tx_count) {
+            osr = sm.tx[0];
+            memmove(sm.tx, sm.tx + 1, --sm.tx_count * sizeof(sm.tx[0]));
+        } else {
+            osr = sm.x;
+        }
+    } else if ((instr & 0xE0FFu) == (0xA000u | (uint)pio_x << 5 | (uint)pio_osr)) {
+        sm.x = osr;
+    } else if ((instr & 0xE000u) == 0x0000u) {
+        sm.waiting = false;     /* jmp top */
+    }
+}
+
+static void sm_put(uint32_t data) {
+    sm_advance();
+    if (sm.tx_count < SM_FIFO_DEPTH) {
+        sm.tx[sm.tx_count++] = data;
+    }
+}
+
+/** Full: the firmware spinning on it waits for the next pull */
+static bool sm_tx_full(void) {
+    sm_advance();
+    if (sm.tx_count < SM_FIFO_DEPTH) {
+        return false;
+    }
+    if (sm.enabled) {
+        host_sim_advance_ns(sm.t_ns - host_sim_now_ns() + 1u);
+    }
+    return true;
+}
+
+static bool sm_tx_empty(void) {
+    sm_advance();
+    if (sm.tx_count && sm.enabled) {
+        host_sim_advance_ns(sm.t_ns - host_sim_now_ns() + 1u);
+    }
+    return sm.tx_count == 0;
+}
+
+static bool sm_rx_empty(void) {
+    sm_advance();
+    return !sm.rx_count || sm.rx_ns[0] > host_sim_now_ns();
+}
+
+static uint32_t sm_get(void) {
+    uint32_t v;
+
+    sm_advance();
+    if (!sm.rx_count) {
+        return 0;
+    }
+    v = sm.rx[0];
+    sm.rx_count--;
+    memmove(sm.rx, sm.rx + 1, sm.rx_count * sizeof(sm.rx[0]));
+    memmove(sm.rx_ns, sm.rx_ns + 1, sm.rx_count * sizeof(sm.rx_ns[0]));
+    return v;
+}
+
+static int sm_drive(uint pin) {
+    if (!sm.configured) {
+        return -1;
+    }
+    if (pin == PDI_CLK_PIN) {
+        return sm.clk;
+    }
+    if (pin == PDI_DATA_PIN && sm.data_out) {
+        return sm.data;
+    }
+    return -1;
+}
+
+const host_pio_role_t host_pio_pdi = {
+    .init = sm_init,
+    .enable = sm_enable,
+    .clear_fifos = sm_clear_fifos,
+    .exec = sm_exec,
+    .restart = sm_restart,
+    .put = sm_put,
+    .tx_full = sm_tx_full,
+    .tx_empty = sm_tx_empty,
+    .rx_empty = sm_rx_empty,
+    .get = sm_get,
+    .drive = sm_drive,
+};
+
+/*******************************************************************************
+ * XMEGA PDI Physical Layer
+ ******************************************************************************/
+
+/**
+ * The target samples PDI_DATA on rising PDI_CLK edges and changes its
+ * output on falling ones. 16 clocks with PDI_DATA high enable PDI; a
+ * clock pause over 100 us disables it again. Frames, parity and the
+ * error state until a BREAK are as on TPI. A reply starts after the
+ * guard time (CTRL.GTVAL, 128 bits by default) when the link turns
+ * around; the bytes of one reply follow each other without idle bits.
+ */
+
+#define PDI_ENABLE_BITS     16u
+#define PDI_BREAK_BITS      12u
+#define PDI_FRAME_BITS      12u
+#define PDI_TIMEOUT_NS      100000u
+#define PDI_REPLY_MAX       512u
+
+static struct {
+    bool enabled;
+    bool clk;
+    uint64_t rise_ns;
+    uint8_t ones;
+    uint8_t zeros;
+    bool error;
+    int8_t rx_bit;
+    uint16_t rx_frame;
+
+    uint16_t guard_left;
+    uint8_t reply[PDI_REPLY_MAX];
+    uint32_t reply_head;
+    uint32_t reply_count;
+    uint16_t tx_frame;
+    uint8_t tx_left;
+    int8_t out;
+} phy;
+
+static uint8_t parity(uint8_t b) {
+    return (uint8_t)__builtin_parity(b);
+}
+
+static uint16_t guard_bits(uint8_t gtval) {
+    return gtval >= 7u ? 0u : (uint16_t)(128u >> gtval);
+}
+
+/*******************************************************************************
+ * PDI Controller and XMEGA NVM
+ ******************************************************************************/
+
+#define CS_STATUS           0x00
+#define CS_RESET            0x01
+#define CS_CTRL             0x02
+#define STATUS_NVMEN        0x02
+#define RESET_KEY           0x59
+
+#define IO_BASE             0x01000000u
+#define IO_SIG              0x0090u
+#define IO_NVM              0x01C0u
+#define NVM_CMD             (IO_NVM + 0x0A)
+#define NVM_CTRLA           (IO_NVM + 0x0B)
+#define NVM_STATUS          (IO_NVM + 0x0F)
+#define CTRLA_CMDEX         0x01
+#define NVM_BUSY            0xC0    /* NVMBUSY | FBUSY */
+
+#define ADDR_FLASH          0x00800000u
+#define ADDR_FUSE           0x008F0020u
+#define ADDR_LOCK           0x008F0027u
+
+#define CMD_NOP             0x00
+#define CMD_WRITE_LOCK_BITS 0x08
+#define CMD_LOAD_FLASH_BUF  0x23
+#define CMD_ERASE_FLASH_BUF 0x26
+#define CMD_ERASE_WRITE_PG  0x2F
+#define CMD_CHIP_ERASE      0x40
+#define CMD_READ_NVM        0x43
+
+#define PAGE_MAX            512u
+
+static const uint8_t nvm_key[8] = {0xFF, 0x88, 0xD8, 0xCD, 0x45, 0xAB, 0x89, 0x12};
+
+static struct {
+    uint8_t op;
+    uint8_t need;
+    uint8_t got;
+    bool data_phase;            /* ST data rather than operands */
+    uint8_t buf[8];
+    uint32_t addr;              /* STS address */
+    uint32_t repeat;
+    uint32_t ptr;
+
+    uint8_t gtval;
+    bool in_reset;
+    bool nvmen;
+
+    uint8_t cmd;
+    uint64_t busy_until;
+    bool erasing;               /* Chip erase: NVM access suspended */
+    uint8_t page[PAGE_MAX];
+} pdi;
+
+static bool nvm_busy(uint64_t t) {
+    return t < pdi.busy_until;
+}
+
+static uint8_t data_read(uint32_t addr, uint64_t t) {
+    host_target_t* tg = host_target();
+
+    if (pdi.erasing && nvm_busy(t)) {
+        return 0x00;    /* NVM controller off the bus until the erase is done */
+    }
+    if (addr >= IO_BASE) {
+        uint32_t io = addr - IO_BASE;
+        if (io >= IO_SIG && io < IO_SIG + 3u) {
+            return tg->signature[io - IO_SIG];
+        }
+        if (io == NVM_STATUS && pdi.nvmen) {
+            return nvm_busy(t) ? NVM_BUSY : 0x00;
+        }
+        if (io == NVM_CMD) {
+            return pdi.cmd;
+        }
+        return 0x00;
+    }
+    /* NVM memories read through READ_NVM only */
+    if (!pdi.nvmen || nvm_busy(t) || pdi.cmd != CMD_READ_NVM) {
+        return 0x00;
+    }
+    if (addr >= ADDR_FLASH && addr - ADDR_FLASH < tg->flash_bytes) {
+        return tg->flash[addr - ADDR_FLASH];
+    }
+    if (addr == ADDR_LOCK) {
+        return tg->lock;
+    }
+    return addr >= ADDR_FUSE && addr < ADDR_LOCK ? 0xFF : 0x00;
+}
+
+static void nvm_execute(uint64_t t) {
+    host_target_t* tg = host_target();
+
+    switch (pdi.cmd) {
+        case CMD_ERASE_FLASH_BUF:
+            memset(pdi.page, 0xFF, sizeof(pdi.page));
+            break;
+        case CMD_CHIP_ERASE:
+            memset(tg->flash, 0xFF, tg->flash_bytes);
+            memset(tg->eeprom, 0xFF, tg->eeprom_bytes);
+            tg->lock = 0xFF;
+            tg->chip_erases++;
+            pdi.busy_until = t + (uint64_t)tg->erase_us * 1000u;
+            pdi.erasing = true;
+            break;
+        default:
+            break;
+    }
+}
+
+static void data_write(uint32_t addr, uint8_t v, uint64_t t) {
+    host_target_t* tg = host_target();
+
+    if (!pdi.nvmen) {
+        return;
+    }
+    if (nvm_busy(t)) {
+        tg->busy_violations++;
+        return;
+    }
+    if (addr == IO_BASE + NVM_CMD) {
+        pdi.cmd = v;
+    } else if (addr == IO_BASE + NVM_CTRLA) {
+        if (v & CTRLA_CMDEX) {
+            nvm_execute(t);
+        }
+    } else if (addr >= ADDR_FLASH && addr - ADDR_FLASH < tg->flash_bytes) {
+        uint32_t off = addr - ADDR_FLASH;
+        uint32_t base = off - off % tg->page_bytes;
+
+        if (pdi.cmd == CMD_LOAD_FLASH_BUF) {
+            pdi.page[off % tg->page_bytes] = v;
+        } else if (pdi.cmd == CMD_ERASE_WRITE_PG) {
+            /* Any write inside the page starts erase + write */
+            memset(tg->flash + base, 0xFF, tg->page_bytes);
+            for (uint32_t i = 0; i < tg->page_bytes; i++) {
+                tg->flash[base + i] &= pdi.page[i];
+            }
+            tg->page_writes++;
+            pdi.busy_until = t + (uint64_t)tg->flash_write_us * 1000u;
+            memset(pdi.page, 0xFF, sizeof(pdi.page));
+        }
+    } else if (addr == ADDR_LOCK && pdi.cmd == CMD_WRITE_LOCK_BITS) {
+        tg->lock &= v;
+        pdi.busy_until = t + (uint64_t)tg->fuse_write_us * 1000u;
+    }
+}
+
+static uint8_t cs_read(uint8_t reg, uint64_t t) {
+    switch (reg) {
+        case CS_STATUS:
+            /* NVMEN reads 0 while a chip erase runs */
+            return pdi.nvmen && !(pdi.erasing && nvm_busy(t)) ? STATUS_NVMEN : 0x00;
+        case CS_RESET: return pdi.in_reset ? RESET_KEY : 0x00;
+        case CS_CTRL: return pdi.gtval;
+        default: return 0x00;
+    }
+}
+
+static void cs_write(uint8_t reg, uint8_t v) {
+    switch (reg) {
+        case CS_STATUS:
+            pdi.nvmen = pdi.nvmen && (v & STATUS_NVMEN);
+            break;
+        case CS_RESET:
+            pdi.in_reset = v == RESET_KEY;
+            break;
+        case CS_CTRL:
+            pdi.gtval = v & 0x07;
+            host_target()->guard_bits = (uint8_t)guard_bits(pdi.gtval);
+            break;
+        default:
+            break;
+    }
+}
+
+/** Queue reply bytes; the guard time only when the link turns around */
+static void reply(uint8_t b) {
+    if (!phy.reply_count && !phy.tx_left) {
+        phy.guard_left = guard_bits(pdi.gtval);
+    }
+    if (phy.reply_count < PDI_REPLY_MAX) {
+        phy.reply[(phy.reply_head + phy.reply_count++) % PDI_REPLY_MAX] = b;
+    }
+}
+
+/*******************************************************************************
+ * Instructions
+ ******************************************************************************/
+
+#define OP_LDS      0x00
+#define OP_LD       0x20
+#define OP_STS      0x40
+#define OP_ST       0x60
+#define OP_LDCS     0x80
+#define OP_REPEAT   0xA0
+#define OP_STCS     0xC0
+#define OP_KEY      0xE0
+
+#define PTR_INC     1u
+#define PTR_ADDR    2u
+
+static void expect(uint8_t n, bool data) {
+    pdi.need = n;
+    pdi.got = 0;
+    pdi.data_phase = data;
+}
+
+static uint32_t operand_value(void) {
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < pdi.got && i < 4u; i++) {
+        v |= (uint32_t)pdi.buf[i] << (8u * i);
+    }
+    return v;
+}
+
+static void opcode(uint8_t op, uint64_t t) {
+    uint8_t size = (uint8_t)((op & 0x03) + 1u);
+    uint8_t ptr_mode = (op >> 2) & 0x03;
+
+    pdi.op = op;
+    switch (op & 0xE0) {
+        case OP_LDS:
+        case OP_STS:
+            expect((uint8_t)(((op >> 2) & 0x03) + 1u), false);
+            return;
+        case OP_LD:
+            if (ptr_mode == PTR_ADDR) {
+                for (uint8_t i = 0; i < size; i++) {
+                    reply((uint8_t)(pdi.ptr >> (8u * i)));
+                }
+            } else {
+                for (; pdi.repeat; pdi.repeat--) {
+                    for (uint8_t i = 0; i < size; i++) {
+                        reply(data_read(pdi.ptr, t));
+                        pdi.ptr += ptr_mode == PTR_INC;
+                    }
+                }
+            }
+            pdi.repeat = 1;
+            return;
+        case OP_ST:
+            expect(size, ptr_mode != PTR_ADDR);
+            return;
+        case OP_LDCS:
+            reply(cs_read(op & 0x0F, t));
+            return;
+        case OP_STCS:
+            expect(1, false);
+            return;
+        case OP_REPEAT:
+            expect(size, false);
+            return;
+        case OP_KEY:
+            expect(8, false);
+            return;
+        default:
+            return;
+    }
+}
+
+static void operands_done(uint64_t t) {
+    uint8_t op = pdi.op;
+    uint32_t v = operand_value();
+
+    switch (op & 0xE0) {
+        case OP_LDS:
+            for (uint8_t i = 0; i <= (op & 0x03); i++) {
+                reply(data_read(v + i, t));
+            }
+            break;
+        case OP_STS:
+            pdi.addr = v;
+            expect((uint8_t)((op & 0x03) + 1u), true);
+            return;
+        case OP_ST:
+            pdi.ptr = v;
+            break;
+        case OP_STCS:
+            cs_write(op & 0x0F, (uint8_t)v);
+            break;
+        case OP_REPEAT:
+            pdi.repeat = v + 1u;
+            pdi.need = 0;
+            return;     /* Applies to the next instruction */
+        case OP_KEY:
+            pdi.nvmen = memcmp(pdi.buf, nvm_key, sizeof(nvm_key)) == 0 && pdi.in_reset;
+            break;
+        default:
+            break;
+    }
+    pdi.need = 0;
+    pdi.repeat = 1;
+}
+
+static void data_done(uint64_t t) {
+    uint8_t op = pdi.op;
+
+    if ((op & 0xE0) == OP_STS) {
+        for (uint8_t i = 0; i < pdi.got; i++) {
+            data_write(pdi.addr + i, pdi.buf[i], t);
+        }
+        pdi.need = 0;
+        pdi.repeat = 1;
+        return;
+    }
+    for (uint8_t i = 0; i < pdi.got; i++) {
+        data_write(pdi.ptr, pdi.buf[i], t);
+        pdi.ptr += ((op >> 2) & 0x03) == PTR_INC;
+    }
+    if (--pdi.repeat) {
+        expect(pdi.need, true);
+    } else {
+        pdi.need = 0;
+        pdi.repeat = 1;
+    }
+}
+
+static void instruction_byte(uint8_t b, uint64_t t) {
+    if (pdi.erasing && !nvm_busy(t)) {
+        pdi.erasing = false;
+    }
+    if (!pdi.need) {
+        opcode(b, t);
+        return;
+    }
+    pdi.buf[pdi.got++ & 7u] = b;
+    if (pdi.got < pdi.need) {
+        return;
+    }
+    if (pdi.data_phase) {
+        data_done(t);
+    } else {
+        operands_done(t);
+    }
+}
+
+/*******************************************************************************
+ * Frames and Pins
+ ******************************************************************************/
+
+/** Leave PDI: everything back to its reset state */
+static void pdi_disable(void) {
+    bool clk = phy.clk;
+
+    memset(&phy, 0, sizeof(phy));
+    phy.clk = clk;
+    phy.rx_bit = -1;
+    phy.out = -1;
+    memset(&pdi, 0, sizeof(pdi));
+    pdi.repeat = 1;
+    memset(pdi.page, 0xFF, sizeof(pdi.page));
+    host_target()->guard_bits = (uint8_t)guard_bits(0);
+}
+
+static void frame_done(uint64_t t) {
+    uint8_t b = (uint8_t)phy.rx_frame;
+    bool p = (phy.rx_frame >> 8) & 1u;
+    bool stops = ((phy.rx_frame >> 9) & 3u) == 3u;
+
+    if (p != parity(b) || !stops) {
+        host_target()->frame_errors++;
+        phy.error = true;
+        pdi.need = 0;
+        return;
+    }
+    instruction_byte(b, t);
+}
+
+static void clk_rise(uint64_t t) {
+    bool bit;
+
+    if (phy.rise_ns && t - phy.rise_ns > PDI_TIMEOUT_NS) {
+        pdi_disable();
+    }
+    phy.rise_ns = t;
+    bit = host_pin_level(PDI_DATA_PIN);
+
+    if (!phy.enabled) {
+        phy.ones = bit ? (uint8_t)(phy.ones + (phy.ones < PDI_ENABLE_BITS)) : 0;
+        phy.enabled = phy.ones >= PDI_ENABLE_BITS;
+        return;
+    }
+    if (phy.guard_left || phy.tx_left || phy.reply_count) {
+        return;     /* Sending: half duplex */
+    }
+
+    phy.zeros = bit ? 0 : (uint8_t)(phy.zeros + (phy.zeros < 255u));
+    if (phy.zeros >= PDI_BREAK_BITS) {
+        phy.error = false;
+        phy.rx_bit = -1;
+        pdi.need = 0;
+        return;
+    }
+    if (phy.rx_bit < 0) {
+        if (!bit && !phy.error) {
+            phy.rx_bit = 0;
+            phy.rx_frame = 0;
+        }
+        return;
+    }
+    phy.rx_frame |= (uint16_t)bit << phy.rx_bit;
+    if (++phy.rx_bit == PDI_FRAME_BITS - 1) {
+        phy.rx_bit = -1;
+        frame_done(t);
+    }
+}
+
+static void clk_fall(void) {
+    if (phy.guard_left) {
+        phy.guard_left--;
+        phy.out = -1;
+        return;
+    }
+    if (!phy.tx_left && phy.reply_count) {
+        uint8_t b = phy.reply[phy.reply_head];
+        phy.reply_head = (phy.reply_head + 1u) % PDI_REPLY_MAX;
+        phy.reply_count--;
+        /* ST(0) D0..D7 P SP1 SP2, sent from bit 0 */
+        phy.tx_frame = (uint16_t)((uint16_t)b << 1 | (uint16_t)parity(b) << 9 | 3u << 10);
+        phy.tx_left = PDI_FRAME_BITS;
+    }
+    if (phy.tx_left) {
+        phy.out = (int8_t)(phy.tx_frame & 1u);
+        phy.tx_frame >>= 1;
+        phy.tx_left--;
+    } else {
+        phy.out = -1;
+    }
+}
+
+static void pdi_pico_drive(uint pin, int level, uint64_t t_ns) {
+    bool clk;
+
+    if (pin != PDI_CLK_PIN) {
+        return;
+    }
+    clk = level == 1;
+    if (clk == phy.clk) {
+        return;
+    }
+    phy.clk = clk;
+    if (clk) {
+        clk_rise(t_ns);
+    } else {
+        clk_fall();
+    }
+}
+
+static int pdi_drive(uint pin) {
+    return pin == PDI_DATA_PIN ? phy.out : -1;
+}
+
+const host_board_t host_board_pdi = {
+    .pico_drive = pdi_pico_drive,
+    .drive = pdi_drive,
+};
+
+void host_pdi_reset(void) {
+    memset(&sm, 0, sizeof(sm));
+    phy.clk = false;
+    pdi_disable();
+}
@@ -0,0 +1,198 @@
+/**
+ * @file host_phy.h
+ * @brief Pins, Peripherals and Target Boards Inside the Host Simulation
+ *
+ * Internal to tools/host: glue between the pin core in host_sim.c, the
+ * peripheral models behind the SDK stand-ins, and the simulated targets.
+ *
+ * Pins:
+ *   Each pin is driven by the Pico (SIO with the output enabled, or the
+ *   peripheral its function selects), by the attached board, or by
+ *   neither, when it reads its pull. Whenever the Pico's drive of a pin
+ *   changes the board hears about it with a timestamp, so a target sees
+ *   every edge the firmware makes, at the time it makes it.
+ *
+ * Time:
+ *   Peripherals may clock a board ahead of the simulated clock (a PL022
+ *   frame is shifted out when it is queued); the firmware cannot touch
+ *   the pins before those edges have passed, so boards still see them in
+ *   order.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pico/stdlib.h>
+#include <hardware/pio.h>
+
+/*******************************************************************************
+ * Clock
+ ******************************************************************************/
+
+/** RP2040 system clock (clk_sys = clk_peri) in the simulation */
+#define HOST_SYS_HZ         125000000u
+#define HOST_CYCLE_NS       8u
+
+/** Cost of one SIO or GPIO access in system cycles */
+#define HOST_SIO_CYCLES     3u
+
+/**
+ * @brief Spend system cycles (applies pending SIO writes first)
+ */
+void host_sim_cycles(uint32_t cycles);
+
+/*******************************************************************************
+ * Pins
+ ******************************************************************************/
+
+#define HOST_PINS           30u
+
+/**
+ * @brief A simulated target wired to the Pico's pins
+ */
+typedef struct {
+    /** The Pico's drive of pin changed at t_ns (level -1: released) */
+    void (*pico_drive)(uint pin, int level, uint64_t t_ns);
+
+    /** The board's drive of pin (-1: released) */
+    int (*drive)(uint pin);
+} host_board_t;
+
+/**
+ * @brief Wire a board to the pins (NULL: nothing connected)
+ */
+void host_board_attach(const host_board_t* board);
+
+/**
+ * @brief Level of a line: the Pico's drive, else the board's, else the pull
+ *
+ * Both sides driving different levels reads 0 and counts a contention.
+ */
+bool host_pin_level(uint pin);
+
+/**
+ * @brief Tell the board about a change of the Pico's drive of pin
+ *
+ * Peripheral models call this after changing what they drive.
+ */
+void host_pin_update(uint pin, uint64_t t_ns);
+
+/**
+ * @brief Apply the gpio_set/gpio_clr writes of the last sio_hw access
+ */
+void host_sio_flush(void);
+
+/*******************************************************************************
+ * Peripherals (drive of the pins their function selects, -1: input)
+ ******************************************************************************/
+
+/** SPI0 (host_isp.c): SCK and MOSI */
+int host_spi_drive(uint pin);
+
+/** Reset SPI0 to its power-up state */
+void host_spi_reset(void);
+
+/** UART1 (host_updi.c): TX, high when idle, low during a break */
+int host_uart_drive(uint pin);
+
+/** Reset UART1 to its power-up state */
+void host_uart_reset(void);
+
+/** PIO0 (host_pio.c): pins a state machine's role drives */
+int host_pio_drive(uint pin);
+
+/** Reset PIO0: programs unloaded, state machines unclaimed */
+void host_pio_reset(void);
+
+/*******************************************************************************
+ * PIO State Machine Roles
+ ******************************************************************************/
+
+/** Bus cycles of one PIO register or FIFO access */
+#define HOST_PIO_BUS_CYCLES 2u
+
+/**
+ * @brief What a state machine does, in place of its program
+ *
+ * Set by the *_program_init() stand-ins. Every hook may be NULL; the FIFO
+ * checks then report empty FIFOs.
+ */
+typedef struct host_pio_role {
+    /** pio_sm_init(): configured on pin, disabled; one SM cycle lasts cycle_ns */
+    void (*init)(uint pin, double cycle_ns);
+    void (*enable)(bool enabled);
+    void (*clear_fifos)(void);
+    void (*exec)(uint instr);
+    /** pio_sm_restart(): internal state cleared, program counter kept */
+    void (*restart)(void);
+    void (*put)(uint32_t data);
+    /** TX FIFO checks; a firmware spinning on a full FIFO may skip ahead */
+    bool (*tx_full)(void);
+    bool (*tx_empty)(void);
+    bool (*rx_empty)(void);
+    uint32_t (*get)(void);
+    /** Drive of pin (-1: input) */
+    int (*drive)(uint pin);
+} host_pio_role_t;
+
+/**
+ * @brief Give a state machine its role (the *_program_init() stand-ins)
+ *
+ * clkdiv is truncated to the divider's 16.8 fixed point, as the SDK does.
+ */
+void host_pio_sm_init(PIO pio, uint sm, const host_pio_role_t* role, uint pin, float clkdiv);
+
+/** debugWIRE UART on the RESET pin (host_dw.c) */
+extern const host_pio_role_t host_pio_dw_tx;
+extern const host_pio_role_t host_pio_dw_rx;
+
+/** pdi.pio: frames out, receive words in, PDI_CLK on side-set (host_pdi.c) */
+extern const host_pio_role_t host_pio_pdi;
+
+/*******************************************************************************
+ * Boards
+ ******************************************************************************/
+
+/** Classic AVR on the ISP header (host_isp.c) */
+extern const host_board_t host_board_isp;
+
+/** Reset the classic AVR's serial interface and pin state */
+void host_isp_reset(void);
+
+/** Reduced-core ATtiny on TPI (host_tpi.c) */
+extern const host_board_t host_board_tpi;
+
+/** Reset the TPI link: disabled, guard time 128 bits, NVM locked */
+void host_tpi_reset(void);
+
+/** tinyAVR or megaAVR 0 on UPDI (host_updi.c) */
+extern const host_board_t host_board_updi;
+
+/** Reset the UPDI link and NVMCTRL for the target's signature */
+void host_updi_reset(void);
+
+/** XMEGA on PDI (host_pdi.c) */
+extern const host_board_t host_board_pdi;
+
+/** Reset the PDI state machine and link: disabled, guard time 128 bits */
+void host_pdi_reset(void);
+
+/*******************************************************************************
+ * debugWIRE (host_dw.c): the classic AVR's RESET pin with DWEN programmed
+ ******************************************************************************/
+
+/** DWEN is programmed and dW was not disabled since power-up */
+bool host_dw_active(void);
+
+/** The Pico's drive of RESET changed while dW is active */
+void host_dw_pico_drive(int level, uint64_t t_ns);
+
+/** The target's drive of RESET (-1: released) */
+int host_dw_drive(void);
+
+/** Reset the dW link and the target's debug state (power-up: running) */
+void host_dw_reset(void);
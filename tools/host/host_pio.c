@@ -0,0 +1,195 @@
+/**
+ * @file host_pio.c
+ * @brief Simulated PIO0: Program Memory, State Machine Claims and Roles
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_phy.h"
+#include <string.h>
+#include <hardware/pio.h>
+
+/*******************************************************************************
+ * Program Memory and Claims
+ ******************************************************************************/
+
+static uint32_t used_instructions;
+static uint8_t claimed;
+static const host_pio_role_t* roles[HOST_PIO_SMS];
+static bool enabled[HOST_PIO_SMS];
+
+static uint32_t program_mask(const pio_program_t* program, uint offset) {
+    uint32_t mask = program->length >= 32u ? 0xFFFFFFFFu : (1u << program->length) - 1u;
+    return mask << offset;
+}
+
+/** Where the program fits, highest offset first like the SDK; -1 if full */
+static int find_offset(const pio_program_t* program) {
+    if (program->origin >= 0) {
+        uint offset = (uint)program->origin;
+        return offset + program->length <= HOST_PIO_INSTRUCTIONS
+            && !(used_instructions & program_mask(program, offset)) ? (int)offset : -1;
+    }
+    for (int offset = (int)(HOST_PIO_INSTRUCTIONS - program->length); offset >= 0; offset--) {
+        if (!(used_instructions & program_mask(program, (uint)offset))) {
+            return offset;
+        }
+    }
+    return -1;
+}
+
+bool pio_can_add_program(PIO pio, const pio_program_t* program) {
+    (void)pio;
+    return find_offset(program) >= 0;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t* program) {
+    (void)pio;
+    int offset = find_offset(program);
+    if (offset < 0) {
+        return 0;   /* The SDK panics; callers here always check first */
+    }
+    used_instructions |= program_mask(program, (uint)offset);
+    return (uint)offset;
+}
+
+void pio_remove_program(PIO pio, const pio_program_t* program, uint loaded_offset) {
+    (void)pio;
+    used_instructions &= ~program_mask(program, loaded_offset);
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    (void)pio;
+    (void)required;
+    for (uint sm = 0; sm < HOST_PIO_SMS; sm++) {
+        if (!(claimed & (1u << sm))) {
+            claimed |= (uint8_t)(1u << sm);
+            return (int)sm;
+        }
+    }
+    return -1;
+}
+
+void pio_sm_unclaim(PIO pio, uint sm) {
+    (void)pio;
+    claimed &= (uint8_t)~(1u << sm);
+    roles[sm] = NULL;
+}
+
+void pio_gpio_init(PIO pio, uint pin) {
+    (void)pio;
+    gpio_set_function(pin, GPIO_FUNC_PIO0);
+}
+
+/*******************************************************************************
+ * State Machines
+ ******************************************************************************/
+
+/** A register or FIFO access; pending SIO writes land first */
+static void bus_access(void) {
+    host_sim_cycles(HOST_PIO_BUS_CYCLES);
+}
+
+void host_pio_sm_init(PIO pio, uint sm, const host_pio_role_t* role, uint pin, float clkdiv) {
+    (void)pio;
+    uint32_t div_int = (uint32_t)clkdiv;
+    uint32_t div_frac = (uint32_t)((clkdiv - (float)div_int) * 256.0f);
+
+    bus_access();
+    roles[sm] = role;
+    enabled[sm] = false;
+    if (role->init) {
+        role->init(pin, HOST_CYCLE_NS * ((double)div_int + div_frac / 256.0));
+    }
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enable) {
+    (void)pio;
+    bus_access();
+    if (roles[sm] && roles[sm]->enable && enable != enabled[sm]) {
+        roles[sm]->enable(enable);
+    }
+    enabled[sm] = enable;
+}
+
+void pio_sm_clear_fifos(PIO pio, uint sm) {
+    (void)pio;
+    bus_access();
+    if (roles[sm] && roles[sm]->clear_fifos) {
+        roles[sm]->clear_fifos();
+    }
+}
+
+void pio_sm_exec(PIO pio, uint sm, uint instr) {
+    (void)pio;
+    bus_access();
+    if (roles[sm] && roles[sm]->exec) {
+        roles[sm]->exec(instr);
+    }
+}
+
+void pio_sm_restart(PIO pio, uint sm) {
+    (void)pio;
+    bus_access();
+    if (roles[sm] && roles[sm]->restart) {
+        roles[sm]->restart();
+    }
+}
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data) {
+    (void)pio;
+    bus_access();
+    if (roles[sm] && roles[sm]->put) {
+        roles[sm]->put(data);
+    }
+}
+
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm) {
+    (void)pio;
+    bus_access();
+    return roles[sm] && roles[sm]->tx_full && roles[sm]->tx_full();
+}
+
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm) {
+    (void)pio;
+    bus_access();
+    return !(roles[sm] && roles[sm]->tx_empty) || roles[sm]->tx_empty();
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+    while (pio_sm_is_tx_fifo_full(pio, sm)) {
+    }
+    pio_sm_put(pio, sm, data);
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+    (void)pio;
+    bus_access();
+    return !(roles[sm] && roles[sm]->rx_empty) || roles[sm]->rx_empty();
+}
+
+uint32_t pio_sm_get(PIO pio, uint sm) {
+    (void)pio;
+    bus_access();
+    return roles[sm] && roles[sm]->get ? roles[sm]->get() : 0;
+}
+
+int host_pio_drive(uint pin) {
+    for (uint sm = 0; sm < HOST_PIO_SMS; sm++) {
+        if (roles[sm] && roles[sm]->drive) {
+            int level = roles[sm]->drive(pin);
+            if (level >= 0) {
+                return level;
+            }
+        }
+    }
+    return -1;
+}
+
+void host_pio_reset(void) {
+    used_instructions = 0;
+    claimed = 0;
+    memset(roles, 0, sizeof(roles));
+    memset(enabled, 0, sizeof(enabled));
+}
@@ -0,0 +1,424 @@
+/**
+ * @file host_sim.c
+ * @brief Simulated Clock, USB CDC and Pins for Host Builds
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_sim.h"
+#include "host_phy.h"
+#include <stdio.h>
+#include <string.h>
+#include <pico/stdlib.h>
+#include <hardware/flash.h>
+#include <hardware/structs/sio.h>
+#include <hardware/structs/systick.h>
+#include "tusb.h"
+
+/*******************************************************************************
+ * Clock
+ ******************************************************************************/
+
+static uint64_t now_ns;
+
+/** Time moves on: the pins first see what the last SIO access wrote */
+static void advance_ns(uint64_t ns) {
+    host_sio_flush();
+    now_ns += ns;
+}
+
+uint64_t host_sim_now_ns(void) {
+    return now_ns;
+}
+
+void host_sim_advance_ns(uint64_t ns) {
+    advance_ns(ns);
+}
+
+void host_sim_cycles(uint32_t cycles) {
+    advance_ns((uint64_t)cycles * HOST_CYCLE_NS);
+}
+
+uint64_t time_us_64(void) {
+    return now_ns / 1000u;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+void sleep_us(uint64_t us) {
+    advance_ns(us * 1000u);
+}
+
+void sleep_ms(uint32_t ms) {
+    advance_ns((uint64_t)ms * 1000000u);
+}
+
+void busy_wait_us_32(uint32_t us) {
+    advance_ns((uint64_t)us * 1000u);
+}
+
+void busy_wait_at_least_cycles(uint32_t minimum_cycles) {
+    host_sim_cycles(minimum_cycles);
+}
+
+void tight_loop_contents(void) {
+    advance_ns(1000u);
+}
+
+static systick_hw_t systick_regs;
+
+/** Free-running 24-bit down-counter at the system clock */
+systick_hw_t* host_systick(void) {
+    systick_regs.cvr = 0x00FFFFFFu - (uint32_t)((now_ns / HOST_CYCLE_NS) & 0x00FFFFFFu);
+    return &systick_regs;
+}
+
+/*******************************************************************************
+ * RP2040 Flash
+ ******************************************************************************/
+
+uint8_t host_xip_flash[PICO_FLASH_SIZE_BYTES];
+
+static host_flash_stats_t flash_stats;
+static int64_t flash_fail_op = -1;     /* Operations left before the power cut */
+static uint32_t flash_fail_bytes;
+static bool flash_powered = true;
+
+/** Bytes op may change: all of them, or up to the power cut */
+static size_t flash_op_budget(size_t count) {
+    if (!flash_powered) {
+        return 0;
+    }
+    if (flash_fail_op < 0 || flash_fail_op-- > 0) {
+        return count;
+    }
+    flash_powered = false;
+    return flash_fail_bytes;
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    size_t budget = flash_op_budget(count);
+
+    flash_stats.erases++;
+    for (size_t i = 0; i < count && budget; i++) {
+        if (host_xip_flash[flash_offs + i] != 0xFF) {
+            host_xip_flash[flash_offs + i] = 0xFF;
+            budget--;
+        }
+    }
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count) {
+    size_t budget = flash_op_budget(count);
+
+    flash_stats.programs++;
+    for (size_t i = 0; i < count && budget; i++) {
+        uint8_t v = host_xip_flash[flash_offs + i] & data[i];
+        if (v != host_xip_flash[flash_offs + i]) {
+            host_xip_flash[flash_offs + i] = v;
+            budget--;
+        }
+    }
+}
+
+const host_flash_stats_t* host_flash_stats(void) {
+    return &flash_stats;
+}
+
+void host_flash_fail(uint32_t op, uint32_t bytes) {
+    flash_fail_op = op;
+    flash_fail_bytes = bytes;
+}
+
+void host_flash_power_up(void) {
+    flash_fail_op = -1;
+    flash_powered = true;
+}
+
+bool host_flash_save(const char* path) {
+    FILE* f = fopen(path, "wb");
+    bool ok = f && fwrite(host_xip_flash, 1, sizeof(host_xip_flash), f) == sizeof(host_xip_flash);
+
+    if (f && fclose(f) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+bool host_flash_load(const char* path) {
+    FILE* f = fopen(path, "rb");
+    bool ok = f && fread(host_xip_flash, 1, sizeof(host_xip_flash), f) == sizeof(host_xip_flash);
+
+    if (f) {
+        fclose(f);
+    }
+    return ok;
+}
+
+/*******************************************************************************
+ * USB CDC
+ ******************************************************************************/
+
+#define CDC_TX_FIFO     256u
+#define CDC_PACKET      64u
+
+static uint8_t tx_fifo[CDC_TX_FIFO];
+static uint32_t tx_len;
+static host_cdc_sink_t tx_sink;
+static void* tx_ctx;
+static bool cdc_connected = true;
+
+void host_cdc_set_sink(host_cdc_sink_t sink, void* ctx) {
+    tx_sink = sink;
+    tx_ctx = ctx;
+}
+
+void host_cdc_set_connected(bool connected) {
+    cdc_connected = connected;
+}
+
+bool tud_cdc_connected(void) {
+    return cdc_connected;
+}
+
+uint32_t tud_cdc_write_flush(void) {
+    uint32_t n = tx_len;
+    if (!cdc_connected) {
+        return 0;   /* Nobody reads: the bytes stay queued */
+    }
+    if (n && tx_sink) {
+        tx_sink(tx_fifo, n, tx_ctx);
+    }
+    tx_len = 0;
+    return n;
+}
+
+uint32_t tud_cdc_write(const void* buffer, uint32_t bufsize) {
+    uint32_t n = CDC_TX_FIFO - tx_len;
+    if (n > bufsize) {
+        n = bufsize;
+    }
+    memcpy(tx_fifo + tx_len, buffer, n);
+    tx_len += n;
+    if (tx_len >= CDC_PACKET) {
+        tud_cdc_write_flush();  /* TinyUSB starts a transfer per full packet */
+    }
+    return n;
+}
+
+uint32_t tud_cdc_write_char(char ch) {
+    return tud_cdc_write(&ch, 1);
+}
+
+uint32_t tud_cdc_write_available(void) {
+    return CDC_TX_FIFO - tx_len;
+}
+
+void tud_task(void) {
+    advance_ns(HOST_LOOP_NS);
+}
+
+/*******************************************************************************
+ * Pins
+ ******************************************************************************/
+
+static uint8_t pin_fn[HOST_PINS];
+static uint32_t sio_out;
+static uint32_t sio_oe;
+static uint32_t pull_up;
+static int8_t pico_level[HOST_PINS];    /* Drive the board was last told about */
+static const host_board_t* board;
+static uint32_t contentions;
+
+static sio_hw_t sio_regs;
+static uint64_t sio_write_ns;           /* When the pending SIO writes happened */
+
+void host_board_attach(const host_board_t* b) {
+    board = b;
+}
+
+/** The Pico's drive of a pin: SIO output, its peripheral, or none */
+static int pico_drive(uint pin) {
+    switch (pin_fn[pin]) {
+        case GPIO_FUNC_SIO:
+            return (sio_oe >> pin) & 1u ? (int)((sio_out >> pin) & 1u) : -1;
+        case GPIO_FUNC_SPI:
+            return host_spi_drive(pin);
+        case GPIO_FUNC_UART:
+            return host_uart_drive(pin);
+        case GPIO_FUNC_PIO0:
+            return host_pio_drive(pin);
+        default:
+            return -1;
+    }
+}
+
+bool host_pin_level(uint pin) {
+    int pico = pico_drive(pin);
+    int target = board ? board->drive(pin) : -1;
+
+    if (pico >= 0 && target >= 0 && pico != target) {
+        contentions++;
+        return false;
+    }
+    if (pico >= 0) {
+        return pico;
+    }
+    if (target >= 0) {
+        return target;
+    }
+    return (pull_up >> pin) & 1u;
+}
+
+uint32_t host_sim_contentions(void) {
+    return contentions;
+}
+
+void host_pin_update(uint pin, uint64_t t_ns) {
+    int level = pico_drive(pin);
+    if (level != pico_level[pin]) {
+        pico_level[pin] = (int8_t)level;
+        if (board) {
+            board->pico_drive(pin, level, t_ns);
+        }
+    }
+}
+
+static void update_mask(uint32_t mask, uint64_t t_ns) {
+    for (uint pin = 0; mask; pin++, mask >>= 1) {
+        if (mask & 1u) {
+            host_pin_update(pin, t_ns);
+        }
+    }
+}
+
+/** A GPIO call: pending SIO writes land first, then it costs an SIO access */
+static void gpio_access(void) {
+    host_sim_cycles(HOST_SIO_CYCLES);
+}
+
+void gpio_init(uint gpio) {
+    gpio_access();
+    sio_oe &= ~(1u << gpio);
+    sio_out &= ~(1u << gpio);
+    pin_fn[gpio] = GPIO_FUNC_SIO;
+    host_pin_update(gpio, now_ns);
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    gpio_access();
+    pin_fn[gpio] = (uint8_t)fn;
+    host_pin_update(gpio, now_ns);
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    gpio_access();
+    sio_oe = out ? sio_oe | (1u << gpio) : sio_oe & ~(1u << gpio);
+    host_pin_update(gpio, now_ns);
+}
+
+void gpio_put(uint gpio, bool value) {
+    gpio_access();
+    sio_out = value ? sio_out | (1u << gpio) : sio_out & ~(1u << gpio);
+    host_pin_update(gpio, now_ns);
+}
+
+bool gpio_get(uint gpio) {
+    gpio_access();
+    return host_pin_level(gpio);
+}
+
+void gpio_pull_up(uint gpio) {
+    gpio_access();
+    pull_up |= 1u << gpio;
+}
+
+void host_sio_flush(void) {
+    uint32_t set = sio_regs.gpio_set;
+    uint32_t clr = sio_regs.gpio_clr;
+
+    if (set | clr) {
+        sio_regs.gpio_set = 0;
+        sio_regs.gpio_clr = 0;
+        sio_out = (sio_out | set) & ~clr;
+        update_mask(set | clr, sio_write_ns);
+    }
+}
+
+/**
+ * @brief One access through sio_hw
+ *
+ * The writes of the previous access take effect when it ended; this one
+ * costs HOST_SIO_CYCLES and reads the lines as they are once it is done.
+ */
+sio_hw_t* host_sio_access(void) {
+    host_sim_cycles(HOST_SIO_CYCLES);
+    sio_write_ns = now_ns;
+
+    uint32_t in = 0;
+    for (uint pin = 0; pin < HOST_PINS; pin++) {
+        in |= (uint32_t)host_pin_level(pin) << pin;
+    }
+    sio_regs.gpio_in = in;
+    sio_regs.gpio_out = sio_out;
+    return &sio_regs;
+}
+
+/** Power-up state: every pin an input with no function */
+static void pins_reset(void) {
+    memset(pin_fn, GPIO_FUNC_NULL, sizeof(pin_fn));
+    memset(pico_level, -1, sizeof(pico_level));
+    memset(&sio_regs, 0, sizeof(sio_regs));
+    sio_out = 0;
+    sio_oe = 0;
+    pull_up = 0;
+    contentions = 0;
+    sio_write_ns = 0;
+}
+
+/*******************************************************************************
+ * Reset
+ ******************************************************************************/
+
+void host_sim_reset(void) {
+    static const uint8_t atmega328p[3] = {0x1E, 0x95, 0x0F};
+
+    now_ns = 0;
+    tx_len = 0;
+    cdc_connected = true;
+    memset(host_xip_flash, 0xFF, sizeof(host_xip_flash));
+    memset(&flash_stats, 0, sizeof(flash_stats));
+    host_flash_power_up();
+    pins_reset();
+    host_spi_reset();
+    host_uart_reset();
+    host_pio_reset();
+    host_sim_connect(HOST_LINK_ISP, atmega328p);
+}
+
+void host_sim_connect(host_link_t link, const uint8_t sig[3]) {
+    host_target_init(sig);
+    host_isp_reset();
+    host_dw_reset();
+    host_tpi_reset();
+    host_pdi_reset();
+    if (link == HOST_LINK_TPI) {
+        host_target()->lfuse = 0xFF;
+        host_target()->cpu_hz = 1000000u;
+        host_board_attach(&host_board_tpi);
+    } else if (link == HOST_LINK_UPDI) {
+        host_target()->lock = 0xC5;
+        host_target()->cpu_hz = 3333333u;
+        host_target()->updi_max_hz = 16000000u;
+        host_updi_reset();
+        host_board_attach(&host_board_updi);
+    } else if (link == HOST_LINK_PDI) {
+        host_target()->cpu_hz = 2000000u;
+        host_board_attach(&host_board_pdi);
+    } else {
+        host_board_attach(&host_board_isp);
+    }
+}
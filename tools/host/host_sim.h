@@ -0,0 +1,271 @@
+/**
+ * @file host_sim.h
+ * @brief Simulated Clock, USB CDC, Pins and ISP Target for Host Builds
+ *
+ * Backs the SDK stand-ins in this directory so the firmware's protocol
+ * and ISP layers (stk500v1.c down to avrprog.c) run unmodified on the
+ * development machine. tools/replay drives them with recorded sessions.
+ *
+ * Clock:
+ *   One simulated nanosecond counter. It only moves when the firmware
+ *   sleeps, busy-waits, touches a pin or peripheral register, and by a
+ *   fixed cost per main loop pass (tud_task()), so a replay is
+ *   deterministic and its wall time is what the firmware would have
+ *   spent.
+ *
+ * USB CDC:
+ *   Reply bytes are delivered to a sink when flushed and whenever a full
+ *   64-byte packet is queued, like TinyUSB does. Received bytes are fed
+ *   by the caller through stk500v1_feed(), as main.c does.
+ *
+ * Pins:
+ *   The firmware's own PHY code runs: GPIO calls, sio_hw accesses (3
+ *   system cycles each at 125 MHz), a PL022 model behind hardware/spi.h
+ *   and PIO state machine roles behind hardware/pio.h move the Pico's
+ *   pins, and the target sees each edge at its time (host_phy.h).
+ *
+ * Target:
+ *   A classic AVR on the ISP header, clocked bit by bit: serial
+ *   programming instruction set, page buffer, flash and EEPROM with NOR
+ *   rules, fuses, and RDY/BSY timing from the device table. An SCK phase
+ *   shorter than the datasheet allows (more than 2 target clocks below
+ *   12 MHz, at least 3 from 12 MHz) garbles the instruction, so the rate
+ *   selection in target_clock.c and avr_profile.c meets the same limit
+ *   as on hardware. Programming Enable needs the datasheet's 20 ms in
+ *   reset after power-up or after the target ran.
+ *
+ * debugWIRE:
+ *   With DWEN programmed in the high fuse, RESET is the target's open
+ *   drain dW line instead: it answers a break with 0x55 at f_cpu/128 and
+ *   takes the command set debugwire.c uses (memory reads, register
+ *   writes, SPM from the boot section, disable), behind the firmware's
+ *   own PIO UART and SysTick rate measurement. Both ends sample each
+ *   frame by their own clock, so a rate mismatch garbles bytes.
+ *
+ * TPI:
+ *   host_sim_connect(HOST_LINK_TPI, ...) wires a reduced-core ATtiny
+ *   instead: frames are checked for parity and stop bits, responses
+ *   follow the programmed guard time, and the NVM controller takes word
+ *   writes, chip and section erases with NVMCSR.BSY timing. A TPICLK
+ *   period shorter than one target clock garbles the frame.
+ *
+ * UPDI:
+ *   HOST_LINK_UPDI wires a tinyAVR or megaAVR 0 to the UART1 model: it
+ *   takes the rate from each SYNC up to what its UPDI clock allows, keeps
+ *   the guard time and inter-byte delay, runs REPEAT bursts, the key and
+ *   reset sequence, and NVMCTRL version 0 (page buffer, WP, ERWP, PBC,
+ *   CHER with busy timing). Errors leave the link deaf until a BREAK.
+ *
+ * PDI:
+ *   HOST_LINK_PDI wires an XMEGA to the PIO state machine model of
+ *   pdi.pio, clocked edge by edge: frames are checked for parity and stop
+ *   bits, replies follow the guard time, and the NVM controller takes
+ *   REPEAT + ST *(ptr++) page buffer loads, ERASE_WRITE_PAGE triggered by
+ *   a write into the page, CMDEX commands and lock bit writes, with
+ *   NVM_STATUS busy and STATUS.NVMEN cleared during a chip erase.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+ * Clock
+ ******************************************************************************/
+
+/** Simulated cost of one main loop pass (tud_task()) in ns */
+#define HOST_LOOP_NS            2000u
+
+/**
+ * @brief Get the simulated time in ns since host_sim_reset()
+ */
+uint64_t host_sim_now_ns(void);
+
+/**
+ * @brief Advance the simulated clock
+ */
+void host_sim_advance_ns(uint64_t ns);
+
+/**
+ * @brief Reset clock, USB state, RP2040 flash (erased) and target
+ *
+ * Call before stk500v1_init() and friends.
+ */
+void host_sim_reset(void);
+
+/*******************************************************************************
+ * RP2040 Flash
+ ******************************************************************************/
+
+/** Erase and program calls since host_sim_reset() */
+typedef struct {
+    uint32_t erases;
+    uint32_t programs;
+} host_flash_stats_t;
+
+/**
+ * @brief Get the flash operation counts
+ */
+const host_flash_stats_t* host_flash_stats(void);
+
+/**
+ * @brief Cut the power during a later flash operation
+ *
+ * The op-th erase or program from now (0: the next one) stops once it
+ * has changed bytes bytes; later operations do nothing until
+ * host_flash_power_up(), as the firmware would not be running.
+ */
+void host_flash_fail(uint32_t op, uint32_t bytes);
+
+/**
+ * @brief Power back on: flash operations work again, the image is kept
+ */
+void host_flash_power_up(void);
+
+/**
+ * @brief Save the flash image to a file, or load it back
+ *
+ * @return false if the file could not be written or read in full
+ */
+bool host_flash_save(const char* path);
+bool host_flash_load(const char* path);
+
+/*******************************************************************************
+ * USB CDC
+ ******************************************************************************/
+
+/** Receives reply bytes as they leave the device */
+typedef void (*host_cdc_sink_t)(const uint8_t* data, size_t len, void* ctx);
+
+/**
+ * @brief Set the receiver of reply bytes
+ */
+void host_cdc_set_sink(host_cdc_sink_t sink, void* ctx);
+
+/**
+ * @brief Open or close the port (open after host_sim_reset())
+ *
+ * While closed, tud_cdc_connected() is false and queued bytes are not
+ * delivered, so the TX FIFO fills up as on a real unplugged port.
+ */
+void host_cdc_set_connected(bool connected);
+
+/*******************************************************************************
+ * Target
+ ******************************************************************************/
+
+#define HOST_TARGET_MAX_FLASH   (256u * 1024u)
+#define HOST_TARGET_MAX_EEPROM  4096u
+
+/**
+ * @brief Simulated target state, open to seeding and inspection
+ */
+typedef struct {
+    uint8_t signature[3];
+    uint8_t calibration;
+    uint8_t lfuse;
+    uint8_t hfuse;
+    uint8_t efuse;
+    uint8_t lock;
+    uint32_t cpu_hz;            /**< Target clock; sets the SCK limit */
+
+    uint32_t flash_bytes;
+    uint16_t page_bytes;
+    uint16_t eeprom_bytes;
+    uint8_t eeprom_page_bytes;
+    uint32_t flash_write_us;
+    uint32_t eeprom_write_us;
+    uint32_t erase_us;
+    uint32_t fuse_write_us;
+    uint8_t glitch_bits;        /**< SCK bits miscounted on the next entry into reset */
+
+    uint8_t flash[HOST_TARGET_MAX_FLASH];
+    uint8_t eeprom[HOST_TARGET_MAX_EEPROM];
+
+    /* Counters */
+    uint32_t instructions;      /**< 4-byte instructions clocked in */
+    uint32_t enables;           /**< Successful Programming Enables */
+    uint32_t early_enables;     /**< Programming Enables refused inside the 20 ms wait */
+    uint32_t page_writes;
+    uint32_t chip_erases;
+    uint32_t misreads;          /**< Instructions garbled by a too short SCK phase */
+    uint32_t min_phase_ns;      /**< Shortest SCK high or low phase seen (0: none) */
+    uint32_t busy_violations;   /**< Instructions other than RDY/BSY sent while busy */
+
+    /* debugWIRE (DWEN is hfuse bit 6) */
+    bool dw_disabled;           /**< DISABLE received: RESET is a reset pin until power-up */
+    uint32_t dw_commands;       /**< Command bytes taken while halted */
+    uint32_t dw_breaks;         /**< Lows on RESET longer than a frame */
+    uint32_t dw_garbled;        /**< Frames with a bad stop bit that were no break */
+
+    /* TPI, UPDI and PDI */
+    uint32_t frame_errors;      /**< Frames lost to parity, stop bit, rate or collision errors */
+    uint8_t guard_bits;         /**< TPI, PDI: idle bits before each response (TPIPCR.GT, CTRL.GTVAL) */
+    uint32_t word_writes;       /**< TPI: NVM word writes */
+    uint32_t updi_max_hz;       /**< UPDI: fastest UPDI clock the part runs (faster UPDICLKSEL is ignored) */
+    uint32_t sync_baud;         /**< UPDI: rate measured from the last SYNC */
+} host_target_t;
+
+/**
+ * @brief Get the simulated target
+ */
+host_target_t* host_target(void);
+
+/**
+ * @brief Make the target a blank part with the given signature
+ *
+ * Sizes and write times come from the device table (ATmega328P values
+ * for unknown signatures); memories are erased and fuses set to the
+ * ATmega328P factory defaults, with the clock to match.
+ */
+void host_target_init(const uint8_t sig[3]);
+
+/** What the Pico's programming header is wired to */
+typedef enum {
+    HOST_LINK_ISP,              /**< Classic AVR (the host_sim_reset() default) */
+    HOST_LINK_TPI,              /**< Reduced-core ATtiny */
+    HOST_LINK_UPDI,             /**< tinyAVR or megaAVR 0 */
+    HOST_LINK_PDI,              /**< XMEGA */
+} host_link_t;
+
+/**
+ * @brief Power up a blank part with the given signature on link
+ *
+ * Keeps the clock and RP2040 flash; the target starts as in
+ * host_target_init(). A TPI part gets its own defaults: configuration
+ * byte (low fuse) 0xFF and 1 MHz (8 MHz RC divided by 8). A UPDI part
+ * starts unlocked (LOCKBIT 0xC5) at 3.33 MHz, its UPDI clock at 4 MHz
+ * and able to run at 16 MHz. An XMEGA runs at 2 MHz (its RC oscillator).
+ */
+void host_sim_connect(host_link_t link, const uint8_t sig[3]);
+
+/**
+ * @brief Derive the target clock from its low fuse (ATmega layout)
+ *
+ * Internal RC (CKSEL 0010) runs at 8 MHz, anything else is taken as a
+ * 16 MHz crystal; a programmed CKDIV8 divides by 8.
+ */
+uint32_t host_target_clock_from_fuses(uint8_t lfuse);
+
+/**
+ * @brief Get the fastest SCK the target saw in its last instruction
+ */
+uint32_t host_target_sck_hz(void);
+
+/**
+ * @brief Count reads of a line both the Pico and the target drove, apart
+ */
+uint32_t host_sim_contentions(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,429 @@
+/**
+ * @file host_tpi.c
+ * @brief Simulated Reduced-Core ATtiny on TPI (TPICLK, TPIDATA, RESET)
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_sim.h"
+#include "host_phy.h"
+#include "tpi.h"
+#include <string.h>
+
+/*******************************************************************************
+ * Physical Layer
+ ******************************************************************************/
+
+/**
+ * The target samples TPIDATA on TPICLK rising edges and changes its own
+ * output on falling edges. After RESET goes low it needs 16 clocks with
+ * TPIDATA high before TPI is enabled. A frame is a 0 start bit, 8 data
+ * bits LSB first, even parity and two 1 stop bits; a parity or stop bit
+ * error leaves the link deaf until a BREAK (12 or more 0 bits). A
+ * response starts on the falling edge after the last stop bit of the
+ * instruction, with the guard time (TPIPCR.GT) of released idle bits
+ * before its start bit. A TPICLK period shorter than one target clock
+ * garbles the frame it falls in.
+ */
+
+#define TPI_ENABLE_BITS     16u
+#define TPI_BREAK_BITS      12u
+#define TPI_FRAME_BITS      12u         /* Start, 8 data, parity, 2 stop */
+
+static struct {
+    bool reset;                 /* RESET line level */
+    bool clk;
+    bool enabled;
+    uint8_t ones;               /* TPIDATA high clocks since RESET went low */
+    uint8_t zeros;              /* Consecutive 0 bits (BREAK) */
+    bool error;                 /* Deaf until a BREAK */
+    int8_t rx_bit;              /* Bits of the frame coming in after the start bit, -1: idle */
+    uint16_t rx_frame;
+    bool garbled;               /* A clock of this frame was too fast */
+    uint64_t rise_ns;
+
+    uint16_t guard_left;        /* Released idle bits still to send */
+    uint16_t tx_frame;          /* Response bits still to send, LSB first */
+    uint8_t tx_left;
+    int8_t out;                 /* Drive of TPIDATA (-1: released) */
+} phy;
+
+/** Guard time in idle bits for TPIPCR.GT (see TPI_GT_*) */
+static uint16_t guard_bits(uint8_t gt) {
+    return gt >= TPI_GT_0 ? 0u : (uint16_t)(128u >> gt);
+}
+
+static void respond(uint8_t b);
+static void instruction_byte(uint8_t b);
+static void disable(void);
+
+/*******************************************************************************
+ * TPI Access and the NVM Controller
+ ******************************************************************************/
+
+#define TPIIR_ID            0x80
+#define TPISR_NVMEN         0x02
+#define NVMCSR_BSY          0x80
+#define IO_NVMCSR           0x32
+#define IO_NVMCMD           0x33
+
+#define NVM_NO_OP           0x00
+#define NVM_CHIP_ERASE      0x10
+#define NVM_SECTION_ERASE   0x14
+#define NVM_WORD_WRITE      0x1D
+
+#define ADDR_LOCK           0x3F00
+#define ADDR_CONFIG         0x3F40
+#define ADDR_CALIB          0x3F80
+#define ADDR_SIG            0x3FC0
+#define ADDR_FLASH          0x4000
+
+static const uint8_t nvm_key[8] = {0xFF, 0x88, 0xD8, 0xCD, 0x45, 0xAB, 0x89, 0x12};
+
+static struct {
+    uint8_t op;                 /* Instruction still taking operand bytes */
+    uint8_t need;
+    uint8_t got;
+    uint8_t key[8];
+    uint16_t pr;                /* Pointer register */
+    bool nvmen;
+    uint8_t gt;
+    uint8_t nvmcmd;
+    uint64_t busy_until;
+    bool latched;               /* Word write: low byte taken */
+    uint16_t latch_addr;
+    uint8_t latch;
+} tpi;
+
+static uint64_t now(void) {
+    return host_sim_now_ns();
+}
+
+static uint8_t io_read(uint8_t a) {
+    if (a == IO_NVMCSR) {
+        return now() < tpi.busy_until ? NVMCSR_BSY : 0x00;
+    }
+    return a == IO_NVMCMD ? tpi.nvmcmd : 0x00;
+}
+
+static void io_write(uint8_t a, uint8_t v) {
+    if (a == IO_NVMCMD) {
+        tpi.nvmcmd = v & 0x3F;
+    }
+}
+
+static uint8_t data_read(uint16_t addr) {
+    host_target_t* t = host_target();
+
+    if (addr < 0x40) {
+        return io_read((uint8_t)addr);
+    }
+    if (!tpi.nvmen) {
+        return 0x00;    /* NVM is only mapped with NVMEN */
+    }
+    if (addr >= ADDR_FLASH) {
+        uint32_t off = addr - ADDR_FLASH;
+        return off < t->flash_bytes ? t->flash[off] : 0xFF;
+    }
+    switch (addr) {
+        case ADDR_LOCK: return t->lock;
+        case ADDR_CONFIG: return t->lfuse;
+        case ADDR_CALIB: return t->calibration;
+        case ADDR_SIG:
+        case ADDR_SIG + 1:
+        case ADDR_SIG + 2: return t->signature[addr - ADDR_SIG];
+        default: return 0xFF;
+    }
+}
+
+/** Program (clear bits of) one NVM word */
+static void word_write(uint16_t addr, uint8_t low, uint8_t high) {
+    host_target_t* t = host_target();
+
+    if (addr >= ADDR_FLASH && addr - ADDR_FLASH + 1u < t->flash_bytes) {
+        t->flash[addr - ADDR_FLASH] &= low;
+        t->flash[addr - ADDR_FLASH + 1u] &= high;
+    } else if (addr == ADDR_CONFIG) {
+        t->lfuse &= low;
+    } else if (addr == ADDR_LOCK) {
+        t->lock &= low;
+    }
+    t->word_writes++;
+    tpi.busy_until = now() + (uint64_t)t->flash_write_us * 1000u;
+}
+
+/**
+ * @brief Store to the data space: I/O registers, or an NVM operation
+ *
+ * Erases are started by a dummy write to the high byte of a word in the
+ * section; word writes take the low byte first and start with the high
+ * byte. Stores while the controller is busy are lost.
+ */
+static void data_write(uint16_t addr, uint8_t v) {
+    host_target_t* t = host_target();
+
+    if (addr < 0x40) {
+        io_write((uint8_t)addr, v);
+        return;
+    }
+    if (!tpi.nvmen || addr < ADDR_LOCK) {
+        return;
+    }
+    if (now() < tpi.busy_until) {
+        t->busy_violations++;
+        return;
+    }
+    switch (tpi.nvmcmd) {
+        case NVM_CHIP_ERASE:
+            if (addr & 1u) {
+                memset(t->flash, 0xFF, t->flash_bytes);
+                t->lock = 0xFF;
+                t->chip_erases++;
+                tpi.busy_until = now() + (uint64_t)t->erase_us * 1000u;
+            }
+            break;
+        case NVM_SECTION_ERASE:
+            if (addr & 1u) {
+                if (addr >= ADDR_FLASH) {
+                    memset(t->flash, 0xFF, t->flash_bytes);
+                } else if (addr >= ADDR_CONFIG && addr < ADDR_CALIB) {
+                    t->lfuse = 0xFF;
+                }
+                tpi.busy_until = now() + (uint64_t)t->erase_us * 1000u;
+            }
+            break;
+        case NVM_WORD_WRITE:
+            if (!(addr & 1u)) {
+                tpi.latched = true;
+                tpi.latch_addr = addr;
+                tpi.latch = v;
+            } else {
+                uint16_t word = addr & (uint16_t)~1u;
+                bool low = tpi.latched && tpi.latch_addr == word;
+                word_write(word, low ? tpi.latch : 0xFF, v);
+                tpi.latched = false;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static uint8_t cs_read(uint8_t a) {
+    switch (a) {
+        case 0x00: return tpi.nvmen ? TPISR_NVMEN : 0x00;
+        case 0x02: return tpi.gt;
+        case 0x0F: return TPIIR_ID;
+        default: return 0x00;
+    }
+}
+
+static void cs_write(uint8_t a, uint8_t v) {
+    if (a == 0x00) {
+        tpi.nvmen = tpi.nvmen && (v & TPISR_NVMEN);
+    } else if (a == 0x02) {
+        tpi.gt = v & 0x07;
+        host_target()->guard_bits = (uint8_t)guard_bits(tpi.gt);
+    }
+}
+
+/** Operand byte of the pending instruction */
+static void operand(uint8_t b) {
+    uint8_t op = tpi.op;
+
+    if (op == 0xE0) {
+        tpi.key[tpi.got] = b;
+    } else if ((op & 0xF0) == 0xC0) {
+        cs_write(op & 0x0F, b);
+    } else if ((op & 0xFE) == 0x68) {
+        tpi.pr = (op & 1u) ? (uint16_t)((tpi.pr & 0x00FF) | b << 8) : (uint16_t)((tpi.pr & 0xFF00) | b);
+    } else if ((op & 0xFB) == 0x60) {
+        data_write(tpi.pr, b);
+        if (op & 0x04) {
+            tpi.pr++;
+        }
+    } else if ((op & 0x90) == 0x90) {
+        io_write((uint8_t)(((op >> 1) & 0x30) | (op & 0x0F)), b);
+    }
+
+    if (++tpi.got < tpi.need) {
+        return;
+    }
+    if (op == 0xE0 && memcmp(tpi.key, nvm_key, sizeof(nvm_key)) == 0) {
+        tpi.nvmen = true;
+    }
+    tpi.need = 0;
+}
+
+static void instruction_byte(uint8_t b) {
+    if (tpi.need) {
+        operand(b);
+        return;
+    }
+    tpi.op = b;
+    tpi.got = 0;
+    if ((b & 0xF0) == 0x80) {                   /* SLDCS */
+        respond(cs_read(b & 0x0F));
+    } else if ((b & 0xF0) == 0xC0) {            /* SSTCS */
+        tpi.need = 1;
+    } else if ((b & 0xFB) == 0x20) {            /* SLD, SLD+ */
+        respond(data_read(tpi.pr));
+        if (b & 0x04) {
+            tpi.pr++;
+        }
+    } else if ((b & 0xFB) == 0x60 || (b & 0xFE) == 0x68) {  /* SST, SST+, SSTPR */
+        tpi.need = 1;
+    } else if ((b & 0x90) == 0x10) {            /* SIN */
+        respond(io_read((uint8_t)(((b >> 1) & 0x30) | (b & 0x0F))));
+    } else if ((b & 0x90) == 0x90) {            /* SOUT */
+        tpi.need = 1;
+    } else if (b == 0xE0) {                     /* SKEY */
+        tpi.need = sizeof(nvm_key);
+    }
+}
+
+/*******************************************************************************
+ * Frames and Pins
+ ******************************************************************************/
+
+static void respond(uint8_t b) {
+    uint8_t parity = 0;
+    for (int i = 0; i < 8; i++) {
+        parity ^= (uint8_t)((b >> i) & 1u);
+    }
+    /* ST(0) D0..D7 P SP1 SP2, sent from bit 0 */
+    phy.tx_frame = (uint16_t)((uint16_t)b << 1 | (uint16_t)parity << 9 | 3u << 10);
+    phy.tx_left = TPI_FRAME_BITS;
+    phy.guard_left = guard_bits(tpi.gt);
+}
+
+static void frame_done(void) {
+    uint8_t b = (uint8_t)phy.rx_frame;
+    uint8_t parity = (uint8_t)(phy.rx_frame >> 8) & 1u;
+    bool stops = ((phy.rx_frame >> 9) & 3u) == 3u;
+    uint8_t ones = 0;
+
+    for (int i = 0; i < 8; i++) {
+        ones ^= (uint8_t)((b >> i) & 1u);
+    }
+    if (phy.garbled) {
+        host_target()->misreads++;
+    }
+    if (phy.garbled || parity != ones || !stops) {
+        host_target()->frame_errors++;
+        phy.error = true;
+        tpi.need = 0;
+        return;
+    }
+    instruction_byte(b);
+}
+
+static void clk_rise(uint64_t t_ns) {
+    host_target_t* t = host_target();
+    bool bit = host_pin_level(TPI_DATA_PIN);
+    bool too_fast = phy.rise_ns && (t_ns - phy.rise_ns) * t->cpu_hz < 1000000000u;
+
+    phy.rise_ns = t_ns;
+    if (!phy.enabled) {
+        phy.ones = bit ? (uint8_t)(phy.ones + (phy.ones < TPI_ENABLE_BITS)) : 0;
+        phy.enabled = phy.ones >= TPI_ENABLE_BITS;
+        return;
+    }
+    if (phy.guard_left || phy.tx_left) {
+        return;     /* Sending: half duplex */
+    }
+
+    phy.zeros = bit ? 0 : (uint8_t)(phy.zeros + (phy.zeros < 255u));
+    if (phy.zeros >= TPI_BREAK_BITS) {
+        phy.error = false;
+        phy.rx_bit = -1;
+        tpi.need = 0;
+        return;
+    }
+    if (phy.rx_bit < 0) {
+        if (!bit && !phy.error) {
+            phy.rx_bit = 0;
+            phy.rx_frame = 0;
+            phy.garbled = too_fast;
+        }
+        return;
+    }
+    phy.garbled |= too_fast;
+    phy.rx_frame |= (uint16_t)bit << phy.rx_bit;
+    if (++phy.rx_bit == TPI_FRAME_BITS - 1) {
+        phy.rx_bit = -1;
+        frame_done();
+    }
+}
+
+static void clk_fall(void) {
+    if (phy.guard_left) {
+        phy.guard_left--;
+        phy.out = -1;
+    } else if (phy.tx_left) {
+        phy.out = (int8_t)(phy.tx_frame & 1u);
+        phy.tx_frame >>= 1;
+        phy.tx_left--;
+    } else {
+        phy.out = -1;
+    }
+}
+
+/** RESET high: TPI off, NVM programming off, guard time back to 128 bits */
+static void disable(void) {
+    bool reset = phy.reset;
+    bool clk = phy.clk;
+
+    memset(&phy, 0, sizeof(phy));
+    phy.reset = reset;
+    phy.clk = clk;
+    phy.rx_bit = -1;
+    phy.out = -1;
+    memset(&tpi, 0, sizeof(tpi));
+    host_target()->guard_bits = (uint8_t)guard_bits(0);
+}
+
+static void tpi_pico_drive(uint pin, int level, uint64_t t_ns) {
+    switch (pin) {
+        case TPI_RESET_PIN: {
+            bool reset = level != 0;    /* Pulled up on the target */
+            if (reset != phy.reset) {
+                phy.reset = reset;
+                disable();
+            }
+        } break;
+        case TPI_CLK_PIN: {
+            bool clk = level == 1;
+            if (clk == phy.clk) {
+                break;
+            }
+            phy.clk = clk;
+            if (phy.reset) {
+                break;
+            }
+            if (clk) {
+                clk_rise(t_ns);
+            } else {
+                clk_fall();
+            }
+        } break;
+        default:
+            break;
+    }
+}
+
+static int tpi_drive(uint pin) {
+    return pin == TPI_DATA_PIN && !phy.reset ? phy.out : -1;
+}
+
+const host_board_t host_board_tpi = {
+    .pico_drive = tpi_pico_drive,
+    .drive = tpi_drive,
+};
+
+void host_tpi_reset(void) {
+    phy.reset = true;
+    phy.clk = false;
+    disable();
+}
@@ -0,0 +1,796 @@
+/**
+ * @file host_updi.c
+ * @brief Simulated UART1 (PL011) and a tinyAVR / megaAVR 0 on UPDI
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_sim.h"
+#include "host_phy.h"
+#include "updi.h"
+#include "avr_devices.h"
+#include <string.h>
+#include <hardware/uart.h>
+
+/*******************************************************************************
+ * UART1 (PL011)
+ ******************************************************************************/
+
+/**
+ * TX and RX are joined on the UPDI line, so every frame the Pico sends is
+ * received back as echo when its stop bits are done; target replies are
+ * received the same way. Frames start when written or when the previous
+ * one ends. The RX FIFO is kept in arrival order, including replies the
+ * target has scheduled but not sent yet; bytes arriving at a full FIFO
+ * are lost, as on the PL011.
+ */
+
+#define PL011_FIFO_DEPTH    32u
+#define PL011_RX_SLOTS      1024u           /* Arrived plus scheduled, power of 2 */
+#define PL011_BUS_CYCLES    2u
+
+typedef struct {
+    uint8_t data;
+    uint64_t done_ns;
+} uart_rx_t;
+
+static struct {
+    bool enabled;
+    bool brk;
+    bool format_ok;             /* 8 data bits, even parity */
+    uint32_t frame_bits;
+    uint32_t bit_ns;
+    uint64_t tx_free_ns;        /* Last queued TX frame done */
+    uint8_t tx_last;
+    uart_rx_t rx[PL011_RX_SLOTS];
+    uint32_t rx_head;
+    uint32_t rx_count;
+} uart;
+
+static void target_rx(uint8_t b, uint32_t bit_ns, uint64_t done_ns, bool garbled);
+static uint64_t reply_done_ns(void);
+static uint8_t reply_last(void);
+
+static void bus_access(void) {
+    host_sim_cycles(PL011_BUS_CYCLES);
+}
+
+/** Queue a received byte, keeping the FIFO in arrival order */
+static void rx_push(uint8_t data, uint64_t done_ns) {
+    uint32_t i = uart.rx_count;
+
+    if (i == PL011_RX_SLOTS) {
+        return;
+    }
+    while (i > 0 && uart.rx[(uart.rx_head + i - 1u) & (PL011_RX_SLOTS - 1u)].done_ns > done_ns) {
+        uart.rx[(uart.rx_head + i) & (PL011_RX_SLOTS - 1u)] = uart.rx[(uart.rx_head + i - 1u) & (PL011_RX_SLOTS - 1u)];
+        i--;
+    }
+    uart.rx[(uart.rx_head + i) & (PL011_RX_SLOTS - 1u)] = (uart_rx_t){data, done_ns};
+    uart.rx_count++;
+}
+
+/** Drop what arrived while the FIFO was full (overrun) */
+static void rx_overrun(void) {
+    uint64_t now = host_sim_now_ns();
+    uint32_t arrived = 0;
+
+    while (arrived < uart.rx_count
+           && uart.rx[(uart.rx_head + arrived) & (PL011_RX_SLOTS - 1u)].done_ns <= now) {
+        arrived++;
+    }
+    while (arrived > PL011_FIFO_DEPTH) {
+        uint32_t i = PL011_FIFO_DEPTH;
+        for (; i + 1u < uart.rx_count; i++) {
+            uart.rx[(uart.rx_head + i) & (PL011_RX_SLOTS - 1u)] = uart.rx[(uart.rx_head + i + 1u) & (PL011_RX_SLOTS - 1u)];
+        }
+        uart.rx_count--;
+        arrived--;
+    }
+}
+
+static bool rx_ready(void) {
+    rx_overrun();
+    return uart.rx_count && uart.rx[uart.rx_head].done_ns <= host_sim_now_ns();
+}
+
+int host_uart_drive(uint pin) {
+    return pin == UPDI_TX_PIN && uart.enabled ? !uart.brk : -1;
+}
+
+void host_uart_reset(void) {
+    memset(&uart, 0, sizeof(uart));
+    uart.frame_bits = 10;
+    uart.bit_ns = 8680;
+}
+
+/** The SDK's integer/fractional divider on clk_peri */
+uint uart_set_baudrate(uart_inst_t* uart_id, uint baudrate) {
+    uint32_t div = (uint32_t)(8ull * HOST_SYS_HZ / baudrate) + 1u;
+    uint32_t ibrd = div >> 7;
+    uint32_t fbrd;
+
+    (void)uart_id;
+    bus_access();
+    if (ibrd == 0) {
+        ibrd = 1;
+        fbrd = 0;
+    } else if (ibrd >= 65535u) {
+        ibrd = 65535u;
+        fbrd = 0;
+    } else {
+        fbrd = (div & 0x7Fu) >> 1;
+    }
+    /* 16 clk_peri cycles per bit, divided by ibrd + fbrd / 64 */
+    uart.bit_ns = 2u * (64u * ibrd + fbrd);
+    return (uint)(4ull * HOST_SYS_HZ / (64u * ibrd + fbrd));
+}
+
+uint uart_init(uart_inst_t* uart_id, uint baudrate) {
+    host_uart_reset();
+    uart.enabled = true;
+    host_pin_update(UPDI_TX_PIN, host_sim_now_ns());
+    return uart_set_baudrate(uart_id, baudrate);
+}
+
+void uart_deinit(uart_inst_t* uart_id) {
+    (void)uart_id;
+    bus_access();
+    uart.enabled = false;
+    uart.rx_count = 0;
+    host_pin_update(UPDI_TX_PIN, host_sim_now_ns());
+}
+
+void uart_set_format(uart_inst_t* uart_id, uint data_bits, uint stop_bits, uart_parity_t parity) {
+    (void)uart_id;
+    bus_access();
+    uart.frame_bits = 1u + data_bits + (parity != UART_PARITY_NONE) + stop_bits;
+    uart.format_ok = data_bits == 8u && parity == UART_PARITY_EVEN;
+}
+
+void uart_set_hw_flow(uart_inst_t* uart_id, bool cts, bool rts) {
+    (void)uart_id;
+    (void)cts;
+    (void)rts;
+    bus_access();
+}
+
+void uart_set_fifo_enabled(uart_inst_t* uart_id, bool enabled) {
+    (void)uart_id;
+    (void)enabled;
+    bus_access();
+}
+
+/** Hold TX low; the receiver takes the break as a 0x00 when it ends */
+void uart_set_break(uart_inst_t* uart_id, bool en) {
+    (void)uart_id;
+    bus_access();
+    if (uart.brk && !en) {
+        rx_push(0x00, host_sim_now_ns());
+    }
+    uart.brk = en;
+    host_pin_update(UPDI_TX_PIN, host_sim_now_ns());
+}
+
+/** Shift one frame out; it is echoed, and the target takes it */
+static void tx_byte(uint8_t b) {
+    uint64_t now = host_sim_now_ns();
+    uint64_t frame_ns = (uint64_t)uart.frame_bits * uart.bit_ns;
+
+    /* Wait for room in the TX FIFO */
+    if (uart.tx_free_ns > now + PL011_FIFO_DEPTH * frame_ns) {
+        host_sim_advance_ns(uart.tx_free_ns - now - PL011_FIFO_DEPTH * frame_ns);
+        now = host_sim_now_ns();
+    }
+
+    uint64_t start = uart.tx_free_ns > now ? uart.tx_free_ns : now;
+    uint64_t done = start + frame_ns;
+    bool collision = reply_done_ns() > start;
+    uint8_t echo = collision ? (uint8_t)(b & reply_last()) : b;
+
+    uart.tx_free_ns = done;
+    uart.tx_last = b;
+    rx_push(echo, done);
+    target_rx(b, uart.bit_ns, done, collision || !uart.format_ok);
+}
+
+void uart_write_blocking(uart_inst_t* uart_id, const uint8_t* src, size_t len) {
+    (void)uart_id;
+    for (size_t i = 0; i < len; i++) {
+        bus_access();
+        tx_byte(src[i]);
+    }
+}
+
+bool uart_is_readable(uart_inst_t* uart_id) {
+    (void)uart_id;
+    bus_access();
+    return rx_ready();
+}
+
+/** Waiting for a byte skips straight to its arrival or the deadline */
+bool uart_is_readable_within_us(uart_inst_t* uart_id, uint32_t us) {
+    uint64_t deadline;
+
+    (void)uart_id;
+    bus_access();
+    deadline = host_sim_now_ns() + (uint64_t)us * 1000u;
+    if (uart.rx_count && uart.rx[uart.rx_head].done_ns <= deadline) {
+        if (uart.rx[uart.rx_head].done_ns > host_sim_now_ns()) {
+            host_sim_advance_ns(uart.rx[uart.rx_head].done_ns - host_sim_now_ns());
+        }
+        return rx_ready();
+    }
+    host_sim_advance_ns(deadline - host_sim_now_ns());
+    return false;
+}
+
+char uart_getc(uart_inst_t* uart_id) {
+    uart_rx_t* f;
+
+    (void)uart_id;
+    bus_access();
+    if (!uart.rx_count) {
+        return 0;   /* The SDK blocks forever */
+    }
+    f = &uart.rx[uart.rx_head];
+    if (f->done_ns > host_sim_now_ns()) {
+        host_sim_advance_ns(f->done_ns - host_sim_now_ns());
+    }
+    rx_overrun();
+    f = &uart.rx[uart.rx_head];
+    uart.rx_head = (uart.rx_head + 1u) & (PL011_RX_SLOTS - 1u);
+    uart.rx_count--;
+    return (char)f->data;
+}
+
+/*******************************************************************************
+ * UPDI Physical and Link Layer
+ ******************************************************************************/
+
+/**
+ * The target measures the rate from each SYNC (0x55); a SYNC faster than
+ * its UPDI clock allows (f_UPDI * 9 / 160, 225 kbit/s at the 4 MHz
+ * default, 0.9 Mbit/s at 16 MHz), a byte at another rate, a parity error
+ * or a collision with its own reply puts the link in error state until a
+ * BREAK. Replies start after the guard time (CTRLA.GTVAL, 128 bits by
+ * default) and have 2 idle bits between bytes with CTRLA.IBDLY.
+ */
+
+#define UPDI_SYNC               0x55
+#define UPDI_ACK                0x40
+#define UPDI_BREAK_NS           24600000u   /* Detected at any rate */
+#define UPDI_FRAME_BITS         12u
+#define UPDI_IBDLY_BITS         2u
+
+#define CS_STATUSA              0x00
+#define CS_CTRLA                0x02
+#define CS_CTRLB                0x03
+#define ASI_KEY_STATUS          0x07
+#define ASI_RESET_REQ           0x08
+#define ASI_CTRLA               0x09
+#define ASI_SYS_STATUS          0x0B
+
+#define CTRLA_IBDLY             0x80
+#define CTRLA_RSD               0x08
+#define CTRLA_GTVAL             0x07
+#define CTRLB_UPDIDIS           0x04
+#define KEY_NVMPROG             0x10
+#define SYS_LOCKSTATUS          0x01
+#define SYS_NVMPROG             0x08
+#define SYS_RSTSYS              0x20
+#define RESET_SIGNATURE         0x59
+#define UPDI_REV1               0x10
+
+#define NVMCTRL_CTRLA           0x1000
+#define NVMCTRL_STATUS          0x1002
+#define SIGROW                  0x1100
+#define LOCKBIT                 0x128A
+#define EEPROM_BASE             0x1400
+#define LOCK_UNLOCKED           0xC5
+#define UPDI_PAGE_MAX           512u
+
+#define NVM_WP                  0x01
+#define NVM_ER                  0x02
+#define NVM_ERWP                0x03
+#define NVM_PBC                 0x04
+#define NVM_CHER                0x05
+
+#define STATUS_BUSY             0x03
+#define STATUS_WRERROR          0x04
+
+static const uint8_t key_nvmprog[8] = {' ', 'g', 'o', 'r', 'P', 'M', 'V', 'N'};
+
+typedef enum {
+    PH_SYNC,
+    PH_OPCODE,
+    PH_OPERAND,                 /* Address, pointer, CS value, count or key */
+    PH_DATA,                    /* ST/STS data */
+} phase_t;
+
+static struct {
+    bool enabled;               /* UPDIDIS not written since the last BREAK */
+    bool error;
+    uint32_t bit_ns;            /* From the last SYNC */
+    uint64_t low_ns;            /* TX held low since (break), 0: high */
+    uint64_t tx_free_ns;        /* Last reply frame done */
+    uint8_t tx_last;
+
+    phase_t phase;
+    uint8_t op;
+    uint8_t need;
+    uint8_t got;
+    uint8_t buf[8];
+    uint32_t addr;              /* STS address */
+    uint32_t repeat;            /* Executions left of the current LD/ST */
+    uint32_t ptr;
+
+    uint8_t ctrla;
+    uint8_t ctrlb;
+    uint8_t asi_ctrla;
+    uint32_t updi_hz;
+    bool in_reset;
+    bool key_nvmprog;
+    bool nvmprog;
+
+    uint16_t flash_base;
+    uint64_t busy_until;
+    bool wrerror;
+    uint8_t page[UPDI_PAGE_MAX];
+    uint32_t page_addr;
+    bool page_loaded;
+} updi;
+
+static uint64_t reply_done_ns(void) {
+    return updi.tx_free_ns;
+}
+
+static uint8_t reply_last(void) {
+    return updi.tx_last;
+}
+
+static bool locked(void) {
+    return host_target()->lock != LOCK_UNLOCKED;
+}
+
+static void link_error(void) {
+    host_target()->frame_errors++;
+    updi.error = true;
+    updi.phase = PH_SYNC;
+}
+
+/** Send a reply byte after the guard time or the previous reply byte */
+static void reply(uint8_t b, uint64_t t) {
+    uint8_t gt = updi.ctrla & CTRLA_GTVAL;
+    uint32_t guard = gt == 7u ? 2u : 128u >> gt;
+    uint64_t start = t + (uint64_t)guard * updi.bit_ns;
+
+    uint64_t after = updi.tx_free_ns + (updi.ctrla & CTRLA_IBDLY ? UPDI_IBDLY_BITS * updi.bit_ns : 0u);
+
+    if (after > start) {
+        start = after;
+    }
+    updi.tx_free_ns = start + (uint64_t)UPDI_FRAME_BITS * updi.bit_ns;
+    updi.tx_last = b;
+    if (start < uart.tx_free_ns) {
+        /* The Pico is still sending: both frames are lost */
+        host_target()->frame_errors++;
+        b &= uart.tx_last;
+    }
+    rx_push(b, updi.tx_free_ns);
+}
+
+static void ack(uint64_t t) {
+    if (!(updi.ctrla & CTRLA_RSD)) {
+        reply(UPDI_ACK, t);
+    }
+}
+
+/*******************************************************************************
+ * Control/Status Space and ASI
+ ******************************************************************************/
+
+static uint8_t cs_read(uint8_t reg) {
+    switch (reg) {
+        case CS_STATUSA: return UPDI_REV1;
+        case CS_CTRLA: return updi.ctrla;
+        case CS_CTRLB: return updi.ctrlb;
+        case ASI_KEY_STATUS: return updi.key_nvmprog ? KEY_NVMPROG : 0x00;
+        case ASI_RESET_REQ: return updi.in_reset ? RESET_SIGNATURE : 0x00;
+        case ASI_CTRLA: return updi.asi_ctrla;
+        case ASI_SYS_STATUS:
+            return (uint8_t)((updi.nvmprog ? SYS_NVMPROG : 0x00) | (locked() ? SYS_LOCKSTATUS : 0x00)
+                             | (updi.in_reset ? SYS_RSTSYS : 0x00));
+        default: return 0x00;
+    }
+}
+
+static void cs_write(uint8_t reg, uint8_t v) {
+    host_target_t* t = host_target();
+
+    switch (reg) {
+        case CS_CTRLA:
+            updi.ctrla = v;
+            break;
+        case CS_CTRLB:
+            updi.ctrlb = v;
+            updi.enabled = !(v & CTRLB_UPDIDIS);
+            break;
+        case ASI_RESET_REQ:
+            if (v == RESET_SIGNATURE) {
+                updi.in_reset = true;
+            } else if (updi.in_reset) {
+                /* Leaving reset: the key decides whether the CPU runs */
+                updi.in_reset = false;
+                updi.nvmprog = updi.key_nvmprog && !locked();
+                updi.key_nvmprog = false;
+            }
+            break;
+        case ASI_CTRLA: {
+            static const uint32_t clksel_hz[4] = {32000000u, 16000000u, 8000000u, 4000000u};
+            uint32_t hz = clksel_hz[v & 0x03];
+            if (hz <= t->updi_max_hz) {
+                updi.asi_ctrla = v & 0x03;
+                updi.updi_hz = hz;
+            }
+        } break;
+        default:
+            break;
+    }
+}
+
+/*******************************************************************************
+ * Data Space and NVMCTRL (version 0)
+ ******************************************************************************/
+
+static bool in_flash(uint32_t addr) {
+    return addr >= updi.flash_base && addr - updi.flash_base < host_target()->flash_bytes;
+}
+
+static uint8_t data_read(uint32_t addr, uint64_t t) {
+    host_target_t* tg = host_target();
+
+    if (!updi.nvmprog) {
+        return 0x00;
+    }
+    if (in_flash(addr)) {
+        return tg->flash[addr - updi.flash_base];
+    }
+    if (addr >= EEPROM_BASE && addr - EEPROM_BASE < tg->eeprom_bytes) {
+        return tg->eeprom[addr - EEPROM_BASE];
+    }
+    if (addr >= SIGROW && addr < SIGROW + 3u) {
+        return tg->signature[addr - SIGROW];
+    }
+    switch (addr) {
+        case NVMCTRL_STATUS:
+            return (uint8_t)((t < updi.busy_until ? STATUS_BUSY : 0x00) | (updi.wrerror ? STATUS_WRERROR : 0x00));
+        case LOCKBIT:
+            return tg->lock;
+        default:
+            return 0x00;
+    }
+}
+
+static void page_write(bool erase, uint64_t t) {
+    host_target_t* tg = host_target();
+
+    if (erase) {
+        memset(tg->flash + updi.page_addr, 0xFF, tg->page_bytes);
+    }
+    for (uint32_t i = 0; i < tg->page_bytes; i++) {
+        tg->flash[updi.page_addr + i] &= updi.page[i];
+    }
+    tg->page_writes++;
+    updi.busy_until = t + (uint64_t)tg->flash_write_us * 1000u;
+    memset(updi.page, 0xFF, sizeof(updi.page));
+    updi.page_loaded = false;
+}
+
+static void nvm_command(uint8_t cmd, uint64_t t) {
+    host_target_t* tg = host_target();
+
+    if (t < updi.busy_until) {
+        tg->busy_violations++;
+        return;
+    }
+    updi.wrerror = false;
+    switch (cmd) {
+        case 0x00:
+            break;
+        case NVM_WP:
+        case NVM_ERWP:
+            if (updi.page_loaded) {
+                page_write(cmd == NVM_ERWP, t);
+            }
+            break;
+        case NVM_ER:
+            memset(tg->flash + updi.page_addr, 0xFF, tg->page_bytes);
+            updi.busy_until = t + (uint64_t)tg->flash_write_us * 1000u;
+            break;
+        case NVM_PBC:
+            memset(updi.page, 0xFF, sizeof(updi.page));
+            updi.page_loaded = false;
+            break;
+        case NVM_CHER:
+            memset(tg->flash, 0xFF, tg->flash_bytes);
+            memset(tg->eeprom, 0xFF, tg->eeprom_bytes);
+            tg->lock = LOCK_UNLOCKED;
+            tg->chip_erases++;
+            updi.busy_until = t + (uint64_t)tg->erase_us * 1000u;
+            break;
+        default:
+            updi.wrerror = true;
+            break;
+    }
+}
+
+static void data_write(uint32_t addr, uint8_t v, uint64_t t) {
+    host_target_t* tg = host_target();
+
+    if (!updi.nvmprog) {
+        return;
+    }
+    if (in_flash(addr)) {
+        uint32_t off = addr - updi.flash_base;
+        /* Flash writes go to the page buffer */
+        updi.page[off % tg->page_bytes] = v;
+        updi.page_addr = off - off % tg->page_bytes;
+        updi.page_loaded = true;
+    } else if (addr == NVMCTRL_CTRLA) {
+        nvm_command(v, t);
+    }
+}
+
+/*******************************************************************************
+ * Instructions
+ ******************************************************************************/
+
+#define OP_LDS          0x00
+#define OP_LD           0x20
+#define OP_STS          0x40
+#define OP_ST           0x60
+#define OP_LDCS         0x80
+#define OP_REPEAT       0xA0
+#define OP_STCS         0xC0
+#define OP_KEY          0xE0
+
+#define PTR_INC         1u
+#define PTR_ADDR        2u
+
+static uint32_t operand_value(void) {
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < updi.got; i++) {
+        v |= (uint32_t)updi.buf[i] << (8u * i);
+    }
+    return v;
+}
+
+static void done(void) {
+    updi.phase = PH_SYNC;
+}
+
+static void expect(phase_t phase, uint8_t n) {
+    updi.phase = phase;
+    updi.need = n;
+    updi.got = 0;
+}
+
+static void opcode(uint8_t op, uint64_t t) {
+    uint8_t size = (uint8_t)((op & 0x03) + 1u);
+    uint8_t ptr_mode = (op >> 2) & 0x03;
+
+    updi.op = op;
+    switch (op & 0xE0) {
+        case OP_LDS:
+        case OP_STS:
+            expect(PH_OPERAND, (uint8_t)(((op >> 2) & 0x03) + 1u));
+            return;
+        case OP_LD:
+            if (ptr_mode == PTR_ADDR) {
+                for (uint8_t i = 0; i < size; i++) {
+                    reply((uint8_t)(updi.ptr >> (8u * i)), t);
+                }
+            } else {
+                for (; updi.repeat; updi.repeat--) {
+                    for (uint8_t i = 0; i < size; i++) {
+                        reply(data_read(updi.ptr, t), t);
+                        if (ptr_mode == PTR_INC) {
+                            updi.ptr++;
+                        }
+                    }
+                }
+            }
+            updi.repeat = 1;
+            done();
+            return;
+        case OP_ST:
+            expect(ptr_mode == PTR_ADDR ? PH_OPERAND : PH_DATA, size);
+            return;
+        case OP_LDCS:
+            reply(cs_read(op & 0x0F), t);
+            done();
+            return;
+        case OP_STCS:
+            expect(PH_OPERAND, 1);
+            return;
+        case OP_REPEAT:
+            expect(PH_OPERAND, size);
+            return;
+        case OP_KEY:
+            if (op & 0x04) {
+                link_error();   /* SIB reads are not modelled */
+                return;
+            }
+            expect(PH_OPERAND, 8);
+            return;
+        default:
+            link_error();
+            return;
+    }
+}
+
+static void operands_done(uint64_t t) {
+    uint8_t op = updi.op;
+    uint32_t v = operand_value();
+
+    switch (op & 0xE0) {
+        case OP_LDS:
+            for (uint8_t i = 0; i <= (op & 0x03); i++) {
+                reply(data_read(v + i, t), t);
+            }
+            done();
+            break;
+        case OP_STS:
+            updi.addr = v;
+            ack(t);
+            expect(PH_DATA, (uint8_t)((op & 0x03) + 1u));
+            break;
+        case OP_ST:
+            updi.ptr = v;
+            ack(t);
+            done();
+            break;
+        case OP_STCS:
+            cs_write(op & 0x0F, (uint8_t)v);
+            done();
+            break;
+        case OP_REPEAT:
+            updi.repeat = v + 1u;
+            done();
+            return;     /* Applies to the next instruction */
+        case OP_KEY:
+            if (memcmp(updi.buf, key_nvmprog, sizeof(key_nvmprog)) == 0) {
+                updi.key_nvmprog = true;
+            }
+            done();
+            break;
+        default:
+            done();
+            break;
+    }
+    updi.repeat = 1;
+}
+
+static void data_done(uint64_t t) {
+    uint8_t op = updi.op;
+
+    if ((op & 0xE0) == OP_STS) {
+        for (uint8_t i = 0; i < updi.got; i++) {
+            data_write(updi.addr + i, updi.buf[i], t);
+        }
+        ack(t);
+        updi.repeat = 1;
+        done();
+        return;
+    }
+
+    /* ST *ptr / *(ptr++), once per REPEAT */
+    for (uint8_t i = 0; i < updi.got; i++) {
+        data_write(updi.ptr, updi.buf[i], t);
+        if (((op >> 2) & 0x03) == PTR_INC) {
+            updi.ptr++;
+        }
+    }
+    ack(t);
+    if (--updi.repeat) {
+        expect(PH_DATA, updi.need);
+    } else {
+        updi.repeat = 1;
+        done();
+    }
+}
+
+/** A frame from the Pico, its stop bits done at done_ns */
+static void target_rx(uint8_t b, uint32_t bit_ns, uint64_t done_ns, bool garbled) {
+    if (!updi.enabled || updi.error) {
+        return;
+    }
+    if (garbled) {
+        link_error();
+        return;
+    }
+    if (updi.phase == PH_SYNC) {
+        /* Rate measured from SYNC; faster than f_UPDI * 9 / 160 is missed */
+        if (b != UPDI_SYNC || (uint64_t)bit_ns * updi.updi_hz * 9u < 160u * 1000000000ull) {
+            link_error();
+            return;
+        }
+        updi.bit_ns = bit_ns;
+        host_target()->sync_baud = 1000000000u / bit_ns;
+        updi.phase = PH_OPCODE;
+        return;
+    }
+    if (bit_ns * 100u < updi.bit_ns * 97u || bit_ns * 100u > updi.bit_ns * 103u) {
+        link_error();   /* Not the rate of the SYNC */
+        return;
+    }
+
+    switch (updi.phase) {
+        case PH_OPCODE:
+            opcode(b, done_ns);
+            break;
+        case PH_OPERAND:
+            updi.buf[updi.got++] = b;
+            if (updi.got == updi.need) {
+                operands_done(done_ns);
+            }
+            break;
+        case PH_DATA:
+            updi.buf[updi.got++] = b;
+            if (updi.got == updi.need) {
+                data_done(done_ns);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/** A BREAK: error state and UPDIDIS cleared, the instruction dropped */
+static void updi_break(void) {
+    updi.enabled = true;
+    updi.error = false;
+    updi.phase = PH_SYNC;
+    updi.repeat = 1;
+}
+
+static void updi_pico_drive(uint pin, int level, uint64_t t_ns) {
+    if (pin != UPDI_TX_PIN) {
+        return;
+    }
+    if (level == 0) {
+        updi.low_ns = updi.low_ns ? updi.low_ns : t_ns;
+        return;
+    }
+    if (updi.low_ns) {
+        uint64_t low = t_ns - updi.low_ns;
+        if (low >= UPDI_BREAK_NS || (updi.bit_ns && low >= (uint64_t)UPDI_FRAME_BITS * updi.bit_ns)) {
+            updi_break();
+        }
+        updi.low_ns = 0;
+    }
+}
+
+static int updi_drive(uint pin) {
+    (void)pin;
+    return -1;  /* Replies are delivered to the PL011 as frames */
+}
+
+const host_board_t host_board_updi = {
+    .pico_drive = updi_pico_drive,
+    .drive = updi_drive,
+};
+
+void host_updi_reset(void) {
+    const avr_device_t* dev = avr_lookup_device_by_signature(host_target()->signature);
+
+    memset(&updi, 0, sizeof(updi));
+    updi.enabled = true;
+    updi.repeat = 1;
+    updi.asi_ctrla = 0x03;
+    updi.updi_hz = 4000000u;
+    updi.flash_base = dev && strncmp(dev->name, "ATmega", 6) == 0 ? 0x4000 : 0x8000;
+    memset(updi.page, 0xFF, sizeof(updi.page));
+}
@@ -0,0 +1,35 @@
+/**
+ * @file pdi.pio.h
+ * @brief Host Stand-in for the pioasm Output of pdi.pio
+ *
+ * Same program (length only), entry point and init helper; the state
+ * machine gets the PDI role of host_pdi.c instead of running the
+ * instructions.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <hardware/pio.h>
+#include "host_phy.h"
+
+#define pdi_offset_top 0u
+
+static const uint16_t pdi_program_instructions[16];
+
+static const pio_program_t pdi_program = {
+    .instructions = pdi_program_instructions,
+    .length = 16,
+    .origin = -1,
+};
+
+static inline void pdi_program_init(PIO pio, uint sm, uint offset, uint data_pin, uint clk_pin, float clkdiv) {
+    (void)offset;
+    (void)clk_pin;
+    pio_gpio_init(pio, data_pin);
+    pio_gpio_init(pio, clk_pin);
+    gpio_pull_up(data_pin);
+    host_pio_sm_init(pio, sm, &host_pio_pdi, data_pin, clkdiv);
+}
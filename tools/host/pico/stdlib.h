@@ -0,0 +1,84 @@
+/**
+ * @file stdlib.h
+ * @brief Host Stand-in for pico/stdlib.h
+ *
+ * Just enough of the Pico SDK for the protocol and ISP layers to build
+ * on the development machine (tools/replay). Time is the simulated
+ * clock in host_sim.c, so sleeping and busy-waiting cost nothing; GPIO
+ * calls drive host_sim.c's pins, where the simulated target listens.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#define __not_in_flash_func(func) func
+#define __time_critical_func(func) func
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+/*******************************************************************************
+ * Flash (XIP window onto host_sim.c's RP2040 flash image)
+ ******************************************************************************/
+#define PICO_FLASH_SIZE_BYTES   (2u * 1024u * 1024u)
+#define XIP_BASE                ((uintptr_t)host_xip_flash)
+
+extern uint8_t host_xip_flash[PICO_FLASH_SIZE_BYTES];
+
+/*******************************************************************************
+ * Time (simulated)
+ ******************************************************************************/
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_us_32(uint32_t us);
+void tight_loop_contents(void);
+
+static inline absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+static inline absolute_time_t make_timeout_time_us(uint64_t us) {
+    return time_us_64() + us;
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return time_us_64() + (uint64_t)ms * 1000u;
+}
+
+static inline bool time_reached(absolute_time_t t) {
+    return time_us_64() >= t;
+}
+
+/*******************************************************************************
+ * GPIO (host_sim.c's pins)
+ ******************************************************************************/
+#define GPIO_OUT    1
+#define GPIO_IN     0
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_NULL = 0x1f,
+};
+
+void gpio_init(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+
+/** Spin for at least the given number of system clock cycles */
+void busy_wait_at_least_cycles(uint32_t minimum_cycles);
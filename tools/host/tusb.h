@@ -0,0 +1,23 @@
+/**
+ * @file tusb.h
+ * @brief Host Stand-in for the TinyUSB CDC Device API
+ *
+ * Replies go into a 256-byte TX FIFO like CFG_TUD_CDC_TX_BUFSIZE and
+ * reach the host (host_sim.h) when flushed or when tud_task() runs,
+ * unless the host closed the port (host_cdc_set_connected()).
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+uint32_t tud_cdc_write(const void* buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_char(char ch);
+uint32_t tud_cdc_write_flush(void);
+uint32_t tud_cdc_write_available(void);
+bool tud_cdc_connected(void);
+void tud_task(void);
@@ -0,0 +1,835 @@
+/**
+ * @file replay.cpp
+ * @brief Deterministic Replay of Recorded Sessions Against the Host Build
+ *
+ * Feeds the host side of a capture (test.py --save) into a host build of
+ * the firmware: stk500v1_feed() and everything below it down to a
+ * simulated target (host/host_sim.h). The result is checked against the
+ * recording:
+ *   - Replies: every simulated reply against the recorded one
+ *   - Target: final simulated flash and fuses against what the recorded
+ *     commands wrote
+ *   - Time: simulated wall time per command and for the whole session
+ *
+ * Scheduling:
+ *   Closed loop, like a real host: each host record is released once the
+ *   simulated device has sent as many reply bytes as the recording had
+ *   before it, plus the recorded host think time. A firmware change that
+ *   makes replies faster or slower moves the rest of the session with it.
+ *
+ * Chunking:
+ *   By default every record is one stk500v1_feed() call, as captured.
+ *   --chunk N and --random-chunks SEED split them further to exercise
+ *   the frame parser at arbitrary USB packet boundaries.
+ *
+ * Initial Target:
+ *   Signature, fuses, calibration and flash contents read before being
+ *   written are taken from the recorded replies, so sessions that only
+ *   read a board (backups, verify passes) replay identically.
+ *
+ * Usage:
+ *   replay cap.bin [--chunk N | --random-chunks SEED] [--target-mhz F]
+ *                  [--budget-ms T] [--save sim.bin] [--quiet]
+ *
+ * Exit status: 0 match, 1 mismatch or over budget, 2 usage, 3 error.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "stk_capture.h"
+#include "host_sim.h"
+
+extern "C" {
+#include "avrprog.h"
+#include "avr_profile.h"
+#include "compress.h"
+#include "tusb.h"
+}
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** Fuse slots in TargetModel */
+enum { FUSE_LOW, FUSE_HIGH, FUSE_EXT, FUSE_LOCK, FUSE_COUNT };
+
+/** Largest stk500v1_feed() call main.c makes */
+static constexpr size_t FEED_MAX = 128;
+
+struct Options {
+    const char* capture = nullptr;
+    const char* save = nullptr;
+    size_t chunk = 0;               /* 0 = as recorded */
+    bool random_chunks = false;
+    uint32_t seed = 0;
+    uint32_t target_hz = 0;         /* 0 = from the low fuse */
+    double budget_ms = 0;           /* 0 = none */
+    bool quiet = false;
+};
+
+/*******************************************************************************
+ * Recorded Target
+ ******************************************************************************/
+
+/**
+ * @brief What the recording tells about the target before and after
+ *
+ * Built by walking the recorded command/reply pairs the way the firmware
+ * handles them. Reads of anything not yet written are initial contents;
+ * writes and erases give the expected final state.
+ */
+struct TargetModel {
+    bool have_signature = false;
+    uint8_t signature[3] = {0x1E, 0x95, 0x0F};
+    int calibration = -1;
+    int fuse_initial[FUSE_COUNT] = {-1, -1, -1, -1};
+    int fuse_final[FUSE_COUNT] = {-1, -1, -1, -1};
+
+    uint32_t flash_bytes = 0;
+    uint16_t page_bytes = 128;
+    std::vector<uint8_t> initial;   /* Seeded bytes (valid where seeded) */
+    std::vector<uint8_t> seeded;
+    std::vector<uint8_t> expect;    /* Expected final flash */
+    std::vector<uint8_t> touched;   /* Written or erased: later reads are not seeds */
+
+    uint32_t address = 0;           /* Word address, as current_address */
+    std::vector<uint8_t> page_buf;  /* Raw 0x40/0x48 loads through UNIVERSAL */
+    lzss_decoder_t lz;
+    uint8_t lz_page[256];
+    size_t lz_page_len = 0;
+
+    void reset(uint32_t flash, uint16_t page) {
+        flash_bytes = flash;
+        page_bytes = page;
+        initial.assign(flash, 0xFF);
+        seeded.assign(flash, 0);
+        expect.assign(flash, 0xFF);
+        touched.assign(flash, 0);
+        page_buf.assign(page, 0xFF);
+        lz_reset();
+    }
+
+    void lz_reset() {
+        lzss_init(&lz);
+        lz_page_len = 0;
+    }
+
+    void seed(uint32_t byte_addr, uint8_t value) {
+        if (byte_addr >= flash_bytes || touched[byte_addr] || seeded[byte_addr]) {
+            return;
+        }
+        seeded[byte_addr] = 1;
+        initial[byte_addr] = value;
+        expect[byte_addr] = value;
+    }
+
+    void write(uint32_t byte_addr, uint8_t value) {
+        if (byte_addr < flash_bytes) {
+            expect[byte_addr] &= value;     /* Programming only clears bits */
+            touched[byte_addr] = 1;
+        }
+    }
+
+    void erase() {
+        std::fill(expect.begin(), expect.end(), 0xFF);
+        std::fill(touched.begin(), touched.end(), 1);
+        fuse_final[FUSE_LOCK] = 0xFF;
+    }
+
+    void seed_fuse(int slot, int value) {
+        if (fuse_initial[slot] < 0 && fuse_final[slot] < 0) {
+            fuse_initial[slot] = value;
+        }
+    }
+
+    /** Program len bytes at the current address, as program_flash_page() */
+    void program(const uint8_t* data, size_t len) {
+        size_t words = len / 2;
+        for (size_t i = 0; i < words * 2; i++) {
+            write(address * 2 + (uint32_t)i, data[i]);
+        }
+        address += (uint32_t)words;
+    }
+
+    /** One raw ISP instruction and its result byte (-1 if unknown) */
+    void instruction(const uint8_t* in, int result) {
+        uint32_t word = ((uint32_t)in[1] << 8) | in[2];
+        switch (in[0]) {
+            case 0x38:
+                if (result >= 0 && calibration < 0) {
+                    calibration = result;
+                }
+                break;
+            case 0x50:
+                if (result >= 0) {
+                    seed_fuse(in[1] == 0x08 ? FUSE_EXT : FUSE_LOW, result);
+                }
+                break;
+            case 0x58:
+                if (result >= 0) {
+                    seed_fuse(in[1] == 0x08 ? FUSE_HIGH : FUSE_LOCK, result);
+                }
+                break;
+            case 0x20:
+            case 0x28:
+                if (result >= 0) {
+                    seed(word * 2 + (in[0] == 0x28), (uint8_t)result);
+                }
+                break;
+            case 0x40:
+            case 0x48:
+                page_buf[(word % (page_bytes / 2u)) * 2 + (in[0] == 0x48)] = in[3];
+                break;
+            case 0x4C: {
+                uint32_t page = (word * 2) & ~(uint32_t)(page_bytes - 1u);
+                for (uint32_t i = 0; i < page_bytes; i++) {
+                    write(page + i, page_buf[i]);
+                }
+                std::fill(page_buf.begin(), page_buf.end(), 0xFF);
+            } break;
+            case 0xAC:
+                switch (in[1]) {
+                    case 0x80: erase(); break;
+                    case 0xA0: fuse_final[FUSE_LOW] = in[3]; break;
+                    case 0xA8: fuse_final[FUSE_HIGH] = in[3]; break;
+                    case 0xA4: fuse_final[FUSE_EXT] = in[3]; break;
+                    case 0xE0: fuse_final[FUSE_LOCK] = in[3] | 0xC0; break;
+                    default: break;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+/** First signature the recording shows, from READ_SIGN or raw reads */
+static void find_signature(const std::vector<Frame>& cmds, const std::vector<Frame>& reps,
+                           const std::vector<uint8_t>& in, const std::vector<uint8_t>& out,
+                           TargetModel& m) {
+    bool have[3] = {false, false, false};
+    for (size_t k = 0; k < reps.size(); k++) {
+        const uint8_t* c = &in[cmds[k].at];
+        const uint8_t* r = &out[reps[k].at];
+        if (!ok_reply(out, reps[k])) {
+            continue;
+        }
+        if (c[0] == Cmnd_STK_READ_SIGN && reps[k].len == 5) {
+            memcpy(m.signature, r + 1, 3);
+            m.have_signature = true;
+            return;
+        }
+        if (c[0] == Cmnd_STK_UNIVERSAL && cmds[k].len == 6 && c[1] == 0x30 && (c[3] & 3) < 3) {
+            m.signature[c[3] & 3] = r[1];
+            have[c[3] & 3] = true;
+            if (have[0] && have[1] && have[2]) {
+                m.have_signature = true;
+                return;
+            }
+        }
+    }
+}
+
+/** Decode a READ_FLASH_RLE reply body */
+static std::vector<uint8_t> rle_decode(const uint8_t* p, size_t len) {
+    std::vector<uint8_t> bytes;
+    size_t i = 0;
+    while (i < len) {
+        uint8_t c = p[i];
+        if (c < 0x80) {
+            size_t n = std::min<size_t>(c + 1u, len - i - 1);
+            bytes.insert(bytes.end(), p + i + 1, p + i + 1 + n);
+            i += 1 + n;
+        } else {
+            if (i + 2 >= len) {
+                break;
+            }
+            bytes.insert(bytes.end(), (((size_t)(c & 0x7F) << 8) | p[i + 1]) + 3, p[i + 2]);
+            i += 3;
+        }
+    }
+    return bytes;
+}
+
+/**
+ * @brief Walk the recorded pairs through the model
+ */
+static void model_session(const std::vector<Frame>& cmds, const std::vector<Frame>& reps,
+                          const std::vector<uint8_t>& in, const std::vector<uint8_t>& out,
+                          TargetModel& m) {
+    for (size_t k = 0; k < reps.size(); k++) {
+        const uint8_t* c = &in[cmds[k].at];
+        size_t clen = cmds[k].len;
+        const uint8_t* r = &out[reps[k].at];
+        size_t rlen = reps[k].len;
+        bool ok = ok_reply(out, reps[k]);
+        if (clen < 2 || c[clen - 1] != Sync_CRC_EOP) {
+            continue;   /* Answered with NOSYNC, never handled */
+        }
+        const uint8_t* payload = c + 1;
+        size_t plen = clen - 2;
+
+        switch (c[0]) {
+            case Cmnd_STK_ENTER_PROGMODE:
+            case Cmnd_STK_LEAVE_PROGMODE:
+                m.lz_reset();
+                break;
+
+            case Cmnd_STK_CHIP_ERASE:
+                m.erase();
+                break;
+
+            case Cmnd_STK_LOAD_ADDRESS:
+                m.address = ((uint32_t)payload[1] << 8) | payload[0];
+                break;
+
+            case Cmnd_STK_UNIVERSAL:
+                m.instruction(payload, ok ? r[1] : -1);
+                break;
+
+            case Cmnd_STK_UNIVERSAL_MULTI:
+                for (size_t i = 1; i + 4 <= plen; i += 4) {
+                    m.instruction(payload + i, -1);
+                }
+                break;
+
+            case Cmnd_STK_UNIVERSAL_BATCH:
+                for (size_t i = 0; i < payload[0] && 1 + i * 4 + 4 <= plen; i++) {
+                    m.instruction(payload + 1 + i * 4, ok && 1 + i < rlen - 1 ? r[1 + i] : -1);
+                }
+                break;
+
+            case Cmnd_STK_PROG_PAGE: {
+                size_t size = ((size_t)payload[0] << 8) | payload[1];
+                if ((payload[2] == 'F' || payload[2] == 'f') && size == plen - 3
+                    && size <= m.page_bytes && size <= 256) {
+                    m.program(payload + 3, size);
+                }
+            } break;
+
+            case Cmnd_STK_PROG_PAGE_LZ: {
+                size_t size = ((size_t)payload[0] << 8) | payload[1];
+                if (!(payload[2] == 'F' || payload[2] == 'f') || size != plen - 3) {
+                    m.lz_reset();
+                    break;
+                }
+                size_t page = std::min<size_t>(m.page_bytes, 256);
+                if (size == 0) {
+                    if (lzss_at_boundary(&m.lz) && m.lz_page_len > 0) {
+                        if (m.lz_page_len & 1) {
+                            m.lz_page[m.lz_page_len++] = 0xFF;
+                        }
+                        m.program(m.lz_page, m.lz_page_len);
+                    }
+                    m.lz_reset();
+                    break;
+                }
+                const uint8_t* data = payload + 3;
+                size_t len = size;
+                while (len > 0 || lzss_pending(&m.lz)) {
+                    size_t used = 0;
+                    m.lz_page_len += lzss_decode(&m.lz, data, len, &used,
+                                                 m.lz_page + m.lz_page_len, page - m.lz_page_len);
+                    data += used;
+                    len -= used;
+                    if (m.lz_page_len == page) {
+                        m.program(m.lz_page, page);
+                        m.lz_page_len = 0;
+                    }
+                }
+            } break;
+
+            case Cmnd_STK_READ_PAGE: {
+                size_t size = ((size_t)payload[0] << 8) | payload[1];
+                if (ok && rlen == size + 2) {
+                    for (size_t i = 0; i < size; i++) {
+                        m.seed(m.address * 2 + (uint32_t)i, r[1 + i]);
+                    }
+                    m.address += (uint32_t)((size + 1) / 2);
+                }
+            } break;
+
+            case Cmnd_STK_READ_FLASH_RLE: {
+                size_t size = ((size_t)payload[0] << 16) | ((size_t)payload[1] << 8) | payload[2];
+                if (ok) {
+                    std::vector<uint8_t> bytes = rle_decode(r + 1, rlen - 2);
+                    for (size_t i = 0; i < bytes.size() && i < size; i++) {
+                        m.seed(m.address * 2 + (uint32_t)i, bytes[i]);
+                    }
+                    m.address += (uint32_t)((size + 1) / 2);
+                }
+            } break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/** Load the recorded initial state into the simulated target */
+static void seed_target(const TargetModel& m, const Options& o) {
+    host_target_t* t = host_target();
+    for (uint32_t i = 0; i < m.flash_bytes; i++) {
+        if (m.seeded[i]) {
+            t->flash[i] = m.initial[i];
+        }
+    }
+    uint8_t* fuse[FUSE_COUNT] = {&t->lfuse, &t->hfuse, &t->efuse, &t->lock};
+    for (int f = 0; f < FUSE_COUNT; f++) {
+        if (m.fuse_initial[f] >= 0) {
+            *fuse[f] = (uint8_t)m.fuse_initial[f];
+        }
+    }
+    if (m.calibration >= 0) {
+        t->calibration = (uint8_t)m.calibration;
+    }
+    t->cpu_hz = o.target_hz ? o.target_hz : host_target_clock_from_fuses(t->lfuse);
+}
+
+/*******************************************************************************
+ * Simulation
+ ******************************************************************************/
+
+/** A recorded host record and what it waited for */
+struct Release {
+    size_t begin;
+    size_t end;
+    size_t after_replies;       /* Replies complete when it was sent */
+    uint64_t think_us;          /* Recorded time since the last of those (or the first record) */
+};
+
+/**
+ * @brief Pair every host record with the replies that preceded it
+ *
+ * Counted in replies, not bytes, so a reply that changes size (RLE, a
+ * new error path) does not throw off the rest of the schedule. Replies
+ * precede a host record by capture order, not by time: a fast reply and
+ * the next command are often stamped in the same microsecond.
+ */
+static std::vector<Release> schedule(const Stream& host, const Stream& prog,
+                                     const std::vector<Frame>& rec) {
+    std::vector<Release> rel;
+    size_t j = 0;
+    size_t done = 0;
+    size_t begin = 0;
+    uint64_t t0 = host.marks.empty() ? 0 : host.marks.front().second;
+    for (size_t k = 0; k < host.marks.size(); k++) {
+        const auto& m = host.marks[k];
+        while (j < prog.marks.size() && prog.records[j] < host.records[k]) {
+            j++;
+        }
+        size_t sent = j ? prog.marks[j - 1].first : 0;
+        while (done < rec.size() && rec[done].at + rec[done].len <= sent) {
+            done++;
+        }
+        uint64_t since = done ? prog.time_at(rec[done - 1].at + rec[done - 1].len - 1) : t0;
+        rel.push_back({begin, m.first, done, m.second > since ? m.second - since : 0});
+        begin = m.first;
+    }
+    return rel;
+}
+
+/** Simulated session */
+struct Simulation {
+    Stream in;                      /* Feed times of the host bytes (marks only) */
+    Stream out;                     /* Reply bytes with delivery times */
+    std::vector<uint8_t> capture;   /* --save: both directions as capture records */
+    bool save = false;
+    uint32_t stalls = 0;            /* Records released without the replies they waited for */
+    bool finished = true;
+};
+
+static uint64_t now_us() {
+    return host_sim_now_ns() / 1000u;
+}
+
+static void append_record(std::vector<uint8_t>& cap, uint8_t dir, const uint8_t* data, size_t len) {
+    uint32_t t = (uint32_t)now_us();
+    uint8_t hdr[CAPTURE_RECORD_HEADER] = {
+        (uint8_t)t, (uint8_t)(t >> 8), (uint8_t)(t >> 16), (uint8_t)(t >> 24),
+        dir, (uint8_t)len, (uint8_t)(len >> 8),
+    };
+    cap.insert(cap.end(), hdr, hdr + sizeof(hdr));
+    cap.insert(cap.end(), data, data + len);
+}
+
+static void on_reply(const uint8_t* data, size_t len, void* ctx) {
+    Simulation* sim = static_cast<Simulation*>(ctx);
+    sim->out.bytes.insert(sim->out.bytes.end(), data, data + len);
+    sim->out.marks.emplace_back(sim->out.bytes.size(), now_us());
+    if (sim->save) {
+        append_record(sim->capture, 1, data, len);
+    }
+}
+
+/** Cut one record into stk500v1_feed() calls */
+static void split_record(const Release& r, const Options& o, std::mt19937& rng,
+                         std::deque<std::pair<size_t, size_t>>& rx) {
+    std::uniform_int_distribution<size_t> piece(1, 64);
+    for (size_t at = r.begin; at < r.end; ) {
+        size_t n = o.random_chunks ? piece(rng) : o.chunk ? o.chunk : r.end - at;
+        n = std::min({n, FEED_MAX, r.end - at});
+        rx.emplace_back(at, at + n);
+        at += n;
+    }
+}
+
+/**
+ * @brief Run the recorded host side against the host build, as main.c
+ *
+ * @param limit_us Simulated time after which the run is abandoned
+ */
+static void simulate(const Stream& host, const std::vector<Frame>& cmds,
+                     const std::vector<Release>& rel, const Options& o,
+                     uint64_t limit_us, Simulation& sim) {
+    host_cdc_set_sink(on_reply, &sim);
+    avr_spi_init();
+    avr_profile_init();
+    stk500v1_init();
+
+    std::mt19937 rng(o.seed);
+    std::deque<std::pair<size_t, size_t>> rx;
+    size_t next = 0;
+    uint64_t last_release = 0;
+    bool idle = false;
+    bool stalled = false;
+    uint64_t stall_base = 0;
+    std::vector<Frame> replies;
+    size_t replies_from = 0;    /* Output size replies was split at */
+
+    for (;;) {
+        tud_task();
+        uint64_t now = now_us();
+        uint64_t wake = now + 1000;     /* Idle sleep, up to the next release */
+        while (next < rel.size()) {
+            const Release& r = rel[next];
+            /* Replies are written whole within one firmware call, so
+             * between calls the output ends on a reply boundary */
+            if (replies.size() < r.after_replies && replies_from != sim.out.bytes.size()) {
+                split_more_replies(cmds, host.bytes, sim.out.bytes, replies);
+                replies_from = sim.out.bytes.size();
+            }
+            uint64_t base;
+            if (replies.size() >= r.after_replies) {
+                const Frame* last = r.after_replies ? &replies[r.after_replies - 1] : nullptr;
+                base = last ? sim.out.time_at(last->at + last->len - 1) : 0;
+            } else if (idle && rx.empty()) {
+                if (!stalled) {
+                    stalled = true;     /* The device will not send them */
+                    stall_base = now;
+                    sim.stalls++;
+                }
+                base = stall_base;
+            } else {
+                break;
+            }
+            uint64_t due = std::max(base + r.think_us, last_release);
+            if (due > now) {
+                wake = std::min(wake, due);
+                break;
+            }
+            last_release = due;
+            stalled = false;
+            split_record(r, o, rng, rx);
+            next++;
+        }
+
+        if (!rx.empty()) {
+            auto [begin, end] = rx.front();
+            rx.pop_front();
+            if (sim.save) {
+                append_record(sim.capture, 0, &host.bytes[begin], end - begin);
+            }
+            sim.in.marks.emplace_back(end, now_us());
+            stk500v1_feed(&host.bytes[begin], (int)(end - begin));
+        }
+        idle = !stk500v1_task();
+        if (idle && rx.empty()) {
+            if (next >= rel.size()) {
+                break;
+            }
+            /* Wake one loop pass early, so the record is fed at its due
+             * time and a saved session replays to the same stamps */
+            uint64_t at_ns = wake * 1000u - HOST_LOOP_NS;
+            host_sim_advance_ns(at_ns > host_sim_now_ns() ? at_ns - host_sim_now_ns() : 1u);
+        }
+        if (now_us() > limit_us) {
+            sim.finished = false;
+            break;
+        }
+    }
+    tud_cdc_write_flush();
+}
+
+/*******************************************************************************
+ * Report
+ ******************************************************************************/
+
+/** Replies whose contents depend on timing or device history */
+static bool volatile_reply(const uint8_t* cmd, size_t len) {
+    switch (cmd[0]) {
+        case Cmnd_STK_SPI_BENCH:
+        case Cmnd_STK_METRICS:
+        case Cmnd_STK_TRACE_DUMP:
+        case Cmnd_STK_CAPTURE_DUMP:
+            return true;
+        case Cmnd_STK_GET_PARAMETER:
+            return len >= 2 && cmd[1] >= Parm_VND_ENTRY_ATTEMPTS && cmd[1] <= Parm_VND_READAHEAD_MISSES;
+        default:
+            return false;
+    }
+}
+
+static void print_bytes(const std::vector<uint8_t>& s, const Frame& f) {
+    size_t n = std::min<size_t>(f.len, 16);
+    for (size_t i = 0; i < n; i++) {
+        printf(" %02X", s[f.at + i]);
+    }
+    if (f.len > n) {
+        printf(" ... (%zu bytes)", f.len);
+    }
+}
+
+/** @return Number of mismatching replies */
+static size_t compare_replies(const std::vector<Frame>& cmds, const std::vector<uint8_t>& in,
+                              const std::vector<Frame>& rec, const std::vector<uint8_t>& rec_out,
+                              const std::vector<Frame>& sim, const std::vector<uint8_t>& sim_out,
+                              bool quiet) {
+    size_t differ = 0;
+    size_t skipped = 0;
+    for (size_t k = 0; k < rec.size(); k++) {
+        const uint8_t* c = &in[cmds[k].at];
+        bool same = k < sim.size() && rec[k].len == sim[k].len
+                 && memcmp(&rec_out[rec[k].at], &sim_out[sim[k].at], rec[k].len) == 0;
+        if (!same && volatile_reply(c, cmds[k].len) && k < sim.size()
+            && ok_reply(rec_out, rec[k]) == ok_reply(sim_out, sim[k])) {
+            skipped++;
+            continue;
+        }
+        if (same) {
+            continue;
+        }
+        if (differ++ < 5 && !quiet) {
+            printf("  #%zu %s\n     CMD:", k + 1, command_name(c[0]));
+            print_bytes(in, cmds[k]);
+            printf("\n     REC:");
+            print_bytes(rec_out, rec[k]);
+            printf("\n     SIM:");
+            if (k < sim.size()) {
+                print_bytes(sim_out, sim[k]);
+            } else {
+                printf(" (none)");
+            }
+            printf("\n");
+        }
+    }
+    printf("Replies: %zu recorded, %zu simulated, %zu differ", rec.size(), sim.size(), differ);
+    if (skipped) {
+        printf(", %zu timing-dependent skipped", skipped);
+    }
+    printf("\n");
+    return differ;
+}
+
+/** @return Number of differing flash bytes and fuses */
+static size_t compare_target(const TargetModel& m, bool quiet) {
+    const host_target_t* t = host_target();
+    size_t differ = 0;
+    size_t ranges = 0;
+    for (uint32_t i = 0; i < m.flash_bytes; ) {
+        if (t->flash[i] == m.expect[i]) {
+            i++;
+            continue;
+        }
+        uint32_t start = i;
+        while (i < m.flash_bytes && t->flash[i] != m.expect[i]) {
+            i++;
+        }
+        differ += i - start;
+        if (ranges++ < 5 && !quiet) {
+            printf("  flash 0x%05X-0x%05X: expected %02X, simulated %02X\n",
+                   start, i - 1, m.expect[start], t->flash[start]);
+        }
+    }
+
+    static const char* const names[FUSE_COUNT] = {"lfuse", "hfuse", "efuse", "lock"};
+    const uint8_t actual[FUSE_COUNT] = {t->lfuse, t->hfuse, t->efuse, t->lock};
+    size_t fuses = 0;
+    for (int f = 0; f < FUSE_COUNT; f++) {
+        if (m.fuse_final[f] >= 0 && actual[f] != m.fuse_final[f]) {
+            fuses++;
+            if (!quiet) {
+                printf("  %s: expected %02X, simulated %02X\n", names[f], m.fuse_final[f], actual[f]);
+            }
+        }
+    }
+    size_t written = (size_t)std::count(m.touched.begin(), m.touched.end(), 1);
+    size_t seeded = (size_t)std::count(m.seeded.begin(), m.seeded.end(), 1);
+    printf("Target: %s, %u bytes flash, %zu written/erased, %zu seeded from reads, "
+           "%zu bytes and %zu fuses differ\n",
+           m.have_signature ? "signature from recording" : "default signature",
+           m.flash_bytes, written, seeded, differ, fuses);
+    return differ + fuses;
+}
+
+/** Per-command latency totals, recorded vs simulated */
+static void compare_time(const std::vector<Frame>& cmds, const Stream& host,
+                         const std::vector<Frame>& rec, const Stream& prog,
+                         const std::vector<Frame>& got, const Simulation& sim) {
+    struct Totals {
+        uint64_t count = 0;
+        uint64_t rec_us = 0;
+        uint64_t sim_us = 0;
+    };
+    Totals per[256];
+    std::vector<int> order;
+
+    /* Latency as in stkcap: command EOP to the last byte of its reply */
+    size_t n = std::min(rec.size(), got.size());
+    for (size_t k = 0; k < n; k++) {
+        uint8_t c = host.bytes[cmds[k].at];
+        size_t eop = cmds[k].at + cmds[k].len - 1;
+        uint64_t t_cmd = host.time_at(eop);
+        uint64_t t_rsp = prog.time_at(rec[k].at + rec[k].len - 1);
+        uint64_t s_cmd = sim.in.time_at(eop);
+        uint64_t s_rsp = sim.out.time_at(got[k].at + got[k].len - 1);
+        if (per[c].count++ == 0) {
+            order.push_back(c);
+        }
+        per[c].rec_us += t_rsp > t_cmd ? t_rsp - t_cmd : 0;
+        per[c].sim_us += s_rsp > s_cmd ? s_rsp - s_cmd : 0;
+    }
+
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return per[a].rec_us > per[b].rec_us; });
+    printf("\n%-16s %6s %10s %10s %8s\n", "command", "count", "rec ms", "sim ms", "change");
+    for (int c : order) {
+        const Totals& t = per[c];
+        double change = t.rec_us ? 100.0 * ((double)t.sim_us - (double)t.rec_us) / (double)t.rec_us : 0;
+        printf("%-16s %6" PRIu64 " %10.1f %10.1f %+7.1f%%\n", command_name((uint8_t)c), t.count,
+               t.rec_us / 1e3, t.sim_us / 1e3, change);
+    }
+}
+
+/*******************************************************************************
+ * Main
+ ******************************************************************************/
+
+static int usage(void) {
+    fprintf(stderr,
+            "usage: replay CAPTURE [--chunk N | --random-chunks SEED] [--target-mhz F]\n"
+            "              [--budget-ms T] [--save FILE] [--quiet]\n");
+    return 2;
+}
+
+static bool parse_args(int argc, char** argv, Options& o) {
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        bool has_value = a + 1 < argc;
+        if (arg == "--chunk" && has_value) {
+            o.chunk = std::strtoul(argv[++a], nullptr, 0);
+        } else if (arg == "--random-chunks" && has_value) {
+            o.random_chunks = true;
+            o.seed = (uint32_t)std::strtoul(argv[++a], nullptr, 0);
+        } else if (arg == "--target-mhz" && has_value) {
+            o.target_hz = (uint32_t)(std::strtod(argv[++a], nullptr) * 1e6);
+        } else if (arg == "--budget-ms" && has_value) {
+            o.budget_ms = std::strtod(argv[++a], nullptr);
+        } else if (arg == "--save" && has_value) {
+            o.save = argv[++a];
+        } else if (arg == "--quiet") {
+            o.quiet = true;
+        } else if (arg[0] == '-' || o.capture) {
+            return false;
+        } else {
+            o.capture = argv[a];
+        }
+    }
+    return o.capture != nullptr;
+}
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parse_args(argc, argv, o)) {
+        return usage();
+    }
+
+    try {
+        Stream host, prog;
+        {
+            MappedFile f(o.capture);
+            parse_capture(f.data(), f.size(), host, prog);
+        }
+        if (host.marks.empty()) {
+            throw std::runtime_error("no host records in capture");
+        }
+        std::vector<Frame> cmds = split_commands(host.bytes);
+        std::vector<Frame> rec = split_replies(cmds, host.bytes, prog.bytes);
+
+        /* Target as the recording shows it */
+        host_sim_reset();
+        TargetModel model;
+        find_signature(cmds, rec, host.bytes, prog.bytes, model);
+        host_target_init(model.signature);
+        model.reset(host_target()->flash_bytes, host_target()->page_bytes);
+        model_session(cmds, rec, host.bytes, prog.bytes, model);
+        seed_target(model, o);
+
+        /* Replay */
+        std::vector<Release> rel = schedule(host, prog, rec);
+        uint64_t rec_first = host.marks.front().second;
+        uint64_t rec_last = std::max(host.marks.back().second,
+                                     prog.marks.empty() ? 0 : prog.marks.back().second);
+        Simulation sim;
+        sim.save = o.save != nullptr;
+        simulate(host, cmds, rel, o, (rec_last - rec_first) * 10 + 60000000u, sim);
+        if (!sim.finished) {
+            printf("Simulation did not finish within 10x the recorded time\n");
+        }
+
+        std::vector<Frame> got = split_replies(cmds, host.bytes, sim.out.bytes);
+        size_t reply_diff = compare_replies(cmds, host.bytes, rec, prog.bytes, got, sim.out.bytes, o.quiet);
+        size_t target_diff = compare_target(model, o.quiet);
+        if (!o.quiet) {
+            compare_time(cmds, host, rec, prog, got, sim);
+        }
+
+        const host_target_t* t = host_target();
+        double rec_ms = (rec_last - rec_first) / 1e3;
+        double sim_ms = (sim.out.marks.empty() ? now_us() : sim.out.marks.back().second) / 1e3;
+        printf("\nSession: recorded %.1f ms, simulated %.1f ms (%+.1f%%)\n",
+               rec_ms, sim_ms, rec_ms > 0 ? 100.0 * (sim_ms - rec_ms) / rec_ms : 0.0);
+        printf("  target: %u instructions at %u Hz SCK (clock %u Hz), %u page writes, "
+               "%u misreads, %u sent while busy\n",
+               t->instructions, host_target_sck_hz(), t->cpu_hz, t->page_writes,
+               t->misreads, t->busy_violations);
+        if (sim.stalls) {
+            printf("  %u host records released without the reply they waited for\n", sim.stalls);
+        }
+
+        if (o.save) {
+            FILE* f = fopen(o.save, "wb");
+            if (!f || fwrite(sim.capture.data(), 1, sim.capture.size(), f) != sim.capture.size()) {
+                throw std::runtime_error(std::string("cannot write ") + o.save);
+            }
+            fclose(f);
+        }
+
+        bool over = o.budget_ms > 0 && sim_ms > o.budget_ms;
+        if (over) {
+            printf("Over budget: %.1f ms > %.1f ms\n", sim_ms, o.budget_ms);
+        }
+        return reply_diff || target_diff || over || !sim.finished ? 1 : 0;
+    } catch (const std::exception& e) {
+        fprintf(stderr, "replay: %s\n", e.what());
+        return 3;
+    }
+}
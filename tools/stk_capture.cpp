@@ -0,0 +1,291 @@
+/**
+ * @file stk_capture.cpp
+ * @brief Capture Files and STK500v1 Stream Splitting for the Host Tools
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "stk_capture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*******************************************************************************
+ * Capture File
+ ******************************************************************************/
+
+/**
+ * @brief Map a whole file read-only
+ */
+MappedFile::MappedFile(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("cannot open ") + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error(std::string("cannot stat ") + path);
+    }
+    size_ = (size_t)st.st_size;
+    if (size_ > 0) {
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error(std::string("cannot map ") + path);
+        }
+        madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const uint8_t*>(p);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+/**
+ * @brief Timestamp of the byte at offset
+ */
+uint64_t Stream::time_at(size_t offset) const {
+    auto it = std::upper_bound(marks.begin(), marks.end(), offset,
+        [](size_t o, const std::pair<size_t, uint64_t>& m) { return o < m.first; });
+    return it == marks.end() ? marks.back().second : it->second;
+}
+
+/**
+ * @brief Split a firmware capture into the host and programmer streams
+ */
+void parse_capture(const uint8_t* raw, size_t len, Stream& host, Stream& prog) {
+    host.bytes.reserve(len);
+    prog.bytes.reserve(len);
+    uint64_t base = 0;
+    uint32_t prev = 0;
+    bool first = true;
+    size_t i = 0;
+    size_t record = 0;
+    while (i + CAPTURE_RECORD_HEADER <= len) {
+        uint32_t t = (uint32_t)raw[i] | (uint32_t)raw[i + 1] << 8
+                   | (uint32_t)raw[i + 2] << 16 | (uint32_t)raw[i + 3] << 24;
+        if (!first && t < prev && prev - t > 0x80000000u) {
+            base += 1ull << 32;    /* time_us_32() wrapped */
+        }
+        first = false;
+        prev = t;
+        size_t n = (size_t)raw[i + 5] | (size_t)raw[i + 6] << 8;
+        if (i + CAPTURE_RECORD_HEADER + n > len) {
+            break;
+        }
+        Stream& s = raw[i + 4] == 0 ? host : prog;
+        s.bytes.insert(s.bytes.end(), raw + i + CAPTURE_RECORD_HEADER, raw + i + CAPTURE_RECORD_HEADER + n);
+        s.marks.emplace_back(s.bytes.size(), base + t);
+        s.records.push_back(record++);
+        i += CAPTURE_RECORD_HEADER + n;
+    }
+}
+
+/*******************************************************************************
+ * Frame Splitting
+ ******************************************************************************/
+
+/**
+ * @brief Split the host stream into command frames the way the firmware does
+ */
+std::vector<Frame> split_commands(const std::vector<uint8_t>& in) {
+    std::vector<Frame> cmds;
+    const uint8_t* p = in.data();
+    size_t n = in.size();
+    size_t i = 0;
+    while (i < n) {
+        int length = stk500v1_frame_length(p + i, n - i);
+        if (length == STK_FRAME_SKIP) {
+            i++;
+            continue;
+        }
+        if (length == STK_FRAME_MORE || i + (size_t)length > n) {
+            break;
+        }
+        size_t len = (size_t)length;
+        if (p[i + len - 1] != Sync_CRC_EOP) {
+            const void* eop = memchr(p + i, Sync_CRC_EOP, n - i);
+            len = eop ? (size_t)(static_cast<const uint8_t*>(eop) - (p + i)) + 1 : 1;
+        }
+        cmds.push_back({i, len});
+        i += len;
+    }
+    return cmds;
+}
+
+/** Bytes of a READ_FLASH_RLE stream at out[i] decoding to size bytes, 0 if cut */
+static size_t rle_length(const std::vector<uint8_t>& out, size_t i, long size) {
+    size_t start = i;
+    while (size > 0) {
+        if (i >= out.size()) {
+            return 0;
+        }
+        uint8_t c = out[i];
+        if (c < 0x80) {
+            i += 2 + (size_t)c;
+            size -= c + 1;
+        } else {
+            if (i + 1 >= out.size()) {
+                return 0;
+            }
+            size -= (((long)(c & 0x7F) << 8) | out[i + 1]) + 3;
+            i += 3;
+        }
+    }
+    return i - start;
+}
+
+static uint32_t be32(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+/**
+ * @brief Length of a successful reply to cmd at out[i]
+ *
+ * @return Reply length, 0 if the stream ends before it is known
+ */
+static size_t success_length(const uint8_t* cmd, size_t cmd_len,
+                             const std::vector<uint8_t>& out, size_t i) {
+    size_t avail = out.size() - i;
+    switch (cmd[0]) {
+        case Cmnd_STK_GET_SIGN_ON:
+            return 9;                       /* INSYNC "AVR ISP" OK */
+        case Cmnd_STK_GET_PARAMETER:
+        case Cmnd_STK_CHECK_AUTOINC:
+        case Cmnd_STK_UNIVERSAL:
+            return 3;
+        case Cmnd_STK_READ_SIGN:
+            return 5;
+        case Cmnd_STK_READ_PAGE:
+            return cmd_len >= 5 ? ((size_t)cmd[1] << 8 | cmd[2]) + 2 : 2;
+        case Cmnd_STK_UNIVERSAL_BATCH:
+            return cmd_len >= 3 ? (size_t)cmd[1] + 2 : 2;
+        case Cmnd_STK_SPI_BENCH:
+            return avail > 1 ? 2 + (size_t)out[i + 1] * 8 + 1 : 0;
+        case Cmnd_STK_VERIFY_MAP:
+            return avail > 2 ? 3 + ((size_t)out[i + 1] << 8 | out[i + 2]) + 1 : 0;
+        case Cmnd_STK_METRICS: {
+            if (avail <= 5) {
+                return 0;
+            }
+            size_t j = 6 + (size_t)out[i + 5] * 4;
+            return j < avail ? j + 1 + (size_t)out[i + j] * 13 + 1 : 0;
+        }
+        case Cmnd_STK_TRACE_DUMP:
+            return avail > 2 ? 7 + ((size_t)out[i + 1] << 8 | out[i + 2]) * 8 + 1 : 0;
+        case Cmnd_STK_CAPTURE_DUMP:
+            return avail > 4 ? 9 + (size_t)be32(&out[i + 1]) + 1 : 0;
+        case Cmnd_STK_READ_FLASH_RLE: {
+            if (cmd_len < 6) {
+                return 2;
+            }
+            long size = (long)cmd[1] << 16 | (long)cmd[2] << 8 | cmd[3];
+            size_t n = size ? rle_length(out, i + 1, size) : 0;
+            return size && !n ? 0 : n + 2;
+        }
+        default:
+            return 2;
+    }
+}
+
+/**
+ * @brief Cut the programmer stream into one reply per command
+ */
+std::vector<Frame> split_replies(const std::vector<Frame>& cmds,
+                                 const std::vector<uint8_t>& in,
+                                 const std::vector<uint8_t>& out) {
+    std::vector<Frame> reps;
+    reps.reserve(cmds.size());
+    split_more_replies(cmds, in, out, reps);
+    return reps;
+}
+
+/**
+ * @brief Continue split_replies() on a grown programmer stream
+ */
+void split_more_replies(const std::vector<Frame>& cmds,
+                        const std::vector<uint8_t>& in,
+                        const std::vector<uint8_t>& out,
+                        std::vector<Frame>& reps) {
+    size_t i = reps.empty() ? 0 : reps.back().at + reps.back().len;
+    for (size_t k = reps.size(); k < cmds.size(); k++) {
+        const Frame& c = cmds[k];
+        if (i >= out.size()) {
+            break;
+        }
+        if (out[i] == Resp_STK_NOSYNC) {
+            reps.push_back({i, 1});
+            i += 1;
+            continue;
+        }
+        if (out[i] != Resp_STK_INSYNC) {
+            break;      /* Lost track; the rest cannot be paired */
+        }
+        size_t n = success_length(&in[c.at], c.len, out, i);
+        if (n == 0 || i + n > out.size() || out[i + n - 1] != Resp_STK_OK) {
+            n = i + 1 < out.size() && out[i + 1] == Resp_STK_FAILED ? 2 : 0;
+        }
+        if (n == 0) {
+            break;
+        }
+        reps.push_back({i, n});
+        i += n;
+    }
+}
+
+/*******************************************************************************
+ * Names
+ ******************************************************************************/
+
+/**
+ * @brief Get the name of a command byte
+ */
+const char* command_name(uint8_t cmd) {
+    switch (cmd) {
+        case Cmnd_STK_GET_SYNC:         return "GET_SYNC";
+        case Cmnd_STK_GET_SIGN_ON:      return "GET_SIGN_ON";
+        case Cmnd_STK_SET_PARAMETER:    return "SET_PARAMETER";
+        case Cmnd_STK_GET_PARAMETER:    return "GET_PARAMETER";
+        case Cmnd_STK_SET_DEVICE:       return "SET_DEVICE";
+        case Cmnd_STK_SET_DEVICE_EXT:   return "SET_DEVICE_EXT";
+        case Cmnd_STK_ENTER_PROGMODE:   return "ENTER_PROGMODE";
+        case Cmnd_STK_LEAVE_PROGMODE:   return "LEAVE_PROGMODE";
+        case Cmnd_STK_CHIP_ERASE:       return "CHIP_ERASE";
+        case Cmnd_STK_CHECK_AUTOINC:    return "CHECK_AUTOINC";
+        case Cmnd_STK_LOAD_ADDRESS:     return "LOAD_ADDRESS";
+        case Cmnd_STK_UNIVERSAL:        return "UNIVERSAL";
+        case Cmnd_STK_UNIVERSAL_MULTI:  return "UNIVERSAL_MULTI";
+        case Cmnd_STK_UNIVERSAL_BATCH:  return "UNIVERSAL_BATCH";
+        case Cmnd_STK_SPI_BENCH:        return "SPI_BENCH";
+        case Cmnd_STK_VERIFY_MAP:       return "VERIFY_MAP";
+        case Cmnd_STK_METRICS:          return "METRICS";
+        case Cmnd_STK_TRACE_DUMP:       return "TRACE_DUMP";
+        case Cmnd_STK_CAPTURE_DUMP:     return "CAPTURE_DUMP";
+        case Cmnd_STK_PROG_PAGE:        return "PROG_PAGE";
+        case Cmnd_STK_PROG_PAGE_LZ:     return "PROG_PAGE_LZ";
+        case Cmnd_STK_READ_PAGE:        return "READ_PAGE";
+        case Cmnd_STK_READ_SIGN:        return "READ_SIGN";
+        case Cmnd_STK_READ_FLASH_RLE:   return "READ_FLASH_RLE";
+        default:                        return "?";
+    }
+}
+
+/**
+ * @brief Check whether a reply ends in OK
+ */
+bool ok_reply(const std::vector<uint8_t>& out, const Frame& r) {
+    return r.len >= 2 && out[r.at + r.len - 1] == Resp_STK_OK;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file stk_capture.h
+ * @brief Capture Files and STK500v1 Stream Splitting for the Host Tools
+ *
+ * Shared by stkcap (analysis) and replay (simulation). Commands are
+ * split with the firmware's own frame rule (stk500v1_frame_length()),
+ * replies with the layout each command's handler produces.
+ *
+ * Capture Files:
+ *   Records as dumped by Cmnd_STK_CAPTURE_DUMP (see capture.h): time,
+ *   direction, length, data. Hand captures are two raw byte files.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include "stk500v1.h"
+}
+
+/** Capture record header bytes (see capture.h) */
+constexpr size_t CAPTURE_RECORD_HEADER = 7;
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ *
+ * Throws std::runtime_error if the file cannot be opened or mapped.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const char* path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/** One direction of the session */
+struct Stream {
+    std::vector<uint8_t> bytes;
+    /* (end offset, time_us) per capture record: bytes before end offset
+     * and at or after the previous mark were stamped with time_us */
+    std::vector<std::pair<size_t, uint64_t>> marks;
+    /* Capture record index per mark, for ordering the two streams when
+     * records share a timestamp (parse_capture() only) */
+    std::vector<size_t> records;
+
+    /** Timestamp of the byte at offset (requires marks) */
+    uint64_t time_at(size_t offset) const;
+};
+
+/** Byte range of a frame in its stream */
+struct Frame {
+    size_t at;
+    size_t len;
+};
+
+/**
+ * @brief Split a firmware capture into the host and programmer streams
+ *
+ * Undoes time_us_32() wraps. A truncated last record is ignored.
+ *
+ * @param raw  Capture records
+ * @param len  Number of bytes
+ * @param host Receives the host to programmer stream
+ * @param prog Receives the programmer to host stream
+ */
+void parse_capture(const uint8_t* raw, size_t len, Stream& host, Stream& prog);
+
+/**
+ * @brief Split the host stream into command frames the way the firmware does
+ *
+ * Bytes that cannot start a frame are skipped; a frame without its EOP
+ * is cut at the next EOP (answered with NOSYNC). Stops at a frame the
+ * capture ends in.
+ */
+std::vector<Frame> split_commands(const std::vector<uint8_t>& in);
+
+/**
+ * @brief Cut the programmer stream into one reply per command
+ *
+ * A reply is a NOSYNC byte, INSYNC FAILED, or the success layout of its
+ * command; success wins when both fit (READ_PAGE data starting with
+ * FAILED). Stops where the stream can no longer be followed.
+ *
+ * @param cmds Command frames from split_commands()
+ * @param in   Host stream the frames refer to
+ * @param out  Programmer stream
+ * @return One reply per command, possibly fewer
+ */
+std::vector<Frame> split_replies(const std::vector<Frame>& cmds,
+                                 const std::vector<uint8_t>& in,
+                                 const std::vector<uint8_t>& out);
+
+/**
+ * @brief Continue split_replies() after the programmer stream grew
+ *
+ * Pairs only the commands after the last reply already in reps. The
+ * stream must end on a reply boundary, or a partial reply may be taken
+ * for INSYNC FAILED.
+ */
+void split_more_replies(const std::vector<Frame>& cmds,
+                        const std::vector<uint8_t>& in,
+                        const std::vector<uint8_t>& out,
+                        std::vector<Frame>& reps);
+
+/**
+ * @brief Get the name of a command byte ("?" if unknown)
+ */
+const char* command_name(uint8_t cmd);
+
+/**
+ * @brief Check whether a reply ends in OK
+ */
+bool ok_reply(const std::vector<uint8_t>& out, const Frame& r);
@@ -0,0 +1,361 @@
+/**
+ * @file stkcap.cpp
+ * @brief STK500v1 Capture Analyzer
+ *
+ * Native counterpart of test.py for captures too large for Python
+ * (fleet runs, several MB). The host stream is split with the
+ * firmware's own frame rule (stk500v1_frame_length()), including its
+ * NOSYNC resync, so frames whose payload contains EOP bytes are never
+ * mis-framed. Every command is paired with its reply and the same
+ * per-command table and session breakdown as test.py are printed.
+ *
+ * The capture file (capture.h record format) is memory-mapped and
+ * decoded in one pass; pairing and timing are linear in its size.
+ *
+ * Usage:
+ *   stkcap cap.bin [--list] [--no-hist] [--timeline t.json] [--csv p.csv]
+ *   stkcap in.txt out.txt [--list]        (hand capture, no timing)
+ *
+ * Timeline:
+ *   Chrome trace JSON (chrome://tracing, ui.perfetto.dev) with one track
+ *   for the programmer (command received -> reply flushed) and one for
+ *   the host and USB (reply flushed -> next command received).
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "stk_capture.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*******************************************************************************
+ * Analysis
+ ******************************************************************************/
+
+/**
+ * Command/reply pair with times of the command EOP and the last reply
+ * byte. A command that arrives while the previous reply is still pending
+ * (host readahead) starts at that reply instead, so latencies never
+ * overlap and add up with the host gaps to the session time.
+ */
+struct Pair {
+    Frame cmd;
+    Frame rsp;
+    uint64_t t_cmd;
+    uint64_t t_start;
+    uint64_t t_rsp;
+};
+
+/** Per-command totals */
+struct CommandStats {
+    uint64_t count = 0;
+    uint64_t failed = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    uint64_t total_us = 0;
+    std::vector<uint32_t> latency;
+};
+
+static uint32_t percentile(std::vector<uint32_t>& v, int p) {
+    size_t k = std::min(v.size() - 1, v.size() * (size_t)p / 100);
+    std::nth_element(v.begin(), v.begin() + (long)k, v.end());
+    return v[k];
+}
+
+static void print_histogram(const std::vector<uint32_t>& v) {
+    uint64_t buckets[33] = {0};
+    int lo = 32, hi = 4;
+    for (uint32_t x : v) {
+        int b = 0;
+        while (b < 32 && (x >> b)) {
+            b++;
+        }
+        b = std::max(b, 4);
+        buckets[b]++;
+        lo = std::min(lo, b);
+        hi = std::max(hi, b);
+    }
+    uint64_t peak = *std::max_element(buckets + lo, buckets + hi + 1);
+    for (int b = lo; b <= hi; b++) {
+        uint64_t n = buckets[b];
+        uint64_t bar = n ? std::max<uint64_t>(n * 30 / peak, 1) : 0;
+        printf("    %8" PRIu64 "-%-8" PRIu64 " us %6" PRIu64 " %s\n",
+               (uint64_t)(b == 4 ? 0 : 1ull << (b - 1)), (uint64_t)((1ull << b) - 1), n, std::string(bar, '#').c_str());
+    }
+}
+
+/**
+ * @brief Print the per-command table, histograms and session breakdown
+ */
+static void analyze(const std::vector<Pair>& pairs, const std::vector<uint8_t>& in,
+                    const std::vector<uint8_t>& out, bool timed, bool show_hist) {
+    CommandStats stats[256];
+    std::vector<int> order;     /* First seen first, as ties are listed */
+    for (const Pair& p : pairs) {
+        CommandStats& s = stats[in[p.cmd.at]];
+        if (s.count == 0) {
+            order.push_back(in[p.cmd.at]);
+        }
+        s.count++;
+        s.failed += !ok_reply(out, p.rsp);
+        s.bytes_in += p.cmd.len;
+        s.bytes_out += p.rsp.len;
+        if (timed) {
+            uint32_t lat = (uint32_t)(p.t_rsp - p.t_start);
+            s.total_us += lat;
+            s.latency.push_back(lat);
+        }
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return timed ? stats[a].total_us > stats[b].total_us
+                     : strcmp(command_name((uint8_t)a), command_name((uint8_t)b)) < 0;
+    });
+
+    printf("%-16s %6s %5s %8s %8s", "command", "count", "fail", "in B", "out B");
+    if (timed) {
+        printf(" %9s %8s %8s %8s", "total ms", "p50 us", "p95 us", "max us");
+    }
+    printf("\n");
+    for (int c : order) {
+        CommandStats& s = stats[c];
+        char unknown[8];
+        const char* name = command_name((uint8_t)c);
+        if (name[0] == '?') {
+            snprintf(unknown, sizeof(unknown), "0x%02X", c);
+            name = unknown;
+        }
+        printf("%-16s %6" PRIu64 " %5" PRIu64 " %8" PRIu64 " %8" PRIu64,
+               name, s.count, s.failed, s.bytes_in, s.bytes_out);
+        if (timed) {
+            uint32_t max = *std::max_element(s.latency.begin(), s.latency.end());
+            uint32_t p50 = percentile(s.latency, 50);
+            uint32_t p95 = percentile(s.latency, 95);
+            printf(" %9.1f %8u %8u %8u", s.total_us / 1e3, p50, p95, max);
+        }
+        printf("\n");
+    }
+    if (!timed) {
+        return;
+    }
+
+    if (show_hist) {
+        printf("\nLatency histograms (command start -> reply flushed):\n");
+        for (int c : order) {
+            printf("  %s\n", command_name((uint8_t)c));
+            print_histogram(stats[c].latency);
+        }
+    }
+
+    uint64_t span = std::max<uint64_t>(pairs.back().t_rsp - pairs.front().t_cmd, 1);
+    uint64_t device = 0;
+    uint64_t written = 0;
+    uint64_t read = 0;
+    for (const Pair& p : pairs) {
+        device += p.t_rsp - p.t_start;
+        if (!ok_reply(out, p.rsp)) {
+            continue;
+        }
+        if (in[p.cmd.at] == Cmnd_STK_PROG_PAGE) {
+            written += p.cmd.len - 5;
+        } else if (in[p.cmd.at] == Cmnd_STK_READ_PAGE) {
+            read += p.rsp.len - 2;
+        }
+    }
+    uint64_t host = span > device ? span - device : 0;
+    printf("\nSession %.1f ms over %zu commands\n", span / 1e3, pairs.size());
+    printf("  programmer   %10.1f ms %5.1f%%\n", device / 1e3, 100.0 * device / span);
+    printf("  host + USB   %10.1f ms %5.1f%%  (avg %.0f us between reply and next command)\n",
+           host / 1e3, 100.0 * host / span, (double)host / pairs.size());
+    if (written) {
+        printf("  PROG_PAGE    %10" PRIu64 " B  %8.1f kB/s\n", written, written * 1e3 / span);
+    }
+    if (read) {
+        printf("  READ_PAGE    %10" PRIu64 " B  %8.1f kB/s\n", read, read * 1e3 / span);
+    }
+}
+
+/*******************************************************************************
+ * Output Files
+ ******************************************************************************/
+
+static void print_hex(FILE* f, const std::vector<uint8_t>& s, const Frame& r) {
+    for (size_t k = 0; k < r.len; k++) {
+        fprintf(f, k ? " %02X" : "%02X", s[r.at + k]);
+    }
+}
+
+/** Paired listing in test.py --list layout */
+static void print_list(const std::vector<Pair>& pairs, const std::vector<uint8_t>& in,
+                       const std::vector<uint8_t>& out, bool timed) {
+    for (size_t k = 0; k < pairs.size(); k++) {
+        const Pair& p = pairs[k];
+        printf("%04zu", k + 1);
+        if (timed) {
+            printf(" +%9.3f ms", (p.t_cmd - pairs.front().t_cmd) / 1e3);
+        }
+        printf(" %s", command_name(in[p.cmd.at]));
+        if (timed) {
+            printf("  (%" PRIu64 " us)", p.t_rsp - p.t_start);
+        }
+        printf("\n     CMD: ");
+        print_hex(stdout, in, p.cmd);
+        printf("\n     RSP: ");
+        print_hex(stdout, out, p.rsp);
+        printf("\n\n");
+    }
+}
+
+static const char* status_of(const std::vector<uint8_t>& out, const Frame& r) {
+    if (out[r.at] == Resp_STK_NOSYNC) {
+        return "nosync";
+    }
+    return ok_reply(out, r) ? "ok" : "failed";
+}
+
+/** Chrome trace JSON: programmer and host + USB tracks */
+static void write_timeline(const char* path, const std::vector<Pair>& pairs,
+                           const std::vector<uint8_t>& in, const std::vector<uint8_t>& out) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        throw std::runtime_error(std::string("cannot write ") + path);
+    }
+    uint64_t t0 = pairs.front().t_cmd;
+    fprintf(f, "{\"traceEvents\":[\n"
+               "{\"ph\":\"M\",\"pid\":1,\"tid\":1,\"name\":\"thread_name\",\"args\":{\"name\":\"programmer\"}},\n"
+               "{\"ph\":\"M\",\"pid\":1,\"tid\":2,\"name\":\"thread_name\",\"args\":{\"name\":\"host + USB\"}}");
+    for (size_t k = 0; k < pairs.size(); k++) {
+        const Pair& p = pairs[k];
+        fprintf(f, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":1,\"name\":\"%s\",\"ts\":%" PRIu64
+                   ",\"dur\":%" PRIu64 ",\"args\":{\"in\":%zu,\"out\":%zu,\"status\":\"%s\"}}",
+                command_name(in[p.cmd.at]), p.t_start - t0, p.t_rsp - p.t_start,
+                p.cmd.len, p.rsp.len, status_of(out, p.rsp));
+        if (k + 1 < pairs.size() && pairs[k + 1].t_start > p.t_rsp) {
+            fprintf(f, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":2,\"name\":\"host\",\"ts\":%" PRIu64
+                       ",\"dur\":%" PRIu64 "}",
+                    p.t_rsp - t0, pairs[k + 1].t_start - p.t_rsp);
+        }
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(f);
+}
+
+/** One row per pair, for spreadsheets and fleet scripts */
+static void write_csv(const char* path, const std::vector<Pair>& pairs,
+                      const std::vector<uint8_t>& in, const std::vector<uint8_t>& out, bool timed) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        throw std::runtime_error(std::string("cannot write ") + path);
+    }
+    fprintf(f, "seq,command,t_us,latency_us,in_bytes,out_bytes,status\n");
+    for (size_t k = 0; k < pairs.size(); k++) {
+        const Pair& p = pairs[k];
+        fprintf(f, "%zu,%s,", k + 1, command_name(in[p.cmd.at]));
+        if (timed) {
+            fprintf(f, "%" PRIu64 ",%" PRIu64, p.t_cmd - pairs.front().t_cmd, p.t_rsp - p.t_start);
+        } else {
+            fprintf(f, ",");
+        }
+        fprintf(f, ",%zu,%zu,%s\n", p.cmd.len, p.rsp.len, status_of(out, p.rsp));
+    }
+    fclose(f);
+}
+
+/*******************************************************************************
+ * Main
+ ******************************************************************************/
+
+static int usage(void) {
+    fprintf(stderr,
+            "usage: stkcap CAPTURE [--list] [--no-hist] [--timeline FILE] [--csv FILE]\n"
+            "       stkcap IN_BYTES OUT_BYTES [--list] [--csv FILE]\n");
+    return 2;
+}
+
+static void load(const char* path, std::vector<uint8_t>& bytes) {
+    MappedFile f(path);
+    bytes.assign(f.data(), f.data() + f.size());
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> files;
+    bool list = false;
+    bool show_hist = true;
+    const char* timeline = nullptr;
+    const char* csv = nullptr;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--list") {
+            list = true;
+        } else if (arg == "--no-hist") {
+            show_hist = false;
+        } else if (arg == "--timeline" && a + 1 < argc) {
+            timeline = argv[++a];
+        } else if (arg == "--csv" && a + 1 < argc) {
+            csv = argv[++a];
+        } else if (arg[0] == '-') {
+            return usage();
+        } else {
+            files.push_back(argv[a]);
+        }
+    }
+    if (files.empty() || files.size() > 2) {
+        return usage();
+    }
+
+    try {
+        Stream host, prog;
+        bool timed = files.size() == 1;
+        if (timed) {
+            MappedFile f(files[0]);
+            parse_capture(f.data(), f.size(), host, prog);
+        } else {
+            load(files[0], host.bytes);
+            load(files[1], prog.bytes);
+        }
+
+        std::vector<Frame> cmds = split_commands(host.bytes);
+        std::vector<Frame> reps = split_replies(cmds, host.bytes, prog.bytes);
+        timed = timed && !host.marks.empty() && !prog.marks.empty();
+
+        std::vector<Pair> pairs;
+        pairs.reserve(reps.size());
+        uint64_t prev_rsp = 0;
+        for (size_t k = 0; k < reps.size(); k++) {
+            Pair p = {cmds[k], reps[k], 0, 0, 0};
+            if (timed) {
+                p.t_cmd = host.time_at(p.cmd.at + p.cmd.len - 1);
+                p.t_start = std::max(p.t_cmd, prev_rsp);
+                p.t_rsp = std::max(prog.time_at(p.rsp.at + p.rsp.len - 1), p.t_start);
+                prev_rsp = p.t_rsp;
+            }
+            pairs.push_back(p);
+        }
+
+        printf("commands=%zu replies=%zu paired=%zu\n\n", cmds.size(), reps.size(), pairs.size());
+        if (pairs.empty()) {
+            return 0;
+        }
+        if (list || !timed) {
+            print_list(pairs, host.bytes, prog.bytes, timed);
+        }
+        analyze(pairs, host.bytes, prog.bytes, timed, show_hist);
+        if (timeline && timed) {
+            write_timeline(timeline, pairs, host.bytes, prog.bytes);
+        }
+        if (csv) {
+            write_csv(csv, pairs, host.bytes, prog.bytes, timed);
+        }
+    } catch (const std::exception& e) {
+        fprintf(stderr, "stkcap: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+gen_lz_corpus.py - Compressed Upload Corpus for test_lz.c
+
+Builds a flash image with the regions uploads meet (a repeated vector
+table, code, an erased gap, a long run that expands to many pages per
+frame, a short repeating pattern and an odd-length tail), compresses it
+with lzss_encode() from pico/compress.py and writes both as a C header.
+Run by CMake at build time.
+
+Usage:
+    python3 tools/tests/gen_lz_corpus.py -o lz_corpus.h
+
+Author: MUdroThe1
+Date: 2026
+"""
+
+import argparse
+import random
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[2] / "pico"))
+
+import compress as c  # noqa: E402
+
+
+def corpus() -> bytes:
+    rng = random.Random(1)
+    return (bytes((0x0C, 0x94, 0x5C, 0x00)) * 26         # Vector table
+            + bytes(rng.randrange(256) for _ in range(900))
+            + b"\xff" * 1024                            # Erased gap: whole pages skipped
+            + b"\x00" * 12000                           # ~94 pages from one frame
+            + bytes((1, 2, 3, 4, 5, 6, 7)) * 72
+            + bytes(rng.randrange(256) for _ in range(37)))     # Odd tail, partial page
+
+
+def mid_item(stream: bytes) -> int:
+    """Length of a prefix that ends between a match's offset and length bytes"""
+    i = 0
+    while i < len(stream):
+        flags = stream[i]
+        i += 1
+        for _ in range(8):
+            if i >= len(stream):
+                break
+            if flags & 1:
+                i += 1
+            else:
+                return i + 1
+            flags >>= 1
+    raise ValueError("stream has no match")
+
+
+def array(name: str, data: bytes) -> list:
+    out = [f"static const uint8_t {name}[{len(data)}] = {{"]
+    for i in range(0, len(data), 16):
+        out.append("    " + " ".join(f"0x{b:02X}," for b in data[i:i + 16]))
+    out.append("};")
+    return out
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("-o", "--output", required=True)
+    args = ap.parse_args()
+
+    image = corpus()
+    stream = c.lzss_encode(image)
+    if c.lzss_decode(stream) != image:
+        print("gen_lz_corpus.py: encoder round trip failed", file=sys.stderr)
+        return 1
+
+    out = ["/* Generated by gen_lz_corpus.py - do not edit. */", "", "#pragma once", "",
+           "#include <stdint.h>", "",
+           f"#define LZ_TRUNCATED_LEN {mid_item(stream)}u    /* Ends inside a match item */", ""]
+    out += array("lz_image", image) + [""] + array("lz_stream", stream)
+    Path(args.output).write_text("\n".join(out) + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
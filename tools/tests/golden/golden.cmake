@@ -0,0 +1,39 @@
+#===============================================================================
+# Golden-File Check
+#===============================================================================
+# Runs one analyzer command on a recorded session and compares what it
+# writes (stdout, or OUTPUT when the command writes a file) with the
+# expected file byte for byte. With GOLDEN_UPDATE set in the
+# environment, the expected file is rewritten instead.
+#
+# Usage:
+#   cmake -DCOMMAND="prog args..." -DEXPECTED=f.txt [-DOUTPUT=out]
+#         -P golden.cmake
+#===============================================================================
+separate_arguments(command UNIX_COMMAND "${COMMAND}")
+get_filename_component(name "${EXPECTED}" NAME)
+
+if(OUTPUT)
+    set(actual "${OUTPUT}")
+    file(REMOVE "${actual}")
+    execute_process(COMMAND ${command} RESULT_VARIABLE rc OUTPUT_QUIET)
+else()
+    set(actual "${CMAKE_CURRENT_BINARY_DIR}/golden_${name}")
+    execute_process(COMMAND ${command} RESULT_VARIABLE rc OUTPUT_FILE "${actual}")
+endif()
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "${COMMAND}: exit status ${rc}")
+endif()
+
+if(DEFINED ENV{GOLDEN_UPDATE})
+    execute_process(COMMAND ${CMAKE_COMMAND} -E copy "${actual}" "${EXPECTED}")
+    message(STATUS "updated ${EXPECTED}")
+    return()
+endif()
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files "${actual}" "${EXPECTED}"
+                RESULT_VARIABLE differ)
+if(differ)
+    execute_process(COMMAND diff -u "${EXPECTED}" "${actual}")
+    message(FATAL_ERROR "${name}: output differs from the golden file")
+endif()
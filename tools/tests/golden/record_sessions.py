@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""
+Host side of the golden sessions, recorded against the host build.
+
+Writes host-only captures; replay sends them to the simulated firmware
+and --save records the session as the firmware's capture would. The
+second pass turns the host's waits into think times after each reply,
+so flash.bin replays to itself (golden_replay_roundtrip):
+
+    python3 tools/tests/golden/record_sessions.py /tmp/host.bin
+    build-tools/replay /tmp/host.bin --target-mhz 16 --quiet --save /tmp/pass.bin
+    build-tools/replay /tmp/pass.bin --target-mhz 16 --quiet --save tools/tests/golden/flash.bin
+
+The expected outputs are then regenerated with GOLDEN_UPDATE=1 (see
+tools/CMakeLists.txt).
+"""
+
+import struct
+import sys
+
+EOP = 0x20
+
+
+def session() -> list:
+    """
+    Frames of one avrdude-like run, with the cases the splitter must get
+    right, each with the host's wait before the next (longer than the
+    reply takes, so the host never runs ahead)
+    """
+    page = bytes((0x20 if i % 3 == 0 else i) for i in range(128))     # EOP inside the payload
+    return [
+        (bytes((0x30, EOP)), 1000),                                 # GET_SYNC
+        (bytes((0x40, 0x89, 0x01, EOP)), 1000),                     # SET_PARAMETER: SCK (-B 1)
+        (bytes((0x50, EOP)), 40000),                                # ENTER_PROGMODE
+        (bytes((0x75, EOP)), 1000),                                 # READ_SIGN
+        (bytes((0x52, EOP)), 15000),                                # CHIP_ERASE
+        (bytes((0x55, 0x00, 0x00, EOP)), 1000),                     # LOAD_ADDRESS 0
+        (bytes((0x64, 0x00, 0x80, ord("F"))) + page + bytes((EOP,)), 10000),
+        (bytes((0x55, 0x40, 0x00, EOP)), 1000),                     # LOAD_ADDRESS 0x40 words
+        (bytes((0x64, 0x00, 0x80, ord("F"))) + page[::-1] + bytes((EOP,)), 10000),
+        (bytes((0x55, 0x00, 0x00, EOP)), 1000),
+        (bytes((0x74, 0x01, 0x00, ord("F"), EOP)), 10000),          # READ_PAGE both pages
+        (bytes((0x74, 0x00, 0x10, ord("X"), EOP)), 1000),           # Bad memory type: FAILED
+        (bytes((0x56, 0x50, 0x00, 0x00, 0x00, EOP)), 1000),         # UNIVERSAL: low fuse
+        (bytes((EOP,)), 1000),                                      # Stray EOP: dropped
+        (bytes((0x55, 0x00, 0x00, 0x00, EOP)), 1000),               # Extra byte: NOSYNC
+        (bytes((0x51, EOP)), 0),                                    # LEAVE_PROGMODE
+    ]
+
+
+def main() -> int:
+    if len(sys.argv) != 2:
+        print(__doc__, file=sys.stderr)
+        return 2
+    out = bytearray()
+    t_us = 0
+    for frame, wait_us in session():
+        out += struct.pack("<IBH", t_us, 0, len(frame)) + frame
+        t_us += wait_us
+    with open(sys.argv[1], "wb") as f:
+        f.write(out)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
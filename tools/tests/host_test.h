@@ -0,0 +1,49 @@
+/**
+ * @file host_test.h
+ * @brief Check Macros for the Host Tests
+ *
+ * Each test is one executable run by ctest. Checks report the failing
+ * expression and keep going; host_test_result() turns the count into
+ * the exit code.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+static int host_test_failures;
+
+/** Fail the test, but keep running, if cond is false */
+#define CHECK(cond) do {                                                    \
+    if (!(cond)) {                                                          \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        host_test_failures++;                                               \
+    }                                                                       \
+} while (0)
+
+/** Fail the test, printing both values, if a != b (integers) */
+#define CHECK_EQ(a, b) do {                                                 \
+    long long check_a_ = (long long)(a);                                    \
+    long long check_b_ = (long long)(b);                                    \
+    if (check_a_ != check_b_) {                                             \
+        fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",   \
+                __FILE__, __LINE__, #a, #b, check_a_, check_b_);            \
+        host_test_failures++;                                               \
+    }                                                                       \
+} while (0)
+
+/**
+ * @brief Print the summary and get the process exit code
+ */
+static inline int host_test_result(const char* name) {
+    if (host_test_failures) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, host_test_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
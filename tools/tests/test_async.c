@@ -0,0 +1,182 @@
+/**
+ * @file test_async.c
+ * @brief Non-blocking ISP Engine on the Simulated Clock
+ *
+ * Each avr_async_poll() is one step of the main loop; the tests advance
+ * the clock between steps like tud_task() would and check when the
+ * engine moves on and when the callback runs.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_async.h"
+#include "avr_iface.h"
+#include "avrprog.h"
+#include <string.h>
+
+#define LOOP_NS     100000u     /* Main loop step between polls */
+
+AVR_BATCH_DEFINE(b, AVR_BATCH_PAGE_INSTR);
+AVR_BATCH_DEFINE(next_b, 4);
+
+static struct {
+    uint32_t calls;
+    bool ok;
+    uint64_t t_ns;
+    bool busy_in_cb;
+} done;
+
+static void on_done(bool ok, void* ctx) {
+    (void)ctx;
+    done.calls++;
+    done.ok = ok;
+    done.t_ns = host_sim_now_ns();
+    done.busy_in_cb = avr_async_busy();
+}
+
+static bool start(void) {
+    host_sim_reset();
+    host_target()->cpu_hz = 16000000u;
+    avr_spi_init();
+    avr_iface_select(AVR_IFACE_ISP);
+    avr_set_sck_frequency(1000000u);
+    memset(&done, 0, sizeof(done));
+    return avr_iface()->enter();
+}
+
+/** Poll like the main loop until idle; the longest single poll in *max_ns */
+static uint32_t run_loop(uint64_t* max_ns) {
+    uint32_t polls = 0;
+
+    *max_ns = 0;
+    for (;;) {
+        uint64_t t = host_sim_now_ns();
+        bool busy = avr_async_poll();
+        uint64_t d = host_sim_now_ns() - t;
+
+        *max_ns = d > *max_ns ? d : *max_ns;
+        polls++;
+        if (!busy || polls > 100000u) {
+            return polls;
+        }
+        host_sim_advance_ns(LOOP_NS);
+    }
+}
+
+/** A fixed delay holds the next segment back until its deadline */
+static void test_delay_orders(void) {
+    uint8_t sig[3] = {0};
+    uint64_t t0;
+    uint64_t max_ns;
+
+    CHECK(start());
+    avr_batch_chip_erase(&b);
+    avr_batch_wait(&b, AVR_BATCH_DELAY, 9000);
+    avr_batch_read_signature(&b, sig);
+
+    t0 = host_sim_now_ns();
+    CHECK(avr_async_submit(&b, on_done, NULL));
+    CHECK(avr_async_busy());
+    CHECK(!avr_async_submit(&next_b, on_done, NULL));
+
+    CHECK(avr_async_poll());
+    CHECK_EQ(host_target()->chip_erases, 1);
+    CHECK_EQ(sig[0], 0x00);     /* Not before the delay */
+
+    run_loop(&max_ns);
+    CHECK_EQ(done.calls, 1);
+    CHECK(done.ok);
+    CHECK(!done.busy_in_cb);
+    CHECK(done.t_ns - t0 >= 9000000u);
+    CHECK(done.t_ns - t0 < 9000000u + 2u * LOOP_NS + 1000000u);
+    CHECK(max_ns < LOOP_NS);
+    CHECK_EQ(sig[0], 0x1E);
+    CHECK_EQ(sig[2], 0x0F);
+    CHECK_EQ(b.count, 0);
+    CHECK_EQ(host_target()->busy_violations, 0);
+}
+
+/** RDY/BSY is one query per poll; the job ends once the page is written */
+static void test_poll_ready(void) {
+    uint8_t page[128];
+    uint64_t t_write;
+    uint64_t max_ns;
+
+    CHECK(start());
+    memset(page, 0x5A, sizeof(page));
+    avr_batch_load_page(&b, page, sizeof(page));
+    avr_batch_write_page(&b, 0x00);
+    avr_batch_wait(&b, AVR_BATCH_POLL, 50000);
+    CHECK(avr_async_submit(&b, on_done, NULL));
+
+    /* 129 instructions: three transfers of up to 64 */
+    CHECK(avr_async_poll());
+    CHECK(avr_async_poll());
+    CHECK_EQ(host_target()->page_writes, 0);
+    CHECK(avr_async_poll());
+    CHECK_EQ(host_target()->page_writes, 1);
+    t_write = host_sim_now_ns();
+
+    run_loop(&max_ns);
+    CHECK_EQ(done.calls, 1);
+    CHECK(done.ok);
+    CHECK(done.t_ns - t_write >= host_target()->flash_write_us * 1000ull);
+    CHECK(done.t_ns - t_write < host_target()->flash_write_us * 1000ull + 2u * LOOP_NS);
+    CHECK(max_ns < LOOP_NS);
+    CHECK_EQ(host_target()->flash[0], 0x5A);
+    CHECK_EQ(host_target()->busy_violations, 0);
+}
+
+/** A target that stays busy fails the job at the poll timeout */
+static void test_poll_timeout(void) {
+    uint64_t t0;
+    uint64_t max_ns;
+
+    CHECK(start());
+    host_target()->erase_us = 200000u;
+    avr_batch_chip_erase(&b);
+    avr_batch_wait(&b, AVR_BATCH_POLL, 5000);
+    t0 = host_sim_now_ns();
+    CHECK(avr_async_submit(&b, on_done, NULL));
+    run_loop(&max_ns);
+    CHECK_EQ(done.calls, 1);
+    CHECK(!done.ok);
+    CHECK(done.t_ns - t0 >= 5000000u);
+    CHECK(done.t_ns - t0 < 5000000u + 2u * LOOP_NS);
+}
+
+static void submit_next(bool ok, void* ctx) {
+    on_done(ok, ctx);
+    avr_batch_read_fuses(&next_b, (uint8_t*)ctx);
+    CHECK(avr_async_submit(&next_b, on_done, NULL));
+}
+
+/** The callback may queue the next job; empty jobs complete at once */
+static void test_chain(void) {
+    uint8_t fuses[4] = {0};
+
+    CHECK(start());
+    avr_batch_chip_erase(&b);
+    avr_batch_wait(&b, AVR_BATCH_DELAY, 9000);
+    CHECK(avr_async_submit(&b, submit_next, fuses));
+    avr_async_finish();
+    CHECK_EQ(done.calls, 2);
+    CHECK(!avr_async_busy());
+    CHECK_EQ(fuses[0], 0x62);
+    CHECK_EQ(fuses[1], 0xD9);
+
+    CHECK(avr_async_submit(&b, on_done, NULL));
+    CHECK_EQ(done.calls, 3);
+    CHECK(!avr_async_busy());
+}
+
+int main(void) {
+    test_delay_orders();
+    test_poll_ready();
+    test_poll_timeout();
+    test_chain();
+    return host_test_result("async");
+}
@@ -0,0 +1,180 @@
+/**
+ * @file test_batch.c
+ * @brief ISP Batch Encoders and Segments, Run Against the Simulated Target
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_batch.h"
+#include "avr_iface.h"
+#include "avrprog.h"
+#include <string.h>
+
+AVR_BATCH_DEFINE(b, AVR_BATCH_PAGE_INSTR);
+
+/** Instruction i is op0..op3, with no wait */
+static void check_op(size_t i, uint8_t op0, uint8_t op1, uint8_t op2, uint8_t op3) {
+    CHECK(i < b.count);
+    CHECK_EQ(b.instr[i].op[0], op0);
+    CHECK_EQ(b.instr[i].op[1], op1);
+    CHECK_EQ(b.instr[i].op[2], op2);
+    CHECK_EQ(b.instr[i].op[3], op3);
+    CHECK_EQ(b.instr[i].wait, AVR_BATCH_NONE);
+}
+
+/** Low byte (0x40), then high byte (0x48) of each word from word 0 */
+static void test_load_page(void) {
+    static const uint8_t data[5] = {0xD0, 0xD1, 0xD2, 0xD3, 0xD4};
+
+    avr_batch_clear(&b);
+    CHECK(avr_batch_load_page(&b, data, sizeof(data)));
+    CHECK_EQ(b.count, 4);   /* The odd byte is no whole word */
+    check_op(0, 0x40, 0x00, 0x00, 0xD0);
+    check_op(1, 0x48, 0x00, 0x00, 0xD1);
+    check_op(2, 0x40, 0x00, 0x01, 0xD2);
+    check_op(3, 0x48, 0x00, 0x01, 0xD3);
+    CHECK(b.instr[0].result == NULL);
+
+    CHECK(avr_batch_write_page(&b, 0x1234));
+    check_op(4, 0x4C, 0x12, 0x34, 0x00);
+}
+
+/** Byte addresses become word address plus low/high instruction */
+static void test_read_flash(void) {
+    uint8_t out[3];
+
+    avr_batch_clear(&b);
+    CHECK(avr_batch_read_flash(&b, 0x1FF, out, sizeof(out)));
+    CHECK_EQ(b.count, 3);
+    check_op(0, 0x28, 0x00, 0xFF, 0x00);
+    check_op(1, 0x20, 0x01, 0x00, 0x00);
+    check_op(2, 0x28, 0x01, 0x00, 0x00);
+    for (size_t i = 0; i < sizeof(out); i++) {
+        CHECK(b.instr[i].result == &out[i]);
+    }
+}
+
+static void test_fuses_and_erase(void) {
+    uint8_t fuses[4];
+    uint8_t sig[3];
+
+    avr_batch_clear(&b);
+    CHECK(avr_batch_read_fuses(&b, fuses));
+    check_op(0, 0x50, 0x00, 0x00, 0x00);
+    check_op(1, 0x58, 0x08, 0x00, 0x00);
+    check_op(2, 0x50, 0x08, 0x00, 0x00);
+    check_op(3, 0x58, 0x00, 0x00, 0x00);
+    CHECK(b.instr[3].result == &fuses[3]);
+
+    CHECK(avr_batch_read_signature(&b, sig));
+    check_op(4, 0x30, 0x00, 0x00, 0x00);
+    check_op(6, 0x30, 0x00, 0x02, 0x00);
+
+    CHECK(avr_batch_chip_erase(&b));
+    avr_batch_wait(&b, AVR_BATCH_DELAY, 9000);
+    CHECK_EQ(b.instr[7].op[0], 0xAC);
+    CHECK_EQ(b.instr[7].op[1], 0x80);
+    CHECK_EQ(b.instr[7].wait, AVR_BATCH_DELAY);
+    CHECK_EQ(b.instr[7].wait_us, 9000);
+    CHECK_EQ(b.instr[6].wait, AVR_BATCH_NONE);
+}
+
+/** A full batch refuses more, and a wait on an empty one is ignored */
+static void test_capacity(void) {
+    AVR_BATCH_DEFINE(small, 3);
+    static const uint8_t data[4] = {0};
+
+    avr_batch_wait(&small, AVR_BATCH_POLL, 1000);
+    CHECK_EQ(small.count, 0);
+    CHECK(!avr_batch_load_page(&small, data, sizeof(data)));
+    CHECK_EQ(small.count, 3);
+    CHECK(!avr_batch_chip_erase(&small));
+    CHECK_EQ(small.count, 3);
+}
+
+static bool start(void) {
+    host_sim_reset();
+    host_target()->cpu_hz = 16000000u;
+    avr_spi_init();
+    avr_iface_select(AVR_IFACE_ISP);
+    avr_set_sck_frequency(1000000u);
+    return avr_iface()->enter();
+}
+
+/** Transfers end after a wait and at the stream buffer size */
+static void test_segments(void) {
+    uint8_t sig[3];
+    uint8_t out[70];
+
+    CHECK(start());
+    avr_batch_clear(&b);
+    avr_batch_chip_erase(&b);
+    avr_batch_wait(&b, AVR_BATCH_DELAY, 9000);
+    avr_batch_read_signature(&b, sig);
+    CHECK_EQ(avr_batch_run_segment(&b, 0), 1);
+    host_sim_advance_ns(9000000u);
+    CHECK_EQ(avr_batch_run_segment(&b, 1), 4);
+    CHECK_EQ(sig[0], 0x1E);
+    CHECK_EQ(sig[2], 0x0F);
+
+    avr_batch_clear(&b);
+    avr_batch_read_flash(&b, 0, out, sizeof(out));
+    CHECK_EQ(avr_batch_run_segment(&b, 0), 64);
+    CHECK_EQ(avr_batch_run_segment(&b, 64), 70);
+    avr_iface()->leave();
+    CHECK_EQ(host_target()->busy_violations, 0);
+}
+
+/** Erase, page write with RDY/BSY poll, readback and fuses in batches */
+static void test_run(void) {
+    uint8_t page[128];
+    uint8_t back[128];
+    uint8_t fuses[4];
+    uint32_t instructions;
+
+    CHECK(start());
+    memset(host_target()->flash, 0x00, 256);
+    avr_batch_clear(&b);
+    avr_batch_chip_erase(&b);
+    avr_batch_wait(&b, AVR_BATCH_DELAY, 9000);
+    CHECK(avr_batch_run(&b));
+    CHECK_EQ(b.count, 0);
+    CHECK_EQ(host_target()->chip_erases, 1);
+
+    for (size_t i = 0; i < sizeof(page); i++) {
+        page[i] = (uint8_t)(i * 3u + 1u);
+    }
+    instructions = host_target()->instructions;
+    avr_batch_load_page(&b, page, sizeof(page));
+    avr_batch_write_page(&b, 0x40);
+    avr_batch_wait(&b, AVR_BATCH_POLL, 50000);
+    CHECK(avr_batch_run(&b));
+    CHECK(host_target()->instructions - instructions >= sizeof(page) + 1u);
+    CHECK_EQ(host_target()->page_writes, 1);
+    CHECK(memcmp(host_target()->flash + 0x80, page, sizeof(page)) == 0);
+
+    avr_batch_read_flash(&b, 0x80, back, sizeof(back));
+    avr_batch_read_fuses(&b, fuses);
+    CHECK(avr_batch_run(&b));
+    CHECK(memcmp(back, page, sizeof(page)) == 0);
+    CHECK_EQ(fuses[0], 0x62);
+    CHECK_EQ(fuses[1], 0xD9);
+    CHECK_EQ(fuses[2], 0xFF);
+    CHECK_EQ(fuses[3], 0xFF);
+    avr_iface()->leave();
+    CHECK_EQ(host_target()->busy_violations, 0);
+    CHECK_EQ(host_target()->misreads, 0);
+}
+
+int main(void) {
+    test_load_page();
+    test_read_flash();
+    test_fuses_and_erase();
+    test_capacity();
+    test_segments();
+    test_run();
+    return host_test_result("batch");
+}
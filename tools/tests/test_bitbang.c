@@ -0,0 +1,94 @@
+/**
+ * @file test_bitbang.c
+ * @brief Bit-bang SCK Timing Model Against the Simulated Pins
+ *
+ * The host build charges HOST_SIO_CYCLES per sio_hw access, two of them
+ * per half period, which is the overhead BB_EDGE_OVERHEAD_CYCLES takes
+ * off the busy-wait. Each phase the target sees is then the requested
+ * half period rounded up to whole system cycles.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avrprog.h"
+#include "avrprog_bitbang.h"
+#include "avr_spi_transport.h"
+#include <string.h>
+
+#define SYS_HZ  125000000u
+
+/** Phase the model predicts for a half period request */
+static uint32_t expected_phase_ns(uint32_t half_ns) {
+    uint32_t cycles = avr_bitbang_half_period_cycles(SYS_HZ, half_ns) + BB_EDGE_OVERHEAD_CYCLES;
+    return cycles * (1000000000u / SYS_HZ);
+}
+
+static void test_cycle_model(void) {
+    /* Rounded up, then the edge overhead is taken off */
+    CHECK_EQ(avr_bitbang_half_period_cycles(SYS_HZ, 10000), 1244);
+    CHECK_EQ(avr_bitbang_half_period_cycles(SYS_HZ, 250), 26);
+    CHECK_EQ(avr_bitbang_half_period_cycles(SYS_HZ, 251), 26);
+    CHECK_EQ(avr_bitbang_half_period_cycles(SYS_HZ, 257), 27);
+    /* Shorter than the overhead: no wait at all */
+    CHECK_EQ(avr_bitbang_half_period_cycles(SYS_HZ, 40), 0);
+    CHECK_EQ(avr_bitbang_half_period_cycles(SYS_HZ, 1), 0);
+}
+
+/** Read the signature at hz; return the shortest phase the target saw */
+static uint32_t phase_at(uint32_t hz) {
+    static const uint8_t atmega328p[3] = {0x1E, 0x95, 0x0F};
+    uint8_t sig[3];
+
+    host_sim_reset();
+    host_target()->cpu_hz = 32000000u;  /* Fast enough for every rate below */
+    avr_spi_select(AVR_SPI_BITBANG);
+    avr_set_sck_frequency(hz);
+    CHECK(avr_enter_programming_mode());
+    avr_read_signature(sig);
+    avr_leave_programming_mode();
+    CHECK(memcmp(sig, atmega328p, 3) == 0);
+    CHECK_EQ(host_target()->misreads, 0);
+    return host_target()->min_phase_ns;
+}
+
+/** SCK is never faster than requested, and no slower than the cycle grid */
+static void test_rates(void) {
+    static const uint32_t rates[] = {
+        5000, 50000, 100000, 250000, 333333, 500000, 1000000, 1500000, 2000000, 2600000,
+    };
+
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        uint32_t hz = rates[i];
+        uint32_t half_ns = (500000000u + hz - 1u) / hz;
+        uint32_t phase = phase_at(hz);
+
+        CHECK_EQ(phase, expected_phase_ns(half_ns));
+        CHECK(phase >= half_ns);
+        CHECK(phase < half_ns + 8u);
+        CHECK(host_target_sck_hz() <= hz);
+    }
+}
+
+/** The microsecond interface still gives whole-microsecond phases */
+static void test_set_speed(void) {
+    host_sim_reset();
+    avr_spi_select(AVR_SPI_BITBANG);
+    avr_bitbang_set_speed(10);
+    CHECK_EQ(avr_bitbang_get_speed(), 10);
+    avr_enter_programming_mode();
+    CHECK_EQ(host_target()->min_phase_ns, 10000);
+    CHECK_EQ(host_target_sck_hz(), 50000);
+
+    avr_bitbang_set_speed(0);
+    CHECK_EQ(avr_bitbang_get_speed(), 1);
+}
+
+int main(void) {
+    test_cycle_model();
+    test_rates();
+    test_set_speed();
+    return host_test_result("bitbang");
+}
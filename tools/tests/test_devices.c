@@ -0,0 +1,102 @@
+/**
+ * @file test_devices.c
+ * @brief Generated Device Table and Its Perfect-Hash Lookup
+ *
+ * Runs over whatever table the build generated (AVR_DEVICE_SOURCES), so
+ * a larger avrdude.conf is checked the same way as the committed subset.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "avr_devices.h"
+#include <stdbool.h>
+#include <string.h>
+
+/* The same generated table avr_devices.c includes, for iteration */
+#include "avr_devices_table.h"
+
+#define FLAG_IFACES  (AVR_DEV_ISP | AVR_DEV_TPI | AVR_DEV_PDI | AVR_DEV_UPDI)
+
+static bool power_of_two(uint32_t v) {
+    return v && !(v & (v - 1u));
+}
+
+/** Entry i resolves to itself and its geometry is consistent */
+static void check_entry(size_t i) {
+    const avr_device_t* e = &avr_device_table[i];
+    const avr_device_t* d = avr_lookup_device_by_signature(e->signature);
+
+    CHECK(d != NULL);
+    if (!d) {
+        fprintf(stderr, "  %s not found\n", e->name);
+        return;
+    }
+    CHECK(memcmp(d->signature, e->signature, 3) == 0);
+    CHECK(strcmp(d->name, e->name) == 0);
+    CHECK_EQ(d->flash_size_bytes, e->flash_size_bytes);
+    CHECK_EQ(d->page_size_bytes, e->page_size_bytes);
+    CHECK_EQ(d->eeprom_size_bytes, e->eeprom_size_bytes);
+    CHECK_EQ(d->eeprom_page_bytes, e->eeprom_page_bytes);
+    CHECK_EQ(d->flags, e->flags);
+
+    CHECK_EQ(e->signature[0], 0x1E);
+    CHECK(power_of_two(e->page_size_bytes));
+    CHECK(e->flash_size_bytes % e->page_size_bytes == 0);
+    CHECK(e->eeprom_size_bytes == 0 || power_of_two(e->eeprom_page_bytes));
+    CHECK(e->eeprom_page_bytes <= e->eeprom_size_bytes);
+    CHECK(e->flags & FLAG_IFACES);
+    CHECK(!!(e->flags & AVR_DEV_EXT_ADDR) == (e->flash_size_bytes > 128u * 1024u));
+    /* Serial programming entries carry write times for the fixed-delay paths */
+    CHECK(!(e->flags & AVR_DEV_ISP) || (e->flash_write_us && e->erase_us));
+    CHECK(!(e->flags & AVR_DEV_PAGED_EEPROM) || (e->flags & AVR_DEV_ISP));
+}
+
+static void test_entries(void) {
+    CHECK(AVR_DEVICE_COUNT > 2u);
+    for (size_t i = 0; i < AVR_DEVICE_COUNT; i++) {
+        check_entry(i);
+        /* Sorted by signature, so no duplicates */
+        CHECK(i == 0 || memcmp(avr_device_table[i - 1].signature,
+                               avr_device_table[i].signature, 3) < 0);
+    }
+}
+
+/** Known parts against their datasheets */
+static void test_known(void) {
+    const avr_device_t* d;
+
+    d = avr_lookup_device_by_signature((const uint8_t[3]){0x1E, 0x95, 0x0F});
+    CHECK(d && strcmp(d->name, "ATmega328P") == 0);
+    CHECK(d && d->page_size_bytes == 128 && d->flash_size_bytes == 32768);
+    CHECK(d && d->eeprom_size_bytes == 1024 && d->eeprom_page_bytes == 4);
+
+    d = avr_lookup_device_by_signature((const uint8_t[3]){0x1E, 0x93, 0x0B});
+    CHECK(d && strcmp(d->name, "ATtiny85") == 0);
+    CHECK(d && d->page_size_bytes == 64 && d->flash_size_bytes == 8192);
+}
+
+/** Every signature not in the table misses, including other vendors */
+static void test_misses(void) {
+    uint32_t hits = 0;
+
+    for (uint32_t key = 0; key <= 0xFFFFu; key++) {
+        uint8_t sig[3] = {0x1E, (uint8_t)(key >> 8), (uint8_t)key};
+        const avr_device_t* d = avr_lookup_device_by_signature(sig);
+        if (d) {
+            CHECK(memcmp(d->signature, sig, 3) == 0);
+            hits++;
+        }
+        sig[0] = 0x00;
+        CHECK(avr_lookup_device_by_signature(sig) == NULL);
+    }
+    CHECK_EQ(hits, AVR_DEVICE_COUNT);
+}
+
+int main(void) {
+    test_entries();
+    test_known();
+    test_misses();
+    return host_test_result("devices");
+}
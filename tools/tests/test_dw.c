@@ -0,0 +1,145 @@
+/**
+ * @file test_dw.c
+ * @brief debugWIRE Fallback and Interface Against the Simulated dW Target
+ *
+ * The target has DWEN programmed, so RESET is its debugWIRE line and it
+ * ignores ISP until a dW DISABLE.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avrprog.h"
+#include "avr_iface.h"
+#include "avr_spi_transport.h"
+#include "debugwire.h"
+#include <string.h>
+
+#define SCK_HZ      50000u
+
+static const uint8_t atmega328p[3] = {0x1E, 0x95, 0x0F};
+
+/** Power up a part with DWEN programmed, running at cpu_hz */
+static void power_up_dw(uint32_t cpu_hz) {
+    host_sim_reset();
+    host_target()->hfuse &= (uint8_t)~0x40;
+    host_target()->cpu_hz = cpu_hz;
+    avr_dw_fallback_enable(false);
+    avr_iface_select(AVR_IFACE_ISP);
+    avr_spi_select(AVR_SPI_HW);
+    avr_set_sck_frequency(SCK_HZ);
+}
+
+/** Off by default: a failed entry ends with the ISP attempts */
+static void test_fallback_off(void) {
+    power_up_dw(1000000u);
+    CHECK(!avr_dw_fallback_enabled());
+    CHECK(!avr_enter_programming_mode());
+
+    CHECK_EQ(host_target()->enables, 0);
+    CHECK_EQ(host_target()->dw_commands, 0);
+    CHECK(!host_target()->dw_disabled);
+    CHECK(host_sim_now_ns() / 1000u <= avr_entry_log()->total_us + 100u);
+}
+
+/** On: dW is disabled for this power cycle and ISP gets in */
+static void test_fallback_on(void) {
+    uint8_t sig[3];
+    uint8_t rx[4];
+
+    power_up_dw(1000000u);
+    avr_dw_fallback_enable(true);
+    CHECK(avr_enter_programming_mode());
+
+    CHECK(host_target()->dw_disabled);
+    CHECK_EQ(host_target()->dw_commands, 1);
+    CHECK_EQ(host_target()->dw_garbled, 0);
+    CHECK_EQ(host_target()->enables, 1);
+    avr_read_signature(sig);
+    CHECK(memcmp(sig, atmega328p, 3) == 0);
+
+    /* Unprogramming DWEN in the same session makes it stick */
+    avr_universal((const uint8_t[4]){0xAC, 0xA8, 0x00, 0xD9}, rx);
+    CHECK(avr_poll_ready(100000));
+    CHECK_EQ(host_target()->hfuse, 0xD9);
+    avr_leave_programming_mode();
+}
+
+/** On, but not a dW part: the break goes unanswered and costs its wait */
+static void test_fallback_plain_part(void) {
+    host_sim_reset();
+    host_target()->cpu_hz = 100000u;    /* 50 kHz SCK is far too fast */
+    avr_spi_select(AVR_SPI_HW);
+    avr_set_sck_frequency(SCK_HZ);
+    avr_dw_fallback_enable(true);
+
+    CHECK(!avr_enter_programming_mode());
+    CHECK_EQ(dw_baud(), 0);
+    CHECK(host_sim_now_ns() / 1000u >= avr_entry_log()->total_us + 20000u + 50000u);
+    avr_dw_fallback_enable(false);
+}
+
+/** The dW interface itself: ID, flash read, page write through SPM */
+static void test_iface(void) {
+    const avr_iface_t* iface;
+    uint8_t page[128];
+    uint8_t back[200];
+    uint8_t rx[4];
+    uint8_t regs[4] = {0x12, 0x34, 0x56, 0x78};
+    uint8_t regs_back[4];
+
+    power_up_dw(16000000u);
+    for (size_t i = 0; i < sizeof(back); i++) {
+        host_target()->flash[0x1000 + i] = (uint8_t)(i ^ 0x5A);
+    }
+    CHECK(avr_iface_select(AVR_IFACE_DW));
+    iface = avr_iface();
+    CHECK(iface->enter());
+    CHECK_EQ(dw_baud(), 125000);
+
+    iface->universal((const uint8_t[4]){0x30, 0x00, 0x01, 0x00}, rx);
+    CHECK_EQ(rx[3], 0x95);
+
+    iface->read_flash(0x1000, back, sizeof(back));
+    for (size_t i = 0; i < sizeof(back); i++) {
+        CHECK_EQ(back[i], (uint8_t)(i ^ 0x5A));
+    }
+
+    dw_write_registers(2, regs, sizeof(regs));
+    dw_read_registers(2, regs_back, sizeof(regs_back));
+    CHECK(memcmp(regs, regs_back, sizeof(regs)) == 0);
+
+    for (size_t i = 0; i < sizeof(page); i++) {
+        page[i] = (uint8_t)(i * 3u + 1u);
+    }
+    memset(host_target()->flash + 0x200, 0x00, sizeof(page));
+    iface->write_flash_page(0x200, page, sizeof(page));
+    CHECK(iface->poll_ready(100000));
+    CHECK(memcmp(host_target()->flash + 0x200, page, sizeof(page)) == 0);
+    CHECK_EQ(host_target()->page_writes, 1);
+
+    iface->leave();
+    CHECK(!host_target()->dw_disabled);
+    CHECK_EQ(host_target()->dw_garbled, 0);
+    avr_iface_select(AVR_IFACE_ISP);
+}
+
+/** The target clock drifts 6% after the rate was measured: bytes garble */
+static void test_rate_mismatch(void) {
+    power_up_dw(16000000u);
+    CHECK(dw_connect());
+    host_target()->cpu_hz = 16960000u;
+    CHECK(dw_read_device_id() != 0x950F);
+    dw_release();
+}
+
+int main(void) {
+    test_fallback_off();
+    test_fallback_on();
+    test_fallback_plain_part();
+    test_iface();
+    test_rate_mismatch();
+    return host_test_result("dw");
+}
@@ -0,0 +1,113 @@
+/**
+ * @file test_entry.c
+ * @brief Programming Enable Timing and Resyncs Against the Simulated Target
+ *
+ * The target refuses Programming Enable for 20 ms after RESET goes low
+ * on a running (or just powered) part, counts SCK bits from RESET going
+ * low, and can be made to miscount bits on entry (glitch_bits).
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avrprog.h"
+#include "avr_spi_transport.h"
+
+#define SCK_HZ      50000u
+#define MIN_US      (AVR_ENTRY_SETTLE_SCK * (1000000u / SCK_HZ))
+
+static const avr_entry_log_t* enter(uint8_t backend, uint8_t glitch_bits) {
+    host_sim_reset();
+    avr_spi_select(backend);
+    avr_set_sck_frequency(SCK_HZ);
+    host_target()->glitch_bits = glitch_bits;
+    avr_enter_programming_mode();
+    return avr_entry_log();
+}
+
+/** First attempt waits the full 20 ms and gets in */
+static void test_power_up(uint8_t backend) {
+    const avr_entry_log_t* log = enter(backend, 0);
+
+    CHECK(log->ok);
+    CHECK_EQ(log->attempts, 1);
+    CHECK_EQ(log->attempt[0].resync, AVR_ENTRY_RESYNC_NONE);
+    CHECK(log->attempt[0].settle_us >= 20000);
+    CHECK_EQ(log->attempt[0].echo, 0x53);
+    CHECK(log->total_us >= 20000 && log->total_us < 22000);
+    CHECK_EQ(host_target()->enables, 1);
+    CHECK_EQ(host_target()->early_enables, 0);
+}
+
+/** The target ran in between: the 20 ms apply again */
+static void test_reenter(uint8_t backend) {
+    enter(backend, 0);
+    avr_leave_programming_mode();
+    sleep_ms(100);
+    CHECK(avr_enter_programming_mode());
+    CHECK_EQ(avr_entry_log()->attempts, 1);
+    CHECK_EQ(host_target()->enables, 2);
+    CHECK_EQ(host_target()->early_enables, 0);
+}
+
+/** One bit off: the SCK pulse of the first retry realigns */
+static void test_sck_resync(uint8_t backend) {
+    const avr_entry_log_t* log = enter(backend, 31);
+
+    CHECK(log->ok);
+    CHECK_EQ(log->attempts, 2);
+    CHECK(log->attempt[0].echo != 0x53);
+    CHECK_EQ(log->attempt[1].resync, AVR_ENTRY_RESYNC_SCK);
+    CHECK_EQ(log->attempt[1].settle_us, MIN_US);
+    CHECK(log->total_us < 20000 + 2000);
+    CHECK_EQ(host_target()->early_enables, 0);
+}
+
+/** Further off: the short RESET pulse recounts without a new 20 ms wait */
+static void test_reset_resync(uint8_t backend) {
+    const avr_entry_log_t* log = enter(backend, 5);
+
+    CHECK(log->ok);
+    CHECK_EQ(log->attempts, 3);
+    CHECK_EQ(log->attempt[2].resync, AVR_ENTRY_RESYNC_RESET);
+    CHECK_EQ(log->attempt[2].settle_us, MIN_US);
+    CHECK(log->total_us < 20000 + 3000);
+    CHECK_EQ(host_target()->enables, 1);
+    CHECK_EQ(host_target()->early_enables, 0);
+}
+
+/** No answer at all: every attempt made, waits backing off */
+static void test_no_answer(uint8_t backend) {
+    static const uint32_t settle[AVR_ENTRY_MAX_ATTEMPTS] = {
+        20000, MIN_US, MIN_US, 1000, 2000, 5000, 10000, 20000,
+    };
+
+    host_sim_reset();
+    host_target()->cpu_hz = 100000u;    /* 50 kHz SCK is far too fast */
+    avr_spi_select(backend);
+    avr_set_sck_frequency(SCK_HZ);
+    CHECK(!avr_enter_programming_mode());
+
+    const avr_entry_log_t* log = avr_entry_log();
+    CHECK(!log->ok);
+    CHECK_EQ(log->attempts, AVR_ENTRY_MAX_ATTEMPTS);
+    for (int i = 0; i < AVR_ENTRY_MAX_ATTEMPTS; i++) {
+        CHECK_EQ(log->attempt[i].settle_us, settle[i]);
+    }
+    CHECK_EQ(host_target()->enables, 0);
+}
+
+int main(void) {
+    static const uint8_t backends[] = {AVR_SPI_HW, AVR_SPI_BITBANG};
+
+    for (size_t b = 0; b < sizeof(backends); b++) {
+        test_power_up(backends[b]);
+        test_reenter(backends[b]);
+        test_sck_resync(backends[b]);
+        test_reset_resync(backends[b]);
+        test_no_answer(backends[b]);
+    }
+    return host_test_result("entry");
+}
@@ -0,0 +1,159 @@
+/**
+ * @file test_flash_store.c
+ * @brief Record Store Against Power Cuts in the Simulated QSPI Flash
+ *
+ * A power cut stops a flash erase or program part way (host_flash_fail())
+ * and nothing after it reaches the flash; flash_store_init() then plays
+ * the next power-up. Whatever was cut, every key must read back its last
+ * completed value, or the value being written, and the store must keep
+ * taking records.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "flash_store.h"
+#include <stdio.h>
+#include <string.h>
+
+#define KEYS            10u
+#define RECORD_SLOTS    255u    /* Per sector, after the header */
+#define IMAGE_FILE      "test_flash_store.bin"
+
+static uint8_t values[KEYS];    /* Last completed value per key */
+
+static void value_data(uint8_t v, uint8_t data[FLASH_STORE_DATA_BYTES]) {
+    for (size_t i = 0; i < FLASH_STORE_DATA_BYTES; i++) {
+        data[i] = (uint8_t)(v + i * 31u);
+    }
+}
+
+static bool put(uint32_t key, uint8_t v) {
+    uint8_t data[FLASH_STORE_DATA_BYTES];
+    value_data(v, data);
+    return flash_store_put(key, data);
+}
+
+/** Value stored for key, -1 if none or not one put() wrote */
+static int get(uint32_t key) {
+    uint8_t data[FLASH_STORE_DATA_BYTES];
+    uint8_t expect[FLASH_STORE_DATA_BYTES];
+
+    if (!flash_store_get(key, data)) {
+        return -1;
+    }
+    value_data(data[0], expect);
+    return memcmp(data, expect, sizeof(data)) == 0 ? data[0] : -1;
+}
+
+/** Blank flash, then a store whose active sector is full */
+static void fill_store(void) {
+    host_sim_reset();
+    flash_store_init();
+    for (uint32_t i = 0; i < RECORD_SLOTS; i++) {
+        uint32_t key = i % KEYS;
+        values[key] = (uint8_t)(i / KEYS + 1u);
+        CHECK(put(key, values[key]));
+    }
+}
+
+/** Records survive a power cycle through the saved image */
+static void test_persist(void) {
+    uint32_t programs;
+
+    host_sim_reset();
+    flash_store_init();
+    CHECK_EQ(get(1), -1);
+    CHECK(put(1, 0x10));
+    CHECK(put(2, 0x20));
+    CHECK(put(1, 0x11));
+
+    programs = host_flash_stats()->programs;
+    CHECK(put(1, 0x11));    /* Unchanged: nothing written */
+    CHECK_EQ(host_flash_stats()->programs, programs);
+
+    CHECK(host_flash_save(IMAGE_FILE));
+    host_sim_reset();
+    CHECK(host_flash_load(IMAGE_FILE));
+    remove(IMAGE_FILE);
+    flash_store_init();
+    CHECK_EQ(get(1), 0x11);
+    CHECK_EQ(get(2), 0x20);
+    CHECK_EQ(get(3), -1);
+}
+
+/** A record cut at any byte reads as the old value, and appending goes on */
+static void test_torn_record(void) {
+    for (uint32_t bytes = 0; bytes < 16; bytes++) {
+        host_sim_reset();
+        flash_store_init();
+        CHECK(put(5, 0x50));
+        host_flash_fail(0, bytes);
+        put(5, 0x51);
+
+        host_flash_power_up();
+        flash_store_init();
+        CHECK(get(5) == 0x50 || get(5) == 0x51);
+        CHECK(bytes > 2 || get(5) == 0x50);
+        CHECK(put(5, 0x52));
+        CHECK(put(6, 0x60));
+        flash_store_init();
+        CHECK_EQ(get(5), 0x52);
+        CHECK_EQ(get(6), 0x60);
+    }
+}
+
+/** A cut anywhere in a compaction keeps every key's value */
+static void test_compaction_cut(void) {
+    static const uint32_t cut_bytes[] = {0, 7, 100, 4096};
+    uint32_t ops;
+
+    /* Operations the compacting put performs when nothing fails */
+    fill_store();
+    ops = host_flash_stats()->erases + host_flash_stats()->programs;
+    CHECK(put(0, 0xEE));
+    ops = host_flash_stats()->erases + host_flash_stats()->programs - ops;
+    CHECK(ops >= 3);
+    CHECK_EQ(host_flash_stats()->erases, 2);   /* Format, then one compaction */
+
+    for (uint32_t op = 0; op < ops; op++) {
+        for (size_t c = 0; c < sizeof(cut_bytes) / sizeof(cut_bytes[0]); c++) {
+            fill_store();
+            host_flash_fail(op, cut_bytes[c]);
+            put(0, 0xEE);
+
+            host_flash_power_up();
+            flash_store_init();
+            CHECK(get(0) == values[0] || get(0) == 0xEE);
+            for (uint32_t key = 1; key < KEYS; key++) {
+                CHECK_EQ(get(key), values[key]);
+            }
+            CHECK(put(3, 0xA3));
+            flash_store_init();
+            CHECK_EQ(get(3), 0xA3);
+            CHECK_EQ(get(4), values[4]);
+        }
+    }
+}
+
+/** Updates append; one erase per sector's worth of records */
+static void test_wear(void) {
+    host_sim_reset();
+    flash_store_init();
+    for (uint32_t i = 0; i < 1000; i++) {
+        CHECK(put(7, (uint8_t)i));
+    }
+    CHECK_EQ(get(7), (uint8_t)999);
+    CHECK(host_flash_stats()->erases <= 1u + 1000u / (RECORD_SLOTS - 1u) + 1u);
+    CHECK(host_flash_stats()->programs <= 1000u + 2u * (1000u / (RECORD_SLOTS - 1u) + 1u));
+}
+
+int main(void) {
+    test_persist();
+    test_torn_record();
+    test_compaction_cut();
+    test_wear();
+    return host_test_result("flash_store");
+}
@@ -0,0 +1,179 @@
+/**
+ * @file test_lz.c
+ * @brief Compressed Upload (PROG_PAGE_LZ) Through the Protocol Handler
+ *
+ * The stream comes from lzss_encode() in pico/compress.py (see
+ * gen_lz_corpus.py), so the device decoder is checked against the host
+ * encoder, and the simulated flash against the image.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_profile.h"
+#include "avrprog.h"
+#include "stk500v1.h"
+#include "tusb.h"
+#include "lz_corpus.h"
+#include <string.h>
+
+#define PAGE_BYTES  128u        /* ATmega328P */
+
+static uint8_t reply[64];
+static size_t reply_len;
+
+static void on_reply(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    for (size_t i = 0; i < len && reply_len < sizeof(reply); i++) {
+        reply[reply_len++] = data[i];
+    }
+}
+
+/** Run the main loop until the device is idle */
+static void run_loop(void) {
+    for (int i = 0; i < 10000000 && stk500v1_task(); i++) {
+        tud_task();
+    }
+    tud_cdc_write_flush();
+}
+
+static void send(const uint8_t* frame, size_t len) {
+    reply_len = 0;
+    stk500v1_feed(frame, (int)len);
+    run_loop();
+}
+
+static bool ok(uint8_t cmd) {
+    const uint8_t frame[2] = {cmd, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return reply_len == 2 && reply[0] == Resp_STK_INSYNC && reply[1] == Resp_STK_OK;
+}
+
+/** PROG_PAGE_LZ frame for len stream bytes, followed by extra bytes */
+static size_t lz_frame(uint8_t* frame, const uint8_t* data, size_t len,
+                       const uint8_t* extra, size_t extra_len) {
+    frame[0] = Cmnd_STK_PROG_PAGE_LZ;
+    frame[1] = (uint8_t)(len >> 8);
+    frame[2] = (uint8_t)len;
+    frame[3] = 'F';
+    if (len) {
+        memcpy(frame + 4, data, len);
+    }
+    frame[4 + len] = Sync_CRC_EOP;
+    if (extra_len) {
+        memcpy(frame + 5 + len, extra, extra_len);
+    }
+    return 5 + len + extra_len;
+}
+
+/** Stream end: INSYNC, then OK or FAILED */
+static int finish(void) {
+    uint8_t frame[5];
+    send(frame, lz_frame(frame, NULL, 0, NULL, 0));
+    return reply_len == 2 && reply[0] == Resp_STK_INSYNC ? reply[1] : -1;
+}
+
+static const uint8_t load0[] = {Cmnd_STK_LOAD_ADDRESS, 0, 0, Sync_CRC_EOP};
+
+static void start(void) {
+    host_sim_reset();
+    host_target()->cpu_hz = 16000000u;
+    memset(host_target()->flash, 0x5A, host_target()->flash_bytes);    /* Programmed part */
+    host_cdc_set_sink(on_reply, NULL);
+    avr_spi_init();
+    avr_profile_init();
+    stk500v1_init();
+
+    CHECK(ok(Cmnd_STK_ENTER_PROGMODE));
+    CHECK(ok(Cmnd_STK_CHIP_ERASE));
+    send(load0, sizeof(load0));
+}
+
+/** The image, its odd tail padded to a word with 0xFF, then erased flash */
+static void check_flash(void) {
+    const uint8_t* flash = host_target()->flash;
+    size_t bad = 0;
+    for (size_t i = 0; i < host_target()->flash_bytes; i++) {
+        uint8_t want = i < sizeof(lz_image) ? lz_image[i] : 0xFF;
+        bad += flash[i] != want;
+    }
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(host_target()->busy_violations, 0);
+    CHECK_EQ(host_target()->misreads, 0);
+}
+
+/** Pages holding anything but 0xFF: the only ones that need a write */
+static uint32_t programmed_pages(void) {
+    uint32_t n = 0;
+    for (size_t at = 0; at < sizeof(lz_image); at += PAGE_BYTES) {
+        for (size_t i = at; i < at + PAGE_BYTES && i < sizeof(lz_image); i++) {
+            if (lz_image[i] != 0xFF) {
+                n++;
+                break;
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Upload in frames of chunk stream bytes, each followed by GET_SYNC
+ *
+ * A frame that expands to many pages is answered from stk500v1_task(),
+ * and the GET_SYNC behind it waits for that reply.
+ */
+static void test_upload(size_t chunk) {
+    static const uint8_t sync[] = {Cmnd_STK_GET_SYNC, Sync_CRC_EOP};
+    uint8_t frame[5 + 256 + sizeof(sync)];
+    uint32_t deferred = 0;
+
+    start();
+    uint32_t writes = host_target()->page_writes;
+    for (size_t at = 0; at < sizeof(lz_stream); at += chunk) {
+        size_t n = sizeof(lz_stream) - at < chunk ? sizeof(lz_stream) - at : chunk;
+        reply_len = 0;
+        stk500v1_feed(frame, (int)lz_frame(frame, lz_stream + at, n, sync, sizeof(sync)));
+        deferred += reply_len == 0;
+        run_loop();
+        CHECK_EQ(reply_len, 4);
+        CHECK(reply[0] == Resp_STK_INSYNC && reply[1] == Resp_STK_OK);
+        CHECK(reply[2] == Resp_STK_INSYNC && reply[3] == Resp_STK_OK);
+    }
+    CHECK_EQ(finish(), Resp_STK_OK);
+    CHECK(ok(Cmnd_STK_LEAVE_PROGMODE));
+
+    check_flash();
+    CHECK_EQ(host_target()->page_writes - writes, programmed_pages());    /* Erased pages skipped */
+    if (chunk == 256) {
+        CHECK(deferred >= 1);
+    }
+}
+
+/** A stream cut inside an item fails at its end; the next one starts fresh */
+static void test_truncated(void) {
+    uint8_t frame[5 + 256];
+
+    start();
+    send(frame, lz_frame(frame, lz_stream, LZ_TRUNCATED_LEN, NULL, 0));
+    CHECK(reply_len == 2 && reply[1] == Resp_STK_OK);
+    CHECK_EQ(finish(), Resp_STK_FAILED);
+
+    CHECK(ok(Cmnd_STK_CHIP_ERASE));
+    send(load0, sizeof(load0));
+    for (size_t at = 0; at < sizeof(lz_stream); at += 256) {
+        size_t n = sizeof(lz_stream) - at < 256 ? sizeof(lz_stream) - at : 256;
+        send(frame, lz_frame(frame, lz_stream + at, n, NULL, 0));
+        CHECK(reply_len == 2 && reply[1] == Resp_STK_OK);
+    }
+    CHECK_EQ(finish(), Resp_STK_OK);
+    check_flash();
+}
+
+int main(void) {
+    test_upload(256);
+    test_upload(5);     /* Items split across frames */
+    test_truncated();
+    return host_test_result("lz");
+}
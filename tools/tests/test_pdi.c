@@ -0,0 +1,108 @@
+/**
+ * @file test_pdi.c
+ * @brief PDI Backend Against the Simulated XMEGA
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "host_phy.h"
+#include "avr_iface.h"
+#include "pdi.h"
+#include <string.h>
+
+static const uint8_t atxmega128a4u[3] = {0x1E, 0x97, 0x46};
+
+static const avr_iface_t* connect(void) {
+    host_sim_reset();
+    host_sim_connect(HOST_LINK_PDI, atxmega128a4u);
+    avr_iface_select(AVR_IFACE_PDI);
+    return avr_iface();
+}
+
+/** Enter, guard time, identification through the emulated ISP reads */
+static void test_enter(void) {
+    const avr_iface_t* iface = connect();
+    uint8_t rx[4];
+
+    CHECK(iface->enter());
+    CHECK_EQ(host_target()->guard_bits, 2);
+    for (uint8_t i = 0; i < 3; i++) {
+        iface->universal((const uint8_t[4]){0x30, 0x00, i, 0x00}, rx);
+        CHECK_EQ(rx[3], atxmega128a4u[i]);
+    }
+    iface->universal((const uint8_t[4]){0x58, 0x00, 0x00, 0x00}, rx);
+    CHECK_EQ(rx[3], 0xFF);
+    iface->leave();
+    CHECK_EQ(host_target()->frame_errors, 0);
+    CHECK_EQ(host_sim_contentions(), 0);
+}
+
+/** Chip erase, a page through REPEAT + ST *(ptr++) and ERASE_WRITE_PAGE, read back */
+static void test_flash(void) {
+    const avr_iface_t* iface = connect();
+    uint32_t page_bytes = host_target()->page_bytes;
+    uint8_t page[512];
+    uint8_t back[300];
+
+    memset(host_target()->flash, 0x00, 4u * page_bytes);
+    CHECK(iface->enter());
+    iface->chip_erase();
+    CHECK(iface->poll_ready(100000));
+    CHECK_EQ(host_target()->chip_erases, 1);
+    CHECK_EQ(host_target()->flash[0], 0xFF);
+
+    for (uint32_t i = 0; i < page_bytes; i++) {
+        page[i] = (uint8_t)(i * 7u + 3u);
+    }
+    iface->write_flash_page(2u * page_bytes, page, page_bytes);
+    CHECK(iface->poll_ready(100000));
+    CHECK_EQ(host_target()->page_writes, 1);
+    CHECK(memcmp(host_target()->flash + 2u * page_bytes, page, page_bytes) == 0);
+    CHECK_EQ(host_target()->flash[page_bytes], 0xFF);
+
+    /* More than one REPEAT burst */
+    for (uint32_t i = 0; i < sizeof(back); i++) {
+        host_target()->flash[0x1000 + i] = (uint8_t)(i ^ 0xA5);
+    }
+    iface->read_flash(0x1000, back, sizeof(back));
+    for (uint32_t i = 0; i < sizeof(back); i++) {
+        CHECK_EQ(back[i], (uint8_t)(i ^ 0xA5));
+    }
+    iface->leave();
+    CHECK_EQ(host_target()->busy_violations, 0);
+    CHECK_EQ(host_target()->frame_errors, 0);
+    CHECK_EQ(host_sim_contentions(), 0);
+}
+
+/** Lock bits through WRITE_LOCK_BITS, read back through READ_NVM */
+static void test_lock(void) {
+    const avr_iface_t* iface = connect();
+    uint8_t rx[4];
+
+    CHECK(iface->enter());
+    iface->universal((const uint8_t[4]){0xAC, 0xE0, 0x00, 0xFC}, rx);
+    CHECK_EQ(host_target()->lock, 0xFC);
+    iface->universal((const uint8_t[4]){0x58, 0x00, 0x00, 0x00}, rx);
+    CHECK_EQ(rx[3], 0xFC);
+    iface->leave();
+    CHECK_EQ(host_target()->busy_violations, 0);
+}
+
+/** Nothing on the header: no reply, entry gives up */
+static void test_no_target(void) {
+    const avr_iface_t* iface = connect();
+
+    host_board_attach(NULL);
+    CHECK(!iface->enter());
+}
+
+int main(void) {
+    test_enter();
+    test_flash();
+    test_lock();
+    test_no_target();
+    return host_test_result("pdi");
+}
@@ -0,0 +1,77 @@
+/**
+ * @file test_profile.c
+ * @brief Learned ISP Rates Against the Simulated Target's SCK Limit
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_iface.h"
+#include "avr_profile.h"
+#include "avrprog.h"
+#include "target_clock.h"
+
+#define BASE_HZ     125000u
+
+static void start(uint32_t cpu_hz, uint8_t sig[3]) {
+    host_target()->cpu_hz = cpu_hz;
+    avr_spi_init();
+    avr_iface_select(AVR_IFACE_ISP);
+    avr_set_sck_frequency(BASE_HZ);
+    CHECK(avr_iface()->enter());
+    avr_read_signature(sig);
+    CHECK_EQ(sig[0], 0x1E);
+}
+
+/** Without a stated clock nothing above the base rate is probed or used */
+static void test_off_by_default(void) {
+    uint8_t sig[3];
+
+    host_sim_reset();
+    avr_profile_init();
+    avr_profile_set_clock_hz(0);
+    start(16000000u, sig);
+    CHECK_EQ(avr_profile_begin(sig), BASE_HZ);
+    CHECK_EQ(avr_get_sck_frequency(), BASE_HZ);
+    avr_profile_end(true);
+
+    start(16000000u, sig);
+    CHECK_EQ(avr_profile_begin(sig), BASE_HZ);
+    avr_profile_end(true);
+    CHECK_EQ(host_target()->misreads, 0);
+}
+
+/** Probing stops at the SCK limit of the stated clock */
+static void test_capped(void) {
+    uint32_t limit = target_clock_isp_rate(16000000u, 0);
+    uint32_t hz;
+    uint8_t sig[3];
+
+    host_sim_reset();
+    avr_profile_init();
+    avr_profile_set_clock_hz(16000000u);
+    CHECK_EQ(avr_profile_clock_hz(), 16000000u);
+    start(16000000u, sig);
+    hz = avr_profile_begin(sig);
+    CHECK(hz > BASE_HZ);
+    CHECK(hz <= limit);
+    avr_profile_end(true);
+    CHECK_EQ(host_target()->misreads, 0);
+
+    /* The same part, now stated slower: the learned rate is clamped */
+    avr_profile_set_clock_hz(1000000u);
+    start(1000000u, sig);
+    hz = avr_profile_begin(sig);
+    CHECK(hz <= target_clock_isp_rate(1000000u, 0));
+    avr_profile_end(true);
+    CHECK_EQ(host_target()->misreads, 0);
+    avr_profile_set_clock_hz(0);
+}
+
+int main(void) {
+    test_off_by_default();
+    test_capped();
+    return host_test_result("profile");
+}
@@ -0,0 +1,173 @@
+/**
+ * @file test_readahead.c
+ * @brief READ_PAGE Verify Passes Through the Protocol Handler
+ *
+ * avrdude's LOAD_ADDRESS + READ_PAGE pairs go in through stk500v1_feed()
+ * with stk500v1_task() run a set number of times between frames, so the
+ * window can be ahead of the host or still catching up.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_profile.h"
+#include "avrprog.h"
+#include "readahead.h"
+#include "stk500v1.h"
+#include "tusb.h"
+#include <string.h>
+
+#define PAGE_BYTES  128u
+#define IDLE        100000      /* Loop passes: enough for an erase or a full window */
+
+static uint8_t reply[PAGE_BYTES + 8];
+static size_t reply_len;
+
+static void on_reply(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    for (size_t i = 0; i < len && reply_len < sizeof(reply); i++) {
+        reply[reply_len++] = data[i];
+    }
+}
+
+/** Send one frame and run up to passes main loop passes */
+static void send(const uint8_t* frame, size_t len, int passes) {
+    reply_len = 0;
+    stk500v1_feed(frame, (int)len);
+    for (int i = 0; i < passes && stk500v1_task(); i++) {
+        tud_task();
+    }
+    tud_cdc_write_flush();
+}
+
+static bool ok(uint8_t cmd) {
+    const uint8_t frame[2] = {cmd, Sync_CRC_EOP};
+    send(frame, sizeof(frame), IDLE);
+    return reply_len == 2 && reply[0] == Resp_STK_INSYNC && reply[1] == Resp_STK_OK;
+}
+
+static int get_parameter(uint8_t parm) {
+    const uint8_t frame[3] = {Cmnd_STK_GET_PARAMETER, parm, Sync_CRC_EOP};
+    send(frame, sizeof(frame), IDLE);
+    return reply_len == 3 && reply[2] == Resp_STK_OK ? reply[1] : -1;
+}
+
+/** LOAD_ADDRESS + READ_PAGE; true if the page matches the target's flash */
+static bool read_page(uint32_t byte_addr, int passes) {
+    const uint8_t load[4] = {
+        Cmnd_STK_LOAD_ADDRESS, (uint8_t)(byte_addr / 2), (uint8_t)(byte_addr / 2 >> 8), Sync_CRC_EOP,
+    };
+    const uint8_t read[5] = {Cmnd_STK_READ_PAGE, 0, PAGE_BYTES, 'F', Sync_CRC_EOP};
+    send(load, sizeof(load), passes);
+    send(read, sizeof(read), passes);
+    return reply_len == PAGE_BYTES + 2 && reply[0] == Resp_STK_INSYNC &&
+           reply[PAGE_BYTES + 1] == Resp_STK_OK &&
+           memcmp(reply + 1, host_target()->flash + byte_addr, PAGE_BYTES) == 0;
+}
+
+static void start(const uint8_t sig[3]) {
+    host_sim_reset();
+    host_target_init(sig);
+    host_target()->cpu_hz = 16000000u;
+    for (uint32_t i = 0; i < host_target()->flash_bytes; i++) {
+        host_target()->flash[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+    host_cdc_set_sink(on_reply, NULL);
+    avr_spi_init();
+    avr_profile_init();
+    stk500v1_init();
+    CHECK(ok(Cmnd_STK_ENTER_PROGMODE));
+}
+
+static const uint8_t m328p[3] = {0x1E, 0x95, 0x0F};
+
+/**
+ * @brief A pass over pages, checking the data and the hit/miss counters
+ *
+ * The counters run since startup and saturate at 255, so each test
+ * reads few enough pages to compare differences.
+ *
+ * @return ISP instructions sent during the pass
+ */
+static uint32_t verify_pass(uint32_t from, uint32_t pages, int passes, int hits, int misses) {
+    int hits0 = get_parameter(Parm_VND_READAHEAD_HITS);
+    int misses0 = get_parameter(Parm_VND_READAHEAD_MISSES);
+    uint32_t before = host_target()->instructions;
+    for (uint32_t p = 0; p < pages; p++) {
+        CHECK(read_page(from + p * PAGE_BYTES, passes));
+    }
+    uint32_t used = host_target()->instructions - before;
+    CHECK_EQ(get_parameter(Parm_VND_READAHEAD_HITS) - hits0, hits);
+    CHECK_EQ(get_parameter(Parm_VND_READAHEAD_MISSES) - misses0, misses);
+    CHECK_EQ(host_target()->misreads, 0);
+    return used;
+}
+
+/** The host thinks long enough: two requests arm the window, the rest hit */
+static void test_sequential(void) {
+    start(m328p);
+    verify_pass(0, 40, IDLE, 38, 2);
+
+    /* Up to the end of flash: the window stops there */
+    verify_pass(host_target()->flash_bytes - 16 * PAGE_BYTES, 16, IDLE, 14, 2);
+}
+
+/** One chunk per frame: requests are served partly from the window */
+static void test_catching_up(void) {
+    start(m328p);
+    uint32_t used = verify_pass(0, 16, 1, 0, 16);
+    /* Prefetched bytes are served, not read again; one chunk after the last */
+    CHECK_EQ(used, 16 * PAGE_BYTES + READAHEAD_CHUNK);
+}
+
+/** A command that is no read drops the window: the target is read again */
+static void test_invalidation(void) {
+    static const uint8_t universal[6] = {Cmnd_STK_UNIVERSAL, 0x30, 0, 0, 0, Sync_CRC_EOP};
+    static const uint8_t parameter[4] = {Cmnd_STK_SET_PARAMETER, Parm_VND_TRACE, 0, Sync_CRC_EOP};
+    static const uint8_t erase[2] = {Cmnd_STK_CHIP_ERASE, Sync_CRC_EOP};
+    const struct {
+        const uint8_t* frame;
+        size_t len;
+    } drops[] = {
+        {universal, sizeof(universal)},
+        {parameter, sizeof(parameter)},
+        {erase, sizeof(erase)},
+    };
+
+    start(m328p);
+    uint32_t at = 0;
+    for (size_t i = 0; i < sizeof(drops) / sizeof(drops[0]); i++) {
+        verify_pass(at, 3, IDLE, 1, 2);
+        at += 3 * PAGE_BYTES;
+
+        /* The window holds the next page; change it behind the programmer */
+        host_target()->flash[at] ^= 0xFF;
+        send(drops[i].frame, drops[i].len, IDLE);
+        verify_pass(at, 1, IDLE, 0, 1);
+        at += 2 * PAGE_BYTES;   /* Not sequential: the next pass arms anew */
+    }
+
+    /* Without such a command the stale window is served: it is there */
+    verify_pass(at, 3, IDLE, 1, 2);
+    at += 3 * PAGE_BYTES;
+    host_target()->flash[at] ^= 0xFF;
+    CHECK(!read_page(at, IDLE));
+}
+
+/** Unknown part, so no known flash end: every request reads the target */
+static void test_unknown_part(void) {
+    static const uint8_t unknown[3] = {0x1E, 0x95, 0xEE};
+
+    start(unknown);
+    CHECK_EQ(verify_pass(0, 8, IDLE, 0, 8), 8 * PAGE_BYTES);
+}
+
+int main(void) {
+    test_sequential();
+    test_catching_up();
+    test_invalidation();
+    test_unknown_part();
+    return host_test_result("readahead");
+}
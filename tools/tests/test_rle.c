@@ -0,0 +1,195 @@
+/**
+ * @file test_rle.c
+ * @brief Run-Length Readback (READ_FLASH_RLE) Through the Protocol Handler
+ *
+ * The simulated flash is seeded, read back with one READ_FLASH_RLE and
+ * the stream decoded as compress.py rle_decode() does.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_profile.h"
+#include "avrprog.h"
+#include "compress.h"
+#include "stk500v1.h"
+#include "tusb.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ATmega644P: the longest run fits, with room around it */
+static const uint8_t part[3] = {0x1E, 0x96, 0x0A};
+#define FLASH_BYTES 65536u
+
+static uint8_t reply[FLASH_BYTES + FLASH_BYTES / RLE_MAX_LITERAL + 16];
+static size_t reply_len;
+
+static void on_reply(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    for (size_t i = 0; i < len && reply_len < sizeof(reply); i++) {
+        reply[reply_len++] = data[i];
+    }
+}
+
+static void send(const uint8_t* frame, size_t len) {
+    reply_len = 0;
+    stk500v1_feed(frame, (int)len);
+    for (int i = 0; i < 1000 && stk500v1_task(); i++) {
+        tud_task();
+    }
+    tud_cdc_write_flush();
+}
+
+static bool ok(uint8_t cmd) {
+    const uint8_t frame[2] = {cmd, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return reply_len == 2 && reply[0] == Resp_STK_INSYNC && reply[1] == Resp_STK_OK;
+}
+
+static void load_address(uint16_t word) {
+    const uint8_t frame[4] = {Cmnd_STK_LOAD_ADDRESS, (uint8_t)word, (uint8_t)(word >> 8), Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+}
+
+static void read_rle(uint32_t size) {
+    const uint8_t frame[6] = {
+        Cmnd_STK_READ_FLASH_RLE, (uint8_t)(size >> 16), (uint8_t)(size >> 8), (uint8_t)size,
+        'F', Sync_CRC_EOP,
+    };
+    send(frame, sizeof(frame));
+}
+
+/**
+ * @brief Decode the reply's RLE stream into out
+ *
+ * @return Decoded bytes, or -1 if the reply is not INSYNC, stream, OK
+ */
+static long decode_reply(uint8_t* out, size_t cap) {
+    size_t i = 1;
+    size_t n = 0;
+    if (reply_len < 2 || reply[0] != Resp_STK_INSYNC) {
+        return -1;
+    }
+    while (i < reply_len - 1) {
+        uint8_t c = reply[i++];
+        if (c < 0x80) {
+            size_t lit = (size_t)c + 1;
+            if (i + lit > reply_len - 1 || n + lit > cap) {
+                return -1;
+            }
+            memcpy(out + n, reply + i, lit);
+            i += lit;
+            n += lit;
+        } else {
+            if (i + 2 > reply_len - 1) {
+                return -1;
+            }
+            size_t run = ((size_t)(c & 0x7F) << 8 | reply[i]) + RLE_MIN_RUN;
+            if (n + run > cap) {
+                return -1;
+            }
+            memset(out + n, reply[i + 1], run);
+            i += 2;
+            n += run;
+        }
+    }
+    return reply[reply_len - 1] == Resp_STK_OK ? (long)n : -1;
+}
+
+static void start(void) {
+    host_sim_reset();
+    host_target_init(part);
+    host_target()->cpu_hz = 16000000u;
+    host_cdc_set_sink(on_reply, NULL);
+    avr_spi_init();
+    avr_profile_init();
+    stk500v1_init();
+}
+
+/** Erased, repeating and random regions, and runs at the length limits */
+static void seed(uint8_t* flash) {
+    srand(1);
+    memset(flash, 0xFF, FLASH_BYTES);
+    for (uint32_t i = 0; i < 4096; i++) {
+        flash[i] = (uint8_t)rand();                             /* Literal blocks of 128 */
+    }
+    memset(flash + 4096, 0x00, RLE_MAX_RUN + 5);                /* Longest run, then more */
+    for (uint32_t i = 0; i < 600; i++) {
+        flash[0xA000 + i] = (uint8_t)(i / 2 % 3 == 0 ? 0xAA : i);   /* Runs of 2 stay literal */
+    }
+    memset(flash + 0xB000, 0x55, 3);                            /* Shortest run */
+    flash[0xB003] = 0x56;
+    for (uint32_t i = 0; i < 256; i++) {
+        flash[0xC000 + i] = (uint8_t)(0x0C + (i & 3));          /* Repeating pattern */
+    }
+    for (uint32_t i = FLASH_BYTES - 77; i < FLASH_BYTES; i++) {
+        flash[i] = (uint8_t)rand();                             /* Up to the last byte */
+    }
+}
+
+/** The whole part and a range at an odd offset, in one command each */
+static void test_roundtrip(void) {
+    static uint8_t out[FLASH_BYTES];
+    const uint8_t* flash = host_target()->flash;
+
+    start();
+    seed(host_target()->flash);
+    CHECK(ok(Cmnd_STK_ENTER_PROGMODE));
+    load_address(0);
+    read_rle(FLASH_BYTES);
+    CHECK_EQ(decode_reply(out, sizeof(out)), FLASH_BYTES);
+    CHECK(memcmp(out, flash, FLASH_BYTES) == 0);
+    CHECK(reply_len < FLASH_BYTES / 8);     /* Runs cost next to nothing */
+
+    /* The address auto-increments past an odd size */
+    load_address(0x4000 / 2 - 1);
+    read_rle(4097);
+    CHECK_EQ(decode_reply(out, sizeof(out)), 4097);
+    CHECK(memcmp(out, flash + 0x4000 - 2, 4097) == 0);
+    read_rle(3);
+    CHECK_EQ(decode_reply(out, sizeof(out)), 3);
+    CHECK(memcmp(out, flash + 0x4000 - 2 + 4098, 3) == 0);
+    CHECK_EQ(host_target()->misreads, 0);
+}
+
+/** A range past the end of flash fails instead of wrapping */
+static void test_bounds(void) {
+    uint8_t out[0x200];
+
+    start();
+    CHECK(ok(Cmnd_STK_ENTER_PROGMODE));
+    load_address((FLASH_BYTES - 0x200) / 2);
+    read_rle(0x201);
+    CHECK(reply_len == 2 && reply[1] == Resp_STK_FAILED);
+    read_rle(0x200);
+    CHECK_EQ(decode_reply(out, sizeof(out)), 0x200);
+    load_address(0);
+    read_rle(0xFFFFFF);
+    CHECK(reply_len == 2 && reply[1] == Resp_STK_FAILED);
+}
+
+/** A host that stops reading stops the target reads too */
+static void test_abandoned(void) {
+    start();
+    seed(host_target()->flash);
+    CHECK(ok(Cmnd_STK_ENTER_PROGMODE));
+    load_address(0);
+    uint32_t before = host_target()->instructions;
+    host_cdc_set_connected(false);
+    read_rle(FLASH_BYTES);
+    CHECK(host_target()->instructions - before < 4096);     /* Not the whole part */
+
+    /* The host comes back, drops what was still queued and resyncs */
+    host_cdc_set_connected(true);
+    tud_cdc_write_flush();
+    CHECK(ok(Cmnd_STK_GET_SYNC));
+}
+
+int main(void) {
+    test_roundtrip();
+    test_bounds();
+    test_abandoned();
+    return host_test_result("rle");
+}
@@ -0,0 +1,194 @@
+/**
+ * @file test_target_cache.c
+ * @brief Target Cache Through the Protocol Handler on the Simulated Target
+ *
+ * Whether a query reached the target is read from the simulated target's
+ * instruction counter: a cached answer costs no ISP traffic at all.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_profile.h"
+#include "avrprog.h"
+#include "stk500v1.h"
+#include "tusb.h"
+#include <string.h>
+
+static uint8_t reply[STK_BATCH_MAX_INSTR + 8];
+static size_t reply_len;
+
+static void on_reply(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    for (size_t i = 0; i < len && reply_len < sizeof(reply); i++) {
+        reply[reply_len++] = data[i];
+    }
+}
+
+static void send(const uint8_t* frame, size_t len) {
+    reply_len = 0;
+    stk500v1_feed(frame, (int)len);
+    for (int i = 0; i < 100000 && stk500v1_task(); i++) {
+        tud_task();
+    }
+    tud_cdc_write_flush();
+}
+
+static bool ok(uint8_t cmd) {
+    const uint8_t frame[2] = {cmd, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return reply_len == 2 && reply[0] == Resp_STK_INSYNC && reply[1] == Resp_STK_OK;
+}
+
+static int get_parameter(uint8_t parm) {
+    const uint8_t frame[3] = {Cmnd_STK_GET_PARAMETER, parm, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return reply_len == 3 && reply[2] == Resp_STK_OK ? reply[1] : -1;
+}
+
+/** UNIVERSAL: the result byte, or -1 */
+static int universal(uint8_t op0, uint8_t op1, uint8_t op2, uint8_t op3) {
+    const uint8_t frame[6] = {Cmnd_STK_UNIVERSAL, op0, op1, op2, op3, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return reply_len == 3 && reply[0] == Resp_STK_INSYNC && reply[2] == Resp_STK_OK ? reply[1] : -1;
+}
+
+/** The cacheable reads, in the order of the slots */
+enum { SIG0, SIG1, SIG2, LFUSE, HFUSE, EFUSE, LOCK, OSCCAL, CACHED };
+
+static const uint8_t reads[CACHED][3] = {
+    {0x30, 0x00, 0x00}, {0x30, 0x00, 0x01}, {0x30, 0x00, 0x02},
+    {0x50, 0x00, 0x00}, {0x58, 0x08, 0x00}, {0x50, 0x08, 0x00},
+    {0x58, 0x00, 0x00}, {0x38, 0x00, 0x00},
+};
+
+/** The value the target holds for a cached read */
+static uint8_t target_value(int i) {
+    const host_target_t* t = host_target();
+    switch (i) {
+        case LFUSE:  return t->lfuse;
+        case HFUSE:  return t->hfuse;
+        case EFUSE:  return t->efuse;
+        case LOCK:   return t->lock;
+        case OSCCAL: return t->calibration;
+        default:     return t->signature[i - SIG0];
+    }
+}
+
+/**
+ * @brief Query every cached read once
+ *
+ * @return Bitmask of the reads that reached the target
+ */
+static uint32_t reads_from_target(void) {
+    uint32_t mask = 0;
+    for (int i = 0; i < CACHED; i++) {
+        uint32_t before = host_target()->instructions;
+        CHECK_EQ(universal(reads[i][0], reads[i][1], reads[i][2], 0x00), target_value(i));
+        if (host_target()->instructions != before) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+static void start(void) {
+    static const uint8_t m328p[3] = {0x1E, 0x95, 0x0F};
+
+    host_sim_reset();
+    host_target_init(m328p);
+    host_target()->cpu_hz = 16000000u;
+    host_cdc_set_sink(on_reply, NULL);
+    avr_spi_init();
+    avr_profile_init();
+    stk500v1_init();
+    CHECK(ok(Cmnd_STK_ENTER_PROGMODE));
+}
+
+/** After ENTER, READ_SIGN and the cached UNIVERSAL reads stay off the bus */
+static void test_populated(void) {
+    static const uint8_t read_sign[2] = {Cmnd_STK_READ_SIGN, Sync_CRC_EOP};
+
+    start();
+    uint32_t before = host_target()->instructions;
+    send(read_sign, sizeof(read_sign));
+    CHECK(reply_len == 5 && reply[0] == Resp_STK_INSYNC && reply[4] == Resp_STK_OK);
+    CHECK(memcmp(reply + 1, host_target()->signature, 3) == 0);
+    CHECK_EQ(reads_from_target(), 0);
+    CHECK_EQ(host_target()->instructions, before);
+
+    /* Uncached reads still go to the target */
+    CHECK_EQ(universal(0x20, 0x00, 0x00, 0x00), host_target()->flash[0]);
+    CHECK(host_target()->instructions != before);
+
+    /* A new session reads the part again */
+    CHECK(ok(Cmnd_STK_LEAVE_PROGMODE));
+    host_target()->lfuse = 0xE2;
+    CHECK(ok(Cmnd_STK_ENTER_PROGMODE));
+    CHECK_EQ(reads_from_target(), 0);
+}
+
+/** A write drops the byte it changes; the next query reads the new value */
+static void test_write_invalidates(void) {
+    static const struct {
+        uint8_t op1;
+        uint8_t value;
+        uint32_t dropped;
+    } writes[] = {
+        {0xA0, 0xE2, 1u << LFUSE},
+        {0xA8, 0xD8, 1u << HFUSE},
+        {0xA4, 0xFD, 1u << EFUSE},
+        {0xE0, 0xFC, 1u << LOCK},
+        {0x80, 0x00, 1u << LOCK},       /* Chip erase clears the lock bits */
+    };
+
+    start();
+    for (size_t i = 0; i < sizeof(writes) / sizeof(writes[0]); i++) {
+        universal(0xAC, writes[i].op1, 0x00, writes[i].value);
+        host_sim_advance_ns(10000000u);     /* avrdude waits out the write */
+        CHECK_EQ(reads_from_target(), writes[i].dropped);
+        CHECK_EQ(reads_from_target(), 0);
+    }
+    CHECK_EQ(host_target()->lfuse, 0xE2);
+    CHECK_EQ(host_target()->hfuse, 0xD8);
+    CHECK_EQ(host_target()->efuse, 0xFD);
+
+    /* CHIP_ERASE drops the lock bits too */
+    CHECK(ok(Cmnd_STK_CHIP_ERASE));
+    CHECK_EQ(reads_from_target(), 1u << LOCK);
+}
+
+/** 0xC0/0xC1 stop at 255 instead of wrapping */
+static void test_counters_saturate(void) {
+    static uint8_t frame[3 + 4 * STK_BATCH_MAX_INSTR];
+
+    start();
+    for (int i = 0; i < 2 * 256 / CACHED; i++) {
+        reads_from_target();
+    }
+    CHECK_EQ(get_parameter(Parm_VND_CACHE_HITS), 255);
+
+    /* Low fuse write then read, STK_BATCH_MAX_INSTR / 2 misses per frame */
+    frame[0] = Cmnd_STK_UNIVERSAL_BATCH;
+    frame[1] = STK_BATCH_MAX_INSTR;
+    for (int i = 0; i < STK_BATCH_MAX_INSTR; i += 2) {
+        const uint8_t pair[8] = {0xAC, 0xA0, 0x00, 0x62, 0x50, 0x00, 0x00, 0x00};
+        memcpy(frame + 2 + i * 4, pair, sizeof(pair));
+    }
+    frame[2 + 4 * STK_BATCH_MAX_INSTR] = Sync_CRC_EOP;
+    for (int i = 0; i < 2 * 256 / (STK_BATCH_MAX_INSTR / 2); i++) {
+        send(frame, sizeof(frame));
+        CHECK_EQ(reply[1 + STK_BATCH_MAX_INSTR - 1], 0x62);
+    }
+    CHECK_EQ(get_parameter(Parm_VND_CACHE_MISSES), 255);
+    CHECK_EQ(get_parameter(Parm_VND_CACHE_HITS), 255);
+}
+
+int main(void) {
+    test_populated();
+    test_write_invalidates();
+    test_counters_saturate();
+    return host_test_result("target_cache");
+}
@@ -0,0 +1,94 @@
+/**
+ * @file test_target_clock.c
+ * @brief ISP Rate Selection Against the Datasheet SCK Limit
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avrprog.h"
+#include "target_clock.h"
+#include <string.h>
+
+/** Largest rate the datasheet allows for a target clock */
+static uint32_t datasheet_limit(uint32_t f) {
+    return f >= 12000000u ? f / 6u : (f - 1u) / 4u;
+}
+
+/** Enter programming mode at hz on a target clocked at f, count misreads */
+static uint32_t misreads_at(uint32_t f, uint32_t hz) {
+    static const uint8_t atmega328p[3] = {0x1E, 0x95, 0x0F};
+    uint8_t sig[3];
+
+    host_sim_reset();
+    host_target()->cpu_hz = f;
+    avr_spi_init();
+    avr_set_sck_frequency(hz);
+    avr_enter_programming_mode();
+    avr_read_signature(sig);
+    avr_leave_programming_mode();
+    if (memcmp(sig, atmega328p, 3) != 0) {
+        return host_target()->misreads ? host_target()->misreads : 1;
+    }
+    return host_target()->misreads;
+}
+
+static void test_rate_table(void) {
+    /* No clock: the host's rate, or the safe default */
+    CHECK_EQ(target_clock_isp_rate(0, 0), TARGET_ISP_DEFAULT_HZ);
+    CHECK_EQ(target_clock_isp_rate(0, 1000000), 1000000);
+
+    /* Below 12 MHz: strictly below f/4 */
+    CHECK_EQ(target_clock_isp_rate(1000000, 0), 249999);
+    CHECK_EQ(target_clock_isp_rate(8000000, 0), 1999999);
+    CHECK_EQ(target_clock_isp_rate(7812500, 0), 1953124);
+    CHECK_EQ(target_clock_isp_rate(11999999, 0), 2999999);
+
+    /* From 12 MHz: f/6 */
+    CHECK_EQ(target_clock_isp_rate(12000000, 0), 2000000);
+    CHECK_EQ(target_clock_isp_rate(15625000, 0), 2604166);
+    CHECK_EQ(target_clock_isp_rate(20000000, 0), 3333333);
+
+    /* The host's rate caps the limit, never raises it */
+    CHECK_EQ(target_clock_isp_rate(8000000, 100000), 100000);
+    CHECK_EQ(target_clock_isp_rate(8000000, 2000000), 1999999);
+    CHECK_EQ(target_clock_isp_rate(16000000, 4000000), 2666666);
+}
+
+static void test_rate_sweep(void) {
+    for (uint32_t f = 100000; f <= 32000000; f += 77777) {
+        uint32_t hz = target_clock_isp_rate(f, 0);
+        CHECK_EQ(hz, datasheet_limit(f));
+        if (f < 12000000u) {
+            CHECK((uint64_t)hz * 4u < f);
+        } else {
+            CHECK((uint64_t)hz * 6u <= f);
+        }
+    }
+}
+
+/**
+ * @brief The simulated target accepts the chosen rate and rejects f/4
+ *
+ * SPI0 divides 125 MHz, so f/4 is hit exactly at 7.8125 MHz (1953125 Hz,
+ * 256 ns phases); 2 MHz at 8 MHz really runs at 1953125 Hz too, just
+ * inside the limit.
+ */
+static void test_against_target(void) {
+    CHECK_EQ(misreads_at(7812500, target_clock_isp_rate(7812500, 0)), 0);
+    CHECK(misreads_at(7812500, 1953125) > 0);
+    CHECK_EQ(misreads_at(8000000, target_clock_isp_rate(8000000, 0)), 0);
+    CHECK_EQ(misreads_at(16000000, target_clock_isp_rate(16000000, 0)), 0);
+    CHECK(misreads_at(16000000, 4000000) > 0);
+    CHECK(misreads_at(16000000, 3200000) > 0);
+    CHECK_EQ(misreads_at(1000000, target_clock_isp_rate(1000000, 0)), 0);
+}
+
+int main(void) {
+    test_rate_table();
+    test_rate_sweep();
+    test_against_target();
+    return host_test_result("target_clock");
+}
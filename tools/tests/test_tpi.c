@@ -0,0 +1,128 @@
+/**
+ * @file test_tpi.c
+ * @brief TPI Backend Against the Simulated Reduced-Core ATtiny
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_iface.h"
+#include "tpi.h"
+#include <string.h>
+
+static const uint8_t attiny10[3] = {0x1E, 0x90, 0x03};
+
+static const avr_iface_t* connect(void) {
+    host_sim_reset();
+    host_sim_connect(HOST_LINK_TPI, attiny10);
+    avr_iface_select(AVR_IFACE_TPI);
+    return avr_iface();
+}
+
+/** Enter, guard time, identification through the emulated ISP reads */
+static void test_enter(void) {
+    const avr_iface_t* iface = connect();
+    uint8_t rx[4];
+
+    CHECK(iface->enter());
+    CHECK_EQ(host_target()->guard_bits, 2);
+    for (uint8_t i = 0; i < 3; i++) {
+        iface->universal((const uint8_t[4]){0x30, 0x00, i, 0x00}, rx);
+        CHECK_EQ(rx[3], attiny10[i]);
+    }
+    iface->universal((const uint8_t[4]){0x50, 0x00, 0x00, 0x00}, rx);
+    CHECK_EQ(rx[3], 0xFF);
+    iface->leave();
+    CHECK_EQ(host_target()->frame_errors, 0);
+    CHECK_EQ(host_target()->misreads, 0);
+}
+
+/** Chip erase, then a page write that skips erased words, read back */
+static void test_flash(void) {
+    const avr_iface_t* iface = connect();
+    uint8_t page[16];
+    uint8_t back[sizeof(page) + 4];
+    uint32_t words = 0;
+
+    memset(host_target()->flash, 0x00, 64);
+    CHECK(iface->enter());
+    iface->chip_erase();
+    CHECK(iface->poll_ready(20000));
+    CHECK_EQ(host_target()->chip_erases, 1);
+    CHECK_EQ(host_target()->flash[0], 0xFF);
+
+    for (size_t i = 0; i < sizeof(page); i += 2) {
+        bool erased = i == 4 || i == 10;
+        page[i] = erased ? 0xFF : (uint8_t)(i + 1u);
+        page[i + 1] = erased ? 0xFF : (uint8_t)(0xA0 + i);
+        words += !erased;
+    }
+    iface->write_flash_page(0x20, page, sizeof(page));
+    CHECK(iface->poll_ready(20000));
+    CHECK_EQ(host_target()->word_writes, words);
+    CHECK(memcmp(host_target()->flash + 0x20, page, sizeof(page)) == 0);
+
+    iface->read_flash(0x1E, back, sizeof(back));
+    CHECK_EQ(back[0], 0xFF);
+    CHECK(memcmp(back + 2, page, sizeof(page)) == 0);
+    iface->leave();
+    CHECK_EQ(host_target()->busy_violations, 0);
+    CHECK_EQ(host_target()->frame_errors, 0);
+}
+
+/** Configuration byte (section erase first) and lock bits */
+static void test_config(void) {
+    const avr_iface_t* iface = connect();
+    uint8_t rx[4];
+
+    CHECK(iface->enter());
+    iface->universal((const uint8_t[4]){0xAC, 0xA0, 0x00, 0xFE}, rx);
+    CHECK_EQ(host_target()->lfuse, 0xFE);
+    iface->universal((const uint8_t[4]){0xAC, 0xA0, 0x00, 0xFD}, rx);
+    CHECK_EQ(host_target()->lfuse, 0xFD);
+    iface->universal((const uint8_t[4]){0x50, 0x00, 0x00, 0x00}, rx);
+    CHECK_EQ(rx[3], 0xFD);
+
+    iface->universal((const uint8_t[4]){0xAC, 0xE0, 0x00, 0xFC}, rx);
+    CHECK_EQ(host_target()->lock, 0xFC);
+    iface->universal((const uint8_t[4]){0x58, 0x00, 0x00, 0x00}, rx);
+    CHECK_EQ(rx[3], 0xFC);
+    iface->leave();
+    CHECK_EQ(host_target()->busy_violations, 0);
+}
+
+/** The reset default guard time still works, only slower */
+static void test_long_guard_time(void) {
+    const avr_iface_t* iface = connect();
+    uint8_t rx[4];
+
+    tpi_set_guard_time(TPI_GT_128);
+    CHECK(iface->enter());
+    CHECK_EQ(host_target()->guard_bits, 128);
+    iface->universal((const uint8_t[4]){0x30, 0x00, 0x01, 0x00}, rx);
+    CHECK_EQ(rx[3], attiny10[1]);
+    iface->leave();
+    tpi_set_guard_time(TPI_GT_2);
+    CHECK_EQ(host_target()->frame_errors, 0);
+}
+
+/** TPICLK faster than the target clock: frames garble, entry fails */
+static void test_too_fast(void) {
+    const avr_iface_t* iface = connect();
+
+    host_target()->cpu_hz = 100000u;
+    CHECK(!iface->enter());
+    CHECK(host_target()->misreads > 0);
+    CHECK(host_target()->frame_errors > 0);
+}
+
+int main(void) {
+    test_enter();
+    test_flash();
+    test_config();
+    test_long_guard_time();
+    test_too_fast();
+    return host_test_result("tpi");
+}
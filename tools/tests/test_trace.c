@@ -0,0 +1,158 @@
+/**
+ * @file test_trace.c
+ * @brief Event Trace Ring and Its TRACE_DUMP Encoding
+ *
+ * The host side of the pair, trace_decode() and trace_to_chrome() in
+ * pico/trace_decode.py, is tested by test_trace_decode.py.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_profile.h"
+#include "avrprog.h"
+#include "stk500v1.h"
+#include "trace.h"
+#include "tusb.h"
+#include <string.h>
+
+static uint8_t reply[16 + TRACE_EVENTS * TRACE_RECORD_BYTES];
+static size_t reply_len;
+
+static void on_reply(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    for (size_t i = 0; i < len && reply_len < sizeof(reply); i++) {
+        reply[reply_len++] = data[i];
+    }
+}
+
+static void send(const uint8_t* frame, size_t len) {
+    reply_len = 0;
+    stk500v1_feed(frame, (int)len);
+    for (int i = 0; i < 1000 && stk500v1_task(); i++) {
+        tud_task();
+    }
+    tud_cdc_write_flush();
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/** Records are 8 bytes little-endian, oldest first */
+static void test_record(void) {
+    uint8_t r[TRACE_RECORD_BYTES];
+
+    host_sim_reset();
+    trace_enable(false);
+    trace_clear();
+    trace(TRACE_RX, 0, 5);
+    CHECK_EQ(trace_count(), 0);     /* Off: nothing recorded */
+
+    trace_enable(true);
+    host_sim_advance_ns(1234000u);
+    trace(TRACE_DISPATCH_BEGIN, 0x64, 0x0102);
+    host_sim_advance_ns(10000u);
+    trace(TRACE_DISPATCH_END, 0x64, 0);
+    CHECK_EQ(trace_count(), 2);
+    CHECK_EQ(trace_dropped(), 0);
+
+    trace_record(0, r);
+    CHECK_EQ(le32(r), time_us_32() - 10u);
+    CHECK_EQ(r[4], TRACE_DISPATCH_BEGIN);
+    CHECK_EQ(r[5], 0x64);
+    CHECK_EQ(r[6], 0x02);
+    CHECK_EQ(r[7], 0x01);
+    trace_record(1, r);
+    CHECK_EQ(r[4], TRACE_DISPATCH_END);
+    CHECK_EQ(le32(r), time_us_32());
+}
+
+/** A full ring overwrites the oldest events and counts them */
+static void test_wrap(void) {
+    uint8_t r[TRACE_RECORD_BYTES];
+
+    trace_clear();
+    trace_enable(true);
+    for (uint32_t i = 0; i < TRACE_EVENTS + 5u; i++) {
+        trace(TRACE_POLL, 0, (uint16_t)i);
+    }
+    CHECK_EQ(trace_count(), TRACE_EVENTS);
+    CHECK_EQ(trace_dropped(), 5);
+    trace_record(0, r);
+    CHECK_EQ(r[6], 5);
+    trace_record(TRACE_EVENTS - 1u, r);
+    CHECK_EQ(r[6] | r[7] << 8, TRACE_EVENTS + 4u);
+
+    trace_clear();
+    CHECK_EQ(trace_count(), 0);
+    CHECK_EQ(trace_dropped(), 0);
+    trace_enable(false);
+}
+
+/** A session traced and dumped through the protocol handler */
+static void test_dump(void) {
+    static const uint8_t on[] = {Cmnd_STK_SET_PARAMETER, Parm_VND_TRACE, 1, Sync_CRC_EOP};
+    static const uint8_t enter[] = {Cmnd_STK_ENTER_PROGMODE, Sync_CRC_EOP};
+    static const uint8_t sig[] = {Cmnd_STK_READ_SIGN, Sync_CRC_EOP};
+    static const uint8_t leave[] = {Cmnd_STK_LEAVE_PROGMODE, Sync_CRC_EOP};
+    static const uint8_t dump[] = {Cmnd_STK_TRACE_DUMP, STK_TRACE_CLEAR, Sync_CRC_EOP};
+    uint32_t count;
+    uint32_t begins = 0;
+    uint32_t ends = 0;
+    uint32_t isp = 0;
+    uint32_t prev_t = 0;
+
+    host_sim_reset();
+    host_target()->cpu_hz = 16000000u;
+    host_cdc_set_sink(on_reply, NULL);
+    avr_spi_init();
+    avr_profile_init();
+    stk500v1_init();
+
+    send(on, sizeof(on));
+    send(enter, sizeof(enter));
+    send(sig, sizeof(sig));
+    send(leave, sizeof(leave));
+    send(dump, sizeof(dump));
+
+    CHECK(reply_len >= 8);
+    CHECK_EQ(reply[0], Resp_STK_INSYNC);
+    count = (uint32_t)reply[1] << 8 | reply[2];
+    CHECK_EQ(reply[3] | reply[4] | reply[5] | reply[6], 0);    /* None dropped */
+    CHECK_EQ(reply_len, 7u + count * TRACE_RECORD_BYTES + 1u);
+    CHECK_EQ(reply[reply_len - 1], Resp_STK_OK);
+    CHECK(count >= 6);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t* r = &reply[7 + i * TRACE_RECORD_BYTES];
+        CHECK(le32(r) >= prev_t);
+        prev_t = le32(r);
+        CHECK(r[4] >= TRACE_RX && r[4] <= TRACE_NOSYNC);
+        begins += r[4] == TRACE_DISPATCH_BEGIN;
+        ends += r[4] == TRACE_DISPATCH_END;
+        isp += r[4] == TRACE_ISP_BEGIN;
+    }
+    /* ENTER, READ_SIGN and LEAVE, plus the end of the SET_PARAMETER that
+     * turned recording on and the begin of the dump, which is recorded
+     * before the handler pauses recording */
+    CHECK_EQ(begins, 4);
+    CHECK_EQ(ends, 4);
+    CHECK(isp >= 1);
+    CHECK_EQ(reply[7 + (count - 1u) * TRACE_RECORD_BYTES + 4], TRACE_DISPATCH_BEGIN);
+    CHECK_EQ(reply[7 + (count - 1u) * TRACE_RECORD_BYTES + 5], Cmnd_STK_TRACE_DUMP);
+
+    /* Cleared once sent, recording on again: only the dump's end */
+    CHECK_EQ(trace_count(), 1);
+    CHECK(trace_enabled());
+    trace_enable(false);
+}
+
+int main(void) {
+    test_record();
+    test_wrap();
+    test_dump();
+    return host_test_result("trace");
+}
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Host decoder for TRACE_DUMP records (trace_decode.py trace_decode() and
+trace_to_chrome()), the other half of test_trace.c.
+
+Usage:
+    python3 tools/tests/test_trace_decode.py
+"""
+
+import struct
+import sys
+import unittest
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[2] / "pico"))
+
+import trace_decode as c  # noqa: E402
+
+CMD_PROG_PAGE = 0x64
+
+
+def record(t: int, kind: int, a8: int = 0, a16: int = 0) -> bytes:
+    """One 8-byte record as trace_record() encodes it"""
+    return struct.pack("<IBBH", t & 0xFFFFFFFF, kind, a8, a16)
+
+
+class Decode(unittest.TestCase):
+    def test_fields(self):
+        raw = record(1000, c.TRACE_DISPATCH_BEGIN, 0x64, 0x0102) + record(1010, c.TRACE_FLUSH)
+        self.assertEqual(c.trace_decode(raw),
+                         [(1000, c.TRACE_DISPATCH_BEGIN, 0x64, 0x0102), (1010, c.TRACE_FLUSH, 0, 0)])
+
+    def test_partial_record_ignored(self):
+        raw = record(5, c.TRACE_RX, 0, 3) + b"\x01\x02\x03"
+        self.assertEqual(len(c.trace_decode(raw)), 1)
+
+    def test_timestamp_wrap(self):
+        raw = record(0xFFFFFF00, c.TRACE_POLL) + record(0x10, c.TRACE_POLL) + record(0x20, c.TRACE_POLL)
+        times = [e[0] for e in c.trace_decode(raw)]
+        self.assertEqual(times, [0xFFFFFF00, (1 << 32) + 0x10, (1 << 32) + 0x20])
+
+
+class Chrome(unittest.TestCase):
+    def spans(self, events, tid):
+        return [(e["ph"], e["name"], e["ts"]) for e in c.trace_to_chrome(events)["traceEvents"]
+                if e.get("tid") == tid and e["ph"] in "BE"]
+
+    def test_tracks(self):
+        raw = (record(0xFFFFFFF0, c.TRACE_DISPATCH_END, CMD_PROG_PAGE)     # Begin overwritten
+               + record(0xFFFFFFF8, c.TRACE_RX, 0, 133)
+               + record(0x00000008, c.TRACE_DISPATCH_BEGIN, CMD_PROG_PAGE, 132)
+               + record(0x00000010, c.TRACE_ISP_BEGIN, 0, 129)
+               + record(0x00000040, c.TRACE_ISP_END, 0, 129)
+               + record(0x00000041, c.TRACE_POLL, 1)
+               + record(0x00000050, c.TRACE_WAIT_BEGIN)
+               + record(0x00000090, c.TRACE_WAIT_END, 1)
+               + record(0x00000098, c.TRACE_DISPATCH_END, CMD_PROG_PAGE)
+               + record(0x000000A0, c.TRACE_FLUSH))
+        trace = c.trace_to_chrome(c.trace_decode(raw))
+        events = trace["traceEvents"]
+        name = c.COMMAND_NAMES[CMD_PROG_PAGE]
+
+        names = {e["tid"]: e["args"]["name"] for e in events if e["ph"] == "M"}
+        self.assertEqual(names, {1: "protocol", 2: "isp", 3: "target"})
+        # Times relative to the first event, across the wrap
+        self.assertEqual(self.spans(c.trace_decode(raw), 1), [("B", name, 0x18), ("E", name, 0xA8)])
+        self.assertEqual(self.spans(c.trace_decode(raw), 2), [("B", "ISP", 0x20), ("E", "ISP", 0x50)])
+        self.assertEqual(self.spans(c.trace_decode(raw), 3), [("B", "busy", 0x60), ("E", "busy", 0xA0)])
+
+        instants = [(e["tid"], e["name"], e["args"]) for e in events if e["ph"] == "i"]
+        self.assertEqual(instants, [(1, "rx", {"bytes": 133}), (2, "poll", {"busy": True}),
+                                    (1, "flush", {})])
+
+    def test_unknown_command_named_by_code(self):
+        raw = record(0, c.TRACE_DISPATCH_BEGIN, 0xEE) + record(1, c.TRACE_DISPATCH_END, 0xEE)
+        self.assertEqual([n for _, n, _ in self.spans(c.trace_decode(raw), 1)], ["0xEE", "0xEE"])
+
+    def test_empty(self):
+        self.assertEqual([e["ph"] for e in c.trace_to_chrome([])["traceEvents"]], ["M"] * 3)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,112 @@
+/**
+ * @file test_transports.c
+ * @brief Both ISP Transports Against the Simulated Target
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avrprog.h"
+#include "avr_iface.h"
+#include "avr_spi_transport.h"
+#include <string.h>
+
+static const uint8_t atmega328p[3] = {0x1E, 0x95, 0x0F};
+
+/** Power up a 16 MHz ATmega328P and enter programming mode at hz */
+static bool start(uint8_t backend, uint32_t hz) {
+    host_sim_reset();
+    host_target()->cpu_hz = 16000000u;
+    avr_iface_select(AVR_IFACE_ISP);
+    avr_spi_select(backend);
+    avr_set_sck_frequency(hz);
+    return avr_iface()->enter();
+}
+
+/** A session touching every kind of instruction */
+static void test_session(uint8_t backend, uint32_t hz) {
+    const avr_iface_t* iface = avr_iface();
+    uint8_t page[128];
+    uint8_t back[128];
+    uint8_t sig[3];
+    uint8_t rx[4];
+
+    CHECK(start(backend, hz));
+    avr_read_signature(sig);
+    CHECK(memcmp(sig, atmega328p, 3) == 0);
+
+    /* Leftovers from an earlier image, then chip erase */
+    memset(host_target()->flash + 0x200, 0x00, 64);
+    iface->chip_erase();
+    CHECK(iface->poll_ready(100000));
+    CHECK_EQ(host_target()->flash[0x200], 0xFF);
+
+    for (size_t i = 0; i < sizeof(page); i++) {
+        page[i] = (uint8_t)(i * 7u + hz);
+    }
+    iface->write_flash_page(0x200, page, sizeof(page));
+    CHECK(iface->poll_ready(100000));
+    CHECK(memcmp(host_target()->flash + 0x200, page, sizeof(page)) == 0);
+    iface->read_flash(0x200, back, sizeof(back));
+    CHECK(memcmp(back, page, sizeof(page)) == 0);
+
+    /* Fuses through raw instructions */
+    avr_universal((const uint8_t[4]){0x50, 0x00, 0x00, 0x00}, rx);
+    CHECK_EQ(rx[3], 0x62);
+    avr_universal((const uint8_t[4]){0xAC, 0xA8, 0x00, 0xD1}, rx);
+    CHECK(iface->poll_ready(100000));
+    avr_universal((const uint8_t[4]){0x58, 0x08, 0x00, 0x00}, rx);
+    CHECK_EQ(rx[3], 0xD1);
+    CHECK_EQ(rx[2], 0x08);  /* Other bytes echo the one before */
+    CHECK_EQ(rx[1], 0x58);
+
+    iface->leave();
+
+    CHECK_EQ(host_target()->enables, 1);
+    CHECK_EQ(host_target()->page_writes, 1);
+    CHECK_EQ(host_target()->misreads, 0);
+    CHECK_EQ(host_target()->busy_violations, 0);
+    CHECK_EQ(host_sim_contentions(), 0);
+    CHECK(host_target_sck_hz() <= hz);
+    CHECK(host_target_sck_hz() >= hz * 9u / 10u);
+}
+
+/** Leaving programming mode stops the target listening */
+static void test_reset_released(uint8_t backend) {
+    uint8_t rx[4];
+
+    CHECK(start(backend, 100000));
+    avr_leave_programming_mode();
+    uint32_t before = host_target()->instructions;
+    avr_universal((const uint8_t[4]){0x30, 0x00, 0x00, 0x00}, rx);
+    CHECK_EQ(host_target()->instructions, before);
+    CHECK(rx[3] != atmega328p[0]);
+}
+
+/** Too fast for the target clock: garbled, and nothing is written */
+static void test_too_fast(uint8_t backend) {
+    host_sim_reset();
+    host_target()->cpu_hz = 1000000u;
+    avr_iface_select(AVR_IFACE_ISP);
+    avr_spi_select(backend);
+    avr_set_sck_frequency(1000000);
+    CHECK(!avr_iface()->enter());
+    CHECK_EQ(host_target()->enables, 0);
+    CHECK(host_target()->misreads > 0);
+}
+
+int main(void) {
+    static const uint8_t backends[] = {AVR_SPI_HW, AVR_SPI_BITBANG};
+    static const uint32_t rates[] = {50000, 400000, 2000000};
+
+    for (size_t b = 0; b < sizeof(backends); b++) {
+        for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+            test_session(backends[b], rates[r]);
+        }
+        test_reset_released(backends[b]);
+        test_too_fast(backends[b]);
+    }
+    return host_test_result("transports");
+}
@@ -0,0 +1,209 @@
+/**
+ * @file test_universal.c
+ * @brief UNIVERSAL_MULTI and UNIVERSAL_BATCH Through the Protocol Handler
+ *
+ * Raw ISP instruction lists go in through stk500v1_feed() and run
+ * against the simulated ATmega328P; writes in a list must finish before
+ * the instruction behind them is clocked in.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_profile.h"
+#include "avrprog.h"
+#include "stk500v1.h"
+#include "tusb.h"
+#include <string.h>
+
+static uint8_t reply[STK_BATCH_MAX_INSTR + 8];
+static size_t reply_len;
+
+static void on_reply(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    for (size_t i = 0; i < len && reply_len < sizeof(reply); i++) {
+        reply[reply_len++] = data[i];
+    }
+}
+
+static void send(const uint8_t* frame, size_t len) {
+    reply_len = 0;
+    stk500v1_feed(frame, (int)len);
+    for (int i = 0; i < 100000 && stk500v1_task(); i++) {
+        tud_task();
+    }
+    tud_cdc_write_flush();
+}
+
+static bool ok(uint8_t cmd) {
+    const uint8_t frame[2] = {cmd, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return reply_len == 2 && reply[0] == Resp_STK_INSYNC && reply[1] == Resp_STK_OK;
+}
+
+static bool failed(void) {
+    return reply_len == 2 && reply[0] == Resp_STK_INSYNC && reply[1] == Resp_STK_FAILED;
+}
+
+/** UNIVERSAL_MULTI frame for n instruction bytes (n - 1 in the length byte) */
+static size_t multi_frame(uint8_t* frame, const uint8_t* instr, size_t n) {
+    frame[0] = Cmnd_STK_UNIVERSAL_MULTI;
+    frame[1] = (uint8_t)(n - 1);
+    memcpy(frame + 2, instr, n);
+    frame[2 + n] = Sync_CRC_EOP;
+    return 3 + n;
+}
+
+/** UNIVERSAL_BATCH frame for count instructions */
+static size_t batch_frame(uint8_t* frame, const uint8_t* instr, size_t count) {
+    frame[0] = Cmnd_STK_UNIVERSAL_BATCH;
+    frame[1] = (uint8_t)count;
+    memcpy(frame + 2, instr, count * 4);
+    frame[2 + count * 4] = Sync_CRC_EOP;
+    return 3 + count * 4;
+}
+
+/** Run a batch; true if the reply is INSYNC, count result bytes, OK */
+static bool batch(const uint8_t* instr, size_t count) {
+    uint8_t frame[3 + 4 * 256];
+    size_t len = batch_frame(frame, instr, count);
+    CHECK_EQ(stk500v1_frame_length(frame, len), (int)len);
+    send(frame, len);
+    return reply_len == count + 2 && reply[0] == Resp_STK_INSYNC && reply[count + 1] == Resp_STK_OK;
+}
+
+static bool multi(const uint8_t* instr, size_t n) {
+    uint8_t frame[3 + 256];
+    size_t len = multi_frame(frame, instr, n);
+    CHECK_EQ(stk500v1_frame_length(frame, len), (int)len);
+    send(frame, len);
+    return reply_len == 2 && reply[0] == Resp_STK_INSYNC && reply[1] == Resp_STK_OK;
+}
+
+static void start(void) {
+    static const uint8_t m328p[3] = {0x1E, 0x95, 0x0F};
+
+    host_sim_reset();
+    host_target_init(m328p);
+    host_target()->cpu_hz = 16000000u;
+    host_cdc_set_sink(on_reply, NULL);
+    avr_spi_init();
+    avr_profile_init();
+    stk500v1_init();
+    CHECK(ok(Cmnd_STK_ENTER_PROGMODE));
+}
+
+/** Read instructions answer in order, one result byte each */
+static void test_batch_reads(void) {
+    static const uint8_t reads[] = {
+        0x30, 0x00, 0x00, 0x00,     /* Signature */
+        0x30, 0x00, 0x01, 0x00,
+        0x30, 0x00, 0x02, 0x00,
+        0x50, 0x00, 0x00, 0x00,     /* Low fuse */
+        0x58, 0x08, 0x00, 0x00,     /* High fuse */
+        0x50, 0x08, 0x00, 0x00,     /* Extended fuse */
+        0x58, 0x00, 0x00, 0x00,     /* Lock */
+        0x38, 0x00, 0x00, 0x00,     /* Calibration */
+        0x20, 0x00, 0x01, 0x00,     /* Flash word 1, low and high byte */
+        0x28, 0x00, 0x01, 0x00,
+    };
+    static const uint8_t expect[] = {0x1E, 0x95, 0x0F, 0x62, 0xD9, 0xFF, 0xFF, 0x80, 0x34, 0x12};
+
+    start();
+    host_target()->flash[2] = 0x34;
+    host_target()->flash[3] = 0x12;
+    CHECK(batch(reads, sizeof(reads) / 4));
+    CHECK(memcmp(reply + 1, expect, sizeof(expect)) == 0);
+    CHECK_EQ(host_target()->misreads, 0);
+}
+
+/** Writes back to back: each one waits for the one before it */
+static void test_fuse_writes(void) {
+    static const uint8_t writes[] = {
+        0xAC, 0xA0, 0x00, 0xE2,     /* Low fuse */
+        0xAC, 0xA8, 0x00, 0xD8,     /* High fuse */
+        0xAC, 0xA4, 0x00, 0xFD,     /* Extended fuse */
+        0xAC, 0xE0, 0x00, 0xFC,     /* Lock */
+    };
+    static const uint8_t write_read[] = {
+        0xAC, 0xA0, 0x00, 0xFF,     /* Low fuse, then read it in the same frame */
+        0x50, 0x00, 0x00, 0x00,
+        0x58, 0x08, 0x00, 0x00,
+        0x50, 0x08, 0x00, 0x00,
+        0x58, 0x00, 0x00, 0x00,
+    };
+
+    start();
+    CHECK(multi(writes, sizeof(writes)));
+    CHECK_EQ(host_target()->lfuse, 0xE2);
+    CHECK_EQ(host_target()->hfuse, 0xD8);
+    CHECK_EQ(host_target()->efuse, 0xFD);
+    CHECK_EQ(host_target()->lock, 0xFC);
+
+    CHECK(batch(write_read, sizeof(write_read) / 4));
+    CHECK_EQ(reply[2], 0xFF);
+    CHECK_EQ(reply[3], 0xD8);
+    CHECK_EQ(reply[4], 0xFD);
+    CHECK_EQ(reply[5], 0xFC);
+    CHECK_EQ(host_target()->busy_violations, 0);
+}
+
+/** A chip erase in a list finishes before the read behind it */
+static void test_erase_then_read(void) {
+    static const uint8_t erase_read[] = {
+        0xAC, 0x80, 0x00, 0x00,
+        0x20, 0x00, 0x00, 0x00,
+    };
+
+    start();
+    memset(host_target()->flash, 0x00, 256);
+    CHECK(batch(erase_read, 2));
+    CHECK_EQ(reply[2], 0xFF);
+    CHECK_EQ(host_target()->chip_erases, 1);
+    CHECK_EQ(host_target()->busy_violations, 0);
+}
+
+/** Bad lengths fail without touching the target; framing stays in step */
+static void test_bad_lengths(void) {
+    static uint8_t instr[4 * 256];
+    uint8_t frame[3 + sizeof(instr)];
+
+    memset(instr, 0x30, sizeof(instr));     /* Signature reads */
+    start();
+    uint32_t before = host_target()->instructions;
+
+    send(frame, multi_frame(frame, instr, 6));              /* Not whole instructions */
+    CHECK(failed());
+    send(frame, batch_frame(frame, instr, 0));
+    CHECK(failed());
+    send(frame, batch_frame(frame, instr, STK_BATCH_MAX_INSTR + 1));
+    CHECK(failed());
+    CHECK_EQ(host_target()->instructions, before);
+    CHECK(ok(Cmnd_STK_GET_SYNC));
+
+    /* The largest of each */
+    CHECK(multi(instr, 256));
+    CHECK(batch(instr, STK_BATCH_MAX_INSTR));
+}
+
+/** The length byte is all the parser needs */
+static void test_frame_length(void) {
+    static const uint8_t multi_hdr[2] = {Cmnd_STK_UNIVERSAL_MULTI, 7};
+    static const uint8_t batch_hdr[2] = {Cmnd_STK_UNIVERSAL_BATCH, 3};
+
+    CHECK_EQ(stk500v1_frame_length(multi_hdr, 1), STK_FRAME_MORE);
+    CHECK_EQ(stk500v1_frame_length(multi_hdr, 2), 1 + 1 + 8 + 1);
+    CHECK_EQ(stk500v1_frame_length(batch_hdr, 1), STK_FRAME_MORE);
+    CHECK_EQ(stk500v1_frame_length(batch_hdr, 2), 1 + 1 + 12 + 1);
+}
+
+int main(void) {
+    test_frame_length();
+    test_batch_reads();
+    test_fuse_writes();
+    test_erase_then_read();
+    test_bad_lengths();
+    return host_test_result("universal");
+}
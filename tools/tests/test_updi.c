@@ -0,0 +1,133 @@
+/**
+ * @file test_updi.c
+ * @brief UPDI Backend Against the Simulated tinyAVR / megaAVR 0
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_iface.h"
+#include "updi.h"
+#include <string.h>
+
+static const uint8_t attiny1614[3] = {0x1E, 0x94, 0x22};
+static const uint8_t atmega4809[3] = {0x1E, 0x96, 0x51};
+
+static const avr_iface_t* connect(const uint8_t sig[3]) {
+    host_sim_reset();
+    host_sim_connect(HOST_LINK_UPDI, sig);
+    updi_set_high_baud(UPDI_HIGH_BAUD);
+    avr_iface_select(AVR_IFACE_UPDI);
+    return avr_iface();
+}
+
+/** |a - b| within 1% of b */
+static bool near(uint32_t a, uint32_t b) {
+    uint32_t d = a > b ? a - b : b - a;
+    return d * 100u <= b;
+}
+
+/** Enter at the connection rate, then run at the raised one */
+static void test_enter(void) {
+    const avr_iface_t* iface = connect(attiny1614);
+    uint8_t rx[4];
+
+    CHECK(iface->enter());
+    CHECK(near(host_target()->sync_baud, UPDI_HIGH_BAUD));
+    for (uint8_t i = 0; i < 3; i++) {
+        iface->universal((const uint8_t[4]){0x30, 0x00, i, 0x00}, rx);
+        CHECK_EQ(rx[3], attiny1614[i]);
+    }
+    iface->universal((const uint8_t[4]){0x58, 0x00, 0x00, 0x00}, rx);
+    CHECK_EQ(rx[3], 0xC5);
+    iface->leave();
+    CHECK_EQ(host_target()->frame_errors, 0);
+}
+
+/** Chip erase, a page through PBC + REPEAT/ST burst + WP, read back */
+static void test_flash(void) {
+    const avr_iface_t* iface = connect(attiny1614);
+    uint32_t page_bytes = host_target()->page_bytes;
+    uint8_t page[512];
+    uint8_t back[300];
+
+    memset(host_target()->flash, 0x00, 2u * page_bytes);
+    CHECK(iface->enter());
+    iface->chip_erase();
+    CHECK(iface->poll_ready(50000));
+    CHECK_EQ(host_target()->chip_erases, 1);
+    CHECK_EQ(host_target()->flash[0], 0xFF);
+
+    for (uint32_t i = 0; i < page_bytes; i++) {
+        page[i] = (uint8_t)(i * 7u + 3u);
+    }
+    iface->write_flash_page(page_bytes, page, page_bytes);
+    CHECK(iface->poll_ready(50000));
+    CHECK_EQ(host_target()->page_writes, 1);
+    CHECK(memcmp(host_target()->flash + page_bytes, page, page_bytes) == 0);
+
+    /* More than one REPEAT burst */
+    for (uint32_t i = 0; i < sizeof(back); i++) {
+        host_target()->flash[0x400 + i] = (uint8_t)(i ^ 0xA5);
+    }
+    iface->read_flash(0x400, back, sizeof(back));
+    for (uint32_t i = 0; i < sizeof(back); i++) {
+        CHECK_EQ(back[i], (uint8_t)(i ^ 0xA5));
+    }
+    iface->leave();
+    CHECK_EQ(host_target()->busy_violations, 0);
+    CHECK_EQ(host_target()->frame_errors, 0);
+}
+
+/** megaAVR 0 maps flash at 0x4000 instead of 0x8000 */
+static void test_mega0(void) {
+    const avr_iface_t* iface = connect(atmega4809);
+    uint32_t page_bytes = host_target()->page_bytes;
+    uint8_t page[512];
+
+    CHECK(iface->enter());
+    memset(page, 0x3C, page_bytes);
+    iface->write_flash_page(0x100, page, page_bytes);
+    CHECK(iface->poll_ready(50000));
+    CHECK(memcmp(host_target()->flash + 0x100, page, page_bytes) == 0);
+    iface->leave();
+}
+
+/** The UPDI clock cannot go to 16 MHz: the high rate fails, and a BREAK recovers */
+static void test_high_baud_fallback(void) {
+    const avr_iface_t* iface = connect(attiny1614);
+    uint8_t page[64];
+    uint8_t rx[4];
+
+    host_target()->updi_max_hz = 4000000u;
+    CHECK(iface->enter());
+    CHECK(host_target()->frame_errors > 0);
+    CHECK(near(host_target()->sync_baud, UPDI_BAUD));
+
+    iface->universal((const uint8_t[4]){0x30, 0x00, 0x01, 0x00}, rx);
+    CHECK_EQ(rx[3], attiny1614[1]);
+    memset(page, 0x5A, sizeof(page));
+    iface->write_flash_page(0, page, sizeof(page));
+    CHECK(iface->poll_ready(50000));
+    CHECK_EQ(host_target()->flash[0], 0x5A);
+    iface->leave();
+}
+
+/** A locked part never reaches NVM programming */
+static void test_locked(void) {
+    const avr_iface_t* iface = connect(attiny1614);
+
+    host_target()->lock = 0x00;
+    CHECK(!iface->enter());
+}
+
+int main(void) {
+    test_enter();
+    test_flash();
+    test_mega0();
+    test_high_baud_fallback();
+    test_locked();
+    return host_test_result("updi");
+}
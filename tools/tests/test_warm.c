@@ -0,0 +1,159 @@
+/**
+ * @file test_warm.c
+ * @brief Warm Sessions Through the Protocol Handler on the Simulated Clock
+ *
+ * Frames go in through stk500v1_feed() and replies come back through the
+ * CDC sink, as main.c and avrdude would see them; the clock moves between
+ * avrdude runs while stk500v1_task() keeps being called.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_profile.h"
+#include "avrprog.h"
+#include "stk500v1.h"
+#include "tusb.h"
+#include <string.h>
+
+#define LOOP_NS     1000000u    /* Main loop step while the host thinks */
+
+static uint8_t reply[64];
+static size_t reply_len;
+
+static void on_reply(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    for (size_t i = 0; i < len && reply_len < sizeof(reply); i++) {
+        reply[reply_len++] = data[i];
+    }
+}
+
+/** Send one frame and run the main loop until the device is idle */
+static void send(const uint8_t* frame, size_t len) {
+    reply_len = 0;
+    stk500v1_feed(frame, (int)len);
+    for (int i = 0; i < 1000 && stk500v1_task(); i++) {
+        tud_task();
+    }
+    tud_cdc_write_flush();
+}
+
+/** Send a frame whose reply is INSYNC, OK with nothing between */
+static bool ok(uint8_t cmd) {
+    const uint8_t frame[2] = {cmd, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return reply_len == 2 && reply[0] == Resp_STK_INSYNC && reply[1] == Resp_STK_OK;
+}
+
+static bool set_parameter(uint8_t parm, uint8_t value) {
+    const uint8_t frame[4] = {Cmnd_STK_SET_PARAMETER, parm, value, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return reply_len == 2 && reply[1] == Resp_STK_OK;
+}
+
+static int get_parameter(uint8_t parm) {
+    const uint8_t frame[3] = {Cmnd_STK_GET_PARAMETER, parm, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return reply_len == 3 && reply[2] == Resp_STK_OK ? reply[1] : -1;
+}
+
+/** READ_SIGN matches the simulated target */
+static bool signature_ok(void) {
+    const uint8_t frame[2] = {Cmnd_STK_READ_SIGN, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return reply_len == 5 && memcmp(&reply[1], host_target()->signature, 3) == 0;
+}
+
+/** The host thinking between runs: only the main loop turns */
+static void think(uint64_t ns) {
+    for (uint64_t t = 0; t < ns; t += LOOP_NS) {
+        tud_task();
+        stk500v1_task();
+        host_sim_advance_ns(LOOP_NS);
+    }
+}
+
+/** One avrdude run: sync, enter, signature, leave */
+static void run(void) {
+    CHECK(ok(Cmnd_STK_GET_SYNC));
+    CHECK(ok(Cmnd_STK_ENTER_PROGMODE));
+    CHECK(signature_ok());
+    CHECK(ok(Cmnd_STK_LEAVE_PROGMODE));
+}
+
+static void start(void) {
+    host_sim_reset();
+    host_target()->cpu_hz = 16000000u;
+    host_cdc_set_sink(on_reply, NULL);
+    avr_spi_init();
+    avr_profile_init();
+    stk500v1_init();
+}
+
+/** Off by default: every run enters cold */
+static void test_off(void) {
+    start();
+    CHECK_EQ(get_parameter(Parm_VND_WARM_TIMEOUT), 0);
+    run();
+    run();
+    CHECK_EQ(host_target()->enables, 2);
+    CHECK_EQ(get_parameter(Parm_VND_WARM_HITS), 0);
+}
+
+/** Runs inside the timeout reuse the held target, later ones enter cold */
+static void test_timeout(void) {
+    int cold_time;
+
+    start();
+    CHECK(set_parameter(Parm_VND_WARM_TIMEOUT, 5));     /* 500 ms */
+    run();
+    cold_time = get_parameter(Parm_VND_ENTER_TIME);
+    CHECK_EQ(host_target()->enables, 1);
+
+    think(300000000u);
+    run();
+    CHECK_EQ(host_target()->enables, 1);
+    CHECK_EQ(get_parameter(Parm_VND_WARM_HITS), 1);
+    CHECK(get_parameter(Parm_VND_ENTER_TIME) < cold_time);
+
+    /* Each frame restarts the timeout */
+    for (int i = 0; i < 3; i++) {
+        think(300000000u);
+        CHECK(ok(Cmnd_STK_GET_SYNC));
+    }
+    run();
+    CHECK_EQ(host_target()->enables, 1);
+    CHECK_EQ(get_parameter(Parm_VND_WARM_HITS), 2);
+
+    think(600000000u);
+    run();
+    CHECK_EQ(host_target()->enables, 2);
+    CHECK_EQ(get_parameter(Parm_VND_WARM_HITS), 2);
+    CHECK_EQ(host_target()->busy_violations, 0);
+}
+
+/** A different part on the header while held enters cold */
+static void test_swapped(void) {
+    start();
+    CHECK(set_parameter(Parm_VND_WARM_TIMEOUT, 50));
+    run();
+    host_target()->signature[2] = 0x14;     /* ATmega328 */
+    think(100000000u);
+    run();
+    CHECK_EQ(host_target()->enables, 2);
+    CHECK_EQ(get_parameter(Parm_VND_WARM_HITS), 0);
+
+    /* Turning the timeout off releases the held target */
+    CHECK(set_parameter(Parm_VND_WARM_TIMEOUT, 0));
+    run();
+    CHECK_EQ(host_target()->enables, 3);
+}
+
+int main(void) {
+    test_off();
+    test_timeout();
+    test_swapped();
+    return host_test_result("warm");
+}
@@ -0,0 +1,190 @@
+/**
+ * @file test_write_verify.c
+ * @brief Inline Verify Through the Protocol Handler on the Simulated Target
+ *
+ * PROG_PAGE uploads with Parm_VND_VERIFY set, against a target that
+ * garbles instructions at the session's SCK rate or has a page whose
+ * bits a write cannot set again.
+ *
+ * @author MUdroThe1
+ * @date 2026
+ */
+
+#include "host_test.h"
+#include "host_sim.h"
+#include "avr_profile.h"
+#include "avrprog.h"
+#include "stk500v1.h"
+#include "write_verify.h"
+#include "tusb.h"
+#include <string.h>
+
+#define PAGE_BYTES  128u        /* ATmega328P */
+#define PAGES       6u
+
+static uint8_t reply[64];
+static size_t reply_len;
+
+static void on_reply(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    for (size_t i = 0; i < len && reply_len < sizeof(reply); i++) {
+        reply[reply_len++] = data[i];
+    }
+}
+
+/** Send one frame and run the main loop until the device is idle */
+static void send(const uint8_t* frame, size_t len) {
+    reply_len = 0;
+    stk500v1_feed(frame, (int)len);
+    for (int i = 0; i < 100000 && stk500v1_task(); i++) {
+        tud_task();
+    }
+    tud_cdc_write_flush();
+}
+
+/** INSYNC then the status byte, or -1 */
+static int status(void) {
+    return reply_len == 2 && reply[0] == Resp_STK_INSYNC ? reply[1] : -1;
+}
+
+static int command(uint8_t cmd) {
+    const uint8_t frame[2] = {cmd, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return status();
+}
+
+static int get_parameter(uint8_t parm) {
+    const uint8_t frame[3] = {Cmnd_STK_GET_PARAMETER, parm, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    return reply_len == 3 && reply[2] == Resp_STK_OK ? reply[1] : -1;
+}
+
+static uint8_t image(uint32_t page, uint32_t i) {
+    return (uint8_t)(i * 13 + page * 7 + 1);
+}
+
+/** LOAD_ADDRESS + PROG_PAGE as avrdude sends them; the PROG_PAGE status */
+static int prog_page(uint32_t page) {
+    uint8_t frame[5 + PAGE_BYTES];
+    uint16_t word = (uint16_t)(page * PAGE_BYTES / 2);
+    const uint8_t load[4] = {Cmnd_STK_LOAD_ADDRESS, (uint8_t)word, (uint8_t)(word >> 8), Sync_CRC_EOP};
+    send(load, sizeof(load));
+
+    frame[0] = Cmnd_STK_PROG_PAGE;
+    frame[1] = 0;
+    frame[2] = PAGE_BYTES;
+    frame[3] = 'F';
+    for (uint32_t i = 0; i < PAGE_BYTES; i++) {
+        frame[4 + i] = image(page, i);
+    }
+    frame[4 + PAGE_BYTES] = Sync_CRC_EOP;
+    send(frame, sizeof(frame));
+    return status();
+}
+
+/** VERIFY_MAP bitmap length, its first byte in *first */
+static int verify_map(uint8_t* first) {
+    const uint8_t frame[2] = {Cmnd_STK_VERIFY_MAP, Sync_CRC_EOP};
+    send(frame, sizeof(frame));
+    if (reply_len < 4 || reply[0] != Resp_STK_INSYNC || reply[reply_len - 1] != Resp_STK_OK) {
+        return -1;
+    }
+    int n = reply[1] << 8 | reply[2];
+    *first = n ? reply[3] : 0;
+    return reply_len == (size_t)n + 4 ? n : -1;
+}
+
+static bool page_matches(uint32_t page) {
+    for (uint32_t i = 0; i < PAGE_BYTES; i++) {
+        if (host_target()->flash[page * PAGE_BYTES + i] != image(page, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Enter with inline verify on, at about 300 kHz (avrdude -B 3); the SCK rate */
+static uint32_t start(void) {
+    const uint8_t verify_on[4] = {Cmnd_STK_SET_PARAMETER, Parm_VND_VERIFY, 1, Sync_CRC_EOP};
+    const uint8_t sck_duration[4] = {Cmnd_STK_SET_PARAMETER, Parm_STK_SCK_DURATION, 3, Sync_CRC_EOP};
+
+    host_sim_reset();
+    host_target()->cpu_hz = 16000000u;
+    host_cdc_set_sink(on_reply, NULL);
+    avr_spi_init();
+    avr_profile_init();
+    stk500v1_init();
+
+    send(verify_on, sizeof(verify_on));
+    CHECK_EQ(status(), Resp_STK_OK);
+    send(sck_duration, sizeof(sck_duration));
+    CHECK_EQ(status(), Resp_STK_OK);
+    CHECK_EQ(command(Cmnd_STK_ENTER_PROGMODE), Resp_STK_OK);
+    return avr_get_sck_frequency();
+}
+
+/**
+ * @brief The target clock drops below what SCK needs mid-session
+ *
+ * The first page is garbled and rewritten at half the rate, which the
+ * rest of the upload keeps.
+ */
+static void test_retried(void) {
+    uint32_t sck = start();
+    host_target()->cpu_hz = 3 * sck;    /* Phases of 1.5 target clocks: too short */
+
+    for (uint32_t p = 0; p < PAGES; p++) {
+        CHECK_EQ(prog_page(p), Resp_STK_OK);
+    }
+    CHECK_EQ(command(Cmnd_STK_LEAVE_PROGMODE), Resp_STK_OK);
+
+    CHECK(host_target()->misreads > 0);
+    CHECK_EQ(avr_get_sck_frequency(), sck / 2);
+    CHECK_EQ(get_parameter(Parm_VND_VERIFY_RETRIED), 1);
+    CHECK_EQ(get_parameter(Parm_VND_VERIFY_FAILED), 0);
+    uint8_t first;
+    CHECK_EQ(verify_map(&first), 0);
+    for (uint32_t p = 0; p < PAGES; p++) {
+        CHECK(page_matches(p));
+    }
+}
+
+/**
+ * @brief A page with bits cleared that the image needs set
+ *
+ * Both rewrites run, each at half the rate, and the page is reported.
+ * The failure reaches the host on the next PROG_PAGE, or on
+ * LEAVE_PROGMODE when the bad page was the last.
+ */
+static void test_failed(uint32_t bad) {
+    uint32_t sck = start();
+    memset(host_target()->flash + bad * PAGE_BYTES, 0x00, PAGE_BYTES);    /* Not erased */
+    uint32_t writes = host_target()->page_writes;
+
+    for (uint32_t p = 0; p <= bad + 1 && p < PAGES; p++) {
+        CHECK_EQ(prog_page(p), p == bad + 1 ? Resp_STK_FAILED : Resp_STK_OK);
+    }
+    CHECK_EQ(command(Cmnd_STK_LEAVE_PROGMODE), bad + 1 < PAGES ? Resp_STK_OK : Resp_STK_FAILED);
+
+    uint32_t expect_sck = sck / 4 > WRITE_VERIFY_MIN_SCK_HZ ? sck / 4 : WRITE_VERIFY_MIN_SCK_HZ;
+    CHECK_EQ(avr_get_sck_frequency(), expect_sck);
+    uint32_t written = bad + 1 < PAGES ? bad + 2 : bad + 1;
+    CHECK_EQ(host_target()->page_writes - writes, written + WRITE_VERIFY_RETRIES);
+    CHECK_EQ(get_parameter(Parm_VND_VERIFY_RETRIED), 0);
+    CHECK_EQ(get_parameter(Parm_VND_VERIFY_FAILED), 1);
+
+    uint8_t map[1];
+    CHECK_EQ(verify_map(map), 1);
+    CHECK_EQ(map[0], 1u << bad);
+    CHECK(!page_matches(bad));
+    for (uint32_t p = 0; p < written; p++) {
+        CHECK(p == bad || page_matches(p));
+    }
+}
+
+int main(void) {
+    test_retried();
+    test_failed(2);
+    test_failed(PAGES - 1);
+    return host_test_result("write_verify");
+}